@@ -0,0 +1,107 @@
+/*
+ *		Chunk boundaries of line-oriented data.
+ *
+ * Copyright (c) 2008,2009 Naoaki Okazaki
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the names of the authors nor the names of its contributors
+ *       may be used to endorse or promote products derived from this
+ *       software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* $Id$ */
+
+#ifndef __CHUNK_H__
+#define __CHUNK_H__
+
+#include <cstring>
+
+/*
+ * Finds a chunk boundary at or after the position.
+ *  A chunk boundary is the beginning of a line. With the instance-aware
+ *  mode (candidate format), a boundary is also put after an '@eoi' line
+ *  so that the candidates of an instance are processed by the same thread.
+ */
+inline static const char*
+find_chunk_boundary(
+    const char* p,
+    const char* first,
+    const char* last,
+    bool instances
+    )
+{
+    // Move to the beginning of the next line.
+    if (p != first && *(p-1) != '\n') {
+        const char* eol = (const char*)std::memchr(p, '\n', last - p);
+        p = (eol != NULL) ? eol + 1 : last;
+    }
+
+    if (instances) {
+        // Move to the line following the next '@eoi' line.
+        while (p != last) {
+            const char* eol = (const char*)std::memchr(p, '\n', last - p);
+            const char* next = (eol != NULL) ? eol + 1 : last;
+            if (4 <= next - p && std::strncmp(p, "@eoi", 4) == 0) {
+                return next;
+            }
+            p = next;
+        }
+    }
+    return p;
+}
+
+/*
+ * Finds the end of the last chunk in a block.
+ *  The end is the position following the last newline character, or,
+ *  with the instance-aware mode, following the last '@eoi' line so that
+ *  an instance is never split across blocks. This function returns
+ *  \c first when the block contains no such position.
+ */
+inline static const char*
+find_last_chunk_boundary(
+    const char* first,
+    const char* last,
+    bool instances
+    )
+{
+    // Move back to the position following the last newline.
+    while (last != first && *(last-1) != '\n') {
+        --last;
+    }
+
+    if (instances) {
+        // Move back to the position following the last '@eoi' line.
+        while (last != first) {
+            const char* p = last - 1;
+            while (p != first && *(p-1) != '\n') {
+                --p;
+            }
+            if (4 <= last - p && std::strncmp(p, "@eoi", 4) == 0) {
+                return last;
+            }
+            last = p;
+        }
+    }
+    return last;
+}
+
+#endif/*__CHUNK_H__*/
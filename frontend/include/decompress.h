@@ -0,0 +1,537 @@
+/*
+ *		In-process decompression of input files.
+ *
+ * Copyright (c) 2008,2009 Naoaki Okazaki
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the names of the authors nor the names of its contributors
+ *       may be used to endorse or promote products derived from this
+ *       software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* $Id$ */
+
+#ifndef __DECOMPRESS_H__
+#define __DECOMPRESS_H__
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <istream>
+#include <streambuf>
+#include <string>
+#include <vector>
+
+#include <classias/parallel.h>
+
+#ifdef  HAVE_LIBZ
+#include <zlib.h>
+#endif/*HAVE_LIBZ*/
+#ifdef  HAVE_LIBBZ2
+#include <bzlib.h>
+#endif/*HAVE_LIBBZ2*/
+#ifdef  HAVE_LIBLZMA
+#include <lzma.h>
+#endif/*HAVE_LIBLZMA*/
+
+/*
+ * The interface of a decoder that reads a compressed file.
+ */
+class decoder
+{
+public:
+    virtual ~decoder()
+    {
+    }
+
+    /*
+     * Reads decompressed bytes.
+     *  The function fills the buffer unless it reaches the end of the data,
+     *  and returns the number of bytes read (0 at the end of the data) or
+     *  -1 on an error.
+     */
+    virtual long read(char *buffer, size_t size) = 0;
+};
+
+#ifdef  HAVE_LIBZ
+/*
+ * A decoder of gzip (.gz) files with zlib.
+ *  Each member of the file must be a gzip stream; a file that is not gzip
+ *  data or that has trailing bytes after the last member is an error.
+ */
+class gzip_decoder : public decoder
+{
+protected:
+    FILE *m_fp;
+    z_stream m_strm;
+    bool m_init;
+    bool m_member;
+    bool m_eof;
+    std::vector<char> m_in;
+
+public:
+    gzip_decoder(const char *filename)
+        : m_init(false), m_member(false), m_eof(false), m_in(1 << 20)
+    {
+        std::memset(&m_strm, 0, sizeof(m_strm));
+        m_fp = std::fopen(filename, "rb");
+        if (m_fp != NULL) {
+            // Accept the gzip format only (no raw deflate or zlib data).
+            m_init = (inflateInit2(&m_strm, 16 + MAX_WBITS) == Z_OK);
+        }
+    }
+
+    virtual ~gzip_decoder()
+    {
+        if (m_init) {
+            inflateEnd(&m_strm);
+        }
+        if (m_fp != NULL) {
+            std::fclose(m_fp);
+        }
+    }
+
+    bool is_open() const
+    {
+        return (m_fp != NULL && m_init);
+    }
+
+    virtual long read(char *buffer, size_t size)
+    {
+        m_strm.next_out = (Bytef*)buffer;
+        m_strm.avail_out = (uInt)size;
+
+        while (0 < m_strm.avail_out) {
+            // Fill the input buffer.
+            if (m_strm.avail_in == 0 && !m_eof) {
+                size_t n = std::fread(&m_in[0], 1, m_in.size(), m_fp);
+                if (n == 0) {
+                    if (std::ferror(m_fp)) {
+                        return -1;
+                    }
+                    m_eof = true;
+                }
+                m_strm.next_in = (Bytef*)&m_in[0];
+                m_strm.avail_in = (uInt)n;
+            }
+
+            // Exit at the end of the file; a member must not be truncated.
+            if (m_strm.avail_in == 0 && m_eof) {
+                if (m_member) {
+                    return -1;
+                }
+                break;
+            }
+
+            // Begin a (concatenated) member; inflate() rejects bytes that
+            // do not start with the gzip header.
+            if (!m_member) {
+                if (inflateReset(&m_strm) != Z_OK) {
+                    return -1;
+                }
+                m_member = true;
+            }
+
+            int ret = inflate(&m_strm, Z_NO_FLUSH);
+            if (ret == Z_STREAM_END) {
+                m_member = false;
+            } else if (ret == Z_BUF_ERROR && m_strm.avail_in == 0) {
+                // The member needs more input.
+            } else if (ret != Z_OK) {
+                return -1;
+            }
+        }
+
+        return (long)(size - m_strm.avail_out);
+    }
+};
+#endif/*HAVE_LIBZ*/
+
+#ifdef  HAVE_LIBBZ2
+/*
+ * A decoder of bzip2 (.bz2) files with libbz2.
+ */
+class bzip2_decoder : public decoder
+{
+protected:
+    FILE *m_fp;
+    bz_stream m_strm;
+    bool m_init;
+    bool m_eof;
+    std::vector<char> m_in;
+
+public:
+    bzip2_decoder(const char *filename)
+        : m_init(false), m_eof(false), m_in(1 << 20)
+    {
+        std::memset(&m_strm, 0, sizeof(m_strm));
+        m_fp = std::fopen(filename, "rb");
+    }
+
+    virtual ~bzip2_decoder()
+    {
+        if (m_init) {
+            BZ2_bzDecompressEnd(&m_strm);
+        }
+        if (m_fp != NULL) {
+            std::fclose(m_fp);
+        }
+    }
+
+    bool is_open() const
+    {
+        return (m_fp != NULL);
+    }
+
+    virtual long read(char *buffer, size_t size)
+    {
+        m_strm.next_out = buffer;
+        m_strm.avail_out = (unsigned int)size;
+
+        while (0 < m_strm.avail_out) {
+            // Fill the input buffer.
+            if (m_strm.avail_in == 0 && !m_eof) {
+                size_t n = std::fread(&m_in[0], 1, m_in.size(), m_fp);
+                if (n == 0) {
+                    if (std::ferror(m_fp)) {
+                        return -1;
+                    }
+                    m_eof = true;
+                }
+                m_strm.next_in = &m_in[0];
+                m_strm.avail_in = (unsigned int)n;
+            }
+
+            // Exit at the end of the file; a stream must not be truncated.
+            if (m_strm.avail_in == 0 && m_eof) {
+                if (m_init) {
+                    return -1;
+                }
+                break;
+            }
+
+            // Begin a (concatenated) stream.
+            if (!m_init) {
+                m_strm.bzalloc = NULL;
+                m_strm.bzfree = NULL;
+                m_strm.opaque = NULL;
+                if (BZ2_bzDecompressInit(&m_strm, 0, 0) != BZ_OK) {
+                    return -1;
+                }
+                m_init = true;
+            }
+
+            int ret = BZ2_bzDecompress(&m_strm);
+            if (ret == BZ_STREAM_END) {
+                BZ2_bzDecompressEnd(&m_strm);
+                m_init = false;
+            } else if (ret != BZ_OK) {
+                return -1;
+            }
+        }
+
+        return (long)(size - m_strm.avail_out);
+    }
+};
+#endif/*HAVE_LIBBZ2*/
+
+#ifdef  HAVE_LIBLZMA
+/*
+ * A decoder of xz (.xz) files with liblzma.
+ */
+class xz_decoder : public decoder
+{
+protected:
+    FILE *m_fp;
+    lzma_stream m_strm;
+    bool m_init;
+    bool m_eof;
+    bool m_end;
+    std::vector<char> m_in;
+
+public:
+    xz_decoder(const char *filename)
+        : m_init(false), m_eof(false), m_end(false), m_in(1 << 20)
+    {
+        lzma_stream strm = LZMA_STREAM_INIT;
+        m_strm = strm;
+        m_fp = std::fopen(filename, "rb");
+        if (m_fp != NULL) {
+            m_init = (lzma_stream_decoder(
+                &m_strm, UINT64_MAX, LZMA_CONCATENATED) == LZMA_OK);
+        }
+    }
+
+    virtual ~xz_decoder()
+    {
+        if (m_init) {
+            lzma_end(&m_strm);
+        }
+        if (m_fp != NULL) {
+            std::fclose(m_fp);
+        }
+    }
+
+    bool is_open() const
+    {
+        return (m_fp != NULL && m_init);
+    }
+
+    virtual long read(char *buffer, size_t size)
+    {
+        m_strm.next_out = (uint8_t*)buffer;
+        m_strm.avail_out = size;
+
+        while (0 < m_strm.avail_out && !m_end) {
+            // Fill the input buffer.
+            if (m_strm.avail_in == 0 && !m_eof) {
+                size_t n = std::fread(&m_in[0], 1, m_in.size(), m_fp);
+                if (n == 0) {
+                    if (std::ferror(m_fp)) {
+                        return -1;
+                    }
+                    m_eof = true;
+                }
+                m_strm.next_in = (const uint8_t*)&m_in[0];
+                m_strm.avail_in = n;
+            }
+
+            lzma_ret ret = lzma_code(&m_strm, m_eof ? LZMA_FINISH : LZMA_RUN);
+            if (ret == LZMA_STREAM_END) {
+                m_end = true;
+            } else if (ret != LZMA_OK) {
+                return -1;
+            }
+        }
+
+        return (long)(size - m_strm.avail_out);
+    }
+};
+#endif/*HAVE_LIBLZMA*/
+
+/*
+ * Tests whether a file name ends with an extension.
+ */
+inline static bool
+has_extension(const std::string& filename, const char *ext)
+{
+    const size_t n = filename.size(), m = std::strlen(ext);
+    return (m <= n && filename.compare(n-m, m, ext) == 0);
+}
+
+/*
+ * Creates a decoder for a file name if an in-process decoder is available
+ * for the extension (.gz, .bz2, or .xz). The function returns NULL if the
+ * file does not need a decoder, if no decoder is compiled in, or if the
+ * file cannot be opened; use has_decoder() to tell these cases.
+ */
+inline static decoder*
+create_decoder(const std::string& filename)
+{
+#ifdef  HAVE_LIBZ
+    if (has_extension(filename, ".gz")) {
+        gzip_decoder* dec = new gzip_decoder(filename.c_str());
+        if (dec->is_open()) {
+            return dec;
+        }
+        delete dec;
+    }
+#endif/*HAVE_LIBZ*/
+#ifdef  HAVE_LIBBZ2
+    if (has_extension(filename, ".bz2")) {
+        bzip2_decoder* dec = new bzip2_decoder(filename.c_str());
+        if (dec->is_open()) {
+            return dec;
+        }
+        delete dec;
+    }
+#endif/*HAVE_LIBBZ2*/
+#ifdef  HAVE_LIBLZMA
+    if (has_extension(filename, ".xz")) {
+        xz_decoder* dec = new xz_decoder(filename.c_str());
+        if (dec->is_open()) {
+            return dec;
+        }
+        delete dec;
+    }
+#endif/*HAVE_LIBLZMA*/
+    return NULL;
+}
+
+/*
+ * Tests whether an in-process decoder is compiled in for a file name.
+ */
+inline static bool
+has_decoder(const std::string& filename)
+{
+#ifdef  HAVE_LIBZ
+    if (has_extension(filename, ".gz")) {
+        return true;
+    }
+#endif/*HAVE_LIBZ*/
+#ifdef  HAVE_LIBBZ2
+    if (has_extension(filename, ".bz2")) {
+        return true;
+    }
+#endif/*HAVE_LIBBZ2*/
+#ifdef  HAVE_LIBLZMA
+    if (has_extension(filename, ".xz")) {
+        return true;
+    }
+#endif/*HAVE_LIBLZMA*/
+    return false;
+}
+
+/*
+ * A stream buffer that decompresses a file on a background thread.
+ *  The buffer holds two large blocks: while the reader consumes one block,
+ *  a background thread decompresses the subsequent data into the other, so
+ *  that decoding overlaps with parsing.
+ */
+class decompress_streambuf : public std::streambuf
+{
+protected:
+    struct fill_task
+    {
+        decoder* dec;
+        char* buffer;
+        size_t size;
+        long result;
+
+        void operator()()
+        {
+            result = dec->read(buffer, size);
+        }
+    };
+
+    decoder* m_decoder;
+    std::vector<char> m_blocks[2];
+    int m_next;
+    bool m_end;
+    bool m_error;
+    fill_task m_task;
+    classias::background_task<fill_task> m_thread;
+
+public:
+    decompress_streambuf(decoder* dec, size_t block_size = 4 << 20)
+        : m_decoder(dec), m_next(0), m_end(false), m_error(false)
+    {
+        m_blocks[0].resize(block_size);
+        m_blocks[1].resize(block_size);
+        setg(NULL, NULL, NULL);
+        fill(0);
+    }
+
+    virtual ~decompress_streambuf()
+    {
+        m_thread.join();
+        delete m_decoder;
+    }
+
+    /*
+     * Tests whether an error occurred in decompression.
+     */
+    bool error() const
+    {
+        return m_error;
+    }
+
+protected:
+    void fill(int i)
+    {
+        m_task.dec = m_decoder;
+        m_task.buffer = &m_blocks[i][0];
+        m_task.size = m_blocks[i].size();
+        m_task.result = 0;
+        m_thread.start(m_task);
+    }
+
+    virtual int_type underflow()
+    {
+        if (gptr() < egptr()) {
+            return traits_type::to_int_type(*gptr());
+        }
+        if (m_end) {
+            return traits_type::eof();
+        }
+
+        // Receive the block decompressed in the background.
+        m_thread.join();
+        const int i = m_next;
+        const long n = m_task.result;
+        if (n <= 0) {
+            m_error = (n < 0);
+            m_end = true;
+            return traits_type::eof();
+        }
+
+        // Decompress the subsequent data into the other block, which is no
+        // longer read by the consumer.
+        m_next = 1 - i;
+        if ((size_t)n == m_blocks[i].size()) {
+            fill(m_next);
+        } else {
+            m_task.result = 0;
+        }
+
+        char* p = &m_blocks[i][0];
+        setg(p, p, p + n);
+        return traits_type::to_int_type(*gptr());
+    }
+};
+
+/*
+ * An input stream that reads a compressed file with an in-process decoder.
+ */
+class decompress_stream : public std::istream
+{
+protected:
+    decompress_streambuf* m_buf;
+
+public:
+    decompress_stream(const std::string& filename)
+        : std::istream(NULL), m_buf(NULL)
+    {
+        decoder* dec = create_decoder(filename);
+        if (dec != NULL) {
+            m_buf = new decompress_streambuf(dec);
+            this->init(m_buf);
+        } else {
+            this->setstate(std::ios::failbit);
+        }
+    }
+
+    virtual ~decompress_stream()
+    {
+        delete m_buf;
+    }
+
+    /*
+     * Tests whether an error occurred in decompression.
+     */
+    bool error() const
+    {
+        return (m_buf == NULL || m_buf->error());
+    }
+};
+
+#endif/*__DECOMPRESS_H__*/
@@ -0,0 +1,303 @@
+/*
+ *		Hashed model (a fixed-size weight array) for feature hashing.
+ *
+ * Copyright (c) 2008,2009 Naoaki Okazaki
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the names of the authors nor the names of its contributors
+ *       may be used to endorse or promote products derived from this
+ *       software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* $Id$ */
+
+#ifndef __HASHED_MODEL_H__
+#define __HASHED_MODEL_H__
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <classias/quark.h>
+#include <mapped_file.h>
+#include <util.h>
+
+/*
+ * The layout of a hashed model.
+ *
+ *  classias-train writes a hashed model when the attributes are hashed by
+ *  classias::hashing_quark (option '--hash'). A hashed model begins with a
+ *  header followed by arrays aligned to 8 bytes:
+ *
+ *  double          weights[num_weights]
+ *  size_t          reserved_offsets[num_reserved+1]
+ *  char            reserved_chars[reserved_chars]
+ *  size_t          label_offsets[num_labels+1]
+ *  char            label_chars[label_chars]
+ *
+ *  The reserved attributes (e.g., "__BIAS__") and the header fields bits
+ *  and signed_hash configure the hashing quark that maps an attribute to
+ *  an identifier #a (and a sign). The weight of the attribute is
+ *  weights[a] for binary and candidate models, and the weight of the
+ *  attribute paired with a label #l is weights[a * num_labels + l] for
+ *  multi-class models. The size of a model depends only on the number of
+ *  bits (and labels), but not on the number of distinct attributes.
+ */
+
+#define HASHED_MODEL_MAGIC      "CLSSHASH"
+#define HASHED_MODEL_VERSION    1
+
+struct hashed_model_header
+{
+    char    magic[8];
+    int     version;
+    int     byteorder;
+    int     sizeof_offset;
+    int     type;
+    int     bits;
+    int     signed_hash;
+    size_t  num_weights;
+    size_t  num_reserved;
+    size_t  reserved_chars;
+    size_t  num_labels;
+    size_t  label_chars;
+};
+
+inline static size_t
+hashed_model_aligned(size_t size)
+{
+    return (size + 7) / 8 * 8;
+}
+
+template <class value_type>
+static void
+hashed_model_write_array(std::ostream& os, const std::vector<value_type>& v)
+{
+    static const char zero[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    size_t size = sizeof(value_type) * v.size();
+    if (!v.empty()) {
+        os.write(reinterpret_cast<const char*>(&v[0]), size);
+    }
+    if (size % 8 != 0) {
+        os.write(zero, 8 - size % 8);
+    }
+}
+
+/*
+ * Writes a hashed model.
+ *  The labels are empty for binary and candidate models.
+ */
+inline static void
+write_hashed_model(
+    const std::string& filename,
+    int type,
+    const classias::hashing_quark& attributes,
+    const std::vector<std::string>& labels,
+    const std::vector<double>& weights
+    )
+{
+    std::vector<size_t> reserved_offsets(1, 0);
+    std::vector<char> reserved_chars;
+    for (size_t i = 0;i < attributes.num_reserved();++i) {
+        const std::string& name = attributes.to_item(i);
+        reserved_chars.insert(reserved_chars.end(), name.begin(), name.end());
+        reserved_offsets.push_back(reserved_chars.size());
+    }
+
+    std::vector<size_t> label_offsets(1, 0);
+    std::vector<char> label_chars;
+    for (size_t i = 0;i < labels.size();++i) {
+        label_chars.insert(label_chars.end(), labels[i].begin(), labels[i].end());
+        label_offsets.push_back(label_chars.size());
+    }
+
+    // Fill the header.
+    hashed_model_header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, HASHED_MODEL_MAGIC, 8);
+    header.version = HASHED_MODEL_VERSION;
+    header.byteorder = 0x12345678;
+    header.sizeof_offset = (int)sizeof(size_t);
+    header.type = type;
+    header.bits = attributes.bits();
+    header.signed_hash = attributes.is_signed() ? 1 : 0;
+    header.num_weights = weights.size();
+    header.num_reserved = attributes.num_reserved();
+    header.reserved_chars = reserved_chars.size();
+    header.num_labels = labels.size();
+    header.label_chars = label_chars.size();
+
+    // Write the hashed model.
+    std::ofstream os(filename.c_str(), std::ios::out | std::ios::binary);
+    if (os.fail()) {
+        throw invalid_model("failed to open a file for the hashed model", filename);
+    }
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (sizeof(header) % 8 != 0) {
+        static const char zero[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        os.write(zero, 8 - sizeof(header) % 8);
+    }
+    hashed_model_write_array(os, weights);
+    hashed_model_write_array(os, reserved_offsets);
+    hashed_model_write_array(os, reserved_chars);
+    hashed_model_write_array(os, label_offsets);
+    hashed_model_write_array(os, label_chars);
+    if (os.fail()) {
+        throw invalid_model("failed to write the hashed model", filename);
+    }
+}
+
+/*
+ * A read-only model mapped from a hashed model file.
+ *  operator[] with an attribute name yields the (signed) weight of the
+ *  attribute for binary and candidate models; operator[] with an index
+ *  yields weights[index] for multi-class models.
+ */
+class hashed_model
+{
+public:
+    typedef std::string key_type;
+    typedef double value_type;
+
+protected:
+    mapped_file m_file;
+    hashed_model_header m_header;
+    classias::hashing_quark m_attributes;
+    const double* m_weights;
+    const size_t* m_label_offsets;
+    const char* m_label_chars;
+
+public:
+    hashed_model()
+    {
+        std::memset(&m_header, 0, sizeof(m_header));
+        m_weights = NULL;
+        m_label_offsets = NULL;
+        m_label_chars = NULL;
+    }
+
+    virtual ~hashed_model()
+    {
+    }
+
+    /*
+     * Tests whether a file is a hashed model.
+     */
+    static bool is_hashed(std::istream& is)
+    {
+        char magic[8];
+        is.read(magic, 8);
+        bool ret = (!is.fail() && std::memcmp(magic, HASHED_MODEL_MAGIC, 8) == 0);
+        is.clear();
+        is.seekg(0, std::ios::beg);
+        return ret;
+    }
+
+    /*
+     * Maps a hashed model into memory.
+     */
+    void open(const std::string& filename)
+    {
+        if (!m_file.open(filename)) {
+            throw invalid_model("failed to open the hashed model", filename);
+        }
+        if (m_file.size() < sizeof(m_header)) {
+            throw invalid_model("broken hashed model", filename);
+        }
+        std::memcpy(&m_header, m_file.data(), sizeof(m_header));
+        if (std::memcmp(m_header.magic, HASHED_MODEL_MAGIC, 8) != 0 ||
+            m_header.version != HASHED_MODEL_VERSION ||
+            m_header.byteorder != 0x12345678 ||
+            m_header.sizeof_offset != (int)sizeof(size_t) ||
+            m_header.bits < 1 || 30 < m_header.bits) {
+            throw invalid_model("unsupported hashed model", filename);
+        }
+
+        const char* p = m_file.data();
+        size_t offset = hashed_model_aligned(sizeof(m_header));
+        m_weights = reinterpret_cast<const double*>(p + offset);
+        offset += hashed_model_aligned(sizeof(double) * m_header.num_weights);
+        const size_t* reserved_offsets = reinterpret_cast<const size_t*>(p + offset);
+        offset += hashed_model_aligned(sizeof(size_t) * (m_header.num_reserved+1));
+        const char* reserved_chars = p + offset;
+        offset += hashed_model_aligned(m_header.reserved_chars);
+        m_label_offsets = reinterpret_cast<const size_t*>(p + offset);
+        offset += hashed_model_aligned(sizeof(size_t) * (m_header.num_labels+1));
+        m_label_chars = p + offset;
+        offset += hashed_model_aligned(m_header.label_chars);
+        if (m_file.size() < offset) {
+            throw invalid_model("truncated hashed model", filename);
+        }
+
+        // Configure the quark for attributes.
+        m_attributes.set_bits(m_header.bits);
+        m_attributes.set_signed(m_header.signed_hash != 0);
+        for (size_t i = 0;i < m_header.num_reserved;++i) {
+            m_attributes.reserve(std::string(
+                reserved_chars + reserved_offsets[i],
+                reserved_offsets[i+1] - reserved_offsets[i]
+                ));
+        }
+        const size_t L = (0 < m_header.num_labels ? m_header.num_labels : 1);
+        if (m_header.num_weights != m_attributes.size() * L) {
+            throw invalid_model("inconsistent hashed model", filename);
+        }
+    }
+
+    int type() const
+    {
+        return m_header.type;
+    }
+
+    const classias::hashing_quark& attributes() const
+    {
+        return m_attributes;
+    }
+
+    size_t num_labels() const
+    {
+        return m_header.num_labels;
+    }
+
+    std::string label(size_t i) const
+    {
+        return std::string(
+            m_label_chars + m_label_offsets[i],
+            m_label_offsets[i+1] - m_label_offsets[i]
+            );
+    }
+
+    value_type operator[](const key_type& key) const
+    {
+        double sign;
+        size_t i = m_attributes.to_value(key.c_str(), key.size(), sign);
+        return sign * m_weights[i];
+    }
+
+    value_type operator[](size_t i) const
+    {
+        return m_weights[i];
+    }
+};
+
+#endif/*__HASHED_MODEL_H__*/
@@ -0,0 +1,177 @@
+/*
+ *		Read-only memory-mapped files.
+ *
+ * Copyright (c) 2008,2009 Naoaki Okazaki
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the names of the authors nor the names of its contributors
+ *       may be used to endorse or promote products derived from this
+ *       software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* $Id$ */
+
+#ifndef __MAPPED_FILE_H__
+#define __MAPPED_FILE_H__
+
+#include <cstddef>
+#include <string>
+
+#if     defined(_MSC_VER)
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif/*defined(_MSC_VER)*/
+
+/*
+ * A read-only view of a whole file mapped into memory.
+ *  The pages are loaded on demand by the operating system, and are shared
+ *  among processes that map the same file.
+ */
+class mapped_file
+{
+protected:
+    const char* m_data;
+    size_t m_size;
+#if     defined(_MSC_VER)
+    HANDLE m_file;
+    HANDLE m_mapping;
+#endif/*defined(_MSC_VER)*/
+
+public:
+    mapped_file() : m_data(NULL), m_size(0)
+    {
+#if     defined(_MSC_VER)
+        m_file = INVALID_HANDLE_VALUE;
+        m_mapping = NULL;
+#endif/*defined(_MSC_VER)*/
+    }
+
+    virtual ~mapped_file()
+    {
+        close();
+    }
+
+    bool open(const std::string& path)
+    {
+        close();
+
+#if     defined(_MSC_VER)
+        m_file = CreateFileA(
+            path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+            OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (m_file == INVALID_HANDLE_VALUE) {
+            return false;
+        }
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_file, &size)) {
+            close();
+            return false;
+        }
+        m_size = (size_t)size.QuadPart;
+        if (m_size == 0) {
+            return true;
+        }
+
+        m_mapping = CreateFileMappingA(m_file, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (m_mapping == NULL) {
+            close();
+            return false;
+        }
+        m_data = (const char*)MapViewOfFile(m_mapping, FILE_MAP_READ, 0, 0, 0);
+        if (m_data == NULL) {
+            close();
+            return false;
+        }
+#else
+        int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            return false;
+        }
+
+        struct stat st;
+        if (fstat(fd, &st) != 0) {
+            ::close(fd);
+            return false;
+        }
+        m_size = (size_t)st.st_size;
+        if (m_size == 0) {
+            ::close(fd);
+            return true;
+        }
+
+        void *p = mmap(NULL, m_size, PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd);
+        if (p == MAP_FAILED) {
+            m_size = 0;
+            return false;
+        }
+        m_data = (const char*)p;
+#endif/*defined(_MSC_VER)*/
+
+        return true;
+    }
+
+    void close()
+    {
+#if     defined(_MSC_VER)
+        if (m_data != NULL) {
+            UnmapViewOfFile(m_data);
+        }
+        if (m_mapping != NULL) {
+            CloseHandle(m_mapping);
+            m_mapping = NULL;
+        }
+        if (m_file != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_file);
+            m_file = INVALID_HANDLE_VALUE;
+        }
+#else
+        if (m_data != NULL) {
+            munmap((void*)m_data, m_size);
+        }
+#endif/*defined(_MSC_VER)*/
+        m_data = NULL;
+        m_size = 0;
+    }
+
+    const char* data() const
+    {
+        return m_data;
+    }
+
+    size_t size() const
+    {
+        return m_size;
+    }
+
+private:
+    // Non-copyable.
+    mapped_file(const mapped_file&);
+    mapped_file& operator=(const mapped_file&);
+};
+
+#endif/*__MAPPED_FILE_H__*/
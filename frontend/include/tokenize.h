@@ -28,8 +28,180 @@
 #ifndef __TOKENIZE_H__
 #define __TOKENIZE_H__
 
+#include <cstdlib>
+#include <cstring>
 #include <string>
 
+/**
+ * A token, i.e., a range of characters in a source string.
+ *  A token does not own the characters; it is valid only while the source
+ *  string lives and remains unchanged.
+ */
+template <class char_type>
+class basic_token
+{
+public:
+    /// A type representing a string.
+    typedef typename std::basic_string<char_type> string_type;
+    /// A type providing a read-only random-access iterator for characters.
+    typedef const char_type* const_iterator;
+    /// The special value of a position indicating "not found".
+    static const size_t npos = (size_t)-1;
+
+protected:
+    const char_type* m_first;
+    const char_type* m_last;
+
+public:
+    /**
+     * Constructs an empty token.
+     */
+    basic_token() : m_first(NULL), m_last(NULL)
+    {
+    }
+
+    /**
+     * Constructs a token from a range of characters.
+     *  @param  first       The pointer to the first character.
+     *  @param  last        The pointer just beyond the last character.
+     */
+    basic_token(const char_type* first, const char_type* last)
+        : m_first(first), m_last(last)
+    {
+    }
+
+    /**
+     * Returns a pointer to the first character.
+     *  @retval const_iterator  The pointer to the first character.
+     */
+    inline const_iterator begin() const
+    {
+        return m_first;
+    }
+
+    /**
+     * Returns a pointer just beyond the last character.
+     *  @retval const_iterator  The pointer just beyond the last character.
+     */
+    inline const_iterator end() const
+    {
+        return m_last;
+    }
+
+    /**
+     * Returns the number of characters in the token.
+     *  @retval size_t      The length of the token.
+     */
+    inline size_t size() const
+    {
+        return (size_t)(m_last - m_first);
+    }
+
+    /**
+     * Tests if the token is empty.
+     *  @retval bool        \c true if the token is empty.
+     */
+    inline bool empty() const
+    {
+        return m_first == m_last;
+    }
+
+    /**
+     * Accesses to a character in the token.
+     *  @param  i           The index of the character.
+     *  @retval char_type   The character.
+     */
+    inline char_type operator[](size_t i) const
+    {
+        return m_first[i];
+    }
+
+    /**
+     * Finds the last occurrence of a character.
+     *  @param  c           The character.
+     *  @retval size_t      The position of the character, or \c npos if
+     *                      the token does not contain the character.
+     */
+    inline size_t rfind(char_type c) const
+    {
+        for (const char_type* p = m_last;p != m_first;) {
+            if (*--p == c) {
+                return (size_t)(p - m_first);
+            }
+        }
+        return npos;
+    }
+
+    /**
+     * Returns a part of the token.
+     *  @param  pos         The position of the first character.
+     *  @param  n           The maximum number of characters.
+     *  @retval basic_token The token for the part.
+     */
+    inline basic_token substr(size_t pos, size_t n = npos) const
+    {
+        if (size() < pos) {
+            pos = size();
+        }
+        if (size() - pos < n) {
+            n = size() - pos;
+        }
+        return basic_token(m_first + pos, m_first + pos + n);
+    }
+
+    /**
+     * Copies the characters into a string.
+     *  Reuse the same string object in a loop so that the copy does not
+     *  allocate memory once the string has grown enough.
+     *  @param  str         The string that receives the characters.
+     */
+    inline void assign_to(string_type& str) const
+    {
+        str.assign(m_first, m_last);
+    }
+
+    /**
+     * Returns a copy of the token as a string.
+     *  @retval string_type The string.
+     */
+    inline string_type str() const
+    {
+        return string_type(m_first, m_last);
+    }
+
+    /**
+     * Tests whether the token is identical to a null-terminated string.
+     *  @param  s           The null-terminated string.
+     *  @retval bool        \c true if the token and string are identical.
+     */
+    inline bool operator==(const char_type* s) const
+    {
+        const char_type* p = m_first;
+        for (;p != m_last;++p, ++s) {
+            if (*s == 0 || *p != *s) {
+                return false;
+            }
+        }
+        return (*s == 0);
+    }
+
+    /**
+     * Tests whether the token is different from a null-terminated string.
+     *  @param  s           The null-terminated string.
+     *  @retval bool        \c true if the token and string are different.
+     */
+    inline bool operator!=(const char_type* s) const
+    {
+        return !operator==(s);
+    }
+};
+
+/**
+ * A tokenizer that splits a string by a separator character.
+ *  The tokenizer neither copies the source string nor allocates memory for
+ *  tokens: an iterator yields a \ref basic_token pointing to the source
+ *  string, which must outlive the tokenizer and its iterators.
+ */
 template <class char_type>
 class basic_tokenizer
 {
@@ -38,93 +210,61 @@ protected:
     typedef typename std::basic_string<char_type> string_type;
 
 public:
+    /// A type representing a token.
+    typedef basic_token<char_type> token_type;
+
     /**
      * Iterator class for tokenizer.
      */
     class iterator
     {
     protected:
-        typedef typename string_type::const_iterator string_const_iterator;
-
         char_type m_sep;
-        string_const_iterator m_it;
-        string_const_iterator m_prev;
-        string_const_iterator m_end;
+        const char_type* m_it;
+        const char_type* m_prev;
+        const char_type* m_end;
 
-        string_type m_token;
+        token_type m_token;
 
     public:
         /**
          * Constructs an iterator.
          */
         iterator()
-            : m_sep(' ')
+            : m_sep(' '), m_it(NULL), m_prev(NULL), m_end(NULL)
         {
         }
 
         /**
          * Constructs an iterator.
-         *  @param  it          The iterator pointing to the first character.
-         *  @param  end         The iterator pointing just beyond the last character.
+         *  @param  it          The pointer to the first character.
+         *  @param  end         The pointer just beyond the last character.
          *  @param  sep         A separator.
          */
         iterator(
-            string_const_iterator it,
-            string_const_iterator end,
+            const char_type* it,
+            const char_type* end,
             char_type sep
             )
-            : m_it(it), m_prev(it), m_end(end), m_sep(sep)
+            : m_sep(sep), m_it(it), m_prev(it), m_end(end)
         {
             next();
         }
 
-        /**
-         * Destructs the iterator.
-         */
-        virtual ~iterator()
-        {
-        }
-
-        /**
-         * Constructs an iterator by cloning another iterator object.
-         *  @param  x           The iterator that is to be cloned to the
-         *                      target iterator.
-         */
-        iterator(const iterator& x)
-        {
-            operator=(x);
-        }
-
-        /**
-         * Copies the content from another iterator object.
-         *  @param  x           The iterator that is to be cloned to the
-         *                      target iterator.
-         *  @retval iterator&   The reference to this object.
-         */
-        inline iterator& operator=(const iterator& x)
-        {
-            m_it = x.m_it;
-            m_prev = x.m_prev;
-            m_end = x.m_end;
-            m_sep = x.m_sep;
-            m_token = x.m_token;
-            return *this;
-        }
-
         /**
          * Accesses to the current token.
-         *  @retval string_type The current token.
+         *  @retval token_type  The current token.
          */
-        inline const string_type& operator*() const
+        inline const token_type& operator*() const
         {
             return m_token;
         }
 
         /**
          * Accesses to the pointer to the current token.
-         *  @retval string_type*    The pointer to the current token.
+         *  @retval token_type* The pointer to the current token.
          */
-        inline const string_type* operator->() const
+        inline const token_type* operator->() const
         {
             return &m_token;
         }
@@ -169,33 +309,48 @@ public:
             m_prev = m_it;
 
             if (m_it != m_end) {
-                m_token.clear();
-                for (;m_it != m_end;++m_it) {
-                    if (*m_it == m_sep) {
-                        ++m_it;
-                        break;
-                    }
-                    m_token += *m_it;
+                const char_type* first = m_it;
+                while (m_it != m_end && *m_it != m_sep) {
+                    ++m_it;
+                }
+                m_token = token_type(first, m_it);
+                if (m_it != m_end) {
+                    ++m_it;
                 }
             }
         }
     };
 
 protected:
-    string_type m_str;
+    const char_type* m_first;
+    const char_type* m_last;
     char_type m_sep;
-    iterator m_end;
 
 public:
     /**
      * Constructs a tokenizer object.
-     *  @param  str         the string to be tokenized.
+     *  @param  str         the string to be tokenized; the tokenizer refers
+     *                      to the string without copying it.
      *  @param  sep         a separator character for tokenization.
      */
     basic_tokenizer(const string_type& str, const char_type sep = '\t')
-        : m_str(str), m_sep(sep)
+        : m_first(str.data()), m_last(str.data() + str.size()), m_sep(sep)
+    {
+    }
+
+    /**
+     * Constructs a tokenizer object for a range of characters.
+     *  @param  first       the pointer to the first character.
+     *  @param  last        the pointer just beyond the last character.
+     *  @param  sep         a separator character for tokenization.
+     */
+    basic_tokenizer(
+        const char_type* first,
+        const char_type* last,
+        const char_type sep = '\t'
+        )
+        : m_first(first), m_last(last), m_sep(sep)
     {
-        m_end = iterator(m_str.end(), m_str.end(), m_sep);
     }
 
     /**
@@ -213,7 +368,7 @@ public:
      */
     inline iterator begin() const
     {
-        return iterator(m_str.begin(), m_str.end(), m_sep);
+        return iterator(m_first, m_last, m_sep);
     }
 
     /**
@@ -223,10 +378,54 @@ public:
      */
     inline iterator end() const
     {
-        return m_end;
+        return iterator(m_last, m_last, m_sep);
     }
 };
 
+typedef basic_token<char> token;
 typedef basic_tokenizer<char> tokenizer;
 
+/**
+ * Converts a token into a floating-point value.
+ *  @param  t           The token.
+ *  @retval double      The value.
+ */
+inline static double
+token_to_double(const token& t)
+{
+    // Copy the token to a buffer on the stack; the characters of a token
+    // are not necessarily terminated by a null character.
+    char buffer[64];
+    if (t.size() < sizeof(buffer)) {
+        std::memcpy(buffer, t.begin(), t.size());
+        buffer[t.size()] = 0;
+        return std::atof(buffer);
+    } else {
+        return std::atof(t.str().c_str());
+    }
+}
+
+/**
+ * Splits a token into a name and value.
+ *  The value follows the last separator in the token; the value is 1 if the
+ *  token has no separator. The name refers to the characters of the token.
+ *  @param  str         The token.
+ *  @param  name        The token that receives the name.
+ *  @param  value       The value.
+ *  @param  separator   The separator character.
+ */
+inline static void
+get_name_value(
+    const token& str, token& name, double& value, char separator)
+{
+    size_t col = str.rfind(separator);
+    if (col == token::npos) {
+        name = str;
+        value = 1.;
+    } else {
+        value = token_to_double(str.substr(col + 1));
+        name = str.substr(0, col);
+    }
+}
+
 #endif/*__TOKENIZE_H__*/
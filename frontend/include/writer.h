@@ -0,0 +1,197 @@
+/*
+ *		Buffered writer of text.
+ *
+ * Copyright (c) 2008,2009 Naoaki Okazaki
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the names of the authors nor the names of its contributors
+ *       may be used to endorse or promote products derived from this
+ *       software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* $Id$ */
+
+#ifndef __WRITER_H__
+#define __WRITER_H__
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ostream>
+#include <string>
+
+/*
+ * Formats a floating-point value into a buffer.
+ *  With a positive precision, the value is formatted as "%g" of the
+ *  precision, which is what an iostream does with the precision. Otherwise
+ *  the value is formatted with the shortest digits (up to 17 significant
+ *  digits) that convert back to the identical value; "%g" strips trailing
+ *  zeros, and a value with fewer than 15 significant digits is written as
+ *  it is with the precision 15.
+ *  @param  buffer      The buffer of at least 32 characters.
+ *  @param  v           The value.
+ *  @param  precision   The number of significant digits, or zero.
+ *  @return int         The number of characters written.
+ */
+inline int format_double(char *buffer, double v, int precision)
+{
+    if (0 < precision) {
+        return std::sprintf(buffer, "%.*g", precision, v);
+    }
+    for (int p = 15;p < 17;++p) {
+        int n = std::sprintf(buffer, "%.*g", p, v);
+        if (std::strtod(buffer, NULL) == v) {
+            return n;
+        }
+    }
+    return std::sprintf(buffer, "%.17g", v);
+}
+
+/*
+ * A buffered writer of text.
+ *
+ *  This class accumulates the output in a large buffer, and writes the
+ *  buffer to the stream only when it exceeds the capacity or when flush()
+ *  is called; unlike std::endl, a newline character never flushes the
+ *  stream. A writer without a stream simply accumulates the output, e.g.,
+ *  for a worker thread whose output is written later by another writer.
+ *  The destructor writes the remaining output to the stream.
+ */
+class text_writer
+{
+public:
+    enum {
+        /// The size of the buffer that triggers a write to the stream.
+        CAPACITY = 1 << 20,
+    };
+
+protected:
+    std::ostream*   m_os;
+    std::string     m_buffer;
+    int             m_precision;
+
+public:
+    text_writer(std::ostream* os = NULL, int precision = 0)
+        : m_os(os), m_precision(precision)
+    {
+        if (m_os != NULL) {
+            m_buffer.reserve(CAPACITY + 256);
+        }
+    }
+
+    virtual ~text_writer()
+    {
+        drain();
+    }
+
+    /*
+     * Sets the number of significant digits of values (zero for the
+     * shortest digits of the exact value).
+     */
+    void precision(int precision)
+    {
+        m_precision = precision;
+    }
+
+    const char* data() const
+    {
+        return m_buffer.data();
+    }
+
+    size_t size() const
+    {
+        return m_buffer.size();
+    }
+
+    void clear()
+    {
+        m_buffer.clear();
+    }
+
+    void write(const char *str, size_t n)
+    {
+        m_buffer.append(str, n);
+        check();
+    }
+
+    text_writer& operator<<(char c)
+    {
+        m_buffer += c;
+        check();
+        return *this;
+    }
+
+    text_writer& operator<<(const char *str)
+    {
+        write(str, std::strlen(str));
+        return *this;
+    }
+
+    text_writer& operator<<(const std::string& str)
+    {
+        write(str.data(), str.size());
+        return *this;
+    }
+
+    text_writer& operator<<(int v)
+    {
+        char buffer[32];
+        write(buffer, std::sprintf(buffer, "%d", v));
+        return *this;
+    }
+
+    text_writer& operator<<(double v)
+    {
+        char buffer[32];
+        write(buffer, format_double(buffer, v, m_precision));
+        return *this;
+    }
+
+    /*
+     * Writes the buffer to the stream, and flushes the stream.
+     */
+    void flush()
+    {
+        drain();
+        if (m_os != NULL) {
+            m_os->flush();
+        }
+    }
+
+protected:
+    inline void check()
+    {
+        if (m_os != NULL && CAPACITY <= m_buffer.size()) {
+            drain();
+        }
+    }
+
+    void drain()
+    {
+        if (m_os != NULL && !m_buffer.empty()) {
+            m_os->write(m_buffer.data(), (std::streamsize)m_buffer.size());
+            m_buffer.clear();
+        }
+    }
+};
+
+#endif/*__WRITER_H__*/
@@ -46,11 +46,14 @@
 #include "option.h"
 #include "tokenize.h"
 #include "defaultmap.h"
+#include "compiled_model.h"
+#include "pipeline.h"
+#include <hashed_model.h>
 #include <util.h>
 
 typedef defaultmap<std::string, double> model_type;
-typedef classias::classify::linear_binary_logistic<model_type> classifier_type;
 
+template <class classifier_type>
 static void
 parse_line(
     classifier_type& inst,
@@ -61,7 +64,8 @@ parse_line(
     )
 {
     double value;
-    std::string name;
+    token name;
+    std::string str;
 
     // Split the line with tab characters.
     tokenizer values(line, opt.token_separator);
@@ -87,7 +91,8 @@ parse_line(
     for (++itv;itv != values.end();++itv) {
         if (!itv->empty()) {
             get_name_value(*itv, name, value, opt.value_separator);
-            inst.set(name, value);
+            name.assign_to(str);
+            inst.set(str, value);
         }
     }
 }
@@ -99,8 +104,8 @@ read_model(
     option& opt
     )
 {
+    std::string line;
     for (;;) {
-        std::string line;
         std::getline(is, line);
         if (is.eof()) {
             break;
@@ -124,39 +129,39 @@ read_model(
     }
 }
 
-int binary_tag(option& opt, std::ifstream& ifs)
+template <class model_type>
+class binary_tagger
 {
-    int lines = 0;
-    std::istream& is = opt.is;
-    std::ostream& os = opt.os;
-    classias::accuracy acc;
-    classias::precall pr(2);
-
-    // Load a model.
-    model_type model;
-    read_model(model, ifs, opt);
+protected:
+    typedef classias::classify::linear_binary_logistic<model_type> classifier_type;
+
+    const option*       m_opt;
+    const model_type*   m_model;
+    classias::accuracy  m_acc;
+    classias::precall   m_pr;
+
+public:
+    binary_tagger(const option& opt, const model_type& model)
+        : m_opt(&opt), m_model(&model), m_pr(2)
+    {
+    }
 
-    for (;;) {
-        // Read a line.
-        std::string line;
-        std::getline(is, line);
-        if (is.eof()) {
-            break;
-        }
-        ++lines;
+    void operator()(text_writer& os, const std::string& line, int lines)
+    {
+        const option& opt = *m_opt;
 
         // An empty line or comment line.
         if (line.empty() || line.compare(0, 1, "#") == 0) {
             // Output the comment line if necessary.
             if (opt.output & option::OUTPUT_COMMENT) {
-                os << line << std::endl;
+                os << line << '\n';
             }
-            continue;
+            return;
         }
 
         // Parse the line and classify the instance.
         bool rlabel;
-        classifier_type inst(model);
+        classifier_type inst(*m_model);
         parse_line(inst, rlabel, opt, line, lines);
 
         // Determine whether we output this instance or not.
@@ -178,24 +183,61 @@ int binary_tag(option& opt, std::ifstream& ifs)
                 os << opt.value_separator << inst.score();
             }
 
-            os << std::endl;
+            os << '\n';
         }
 
         // Accumulate the performance.
         if (opt.test) {
             int rl = static_cast<int>(rlabel);
             int ml = static_cast<int>(static_cast<bool>(inst));
-            acc.set(ml == rl);
-            pr.set(ml, rl);
+            m_acc.set(ml == rl);
+            m_pr.set(ml, rl);
         }
     }
 
+    void merge(const binary_tagger& rho)
+    {
+        m_acc.merge(rho.m_acc);
+        m_pr.merge(rho.m_pr);
+    }
+
+    void output(std::ostream& os) const
+    {
+        int positive_labels[] = {1};
+        m_acc.output(os);
+        m_pr.output_micro(os, positive_labels, positive_labels+1);
+    }
+};
+
+template <class model_type>
+static int
+tag(
+    option& opt,
+    const model_type& model
+    )
+{
+    binary_tagger<model_type> tagger(opt, model);
+    tag_stream(opt.is, opt.os, tagger, opt);
+
     // Output the performance if necessary.
     if (opt.test) {
-        int positive_labels[] = {1};
-        acc.output(os);
-        pr.output_micro(os, positive_labels, positive_labels+1);
+        tagger.output(opt.os);
     }
 
     return 0;
 }
+
+int binary_tag(option& opt, std::ifstream& ifs, const compiled_model* cmodel, const hashed_model* hmodel)
+{
+    // Use the compiled or hashed model if any.
+    if (cmodel != NULL) {
+        return tag(opt, *cmodel);
+    } else if (hmodel != NULL) {
+        return tag(opt, *hmodel);
+    }
+
+    // Load a model.
+    model_type model;
+    read_model(model, ifs, opt);
+    return tag(opt, model);
+}
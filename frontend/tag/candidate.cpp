@@ -47,12 +47,14 @@
 #include "option.h"
 #include "tokenize.h"
 #include "defaultmap.h"
+#include "compiled_model.h"
+#include "pipeline.h"
+#include <hashed_model.h>
 #include <util.h>
 
 typedef defaultmap<std::string, double> model_type;
 typedef std::vector<std::string> labels_type;
 typedef std::vector<std::string> comments_type;
-typedef classias::classify::linear_multi_logistic<model_type> classifier_type;
 
 class feature_generator
 {
@@ -81,6 +83,7 @@ public:
     }
 };
 
+template <class classifier_type>
 static void
 parse_line(
     classifier_type& inst,
@@ -93,7 +96,8 @@ parse_line(
     )
 {
     double value;
-    std::string name;
+    token name;
+    std::string str;
 
     // Split the line with tab characters.
     tokenizer values(line, opt.token_separator);
@@ -108,15 +112,15 @@ parse_line(
     }
 
     // Set the truth value for this candidate.
-    if (itv->compare(0, 1, "+") == 0) {
+    if ((*itv)[0] == '+') {
         truth = true;
-    } else if (itv->compare(0, 1, "-") == 0) {
+    } else if ((*itv)[0] == '-') {
         truth = false;
     } else {
         throw invalid_data("a class label must begins with '+' or '-'", line, lines);
     }
 
-    label = itv->substr(1);
+    itv->substr(1).assign_to(label);
 
     // Create a new candidate.
     int i = inst.size();
@@ -126,7 +130,8 @@ parse_line(
     for (++itv;itv != values.end();++itv) {
         if (!itv->empty()) {
             get_name_value(*itv, name, value, opt.value_separator);
-            inst.set(i, fgen, name, 0, value);
+            name.assign_to(str);
+            inst.set(i, fgen, str, 0, value);
         }
     }
 }
@@ -138,8 +143,8 @@ read_model(
     const option& opt
     )
 {
+    std::string line;
     for (;;) {
-        std::string line;
         std::getline(is, line);
         if (is.eof()) {
             break;
@@ -159,6 +164,7 @@ read_model(
     }
 }
 
+template <class classifier_type>
 static void output_model_candidates(
     std::ostream& os,
     classifier_type& inst,
@@ -196,6 +202,7 @@ static void output_model_candidates(
     os << "@eoi" << std::endl;
 }
 
+template <class classifier_type>
 static void output_model_label(
     std::ostream& os,
     classifier_type& inst,
@@ -217,154 +224,187 @@ static void output_model_label(
     os << std::endl;
 }
 
-int candidate_tag(option& opt, std::ifstream& ifs)
+template <class model_type>
+class candidate_tagger
 {
-    int rl = -1;
-    int lines = 0;
-    feature_generator fgen;
-    std::istream& is = opt.is;
-    std::ostream& os = opt.os;
-    bool inner = false;
-    std::string comment_outer, comment_inner;
-    comments_type comments;
+protected:
+    typedef classias::classify::linear_multi_logistic<model_type> classifier_type;
 
-    // Load a model.
-    model_type model;
-    read_model(model, ifs, opt);
+    const option*       m_opt;
+    classifier_type     m_inst;
+    classias::accuracy  m_acc;
 
-    // Create an instance of a classifier on the model.
-    classifier_type inst(model);
-    labels_type labels;
+    // The state of the instance being read.
+    int                 m_rl;
+    bool                m_inner;
+    std::string         m_comment_outer;
+    std::string         m_comment_inner;
+    comments_type       m_comments;
+    labels_type         m_labels;
 
-    // Objects for performance evaluation.
-    classias::accuracy acc;
-    classias::precall pr(labels.size());
+public:
+    candidate_tagger(const option& opt, const model_type& model)
+        : m_opt(&opt), m_inst(model), m_rl(-1), m_inner(false)
+    {
+    }
 
-    for (;;) {
-        // Read a line.
-        std::string line;
-        std::getline(is, line);
-        if (is.eof()) {
-            break;
-        }
-        ++lines;
+    void operator()(text_writer& os, const std::string& line, int lines)
+    {
+        const option& opt = *m_opt;
+        feature_generator fgen;
 
         // An empty line or comment line.
         if (line.empty() || line.compare(0, 1, "#") == 0) {
             if (opt.output & option::OUTPUT_COMMENT) {
-                if (0 < inst.size()) {
+                if (0 < m_inst.size()) {
                     // Store the comment line to the current instance.
-                    comments[inst.size()-1] += line;
-                    comments[inst.size()-1] += '\n';
-                } else if (inner) {
-                    comment_inner += line;
-                    comment_inner += '\n';
+                    m_comments[m_inst.size()-1] += line;
+                    m_comments[m_inst.size()-1] += '\n';
+                } else if (m_inner) {
+                    m_comment_inner += line;
+                    m_comment_inner += '\n';
                 } else {
-                    comment_outer += line;
-                    comment_outer += '\n';
+                    m_comment_outer += line;
+                    m_comment_outer += '\n';
                 }
             }
-            continue;
+            return;
         }
 
         if (line.compare(0, 4, "@boi") == 0) {
             // Begin of an instance.
-            rl = -1;
-            inst.clear();
-            labels.clear();
-            comments.clear();
-            inner = true;
+            m_rl = -1;
+            m_inst.clear();
+            m_labels.clear();
+            m_comments.clear();
+            m_inner = true;
 
         } else if (line == "@eoi") {
-            inst.finalize();
+            m_inst.finalize();
 
             // Determine whether we output this instance or not.
             if (opt.condition == option::CONDITION_ALL ||
-                (opt.condition == option::CONDITION_FALSE && rl != inst.argmax())) {
+                (opt.condition == option::CONDITION_FALSE && m_rl != m_inst.argmax())) {
 
                 // Output BOI.
-                os << comment_outer;
-                os << "@boi" << std::endl;
-                os << comment_inner;
+                os << m_comment_outer;
+                os << "@boi" << '\n';
+                os << m_comment_inner;
 
                 if (opt.output & option::OUTPUT_ALL) {
-                    for (int i = 0;i < inst.size();++i) {
+                    for (int i = 0;i < m_inst.size();++i) {
                         // Output the reference label.
                         if (opt.output & option::OUTPUT_RLABEL) {
-                            os << ((i == rl) ? '+' : '-');
+                            os << ((i == m_rl) ? '+' : '-');
                         }
                         // Output the predicted label.
-                        os << ((i == inst.argmax()) ? '+' : '-');
-                        os << labels[i];
+                        os << ((i == m_inst.argmax()) ? '+' : '-');
+                        os << m_labels[i];
 
                         // Output the score/probability if necessary.
                         if (opt.output & option::OUTPUT_PROBABILITY) {
-                            os << opt.value_separator << inst.prob(i);
+                            os << opt.value_separator << m_inst.prob(i);
                         } else if (opt.output & option::OUTPUT_SCORE) {
-                            os << opt.value_separator << inst.score(i);
+                            os << opt.value_separator << m_inst.score(i);
                         }
 
-                        os << std::endl;
-                        os << comments[i];
+                        os << '\n';
+                        os << m_comments[i];
                     }
 
                 } else {
                     // Output the reference label.
                     if (opt.output & option::OUTPUT_RLABEL) {
-                        os << labels[rl] << opt.token_separator;
+                        os << m_labels[m_rl] << opt.token_separator;
                     }
                     // Output the predicted label.
-                    os << labels[inst.argmax()];
+                    os << m_labels[m_inst.argmax()];
 
                     // Output the score/probability if necessary.
                     if (opt.output & option::OUTPUT_PROBABILITY) {
-                        os << opt.value_separator << inst.prob(inst.argmax());
+                        os << opt.value_separator << m_inst.prob(m_inst.argmax());
                     } else if (opt.output & option::OUTPUT_SCORE) {
-                        os << opt.value_separator << inst.score(inst.argmax());
+                        os << opt.value_separator << m_inst.score(m_inst.argmax());
                     }
 
-                    os << std::endl;
+                    os << '\n';
 
                 }
 
                 // Output EOI.
-                os << "@eoi" << std::endl;
+                os << "@eoi" << '\n';
             }
 
             // Accumulate the performance.
             if (opt.test) {
-                acc.set(inst.argmax() == rl);
+                m_acc.set(m_inst.argmax() == m_rl);
             }
 
-            rl = -1;
-            inst.clear();
-            labels.clear();
-            comments.clear();
-            comment_inner.clear();
-            comment_outer.clear();
-            inner = false;
+            m_rl = -1;
+            m_inst.clear();
+            m_labels.clear();
+            m_comments.clear();
+            m_comment_inner.clear();
+            m_comment_outer.clear();
+            m_inner = false;
 
         } else {
             std::string label;
             bool truth = false;
-            parse_line(inst, fgen, label, truth, opt, line, lines);
+            parse_line(m_inst, fgen, label, truth, opt, line, lines);
             if (truth) {
-                rl = inst.size() - 1;
+                m_rl = m_inst.size() - 1;
             }
-            labels.push_back(label);
-            if (labels.size() != inst.size()) {
+            m_labels.push_back(label);
+            if (m_labels.size() != m_inst.size()) {
                 throw invalid_data("", line, lines);
             }
-            if ((int)comments.size() < inst.size()) {
-                comments.resize(inst.size());
+            if ((int)m_comments.size() < m_inst.size()) {
+                m_comments.resize(m_inst.size());
             }
         }
     }
 
+    void merge(const candidate_tagger& rho)
+    {
+        m_acc.merge(rho.m_acc);
+    }
+
+    void output(std::ostream& os) const
+    {
+        m_acc.output(os);
+    }
+};
+
+template <class model_type>
+static int
+tag(
+    option& opt,
+    const model_type& model
+    )
+{
+    candidate_tagger<model_type> tagger(opt, model);
+    tag_stream(opt.is, opt.os, tagger, opt, true);
+
     // Output the performance if necessary.
     if (opt.test) {
-        acc.output(os);
+        tagger.output(opt.os);
     }
 
     return 0;
 }
+
+int candidate_tag(option& opt, std::ifstream& ifs, const compiled_model* cmodel, const hashed_model* hmodel)
+{
+    // Use the compiled or hashed model if any.
+    if (cmodel != NULL) {
+        return tag(opt, *cmodel);
+    } else if (hmodel != NULL) {
+        return tag(opt, *hmodel);
+    }
+
+    // Load a model.
+    model_type model;
+    read_model(model, ifs, opt);
+    return tag(opt, model);
+}
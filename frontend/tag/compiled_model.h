@@ -0,0 +1,398 @@
+/*
+ *		Compiled (binary) model for the tagger.
+ *
+ * Copyright (c) 2008,2009 Naoaki Okazaki
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the names of the authors nor the names of its contributors
+ *       may be used to endorse or promote products derived from this
+ *       software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* $Id$ */
+
+#ifndef __COMPILED_MODEL_H__
+#define __COMPILED_MODEL_H__
+
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <string>
+#include <vector>
+
+#include <mapped_file.h>
+#include <util.h>
+
+/*
+ * The layout of a compiled model.
+ *
+ *  A compiled model begins with a header followed by arrays aligned to 8
+ *  bytes:
+ *
+ *  double          weights[num_features]
+ *  unsigned int    hashes[num_features]
+ *  unsigned int    slots[num_slots]
+ *  size_t          feature_offsets[num_features+1]
+ *  char            feature_chars[feature_chars]
+ *  size_t          label_offsets[num_labels+1]
+ *  char            label_chars[label_chars]
+ *
+ *  The name of a feature #i is the byte sequence [feature_offsets[i],
+ *  feature_offsets[i+1]) of feature_chars; it is identical to the feature
+ *  name in a text model (e.g., "attribute\tlabel" for a multi-class model).
+ *  The hash index (slots) is an open-addressing table whose size is a power
+ *  of two and at least twice the number of features; a slot stores the
+ *  feature number plus one (zero for an empty slot). A lookup computes the
+ *  FNV-1a hash of a name, probes the slots linearly from (hash & mask), and
+ *  compares the names only when the stored hash values agree. The names are
+ *  kept in the model so that a lookup of an unknown feature, which is very
+ *  common in tagging, is answered exactly.
+ */
+
+#define COMPILED_MODEL_MAGIC    "CLSSMODL"
+#define COMPILED_MODEL_VERSION  1
+
+struct compiled_model_header
+{
+    char    magic[8];
+    int     version;
+    int     byteorder;
+    int     sizeof_offset;
+    int     type;
+    size_t  num_features;
+    size_t  num_slots;
+    size_t  feature_chars;
+    size_t  num_labels;
+    size_t  label_chars;
+};
+
+inline static unsigned int
+compiled_model_hash(const char *str, size_t n)
+{
+    unsigned int h = 2166136261U;
+    for (size_t i = 0;i < n;++i) {
+        h ^= (unsigned char)str[i];
+        h *= 16777619U;
+    }
+    return h;
+}
+
+inline static size_t
+compiled_model_aligned(size_t size)
+{
+    return (size + 7) / 8 * 8;
+}
+
+template <class value_type>
+static void
+compiled_model_write_array(std::ostream& os, const std::vector<value_type>& v)
+{
+    static const char zero[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    size_t size = sizeof(value_type) * v.size();
+    if (!v.empty()) {
+        os.write(reinterpret_cast<const char*>(&v[0]), size);
+    }
+    if (size % 8 != 0) {
+        os.write(zero, 8 - size % 8);
+    }
+}
+
+/*
+ * A read-only model mapped from a compiled model file.
+ *  This class provides operator[] compatible with defaultmap, so that the
+ *  classifiers can use a compiled model in place of a text model.
+ */
+class compiled_model
+{
+public:
+    typedef std::string key_type;
+    typedef double value_type;
+
+protected:
+    mapped_file m_file;
+    compiled_model_header m_header;
+    const double* m_weights;
+    const unsigned int* m_hashes;
+    const unsigned int* m_slots;
+    const size_t* m_feature_offsets;
+    const char* m_feature_chars;
+    const size_t* m_label_offsets;
+    const char* m_label_chars;
+
+public:
+    compiled_model()
+    {
+        std::memset(&m_header, 0, sizeof(m_header));
+        m_weights = NULL;
+        m_hashes = NULL;
+        m_slots = NULL;
+        m_feature_offsets = NULL;
+        m_feature_chars = NULL;
+        m_label_offsets = NULL;
+        m_label_chars = NULL;
+    }
+
+    virtual ~compiled_model()
+    {
+    }
+
+    /*
+     * Tests whether a file is a compiled model.
+     */
+    static bool is_compiled(std::istream& is)
+    {
+        char magic[8];
+        is.read(magic, 8);
+        bool ret = (!is.fail() && std::memcmp(magic, COMPILED_MODEL_MAGIC, 8) == 0);
+        is.clear();
+        is.seekg(0, std::ios::beg);
+        return ret;
+    }
+
+    /*
+     * Maps a compiled model into memory.
+     */
+    void open(const std::string& filename)
+    {
+        if (!m_file.open(filename)) {
+            throw invalid_model("failed to open the compiled model", filename);
+        }
+        if (m_file.size() < sizeof(m_header)) {
+            throw invalid_model("broken compiled model", filename);
+        }
+        std::memcpy(&m_header, m_file.data(), sizeof(m_header));
+        if (std::memcmp(m_header.magic, COMPILED_MODEL_MAGIC, 8) != 0 ||
+            m_header.version != COMPILED_MODEL_VERSION ||
+            m_header.byteorder != 0x12345678 ||
+            m_header.sizeof_offset != (int)sizeof(size_t)) {
+            throw invalid_model("unsupported compiled model", filename);
+        }
+
+        const char* p = m_file.data();
+        const size_t N = m_header.num_features;
+        size_t offset = compiled_model_aligned(sizeof(m_header));
+        m_weights = reinterpret_cast<const double*>(p + offset);
+        offset += compiled_model_aligned(sizeof(double) * N);
+        m_hashes = reinterpret_cast<const unsigned int*>(p + offset);
+        offset += compiled_model_aligned(sizeof(unsigned int) * N);
+        m_slots = reinterpret_cast<const unsigned int*>(p + offset);
+        offset += compiled_model_aligned(sizeof(unsigned int) * m_header.num_slots);
+        m_feature_offsets = reinterpret_cast<const size_t*>(p + offset);
+        offset += compiled_model_aligned(sizeof(size_t) * (N+1));
+        m_feature_chars = p + offset;
+        offset += compiled_model_aligned(m_header.feature_chars);
+        m_label_offsets = reinterpret_cast<const size_t*>(p + offset);
+        offset += compiled_model_aligned(sizeof(size_t) * (m_header.num_labels+1));
+        m_label_chars = p + offset;
+        offset += compiled_model_aligned(m_header.label_chars);
+        if (m_file.size() < offset || m_header.num_slots == 0 ||
+            (m_header.num_slots & (m_header.num_slots - 1)) != 0) {
+            throw invalid_model("truncated compiled model", filename);
+        }
+    }
+
+    int type() const
+    {
+        return m_header.type;
+    }
+
+    size_t num_features() const
+    {
+        return m_header.num_features;
+    }
+
+    size_t num_labels() const
+    {
+        return m_header.num_labels;
+    }
+
+    std::string label(size_t i) const
+    {
+        return std::string(
+            m_label_chars + m_label_offsets[i],
+            m_label_offsets[i+1] - m_label_offsets[i]
+            );
+    }
+
+    std::string feature(size_t i) const
+    {
+        return std::string(
+            m_feature_chars + m_feature_offsets[i],
+            m_feature_offsets[i+1] - m_feature_offsets[i]
+            );
+    }
+
+    value_type weight(size_t i) const
+    {
+        return m_weights[i];
+    }
+
+    /*
+     * Finds the feature number of a name (-1 if the name is unknown).
+     */
+    int find(const char *str, size_t n) const
+    {
+        const unsigned int h = compiled_model_hash(str, n);
+        const size_t mask = m_header.num_slots - 1;
+        for (size_t i = (h & mask);;i = ((i+1) & mask)) {
+            unsigned int s = m_slots[i];
+            if (s == 0) {
+                return -1;
+            }
+            --s;
+            if (m_hashes[s] == h) {
+                const size_t first = m_feature_offsets[s];
+                const size_t len = m_feature_offsets[s+1] - first;
+                if (len == n && std::memcmp(m_feature_chars + first, str, n) == 0) {
+                    return (int)s;
+                }
+            }
+        }
+    }
+
+    value_type operator[](const key_type& key) const
+    {
+        int i = find(key.c_str(), key.size());
+        return (0 <= i) ? m_weights[i] : 0.;
+    }
+};
+
+/*
+ * Converts a text model into a compiled model.
+ *  The first line of the text model (the model type) must have been read
+ *  from the stream. For the same feature name appearing more than once, the
+ *  last (first_wins = false) or first (first_wins = true) weight is used as
+ *  read_model() of the corresponding task does.
+ */
+inline static void
+compile_model(
+    std::istream& is,
+    const std::string& filename,
+    int type,
+    bool first_wins
+    )
+{
+    typedef std::map<std::string, size_t> index_type;
+    index_type index;
+    std::vector<double> weights;
+    std::vector<unsigned int> hashes;
+    std::vector<size_t> feature_offsets(1, 0);
+    std::vector<char> feature_chars;
+    std::vector<size_t> label_offsets(1, 0);
+    std::vector<char> label_chars;
+
+    for (;;) {
+        std::string line;
+        std::getline(is, line);
+        if (is.eof()) {
+            break;
+        }
+
+        // Candidate label.
+        if (line.compare(0, 7, "@label\t") == 0) {
+            label_chars.insert(label_chars.end(), line.begin() + 7, line.end());
+            label_offsets.push_back(label_chars.size());
+            continue;
+        }
+
+        if (line.compare(0, 1, "@") == 0) {
+            continue;
+        }
+
+        std::string::size_type pos = line.find('\t');
+        if (pos == line.npos) {
+            throw invalid_model("feature weight is missing", line);
+        }
+
+        double w = std::atof(line.c_str());
+        if (++pos == line.size()) {
+            throw invalid_model("feature name is missing", line);
+        }
+
+        std::string name = line.substr(pos);
+        index_type::iterator it = index.find(name);
+        if (it != index.end()) {
+            if (!first_wins) {
+                weights[it->second] = w;
+            }
+            continue;
+        }
+
+        index.insert(index_type::value_type(name, weights.size()));
+        weights.push_back(w);
+        hashes.push_back(compiled_model_hash(name.c_str(), name.size()));
+        feature_chars.insert(feature_chars.end(), name.begin(), name.end());
+        feature_offsets.push_back(feature_chars.size());
+    }
+
+    // Build the hash index.
+    size_t num_slots = 2;
+    while (num_slots < 2 * weights.size()) {
+        num_slots *= 2;
+    }
+    std::vector<unsigned int> slots(num_slots, 0);
+    for (size_t i = 0;i < weights.size();++i) {
+        size_t j = (hashes[i] & (num_slots-1));
+        while (slots[j] != 0) {
+            j = ((j+1) & (num_slots-1));
+        }
+        slots[j] = (unsigned int)(i+1);
+    }
+
+    // Fill the header.
+    compiled_model_header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, COMPILED_MODEL_MAGIC, 8);
+    header.version = COMPILED_MODEL_VERSION;
+    header.byteorder = 0x12345678;
+    header.sizeof_offset = (int)sizeof(size_t);
+    header.type = type;
+    header.num_features = weights.size();
+    header.num_slots = num_slots;
+    header.feature_chars = feature_chars.size();
+    header.num_labels = label_offsets.size() - 1;
+    header.label_chars = label_chars.size();
+
+    // Write the compiled model.
+    std::ofstream os(filename.c_str(), std::ios::out | std::ios::binary);
+    if (os.fail()) {
+        throw invalid_model("failed to open a file for the compiled model", filename);
+    }
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (sizeof(header) % 8 != 0) {
+        static const char zero[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        os.write(zero, 8 - sizeof(header) % 8);
+    }
+    compiled_model_write_array(os, weights);
+    compiled_model_write_array(os, hashes);
+    compiled_model_write_array(os, slots);
+    compiled_model_write_array(os, feature_offsets);
+    compiled_model_write_array(os, feature_chars);
+    compiled_model_write_array(os, label_offsets);
+    compiled_model_write_array(os, label_chars);
+    if (os.fail()) {
+        throw invalid_model("failed to write the compiled model", filename);
+    }
+}
+
+#endif/*__COMPILED_MODEL_H__*/
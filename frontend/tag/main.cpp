@@ -42,10 +42,12 @@
 #include <optparse.h>
 
 #include "option.h"
+#include "compiled_model.h"
+#include <hashed_model.h>
 
-int binary_tag(option& opt, std::ifstream& ifs);
-int multi_tag(option& opt, std::ifstream& ifs);
-int candidate_tag(option& opt, std::ifstream& ifs);
+int binary_tag(option& opt, std::ifstream& ifs, const compiled_model* cmodel, const hashed_model* hmodel);
+int multi_tag(option& opt, std::ifstream& ifs, const compiled_model* cmodel, const hashed_model* hmodel);
+int candidate_tag(option& opt, std::ifstream& ifs, const compiled_model* cmodel, const hashed_model* hmodel);
 
 class optionparser : public option, public optparse
 {
@@ -62,6 +64,9 @@ public:
         ON_OPTION_WITH_ARG(SHORTOPT('m') || LONGOPT("model"))
             model = arg;
 
+        ON_OPTION_WITH_ARG(SHORTOPT('C') || LONGOPT("compile"))
+            compile = arg;
+
         ON_OPTION(SHORTOPT('t') || LONGOPT("test"))
             test = true;
 
@@ -116,6 +121,12 @@ public:
         ON_OPTION(SHORTOPT('q') || LONGOPT("quiet"))
             condition = CONDITION_NONE;
 
+        ON_OPTION_WITH_ARG(LONGOPT("threads"))
+            threads = atoi(arg);
+
+        ON_OPTION(LONGOPT("line-buffered"))
+            line_buffered = true;
+
         ON_OPTION(SHORTOPT('v') || LONGOPT("version"))
             mode = MODE_VERSION;
 
@@ -131,7 +142,12 @@ static void usage(std::ostream& os, const char *argv0)
     os << "This utility tags labels for a data set read from STDIN." << std::endl;
     os << std::endl;
     os << "OPTIONS:" << std::endl;
-    os << "  -m, --model=FILE      load the model from FILE" << std::endl;
+    os << "  -m, --model=FILE      load the model from FILE; the model is either a text" << std::endl;
+    os << "                        model written by classias-train, a compiled model," << std::endl;
+    os << "                        or a hashed model written by classias-train --hash" << std::endl;
+    os << "  -C, --compile=FILE    convert the text model specified by '-m' into a" << std::endl;
+    os << "                        compiled model FILE and exit; a compiled model is" << std::endl;
+    os << "                        mapped into memory and loads almost instantly" << std::endl;
     os << "  -t, --test            evaluate the tagging performance on the labeled data" << std::endl;
     os << "  -n, --negative=LABEL  assume LABEL to be a negative label" << std::endl;
     os << "  -w, --score           output scores for the labels" << std::endl;
@@ -149,6 +165,11 @@ static void usage(std::ostream& os, const char *argv0)
     os << "      ':',  c, colon            a COLON (':') character (DEFAULT)" << std::endl;
     os << "      '=',  e, equal            a EQUAL ('=') character" << std::endl;
     os << "      '|',  b, bar              a BAR ('|') character" << std::endl;
+    os << "      --threads=N       tag the data with N threads (DEFAULT=1); 0 uses all" << std::endl;
+    os << "                        processors; the output is identical regardless of the" << std::endl;
+    os << "                        number of threads" << std::endl;
+    os << "      --line-buffered   flush the output after every line (with a single" << std::endl;
+    os << "                        thread); the output is otherwise written in blocks" << std::endl;
     os << "  -v, --version         show the version and copyright information" << std::endl;
     os << "  -h, --help            show this help message and exit" << std::endl;
     os << std::endl;
@@ -214,21 +235,55 @@ int main(int argc, char *argv[])
         return 1;
     }
 
-    // Check the model type.
-    int type = check_model(ifs);
-
     try {
+        // Check the model type.
+        int type = option::TYPE_NONE;
+        compiled_model cmodel;
+        const compiled_model* pcm = NULL;
+        hashed_model hmodel;
+        const hashed_model* phm = NULL;
+        if (compiled_model::is_compiled(ifs)) {
+            cmodel.open(opt.model);
+            type = cmodel.type();
+            pcm = &cmodel;
+        } else if (hashed_model::is_hashed(ifs)) {
+            hmodel.open(opt.model);
+            type = hmodel.type();
+            phm = &hmodel;
+        } else {
+            type = check_model(ifs);
+        }
+
+        // Convert the text model into a compiled model if necessary.
+        if (!opt.compile.empty()) {
+            if (pcm != NULL) {
+                es << "ERROR: the model is already compiled: " << opt.model << std::endl;
+                return 1;
+            } else if (phm != NULL) {
+                es << "ERROR: a hashed model cannot be compiled: " << opt.model << std::endl;
+                return 1;
+            } else if (type == option::TYPE_NONE) {
+                es << "ERROR: unknown model type" << std::endl;
+                return 1;
+            }
+            compile_model(
+                ifs, opt.compile, type,
+                (type == option::TYPE_MULTI_SPARSE || type == option::TYPE_MULTI_DENSE)
+                );
+            return 0;
+        }
+
         // Branches for the model type.
         switch (type) {
         case option::TYPE_BINARY:
-            ret = binary_tag(opt, ifs);
+            ret = binary_tag(opt, ifs, pcm, phm);
             break;
         case option::TYPE_MULTI_SPARSE:
         case option::TYPE_MULTI_DENSE:
-            ret = multi_tag(opt, ifs);
+            ret = multi_tag(opt, ifs, pcm, phm);
             break;
         case option::TYPE_CANDIDATE:
-            ret = candidate_tag(opt, ifs);
+            ret = candidate_tag(opt, ifs, pcm, phm);
             break;
         default:
             es << "ERROR: unknown model type" << std::endl;
@@ -34,10 +34,13 @@
 #include <config.h>
 #endif/*HAVE_CONFIG_H*/
 
+#include <cstring>
 #include <fstream>
 #include <iostream>
 #include <iterator>
+#include <map>
 #include <string>
+#include <vector>
 
 #include <classias/classias.h>
 #include <classias/quark.h>
@@ -47,46 +50,191 @@
 #include "option.h"
 #include "tokenize.h"
 #include "defaultmap.h"
+#include "compiled_model.h"
+#include "pipeline.h"
+#include <hashed_model.h>
 #include <util.h>
 
 typedef defaultmap<std::string, double> model_type;
 typedef std::vector<std::string> labels_type;
 typedef std::vector<int> positive_labels_type;
-typedef classias::classify::linear_multi_logistic<model_type> classifier_type;
 
-class feature_generator
+/*
+ * The feature generator for a hashed model.
+ *  An attribute is identified by the hashing quark of the model, and a
+ *  feature is the index of the weight array as the dense feature generator
+ *  of the trainer defines.
+ */
+class hashed_feature_generator
 {
 public:
-    typedef std::string attribute_type;
-    typedef std::string label_type;
-    typedef std::string feature_type;
+    typedef size_t attribute_type;
+    typedef int label_type;
+    typedef size_t feature_type;
+
+protected:
+    const classias::hashing_quark& m_attributes;
+    size_t m_num_labels;
 
 public:
-    feature_generator()
+    hashed_feature_generator(const hashed_model& model)
+        : m_attributes(model.attributes()), m_num_labels(model.num_labels())
+    {
+    }
+
+    virtual ~hashed_feature_generator()
     {
     }
 
-    virtual ~feature_generator()
+    inline const classias::hashing_quark& attributes() const
     {
+        return m_attributes;
     }
 
     inline bool forward(
-        const std::string& a,
-        const std::string& l,
-        std::string& f
+        const attribute_type& a,
+        const label_type& l,
+        feature_type& f
         ) const
     {
-        f  = a;
-        f += '\t';
-        f += l;
+        f = a * m_num_labels + l;
         return true;
     }
 };
 
+/*
+ * An index from an attribute to the weights of its features.
+ *  The index stores, for every attribute in the model, a compact row of
+ *  (label index, weight) pairs of the features "attribute\tlabel". A
+ *  classifier then computes the scores of all labels with a hash lookup
+ *  for each attribute and a loop over the row, instead of looking up the
+ *  model for every pair of the attribute and a label. The hash table is an
+ *  open-addressing table as that of a compiled model.
+ */
+class attribute_index
+{
+public:
+    typedef double value_type;
+
+    struct element
+    {
+        int     label;
+        double  weight;
+    };
+
+protected:
+    typedef std::vector<element> row_type;
+    typedef std::map<std::string, row_type> rows_type;
+
+    rows_type               m_rows;
+    std::vector<element>    m_elements;
+    std::vector<size_t>     m_row_offsets;
+    std::vector<char>       m_chars;
+    std::vector<size_t>     m_char_offsets;
+    std::vector<unsigned int> m_hashes;
+    std::vector<unsigned int> m_slots;
+
+public:
+    attribute_index()
+    {
+    }
+
+    virtual ~attribute_index()
+    {
+    }
+
+    /*
+     * Adds a feature weight; features of unknown labels are ignored.
+     */
+    void append(
+        const std::string& feature,
+        double weight,
+        const classias::quark& labels
+        )
+    {
+        std::string::size_type pos = feature.rfind('\t');
+        if (pos == feature.npos || weight == 0.) {
+            return;
+        }
+        int l = labels.to_value(feature.substr(pos+1), -1);
+        if (l < 0) {
+            return;
+        }
+
+        element e;
+        e.label = l;
+        e.weight = weight;
+        m_rows[feature.substr(0, pos)].push_back(e);
+    }
+
+    /*
+     * Builds the rows and the hash table from the features appended.
+     */
+    void finalize()
+    {
+        m_row_offsets.assign(1, 0);
+        m_char_offsets.assign(1, 0);
+        for (rows_type::const_iterator it = m_rows.begin();it != m_rows.end();++it) {
+            const std::string& name = it->first;
+            m_elements.insert(m_elements.end(), it->second.begin(), it->second.end());
+            m_row_offsets.push_back(m_elements.size());
+            m_chars.insert(m_chars.end(), name.begin(), name.end());
+            m_char_offsets.push_back(m_chars.size());
+            m_hashes.push_back(compiled_model_hash(name.c_str(), name.size()));
+        }
+        m_rows.clear();
+
+        size_t num_slots = 2;
+        while (num_slots < 2 * m_hashes.size()) {
+            num_slots *= 2;
+        }
+        m_slots.assign(num_slots, 0);
+        for (size_t i = 0;i < m_hashes.size();++i) {
+            size_t j = (m_hashes[i] & (num_slots-1));
+            while (m_slots[j] != 0) {
+                j = ((j+1) & (num_slots-1));
+            }
+            m_slots[j] = (unsigned int)(i+1);
+        }
+    }
+
+    /*
+     * Finds the row of an attribute (an empty range if unknown).
+     */
+    void find(
+        const char *str,
+        size_t n,
+        const element*& first,
+        const element*& last
+        ) const
+    {
+        first = last = NULL;
+        const unsigned int h = compiled_model_hash(str, n);
+        const size_t mask = m_slots.size() - 1;
+        for (size_t i = (h & mask);;i = ((i+1) & mask)) {
+            unsigned int s = m_slots[i];
+            if (s == 0) {
+                return;
+            }
+            --s;
+            if (m_hashes[s] == h) {
+                const size_t begin = m_char_offsets[s];
+                const size_t len = m_char_offsets[s+1] - begin;
+                if (len == n && std::memcmp(&m_chars[0] + begin, str, n) == 0) {
+                    first = &m_elements[0] + m_row_offsets[s];
+                    last = &m_elements[0] + m_row_offsets[s+1];
+                    return;
+                }
+            }
+        }
+    }
+};
+
+template <class classifier_type>
 static void
 parse_line(
     classifier_type& inst,
-    const feature_generator& fgen,
+    const hashed_feature_generator& fgen,
     std::string& rl,
     const classias::quark& labels,
     const option& opt,
@@ -94,8 +242,9 @@ parse_line(
     int lines = 0
     )
 {
-    double value;
-    std::string name;
+    double value, sign;
+    token name;
+    const classias::hashing_quark& attributes = fgen.attributes();
 
     // Split the line with tab characters.
     tokenizer values(line, opt.token_separator);
@@ -106,28 +255,80 @@ parse_line(
 
     // Parse the instance label.
     get_name_value(*itv, name, value, opt.value_separator);
-    rl = name;
+    name.assign_to(rl);
 
     // Initialize the classifier.
     inst.clear();
     inst.resize(labels.size());
 
-    // Set attributes for the instance.
+    // Set attributes for the instance; an attribute is hashed only once.
     for (++itv;itv != values.end();++itv) {
         if (!itv->empty()) {
-            double value;
-            std::string name;
             get_name_value(*itv, name, value, opt.value_separator);
-
+            size_t aid = attributes.to_value(name.begin(), name.size(), sign);
             for (int i = 0;i < (int)labels.size();++i) {
-                inst.set(i, fgen, name, labels.to_item(i), value);
+                inst.set(i, fgen, aid, i, sign * value);
             }
         }
     }
 
-    // Apply the bias feature if any.
+    // Apply the bias feature (always reserved in a hashed model).
+    size_t bid = attributes.to_value("__BIAS__");
     for (int i = 0;i < (int)labels.size();++i) {
-        inst.set(i, fgen, "__BIAS__", labels.to_item(i), 1.0);
+        inst.set(i, fgen, bid, i, 1.0);
+    }
+
+    // Finalize the instance.
+    inst.finalize();
+}
+
+template <class classifier_type>
+static void
+parse_line(
+    classifier_type& inst,
+    const attribute_index& index,
+    std::string& rl,
+    const classias::quark& labels,
+    const option& opt,
+    const std::string& line,
+    int lines = 0
+    )
+{
+    double value;
+    token name;
+    const attribute_index::element* first = NULL;
+    const attribute_index::element* last = NULL;
+
+    // Split the line with tab characters.
+    tokenizer values(line, opt.token_separator);
+    tokenizer::iterator itv = values.begin();
+    if (itv == values.end()) {
+        throw invalid_data("no field found in the line", line, lines);
+    }
+
+    // Parse the instance label.
+    get_name_value(*itv, name, value, opt.value_separator);
+    name.assign_to(rl);
+
+    // Initialize the classifier.
+    inst.clear();
+    inst.resize(labels.size());
+
+    // Set attributes for the instance; an attribute is looked up only once.
+    for (++itv;itv != values.end();++itv) {
+        if (!itv->empty()) {
+            get_name_value(*itv, name, value, opt.value_separator);
+            index.find(name.begin(), name.size(), first, last);
+            for (const attribute_index::element* p = first;p != last;++p) {
+                inst.set_score(p->label, inst.score(p->label) + p->weight * value);
+            }
+        }
+    }
+
+    // Apply the bias feature if any.
+    index.find("__BIAS__", 8, first, last);
+    for (const attribute_index::element* p = first;p != last;++p) {
+        inst.set_score(p->label, inst.score(p->label) + p->weight * 1.0);
     }
 
     // Finalize the instance.
@@ -142,8 +343,8 @@ read_model(
     option& opt
     )
 {
+    std::string line;
     for (;;) {
-        std::string line;
         std::getline(is, line);
         if (is.eof()) {
             break;
@@ -173,96 +374,79 @@ read_model(
     }
 }
 
-static void output_model_label(
-    std::ostream& os,
-    classifier_type& inst,
-    const classias::quark& labels,
-    option& opt
-    )
-{
-}
-
-int multi_tag(option& opt, std::ifstream& ifs)
+template <class model_type, class feature_generator_type>
+class multi_tagger
 {
-    int lines = 0;
-    feature_generator fgen;
-    std::istream& is = opt.is;
-    std::ostream& os = opt.os;
+protected:
+    typedef classias::classify::linear_multi_logistic<model_type> classifier_type;
 
-    // Load a model.
-    model_type model;
-    classias::quark labels;
-    read_model(model, labels, ifs, opt);
+    const option*                   m_opt;
+    const classias::quark*          m_labels;
+    const feature_generator_type*   m_fgen;
+    classifier_type                 m_inst;
+    classias::accuracy              m_acc;
+    classias::precall               m_pr;
 
-    // Create an instance of a classifier on the model.
-    classifier_type inst(model);
+    // Another quark for labels unseen in the training stage.
+    classias::quark                 m_rlabels;
 
-    // Generate a set of positive labels (necessary only for evaluation).
-    positive_labels_type positives;
-    if (opt.test) {
-        for (int i = 0;i < (int)labels.size();++i) {
-            if (opt.negative_labels.find(labels.to_item(i)) == opt.negative_labels.end()) {
-                positives.push_back(i);
-            }
-        }
+public:
+    multi_tagger(
+        const option& opt,
+        const model_type& model,
+        const classias::quark& labels,
+        const feature_generator_type& fgen
+        ) :
+        m_opt(&opt), m_labels(&labels), m_fgen(&fgen), m_inst(model),
+        m_pr(labels.size()), m_rlabels(labels)
+    {
     }
 
-    // Objects for performance evaluation.
-    classias::accuracy acc;
-    classias::precall pr(labels.size());
-
-    // Create another quark for labels unseen in the training stage.
-    classias::quark rlabels = labels;
-
-    for (;;) {
-        // Read a line.
-        std::string line;
-        std::getline(is, line);
-        if (is.eof()) {
-            break;
-        }
-        ++lines;
+    void operator()(text_writer& os, const std::string& line, int lines)
+    {
+        const option& opt = *m_opt;
+        const classias::quark& labels = *m_labels;
 
         // An empty line or comment line.
         if (line.empty() || line.compare(0, 1, "#") == 0) {
             // Output the comment line if necessary.
             if (opt.output & option::OUTPUT_COMMENT) {
-                os << line << std::endl;
+                os << line << '\n';
             }
-            continue;
+            return;
         }
 
         // Parse the line and classify the instance.
         std::string rlabel;
-        parse_line(inst, fgen, rlabel, labels, opt, line, lines);
+        parse_line(m_inst, *m_fgen, rlabel, labels, opt, line, lines);
 
         // Determine whether we output this instance or not.
         if (opt.condition == option::CONDITION_ALL ||
-            (opt.condition == option::CONDITION_FALSE && labels.to_item(inst.argmax()) != rlabel)) {
+            (opt.condition == option::CONDITION_FALSE && labels.to_item(m_inst.argmax()) != rlabel)) {
             if (opt.output & option::OUTPUT_ALL) {
                 // Output all candidates
-                os << "@boi" << std::endl;
+                os << "@boi" << '\n';
 
-                for (int i = 0;i < inst.size();++i) {
+                for (int i = 0;i < m_inst.size();++i) {
                     // Output the reference label.
                     if (opt.output & option::OUTPUT_RLABEL) {
                         os << ((labels.to_item(i) == rlabel) ? '+' : '-');
                     }
                     // Output the predicted label.
-                    os << ((i == inst.argmax()) ? '+' : '-');
+                    os << ((i == m_inst.argmax()) ? '+' : '-');
                     os << labels.to_item(i);
 
                     // Output the score/probability if necessary.
                     if (opt.output & option::OUTPUT_PROBABILITY) {
-                        os << opt.value_separator << inst.prob(i);
+                        os << opt.value_separator << m_inst.prob(i);
                     } else if (opt.output & option::OUTPUT_SCORE) {
-                        os << opt.value_separator << inst.score(i);
+                        os << opt.value_separator << m_inst.score(i);
                     }
 
-                    os << std::endl;
+                    os << '\n';
                 }
 
-                os << "@eoi" << std::endl;
+                os << "@eoi" << '\n';
 
             } else  {
                 // Output the predicted candidate only.
@@ -273,42 +457,128 @@ int multi_tag(option& opt, std::ifstream& ifs)
                 }
 
                 // Output the predicted label.
-                os << labels.to_item(inst.argmax());
+                os << labels.to_item(m_inst.argmax());
 
                 // Output the score/probability if necessary.
                 if (opt.output & option::OUTPUT_PROBABILITY) {
-                    os << opt.value_separator << inst.prob(inst.argmax());
+                    os << opt.value_separator << m_inst.prob(m_inst.argmax());
                 } else if (opt.output & option::OUTPUT_SCORE) {
-                    os << opt.value_separator << inst.score(inst.argmax());
+                    os << opt.value_separator << m_inst.score(m_inst.argmax());
                 }
 
-                os << std::endl;
+                os << '\n';
             }
 
         }
 
         // Accumulate the performance.
         if (opt.test) {
-            int pl = inst.argmax();
-            int rl = rlabels.to_value(rlabel, rlabels.size());
-            if (rl != rlabels.size()) {
-                acc.set(pl == rl);
-                pr.set(pl, rl);
+            int pl = m_inst.argmax();
+            int rl = m_rlabels.to_value(rlabel, m_rlabels.size());
+            if (rl != m_rlabels.size()) {
+                m_acc.set(pl == rl);
+                m_pr.set(pl, rl);
             } else {
-                int rl = rlabels(rlabel);
-                pr.resize(rlabels.size());
-                pr.set(pl, rl);
+                int rl = m_rlabels(rlabel);
+                m_pr.resize(m_rlabels.size());
+                m_pr.set(pl, rl);
+            }
+        }
+    }
+
+    void merge(const multi_tagger& rho)
+    {
+        // Unseen labels of rho are registered in the order of appearance.
+        // The first occurrence of an unseen label is excluded from the
+        // accuracy; it is counted as a miss if an earlier chunk has it.
+        std::vector<int> ids(rho.m_rlabels.size());
+        for (int i = 0;i < (int)ids.size();++i) {
+            const std::string& label = rho.m_rlabels.to_item(i);
+            if ((int)m_labels->size() <= i &&
+                m_rlabels.to_value(label, m_rlabels.size()) != m_rlabels.size()) {
+                m_acc.set(false);
+            }
+            ids[i] = m_rlabels(label);
+        }
+        m_acc.merge(rho.m_acc);
+        m_pr.merge(rho.m_pr, ids);
+    }
+
+    void output(std::ostream& os) const
+    {
+        const classias::quark& labels = *m_labels;
+
+        // Generate a set of positive labels.
+        positive_labels_type positives;
+        for (int i = 0;i < (int)labels.size();++i) {
+            if (m_opt->negative_labels.find(labels.to_item(i)) == m_opt->negative_labels.end()) {
+                positives.push_back(i);
             }
         }
+
+        m_acc.output(os);
+        m_pr.output_labelwise(os, labels, positives.begin(), positives.end());
+        m_pr.output_micro(os, positives.begin(), positives.end());
+        m_pr.output_macro(os, positives.begin(), positives.end());
     }
+};
+
+template <class model_type, class feature_generator_type>
+static int
+tag(
+    option& opt,
+    const model_type& model,
+    const classias::quark& labels,
+    const feature_generator_type& fgen
+    )
+{
+    multi_tagger<model_type, feature_generator_type> tagger(opt, model, labels, fgen);
+    tag_stream(opt.is, opt.os, tagger, opt);
 
     // Output the performance if necessary.
     if (opt.test) {
-        acc.output(os);
-        pr.output_labelwise(os, labels, positives.begin(), positives.end());
-        pr.output_micro(os, positives.begin(), positives.end());
-        pr.output_macro(os, positives.begin(), positives.end());
+        tagger.output(opt.os);
     }
 
     return 0;
 }
+
+int multi_tag(option& opt, std::ifstream& ifs, const compiled_model* cmodel, const hashed_model* hmodel)
+{
+    classias::quark labels;
+
+    // Use the compiled model if any.
+    if (cmodel != NULL) {
+        for (size_t i = 0;i < cmodel->num_labels();++i) {
+            labels(cmodel->label(i));
+        }
+
+        // Index the weights by attributes.
+        attribute_index index;
+        for (size_t i = 0;i < cmodel->num_features();++i) {
+            index.append(cmodel->feature(i), cmodel->weight(i), labels);
+        }
+        index.finalize();
+        return tag(opt, index, labels, index);
+    }
+
+    // Use the hashed model if any.
+    if (hmodel != NULL) {
+        for (size_t i = 0;i < hmodel->num_labels();++i) {
+            labels(hmodel->label(i));
+        }
+        return tag(opt, *hmodel, labels, hashed_feature_generator(*hmodel));
+    }
+
+    // Load a model, and index the weights by attributes.
+    attribute_index index;
+    {
+        model_type model;
+        read_model(model, labels, ifs, opt);
+        for (model_type::const_iterator it = model.begin();it != model.end();++it) {
+            index.append(it->first, it->second, labels);
+        }
+    }
+    index.finalize();
+    return tag(opt, index, labels, index);
+}
@@ -80,12 +80,15 @@ public:
 
     int         mode;
     std::string model;
+    std::string compile;
     bool        test;
     int         condition;
     int         output;
 
     char        token_separator;
     char        value_separator;
+    int         threads;
+    bool        line_buffered;
 
     labelset_type   negative_labels;
 
@@ -97,7 +100,8 @@ public:
         is(_is), os(_os), es(_es),
         mode(MODE_NORMAL),
         test(false), condition(CONDITION_ALL), output(OUTPUT_MLABEL),
-        token_separator(' '), value_separator(':')
+        token_separator(' '), value_separator(':'), threads(1),
+        line_buffered(false)
     {
     }
 };
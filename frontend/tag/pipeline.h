@@ -0,0 +1,276 @@
+/*
+ *		Multithreaded tagging of line-oriented data.
+ *
+ * Copyright (c) 2008,2009 Naoaki Okazaki
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the names of the authors nor the names of its contributors
+ *       may be used to endorse or promote products derived from this
+ *       software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* $Id$ */
+
+#ifndef __PIPELINE_H__
+#define __PIPELINE_H__
+
+#include <algorithm>
+#include <cstring>
+#include <istream>
+#include <ostream>
+#include <string>
+#include <vector>
+
+#include <classias/parallel.h>
+#include <chunk.h>
+#include <util.h>
+#include <writer.h>
+
+#include "option.h"
+
+/*
+ * Multithreaded tagging.
+ *
+ *  A tagger is a function object called with a text writer, a source
+ *  line, and the line number, for every line in the order of the source;
+ *  it writes the tagging result of the line and accumulates the counts
+ *  for the evaluation. Values are written with six significant digits as
+ *  an iostream does by default. The output is flushed after every line
+ *  only with --line-buffered.
+ *
+ *  With multiple threads, the source stream is read by blocks on a
+ *  background thread while the previous block is tagged. A block is split
+ *  into chunks at line boundaries ('@boi' ... '@eoi' blocks are never
+ *  split), and each chunk is tagged by a copy of the tagger on a worker
+ *  thread into a writer of its own. The calling thread then writes the
+ *  buffers and merges the counts of the copies in the order of the
+ *  source, so that the output is identical to that of the sequential
+ *  tagging. The output is flushed after every block.
+ */
+
+/* The number of significant digits of scores and probabilities. */
+#define TAG_PRECISION   6
+
+/*
+ * A task reading a block of the source stream.
+ */
+class block_reader
+{
+public:
+    std::istream*       m_is;
+    std::vector<char>   m_buffer;
+    size_t              m_size;
+    size_t              m_n;
+    bool                m_eof;
+
+    block_reader() : m_is(NULL), m_size(0), m_n(0), m_eof(false)
+    {
+    }
+
+    /*
+     * Starts the block with bytes left by the previous block.
+     */
+    void assign(const char* p, size_t n)
+    {
+        m_buffer.assign(p, p + n);
+        m_n = n;
+    }
+
+    /*
+     * Appends at most m_size bytes read from the stream.
+     */
+    void operator()()
+    {
+        m_buffer.resize(m_n + m_size);
+        m_is->read(&m_buffer[m_n], (std::streamsize)m_size);
+        m_n += (size_t)m_is->gcount();
+        m_eof = !*m_is;
+    }
+};
+
+/*
+ * A task tagging a chunk of source lines.
+ */
+template <class tagger_type>
+class tag_task
+{
+public:
+    tagger_type*    m_tagger;
+    const char*     m_first;
+    const char*     m_last;
+    int             m_lines;
+    text_writer     m_output;
+    bool            m_failed;
+    invalid_data    m_error;
+
+    tag_task() :
+        m_tagger(NULL), m_first(NULL), m_last(NULL), m_lines(0),
+        m_output(NULL, TAG_PRECISION), m_failed(false), m_error("")
+    {
+    }
+
+    void operator()()
+    {
+        std::string line;
+        int lines = m_lines;
+
+        // Every line in the chunk is terminated by '\n'. An error is kept
+        // for the calling thread, which reports it after the output of
+        // the preceding lines.
+        m_failed = false;
+        m_output.clear();
+        try {
+            const char* p = m_first;
+            while (p != m_last) {
+                const char* eol = (const char*)std::memchr(p, '\n', m_last - p);
+                line.assign(p, eol);
+                (*m_tagger)(m_output, line, ++lines);
+                p = eol + 1;
+            }
+        } catch (const invalid_data& e) {
+            m_failed = true;
+            m_error = e;
+        }
+    }
+};
+
+/*
+ * Tags the lines of a stream.
+ *  @param  is          The input stream.
+ *  @param  os          The output stream.
+ *  @param  tagger      The tagger, which also receives the counts for the
+ *                      evaluation merged from the worker threads.
+ *  @param  opt         The options.
+ *  @param  instances   Keep '@boi' ... '@eoi' blocks in single chunks.
+ */
+template <class tagger_type>
+static void
+tag_stream(
+    std::istream& is,
+    std::ostream& os,
+    tagger_type& tagger,
+    const option& opt,
+    bool instances = false
+    )
+{
+    const size_t block_size = 16 << 20;
+    const int T = classias::resolve_num_threads(opt.threads);
+    text_writer out(&os, TAG_PRECISION);
+
+    if (T <= 1) {
+        // Tag the stream line by line.
+        int lines = 0;
+        std::string line;
+        for (;;) {
+            // Read a line; the buffer of the line is reused over iterations.
+            std::getline(is, line);
+            if (is.eof()) {
+                break;
+            }
+            tagger(out, line, ++lines);
+            if (opt.line_buffered) {
+                out.flush();
+            }
+        }
+        out.flush();
+        return;
+    }
+
+    int lines = 0;
+    int cur = 0;
+    const tagger_type initial(tagger);
+    block_reader blocks[2];
+    classias::background_task<block_reader> reader;
+    std::vector<tag_task<tagger_type> > tasks(T);
+
+    // Read the first block.
+    for (int i = 0;i < 2;++i) {
+        blocks[i].m_is = &is;
+        blocks[i].m_size = block_size;
+    }
+    blocks[cur]();
+
+    for (;;) {
+        block_reader& block = blocks[cur];
+
+        // Tag complete lines (or instances) only. A last line without a
+        // newline character is ignored as std::getline() in the
+        // sequential tagging would have done.
+        const char* first = block.m_n ? &block.m_buffer[0] : NULL;
+        const char* end = first + block.m_n;
+        const char* last = find_last_chunk_boundary(
+            first, end, instances && !block.m_eof);
+        if (last == first && !block.m_eof) {
+            // The block is shorter than a line or an instance; enlarge it.
+            block.m_size *= 2;
+            block();
+            continue;
+        }
+
+        // Read the next block in background.
+        block_reader& next = blocks[1-cur];
+        if (!block.m_eof) {
+            next.m_size = block.m_size;
+            next.assign(last, end - last);
+            reader.start(next);
+        }
+
+        // Assign chunks to copies of the tagger.
+        std::vector<tagger_type> workers(T, initial);
+        const char* p = first;
+        for (int t = 0;t < T;++t) {
+            const char* q = last;
+            if (t+1 < T) {
+                q = first + (size_t)(last - first) * (t+1) / T;
+                q = find_chunk_boundary(q < p ? p : q, first, last, instances);
+            }
+            tasks[t].m_tagger = &workers[t];
+            tasks[t].m_first = p;
+            tasks[t].m_last = q;
+            tasks[t].m_lines = lines;
+            lines += (int)std::count(p, q, '\n');
+            p = q;
+        }
+
+        // Tag the chunks in parallel.
+        classias::parallel_run(tasks);
+
+        // Write the results and merge the counts in the order of the source.
+        for (int t = 0;t < T;++t) {
+            out.write(tasks[t].m_output.data(), tasks[t].m_output.size());
+            if (tasks[t].m_failed) {
+                out.flush();
+                throw tasks[t].m_error;
+            }
+            tagger.merge(workers[t]);
+        }
+        out.flush();
+
+        if (block.m_eof) {
+            break;
+        }
+        reader.join();
+        cur = 1 - cur;
+    }
+}
+
+#endif/*__PIPELINE_H__*/
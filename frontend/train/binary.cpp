@@ -46,7 +46,9 @@
 #include <classias/train/online_scheduler.h>
 
 #include "option.h"
+#include "reader.h"
 #include "tokenize.h"
+#include "writer.h"
 #include "train.h"
 
 /*
@@ -66,30 +68,23 @@ template <
 >
 static void
 read_line(
-    const std::string& line,
+    const staged_line& sl,
     instance_type& instance,
     features_quark_type& features,
-    const option& opt,
-    int lines = 0
+    const option& opt
     )
 {
     double value;
-    std::string name;
-
-    // Split the line with tab characters.
-    tokenizer values(line, opt.token_separator);
-    tokenizer::iterator itv = values.begin();
-    if (itv == values.end()) {
-        throw invalid_data("no field found in the line", line, lines);
-    }
+    token name;
+    std::string str;
 
     // Make sure that the first token (class) is not empty.
-    if (itv->empty()) {
-        throw invalid_data("an empty label found", line, lines);
+    if (sl.label.empty()) {
+        throw invalid_data("an empty label found", sl.str(), sl.lines);
     }
 
     // Parse the instance label.
-    get_name_value(*itv, name, value, opt.value_separator);
+    get_name_value(sl.label, name, value, opt.value_separator);
 
     // Set the class label of this instance.
     if (name == "+1" || name == "1") {
@@ -97,20 +92,15 @@ read_line(
     } else if (name == "-1") {
         instance.set_label(false);
     } else {
-        throw invalid_data("a class label must be either '+1', '1', or '-1'", line, lines);
+        throw invalid_data("a class label must be either '+1', '1', or '-1'", sl.str(), sl.lines);
     }
 
     // Set the instance weight.
     instance.set_weight(value);
 
     // Set featuress for the instance.
-    for (++itv;itv != values.end();++itv) {
-        if (!itv->empty()) {
-            get_name_value(*itv, name, value, opt.value_separator);
-            if (opt.filter_string.empty() || REGEX_SEARCH(name, opt.filter)) {
-                instance.append(features(name), value);
-            }
-        }
+    for (const staged_field* it = sl.first;it != sl.last;++it) {
+        append_attribute(instance, features, it->name, it->value, str);
     }
 
     // Include a bias feature if necessary.
@@ -119,6 +109,33 @@ read_line(
     }
 }
 
+template <
+    class data_type
+>
+struct binary_line_handler
+{
+    typedef typename data_type::instance_type instance_type;
+
+    data_type& data;
+    const option& opt;
+    int group;
+
+    binary_line_handler(data_type& _data, const option& _opt, int _group)
+        : data(_data), opt(_opt), group(_group)
+    {
+    }
+
+    void operator()(const staged_line& sl)
+    {
+        // Create a new instance.
+        instance_type& inst = data.new_element();
+        inst.set_group(group);
+
+        // Read the instance.
+        read_line(sl, inst, data.attributes, opt);
+    }
+};
+
 template <
     class data_type
 >
@@ -130,44 +147,18 @@ read_stream(
     int group = 0
     )
 {
-    int lines = 0;
-    typedef typename data_type::instance_type instance_type;
-
     // If necessary, generate a bias attribute here to reserve feature #0.
     if (opt.bias != 0.) {
-        int fid = (int)data.attributes("__BIAS__");
+        int fid = (int)reserve_attribute(data.attributes, "__BIAS__");
         if (fid != 0) {
             throw invalid_data("A bias attribute could not obtain #0");
         }
         data.set_user_feature_start(fid+1);
     }
 
-    for (;;) {
-        // Read a line.
-        std::string line;
-        std::getline(is, line);
-        if (is.eof()) {
-            break;
-        }
-        ++lines;
-
-        // Skip an empty line.
-        if (line.empty()) {
-            continue;
-        }
-
-        // Skip a comment line.
-        if (line.compare(0, 1, "#") == 0) {
-            continue;
-        }
-
-        // Create a new instance.
-        instance_type& inst = data.new_element();
-        inst.set_group(group);
-
-        // Read the instance.
-        read_line(line, inst, data.attributes, opt, lines);
-    }
+    // Read the lines (empty and comment lines are skipped by the reader).
+    binary_line_handler<data_type> handler(data, opt, group);
+    read_chunked(is, handler, opt);
 }
 
 template <
@@ -182,6 +173,33 @@ finalize_data(
     // Nothing to do.
 }
 
+template <
+    class data_type
+>
+static int
+read_cache(
+    data_type& data,
+    const option& opt
+    )
+{
+    return read_cache_file(
+        opt.cache_in, data, &data.attributes, (classias::quark*)NULL, CACHE_BINARY, opt);
+}
+
+template <
+    class data_type
+>
+static void
+write_cache(
+    const data_type& data,
+    const option& opt,
+    int num_groups
+    )
+{
+    write_cache_file(
+        opt.cache_out, data, &data.attributes, (const classias::quark*)NULL, CACHE_BINARY, num_groups, opt);
+}
+
 template <
     class data_type,
     class model_type
@@ -198,11 +216,13 @@ output_model(
     const attributes_quark_type& attributes = data.attributes;
     typedef typename model_type::value_type value_type;
 
-    // Open a model file for writing.
-    std::ofstream os(opt.model.c_str());
+    // Open a model file for writing; weights are written with the
+    // shortest digits that restore the values exactly.
+    std::ofstream ofs(opt.model.c_str());
+    text_writer os(&ofs);
 
     // Output a model type.
-    os << "@classias\tlinear\tbinary" << std::endl;
+    os << "@classias\tlinear\tbinary" << '\n';
 
     // Store the feature weights.
     for (aid_type i = 0;i < attributes.size();++i) {
@@ -212,64 +232,94 @@ output_model(
             if (attr == "__BIAS__") {
                 w *= opt.bias;
             }
-            os << w << '\t' << attr << std::endl;
+            os << w << '\t' << attr << '\n';
         }
     }
 }
 
-int binary_train(option& opt)
+template <
+    class model_type
+>
+static void
+output_model(
+    classias::bcsrhdata& data,
+    const model_type& model,
+    const option& opt
+    )
+{
+    const classias::hashing_quark& attributes = data.attributes;
+
+    // Store the weights of all the identifiers.
+    std::vector<double> weights(attributes.size());
+    for (size_t i = 0;i < weights.size();++i) {
+        weights[i] = model[i];
+    }
+
+    // Scale the weight of the bias feature as a text model does.
+    size_t bid = attributes.to_value("__BIAS__");
+    weights[bid] *= opt.bias;
+
+    write_hashed_model(
+        opt.model, option::TYPE_BINARY, attributes, std::vector<std::string>(), weights);
+}
+
+template <
+    class data_type
+>
+static int
+train_algorithm(option& opt)
 {
     // Branches for training algorithms.
     if (opt.algorithm == "lbfgs.logistic") {
         return train<
-            classias::bsdata,
-            classias::train::lbfgs_logistic_binary<classias::bsdata>
+            data_type,
+            classias::train::lbfgs_logistic_binary<data_type>
         >(opt);
     } else if (opt.algorithm == "averaged_perceptron") {
-        return train<
-            classias::bsdata,
-            classias::train::online_scheduler_binary<
-                classias::bsdata,
+        return train_online<
+            data_type,
+            classias::train::mixing_online_scheduler_binary<
+                data_type,
                 classias::train::averaged_perceptron_binary<
                     classias::classify::linear_binary<classias::weight_vector>
                     >
                 >
             >(opt);
     } else if (opt.algorithm == "pegasos.logistic") {
-        return train<
-            classias::bsdata,
-            classias::train::online_scheduler_binary<
-                classias::bsdata,
+        return train_online<
+            data_type,
+            classias::train::parallel_online_scheduler_binary<
+                data_type,
                 classias::train::pegasos_binary<
                     classias::classify::linear_binary_logistic<classias::weight_vector>
                     >
                 >
             >(opt);
     } else if (opt.algorithm == "pegasos.hinge") {
-        return train<
-            classias::bsdata,
-            classias::train::online_scheduler_binary<
-                classias::bsdata,
+        return train_online<
+            data_type,
+            classias::train::parallel_online_scheduler_binary<
+                data_type,
                 classias::train::pegasos_binary<
                     classias::classify::linear_binary_hinge<classias::weight_vector>
                     >
                 >
             >(opt);
     } else if (opt.algorithm == "truncated_gradient.logistic") {
-        return train<
-            classias::bsdata,
-            classias::train::online_scheduler_binary<
-                classias::bsdata,
+        return train_online<
+            data_type,
+            classias::train::parallel_online_scheduler_binary<
+                data_type,
                 classias::train::truncated_gradient_binary<
                     classias::classify::linear_binary_logistic<classias::weight_vector>
                     >
                 >
             >(opt);
     } else if (opt.algorithm == "truncated_gradient.hinge") {
-        return train<
-            classias::bsdata,
-            classias::train::online_scheduler_binary<
-                classias::bsdata,
+        return train_online<
+            data_type,
+            classias::train::parallel_online_scheduler_binary<
+                data_type,
                 classias::train::truncated_gradient_binary<
                     classias::classify::linear_binary_hinge<classias::weight_vector>
                     >
@@ -279,3 +329,13 @@ int binary_train(option& opt)
         throw invalid_algorithm(opt.algorithm);
     }
 }
+
+int binary_train(option& opt)
+{
+    // Branches for the attribute space.
+    if (0 < opt.hash_bits) {
+        return train_algorithm<classias::bcsrhdata>(opt);
+    } else {
+        return train_algorithm<classias::bcsrsdata>(opt);
+    }
+}
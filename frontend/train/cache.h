@@ -0,0 +1,696 @@
+/*
+ *		Binary cache of training data.
+ *
+ * Copyright (c) 2008,2009 Naoaki Okazaki
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the names of the authors nor the names of its contributors
+ *       may be used to endorse or promote products derived from this
+ *       software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* $Id$ */
+
+#ifndef __CACHE_H__
+#define __CACHE_H__
+
+#include <cstring>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include <classias/classias.h>
+#include <mapped_file.h>
+#include <util.h>
+
+#include "option.h"
+
+/*
+ * The layout of a cache file.
+ *
+ *  A cache file stores a data set as read from the source files, i.e.,
+ *  before features are generated by finalize_data(). A cache file begins
+ *  with a header followed by arrays aligned to 8 bytes:
+ *
+ *  int     instance_labels[num_instances]
+ *  int     instance_groups[num_instances]
+ *  double  instance_weights[num_instances]
+ *  size_t  instance_vectors[num_instances+1]
+ *  size_t  vector_elements[num_vectors+1]
+ *  int     element_ids[num_elements]
+ *  double  element_values[num_elements]
+ *  size_t  attribute_offsets[num_attributes+1]
+ *  char    attribute_chars[attribute_chars]
+ *  size_t  label_offsets[num_labels+1]
+ *  char    label_chars[label_chars]
+ *
+ *  An instance #i consists of the vectors (features of a binary instance,
+ *  attributes of a multi-class instance, or candidates of a candidate
+ *  instance) [instance_vectors[i], instance_vectors[i+1]). A vector #j
+ *  consists of the elements [vector_elements[j], vector_elements[j+1]).
+ *  The string of an attribute (label) #k is the byte sequence
+ *  [attribute_offsets[k], attribute_offsets[k+1]) of attribute_chars.
+ *
+ *  The file is written in the native byte order and word size, which are
+ *  recorded in the header so that an incompatible cache is rejected.
+ */
+
+#define CACHE_MAGIC     "CLSSCACH"
+#define CACHE_VERSION   1
+
+enum {
+    CACHE_BINARY = 1,
+    CACHE_MULTI,
+    CACHE_CANDIDATE,
+};
+
+struct cache_header
+{
+    char    magic[8];
+    int     version;
+    int     byteorder;
+    int     sizeof_offset;
+    int     type;
+    int     num_groups;
+    int     user_feature_start;
+    double  bias;
+    size_t  num_instances;
+    size_t  num_vectors;
+    size_t  num_elements;
+    size_t  num_attributes;
+    size_t  attribute_chars;
+    size_t  num_labels;
+    size_t  label_chars;
+};
+
+/*
+ * Accessors for the vectors of an instance.
+ */
+template <class features_type, class weight_type, class group_type>
+inline int cache_label(
+    const classias::binary_instance_base<features_type, weight_type, group_type>& inst)
+{
+    return inst.get_label() ? 1 : 0;
+}
+
+template <class features_type, class weight_type, class group_type>
+inline void cache_set_label(
+    classias::binary_instance_base<features_type, weight_type, group_type>& inst, int l)
+{
+    inst.set_label(l != 0);
+}
+
+template <class features_type, class weight_type, class group_type>
+inline size_t cache_num_vectors(
+    const classias::binary_instance_base<features_type, weight_type, group_type>& inst)
+{
+    return 1;
+}
+
+template <class features_type, class weight_type, class group_type>
+inline const features_type& cache_vector(
+    const classias::binary_instance_base<features_type, weight_type, group_type>& inst, size_t i)
+{
+    return inst;
+}
+
+template <class features_type, class weight_type, class group_type>
+inline features_type& cache_new_vector(
+    classias::binary_instance_base<features_type, weight_type, group_type>& inst)
+{
+    return inst;
+}
+
+template <class data_type>
+inline int cache_label(const classias::csr_binary_instance<data_type>& inst)
+{
+    return inst.get_label() ? 1 : 0;
+}
+
+template <class data_type>
+inline void cache_set_label(classias::csr_binary_instance<data_type>& inst, int l)
+{
+    inst.set_label(l != 0);
+}
+
+template <class data_type>
+inline size_t cache_num_vectors(const classias::csr_binary_instance<data_type>& inst)
+{
+    return 1;
+}
+
+template <class data_type>
+inline const classias::csr_binary_instance<data_type>& cache_vector(
+    const classias::csr_binary_instance<data_type>& inst, size_t i)
+{
+    return inst;
+}
+
+template <class data_type>
+inline classias::csr_binary_instance<data_type>& cache_new_vector(
+    classias::csr_binary_instance<data_type>& inst)
+{
+    return inst;
+}
+
+template <class attributes_type, class weight_type, class group_type>
+inline int cache_label(
+    const classias::multi_instance_base<attributes_type, weight_type, group_type>& inst)
+{
+    return inst.get_label();
+}
+
+template <class attributes_type, class weight_type, class group_type>
+inline void cache_set_label(
+    classias::multi_instance_base<attributes_type, weight_type, group_type>& inst, int l)
+{
+    inst.set_label(l);
+}
+
+template <class attributes_type, class weight_type, class group_type>
+inline size_t cache_num_vectors(
+    const classias::multi_instance_base<attributes_type, weight_type, group_type>& inst)
+{
+    return 1;
+}
+
+template <class attributes_type, class weight_type, class group_type>
+inline const attributes_type& cache_vector(
+    const classias::multi_instance_base<attributes_type, weight_type, group_type>& inst, size_t i)
+{
+    return inst;
+}
+
+template <class attributes_type, class weight_type, class group_type>
+inline attributes_type& cache_new_vector(
+    classias::multi_instance_base<attributes_type, weight_type, group_type>& inst)
+{
+    return inst;
+}
+
+template <class attributes_type, class weight_type, class group_type>
+inline int cache_label(
+    const classias::candidate_instance_base<attributes_type, weight_type, group_type>& inst)
+{
+    return inst.get_label();
+}
+
+template <class attributes_type, class weight_type, class group_type>
+inline void cache_set_label(
+    classias::candidate_instance_base<attributes_type, weight_type, group_type>& inst, int l)
+{
+    inst.set_label(l);
+}
+
+template <class attributes_type, class weight_type, class group_type>
+inline size_t cache_num_vectors(
+    const classias::candidate_instance_base<attributes_type, weight_type, group_type>& inst)
+{
+    return inst.size();
+}
+
+template <class attributes_type, class weight_type, class group_type>
+inline const attributes_type& cache_vector(
+    const classias::candidate_instance_base<attributes_type, weight_type, group_type>& inst, size_t i)
+{
+    return inst.attributes((int)i);
+}
+
+template <class attributes_type, class weight_type, class group_type>
+inline attributes_type& cache_new_vector(
+    classias::candidate_instance_base<attributes_type, weight_type, group_type>& inst)
+{
+    return inst.new_element();
+}
+
+template <class identifier_type, class value_type, class weight_type>
+inline int cache_label(
+    const classias::compact_binary_instance<identifier_type, value_type, weight_type>& inst)
+{
+    return inst.get_label() ? 1 : 0;
+}
+
+template <class identifier_type, class value_type, class weight_type>
+inline void cache_set_label(
+    classias::compact_binary_instance<identifier_type, value_type, weight_type>& inst, int l)
+{
+    inst.set_label(l != 0);
+}
+
+template <class identifier_type, class value_type, class weight_type>
+inline size_t cache_num_vectors(
+    const classias::compact_binary_instance<identifier_type, value_type, weight_type>& inst)
+{
+    return 1;
+}
+
+template <class identifier_type, class value_type, class weight_type>
+inline const classias::compact_binary_instance<identifier_type, value_type, weight_type>& cache_vector(
+    const classias::compact_binary_instance<identifier_type, value_type, weight_type>& inst, size_t i)
+{
+    return inst;
+}
+
+template <class identifier_type, class value_type, class weight_type>
+inline classias::compact_binary_instance<identifier_type, value_type, weight_type>& cache_new_vector(
+    classias::compact_binary_instance<identifier_type, value_type, weight_type>& inst)
+{
+    return inst;
+}
+
+template <class identifier_type, class value_type, class weight_type>
+inline int cache_label(
+    const classias::compact_multi_instance<identifier_type, value_type, weight_type>& inst)
+{
+    return inst.get_label();
+}
+
+template <class identifier_type, class value_type, class weight_type>
+inline void cache_set_label(
+    classias::compact_multi_instance<identifier_type, value_type, weight_type>& inst, int l)
+{
+    inst.set_label(l);
+}
+
+template <class identifier_type, class value_type, class weight_type>
+inline size_t cache_num_vectors(
+    const classias::compact_multi_instance<identifier_type, value_type, weight_type>& inst)
+{
+    return 1;
+}
+
+template <class identifier_type, class value_type, class weight_type>
+inline const classias::compact_multi_instance<identifier_type, value_type, weight_type>& cache_vector(
+    const classias::compact_multi_instance<identifier_type, value_type, weight_type>& inst, size_t i)
+{
+    return inst;
+}
+
+template <class identifier_type, class value_type, class weight_type>
+inline classias::compact_multi_instance<identifier_type, value_type, weight_type>& cache_new_vector(
+    classias::compact_multi_instance<identifier_type, value_type, weight_type>& inst)
+{
+    return inst;
+}
+
+template <class attributes_type, class weight_type>
+inline int cache_label(
+    const classias::compact_candidate_instance<attributes_type, weight_type>& inst)
+{
+    return inst.get_label();
+}
+
+template <class attributes_type, class weight_type>
+inline void cache_set_label(
+    classias::compact_candidate_instance<attributes_type, weight_type>& inst, int l)
+{
+    inst.set_label(l);
+}
+
+template <class attributes_type, class weight_type>
+inline size_t cache_num_vectors(
+    const classias::compact_candidate_instance<attributes_type, weight_type>& inst)
+{
+    return inst.size();
+}
+
+template <class attributes_type, class weight_type>
+inline const attributes_type& cache_vector(
+    const classias::compact_candidate_instance<attributes_type, weight_type>& inst, size_t i)
+{
+    return inst.attributes((int)i);
+}
+
+template <class attributes_type, class weight_type>
+inline attributes_type& cache_new_vector(
+    classias::compact_candidate_instance<attributes_type, weight_type>& inst)
+{
+    return inst.new_element();
+}
+
+/*
+ * Appends the identifiers and values of a vector to arrays.
+ */
+template <class vector_type>
+static void
+cache_append_elements(
+    std::vector<int>* ids,
+    std::vector<double>* values,
+    const vector_type& v
+    )
+{
+    typename vector_type::const_iterator it;
+    for (it = v.begin();it != v.end();++it) {
+        if (ids != NULL) {
+            ids->push_back((int)it->first);
+        }
+        if (values != NULL) {
+            values->push_back((double)it->second);
+        }
+    }
+}
+
+/*
+ * Restores the elements of a vector from arrays.
+ */
+template <class vector_type>
+static void
+cache_restore_elements(
+    vector_type& v,
+    const int* ids,
+    const double* values,
+    size_t first,
+    size_t last
+    )
+{
+    v.reserve(last - first);
+    for (size_t k = first;k < last;++k) {
+        v.append(ids[k], values[k]);
+    }
+}
+
+/*
+ * Writes an array padded to the 8-byte boundary.
+ */
+template <class value_type>
+static void
+cache_write_array(std::ostream& os, const std::vector<value_type>& v)
+{
+    static const char zero[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    size_t size = sizeof(value_type) * v.size();
+    if (!v.empty()) {
+        os.write(reinterpret_cast<const char*>(&v[0]), size);
+    }
+    if (size % 8 != 0) {
+        os.write(zero, 8 - size % 8);
+    }
+}
+
+static inline size_t
+cache_aligned(size_t size)
+{
+    return (size + 7) / 8 * 8;
+}
+
+/*
+ * Writes the strings of a quark.
+ */
+template <class quark_type>
+static void
+cache_write_quark(
+    std::ostream& os,
+    const quark_type* quark,
+    size_t& num_items,
+    size_t& num_chars,
+    bool header
+    )
+{
+    std::vector<size_t> offsets(1, 0);
+    std::vector<char> chars;
+    if (quark != NULL) {
+        for (size_t i = 0;i < (size_t)quark->size();++i) {
+            const std::string& str = quark->to_item(i);
+            chars.insert(chars.end(), str.begin(), str.end());
+            offsets.push_back(chars.size());
+        }
+    }
+    num_items = offsets.size() - 1;
+    num_chars = chars.size();
+    if (!header) {
+        cache_write_array(os, offsets);
+        cache_write_array(os, chars);
+    }
+}
+
+/*
+ * Writes a data set to a cache file.
+ *  This function writes the instances read from the source files together
+ *  with the attribute and label quarks (labels may be NULL).
+ */
+template <class data_type, class attributes_quark_type, class labels_quark_type>
+static void
+write_cache_file(
+    const std::string& filename,
+    const data_type& data,
+    const attributes_quark_type* attributes,
+    const labels_quark_type* labels,
+    int type,
+    int num_groups,
+    const option& opt
+    )
+{
+    typedef typename data_type::const_iterator const_iterator;
+
+    std::ofstream os(filename.c_str(), std::ios::out | std::ios::binary);
+    if (os.fail()) {
+        throw invalid_data("Failed to open the cache file for writing", filename);
+    }
+
+    // Fill the header.
+    cache_header header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, CACHE_MAGIC, 8);
+    header.version = CACHE_VERSION;
+    header.byteorder = 0x12345678;
+    header.sizeof_offset = (int)sizeof(size_t);
+    header.type = type;
+    header.num_groups = num_groups;
+    header.user_feature_start = data.get_user_feature_start();
+    header.bias = opt.bias;
+    header.num_instances = data.size();
+    for (const_iterator iti = data.begin();iti != data.end();++iti) {
+        const size_t V = cache_num_vectors(*iti);
+        header.num_vectors += V;
+        for (size_t j = 0;j < V;++j) {
+            header.num_elements += cache_vector(*iti, j).size();
+        }
+    }
+    cache_write_quark(os, attributes, header.num_attributes, header.attribute_chars, true);
+    cache_write_quark(os, labels, header.num_labels, header.label_chars, true);
+    os.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    if (sizeof(header) % 8 != 0) {
+        static const char zero[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+        os.write(zero, 8 - sizeof(header) % 8);
+    }
+
+    // Write the instance arrays.
+    {
+        std::vector<int> values;
+        values.reserve(data.size());
+        for (const_iterator iti = data.begin();iti != data.end();++iti) {
+            values.push_back(cache_label(*iti));
+        }
+        cache_write_array(os, values);
+
+        values.clear();
+        for (const_iterator iti = data.begin();iti != data.end();++iti) {
+            values.push_back(iti->get_group());
+        }
+        cache_write_array(os, values);
+    }
+    {
+        std::vector<double> weights;
+        weights.reserve(data.size());
+        for (const_iterator iti = data.begin();iti != data.end();++iti) {
+            weights.push_back(iti->get_weight());
+        }
+        cache_write_array(os, weights);
+    }
+    {
+        std::vector<size_t> offsets;
+        offsets.reserve(data.size()+1);
+        size_t n = 0;
+        offsets.push_back(n);
+        for (const_iterator iti = data.begin();iti != data.end();++iti) {
+            n += cache_num_vectors(*iti);
+            offsets.push_back(n);
+        }
+        cache_write_array(os, offsets);
+
+        offsets.clear();
+        offsets.reserve(header.num_vectors+1);
+        n = 0;
+        offsets.push_back(n);
+        for (const_iterator iti = data.begin();iti != data.end();++iti) {
+            const size_t V = cache_num_vectors(*iti);
+            for (size_t j = 0;j < V;++j) {
+                n += cache_vector(*iti, j).size();
+                offsets.push_back(n);
+            }
+        }
+        cache_write_array(os, offsets);
+    }
+
+    // Write the element arrays.
+    {
+        std::vector<int> ids;
+        ids.reserve(header.num_elements);
+        for (const_iterator iti = data.begin();iti != data.end();++iti) {
+            const size_t V = cache_num_vectors(*iti);
+            for (size_t j = 0;j < V;++j) {
+                cache_append_elements(&ids, NULL, cache_vector(*iti, j));
+            }
+        }
+        cache_write_array(os, ids);
+    }
+    {
+        std::vector<double> values;
+        values.reserve(header.num_elements);
+        for (const_iterator iti = data.begin();iti != data.end();++iti) {
+            const size_t V = cache_num_vectors(*iti);
+            for (size_t j = 0;j < V;++j) {
+                cache_append_elements(NULL, &values, cache_vector(*iti, j));
+            }
+        }
+        cache_write_array(os, values);
+    }
+
+    // Write the quarks.
+    cache_write_quark(os, attributes, header.num_attributes, header.attribute_chars, false);
+    cache_write_quark(os, labels, header.num_labels, header.label_chars, false);
+
+    if (os.fail()) {
+        throw invalid_data("Failed to write the cache file", filename);
+    }
+}
+
+/*
+ * Restores the strings of a quark.
+ */
+template <class quark_type>
+static void
+cache_read_quark(
+    quark_type* quark,
+    const size_t* offsets,
+    const char* chars,
+    size_t n
+    )
+{
+    if (quark == NULL) {
+        return;
+    }
+    for (size_t i = 0;i < n;++i) {
+        std::string str(chars + offsets[i], offsets[i+1] - offsets[i]);
+        if ((size_t)(*quark)(str) != i) {
+            throw invalid_data("Inconsistent string table in the cache file", str);
+        }
+    }
+}
+
+/*
+ * Reads a data set from a cache file.
+ *  This function maps the cache file into memory and restores the instances
+ *  and quarks without parsing text. The function returns the number of
+ *  groups in the data set.
+ */
+template <class data_type, class attributes_quark_type, class labels_quark_type>
+static int
+read_cache_file(
+    const std::string& filename,
+    data_type& data,
+    attributes_quark_type* attributes,
+    labels_quark_type* labels,
+    int type,
+    const option& opt
+    )
+{
+    typedef typename data_type::instance_type instance_type;
+
+    mapped_file mf;
+    if (!mf.open(filename)) {
+        throw invalid_data("Failed to open the cache file", filename);
+    }
+
+    // Check the header.
+    cache_header header;
+    if (mf.size() < sizeof(header)) {
+        throw invalid_data("Broken cache file", filename);
+    }
+    std::memcpy(&header, mf.data(), sizeof(header));
+    if (std::memcmp(header.magic, CACHE_MAGIC, 8) != 0 ||
+        header.version != CACHE_VERSION ||
+        header.byteorder != 0x12345678 ||
+        header.sizeof_offset != (int)sizeof(size_t)) {
+        throw invalid_data("Unsupported cache file", filename);
+    }
+    if (header.type != type) {
+        throw invalid_data("The cache file was created for another task type", filename);
+    }
+    if (header.bias != opt.bias) {
+        throw invalid_data("The cache file was created with another bias value", filename);
+    }
+
+    // Locate the arrays.
+    const size_t N = header.num_instances;
+    const size_t V = header.num_vectors;
+    const size_t E = header.num_elements;
+    const size_t A = header.num_attributes;
+    const size_t L = header.num_labels;
+    size_t offset = cache_aligned(sizeof(header));
+    const int* labels_array = reinterpret_cast<const int*>(mf.data() + offset);
+    offset += cache_aligned(sizeof(int) * N);
+    const int* groups_array = reinterpret_cast<const int*>(mf.data() + offset);
+    offset += cache_aligned(sizeof(int) * N);
+    const double* weights_array = reinterpret_cast<const double*>(mf.data() + offset);
+    offset += cache_aligned(sizeof(double) * N);
+    const size_t* instance_vectors = reinterpret_cast<const size_t*>(mf.data() + offset);
+    offset += cache_aligned(sizeof(size_t) * (N+1));
+    const size_t* vector_elements = reinterpret_cast<const size_t*>(mf.data() + offset);
+    offset += cache_aligned(sizeof(size_t) * (V+1));
+    const int* ids_array = reinterpret_cast<const int*>(mf.data() + offset);
+    offset += cache_aligned(sizeof(int) * E);
+    const double* values_array = reinterpret_cast<const double*>(mf.data() + offset);
+    offset += cache_aligned(sizeof(double) * E);
+    const size_t* attribute_offsets = reinterpret_cast<const size_t*>(mf.data() + offset);
+    offset += cache_aligned(sizeof(size_t) * (A+1));
+    const char* attribute_chars = mf.data() + offset;
+    offset += cache_aligned(header.attribute_chars);
+    const size_t* label_offsets = reinterpret_cast<const size_t*>(mf.data() + offset);
+    offset += cache_aligned(sizeof(size_t) * (L+1));
+    const char* label_chars = mf.data() + offset;
+    offset += cache_aligned(header.label_chars);
+    if (mf.size() < offset) {
+        throw invalid_data("Truncated cache file", filename);
+    }
+
+    // Restore the quarks so that the identifiers are assigned in order.
+    cache_read_quark(attributes, attribute_offsets, attribute_chars, A);
+    cache_read_quark(labels, label_offsets, label_chars, L);
+
+    // Restore the instances.
+    for (size_t i = 0;i < N;++i) {
+        instance_type& inst = data.new_element();
+        cache_set_label(inst, labels_array[i]);
+        inst.set_group(groups_array[i]);
+        inst.set_weight(weights_array[i]);
+        for (size_t j = instance_vectors[i];j < instance_vectors[i+1];++j) {
+            cache_restore_elements(
+                cache_new_vector(inst), ids_array, values_array,
+                vector_elements[j], vector_elements[j+1]);
+        }
+    }
+    data.set_user_feature_start(header.user_feature_start);
+
+    return header.num_groups;
+}
+
+#endif/*__CACHE_H__*/
@@ -46,7 +46,9 @@
 #include <classias/train/online_scheduler.h>
 
 #include "option.h"
+#include "reader.h"
 #include "tokenize.h"
+#include "writer.h"
 #include "train.h"
 
 /* Automatic generation of bias features is not supported. */
@@ -73,39 +75,29 @@ template <
 >
 static void
 read_line(
-    const std::string& line,
+    const staged_line& sl,
     instance_type& instance,
     features_quark_type& features,
     label_quark_type& labels,
-    const option& opt,
-    int lines = 0
+    const option& opt
     )
 {
-    std::string name;
+    std::string str;
     typedef typename instance_type::candidate_type candidate_type;
 
-    // Split the line with tab characters.
-    tokenizer values(line, opt.token_separator);
-    tokenizer::iterator itv = values.begin();
-    if (itv == values.end()) {
-        throw invalid_data("no field found in the line", line, lines);
-    }
-
     // Make sure that the first token (class) is not empty.
-    if (itv->empty()) {
-        throw invalid_data("an empty label found", line, lines);
+    if (sl.label.empty()) {
+        throw invalid_data("an empty label found", sl.str(), sl.lines);
     }
 
-    name = *itv;
-
     // Set the truth value for this candidate.
     bool truth = false;
-    if (name.compare(0, 1, "+") == 0) {
+    if (sl.label[0] == '+') {
         truth = true;
-    } else if (name.compare(0, 1, "-") == 0) {
+    } else if (sl.label[0] == '-') {
         truth = false;
     } else {
-        throw invalid_data("a class label must begins with '+' or '-'", line, lines);
+        throw invalid_data("a class label must begins with '+' or '-'", sl.str(), sl.lines);
     }
 
     // Create a new candidate.
@@ -115,70 +107,51 @@ read_line(
     }
 
     // Set featuress for the instance.
-    for (++itv;itv != values.end();++itv) {
-        if (!itv->empty()) {
-            double value;
-            get_name_value(*itv, name, value, opt.value_separator);
-            if (opt.filter_string.empty() || REGEX_SEARCH(name, opt.filter)) {
-                cand.append(features(name), value);
-            }
-        }
+    for (const staged_field* it = sl.first;it != sl.last;++it) {
+        append_attribute(cand, features, it->name, it->value, str);
     }
 }
 
 template <
     class data_type
 >
-static void
-read_stream(
-    std::istream& is,
-    data_type& data,
-    const option& opt,
-    int group = 0
-    )
+struct candidate_line_handler
 {
-    int lines = 0;
     typedef typename data_type::instance_type instance_type;
 
-    for (;;) {
-        // Read a line.
-        std::string line;
-        std::getline(is, line);
-        if (is.eof()) {
-            break;
-        }
-        ++lines;
+    data_type& data;
+    const option& opt;
+    int group;
 
-        // Skip an empty line.
-        if (line.empty()) {
-            continue;
-        }
+    candidate_line_handler(data_type& _data, const option& _opt, int _group)
+        : data(_data), opt(_opt), group(_group)
+    {
+    }
 
-        // Skip a comment line.
-        if (line.compare(0, 1, "#") == 0) {
-            continue;
-        }
+    void operator()(const staged_line& sl)
+    {
+        const token& line = sl.line;
 
         // Read features that should not be regularized.
-        if (line.compare(0, 13, "@unregularize") == 0) {
+        if (line.substr(0, 13) == "@unregularize") {
             if (!data.empty()) {
-                throw invalid_data("Declarative @unregularize must precede an instance", line, lines);
+                throw invalid_data("Declarative @unregularize must precede an instance", sl.str(), sl.lines);
             }
 
             // Feature names for unregularization.
-            tokenizer values(line, opt.token_separator);
+            tokenizer values(line.begin(), line.end(), opt.token_separator);
             tokenizer::iterator itv = values.begin();
             for (++itv;itv != values.end();++itv) {
                 // Reserve early feature identifiers.
-                data.attributes(*itv);
+                reserve_attribute(data.attributes, itv->str());
             }
 
             // Set the start index of the user features.
-            data.set_user_feature_start(data.attributes.size());
+            data.set_user_feature_start((int)num_reserved_attributes(data.attributes));
 
-        } else if (line.compare(0, 4, "@boi") == 0) {
+        } else if (line.substr(0, 4) == "@boi") {
             double value;
-            std::string name;
+            token name;
             get_name_value(line, name, value, opt.value_separator);
 
             if (name == "@boi") {
@@ -190,18 +163,35 @@ read_stream(
 
         } else if (line == "@eoi") {
             if (data.empty()) {
-                throw invalid_data("Declarative @eoi found before a declarative @boi", line, lines);
+                throw invalid_data("Declarative @eoi found before a declarative @boi", sl.str(), sl.lines);
             }
 
             if (data.back().get_label() < 0) {
-                throw invalid_data("No true candidate exists in the current instance", line, lines);
+                throw invalid_data("No true candidate exists in the current instance", sl.str(), sl.lines);
             }
 
         } else {
             // A new candidate.
-            read_line(line, data.back(), data.attributes, data.labels, opt, lines);
+            read_line(sl, data.back(), data.attributes, data.labels, opt);
         }
     }
+};
+
+template <
+    class data_type
+>
+static void
+read_stream(
+    std::istream& is,
+    data_type& data,
+    const option& opt,
+    int group = 0
+    )
+{
+    // Read the lines (empty and comment lines are skipped by the reader);
+    // an instance (@boi ... @eoi) is never split into different chunks.
+    candidate_line_handler<data_type> handler(data, opt, group);
+    read_chunked(is, handler, opt, true);
 }
 
 template <
@@ -223,6 +213,33 @@ finalize_data(
     }
 }
 
+template <
+    class data_type
+>
+static int
+read_cache(
+    data_type& data,
+    const option& opt
+    )
+{
+    return read_cache_file(
+        opt.cache_in, data, &data.attributes, &data.labels, CACHE_CANDIDATE, opt);
+}
+
+template <
+    class data_type
+>
+static void
+write_cache(
+    const data_type& data,
+    const option& opt,
+    int num_groups
+    )
+{
+    write_cache_file(
+        opt.cache_out, data, &data.attributes, &data.labels, CACHE_CANDIDATE, num_groups, opt);
+}
+
 template <
     class data_type,
     class model_type
@@ -237,11 +254,13 @@ output_model(
     typedef int int_t;
     typedef typename model_type::value_type value_type;
 
-    // Open a model file for writing.
-    std::ofstream os(opt.model.c_str());
+    // Open a model file for writing; weights are written with the
+    // shortest digits that restore the values exactly.
+    std::ofstream ofs(opt.model.c_str());
+    text_writer os(&ofs);
 
     // Output a model type.
-    os << "@classias\tlinear\tcandidate" << std::endl;
+    os << "@classias\tlinear\tcandidate" << '\n';
 
     // Store the feature weights.
     for (int i = 0;i < (int)data.attributes.size();++i) {
@@ -249,44 +268,68 @@ output_model(
         if (w != 0.) {
             os <<
                 w << '\t' <<
-                data.attributes.to_item(i) << std::endl;
+                data.attributes.to_item(i) << '\n';
         }
     }
 }
 
-int candidate_train(option& opt)
+template <
+    class model_type
+>
+static void
+output_model(
+    classias::chdata& data,
+    const model_type& model,
+    const option& opt
+    )
+{
+    // Store the weights of all the identifiers.
+    std::vector<double> weights(data.attributes.size());
+    for (size_t i = 0;i < weights.size();++i) {
+        weights[i] = model[i];
+    }
+
+    write_hashed_model(
+        opt.model, option::TYPE_CANDIDATE, data.attributes, std::vector<std::string>(), weights);
+}
+
+template <
+    class data_type
+>
+static int
+train_algorithm(option& opt)
 {
     // Branches for training algorithms.
     if (opt.algorithm == "lbfgs.logistic") {
         return train<
-            classias::csdata,
-            classias::train::lbfgs_logistic_multi<classias::csdata>
+            data_type,
+            classias::train::lbfgs_logistic_multi<data_type>
         >(opt);
     } else if (opt.algorithm == "averaged_perceptron") {
-        return train<
-            classias::csdata,
-            classias::train::online_scheduler_multi<
-                classias::csdata,
+        return train_online<
+            data_type,
+            classias::train::mixing_online_scheduler_multi<
+                data_type,
                 classias::train::averaged_perceptron_multi<
                     classias::classify::linear_multi<classias::weight_vector>
                     >
                 >
             >(opt);
     } else if (opt.algorithm == "pegasos.logistic") {
-        return train<
-            classias::csdata,
-            classias::train::online_scheduler_multi<
-                classias::csdata,
+        return train_online<
+            data_type,
+            classias::train::parallel_online_scheduler_multi<
+                data_type,
                 classias::train::pegasos_multi<
                     classias::classify::linear_multi_logistic<classias::weight_vector>
                     >
                 >
             >(opt);
     } else if (opt.algorithm == "truncated_gradient.logistic") {
-        return train<
-            classias::csdata,
-            classias::train::online_scheduler_multi<
-                classias::csdata,
+        return train_online<
+            data_type,
+            classias::train::parallel_online_scheduler_multi<
+                data_type,
                 classias::train::truncated_gradient_multi<
                     classias::classify::linear_multi_logistic<classias::weight_vector>
                     >
@@ -296,3 +339,13 @@ int candidate_train(option& opt)
 
     throw invalid_algorithm(opt.algorithm);
 }
+
+int candidate_train(option& opt)
+{
+    // Branches for the attribute space.
+    if (0 < opt.hash_bits) {
+        return train_algorithm<classias::chdata>(opt);
+    } else {
+        return train_algorithm<classias::csdata>(opt);
+    }
+}
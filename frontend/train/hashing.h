@@ -0,0 +1,169 @@
+/*
+ *		Attribute quarks and feature hashing for the trainer.
+ *
+ * Copyright (c) 2008,2009 Naoaki Okazaki
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the names of the authors nor the names of its contributors
+ *       may be used to endorse or promote products derived from this
+ *       software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* $Id$ */
+
+#ifndef __HASHING_H__
+#define __HASHING_H__
+
+#include <iostream>
+#include <string>
+
+#include <classias/quark.h>
+#include <tokenize.h>
+
+#include "option.h"
+
+/*
+ * Accessors for the attribute quark of a data set.
+ *
+ *  The readers of the task types use these functions instead of calling the
+ *  attribute quark directly, so that the same code works with a string
+ *  quark (classias::string_quark) and hashed attributes (classias::hashing_quark).
+ *  A hashing quark never stores attribute names; names that need early
+ *  identifiers (the bias attribute and the attributes declared by
+ *  @unregularize) are reserved before the other attributes are hashed.
+ */
+template <class quark_type>
+inline static size_t
+reserve_attribute(quark_type& attributes, const std::string& name)
+{
+    return attributes(name);
+}
+
+inline static size_t
+reserve_attribute(classias::hashing_quark& attributes, const std::string& name)
+{
+    return attributes.reserve(name);
+}
+
+template <class quark_type>
+inline static size_t
+num_reserved_attributes(const quark_type& attributes)
+{
+    return attributes.size();
+}
+
+inline static size_t
+num_reserved_attributes(const classias::hashing_quark& attributes)
+{
+    return attributes.num_reserved();
+}
+
+template <class vector_type, class quark_type>
+inline static void
+append_attribute(
+    vector_type& v,
+    quark_type& attributes,
+    const token& name,
+    double value,
+    std::string& str
+    )
+{
+    name.assign_to(str);
+    v.append(attributes(str), value);
+}
+
+template <class vector_type>
+inline static void
+append_attribute(
+    vector_type& v,
+    classias::string_quark& attributes,
+    const token& name,
+    double value,
+    std::string& str
+    )
+{
+    // Look up the name in place; no string object is necessary.
+    v.append(attributes.associate(name.begin(), name.size()), value);
+}
+
+template <class vector_type>
+inline static void
+append_attribute(
+    vector_type& v,
+    classias::hashing_quark& attributes,
+    const token& name,
+    double value,
+    std::string& str
+    )
+{
+    // Hash the name in place; no string object is necessary.
+    double sign;
+    size_t aid = attributes.associate(name.begin(), name.size(), sign);
+    v.append(aid, sign * value);
+}
+
+/*
+ * Configures the attribute quark of a data set with the options.
+ */
+template <class quark_type>
+inline static void
+setup_attributes(quark_type& attributes, const option& opt)
+{
+}
+
+inline static void
+setup_attributes(classias::hashing_quark& attributes, const option& opt)
+{
+    attributes.set_bits(opt.hash_bits);
+    attributes.set_signed(opt.hash_signed);
+    attributes.set_report(opt.hash_report);
+
+    // Always reserve the bias attribute so that a tagger never hashes it,
+    // even when the model is trained without bias features.
+    attributes.reserve("__BIAS__");
+}
+
+/*
+ * Reports the statistics of the attribute quark of a data set.
+ */
+template <class quark_type>
+inline static void
+report_attributes(std::ostream& os, const quark_type& attributes)
+{
+}
+
+inline static void
+report_attributes(std::ostream& os, const classias::hashing_quark& attributes)
+{
+    os << "Feature hashing: " << attributes.bits() << " bits";
+    if (attributes.is_signed()) {
+        os << ", signed";
+    }
+    os << std::endl;
+    os << "Number of reserved attributes: " << attributes.num_reserved() << std::endl;
+    if (0 < attributes.num_used()) {
+        os << "Number of hashed attributes used: " << attributes.num_used() << std::endl;
+        os << "Number of hashed attributes with collisions: " << attributes.num_shared() << std::endl;
+    }
+}
+
+#endif/*__HASHING_H__*/
@@ -140,6 +140,32 @@ public:
         ON_OPTION_WITH_ARG(SHORTOPT('L') || LONGOPT("logbase"))
             logbase = arg;
 
+        ON_OPTION_WITH_ARG(LONGOPT("cache-in"))
+            cache_in = arg;
+
+        ON_OPTION_WITH_ARG(LONGOPT("cache-out"))
+            cache_out = arg;
+
+        ON_OPTION_WITH_ARG(LONGOPT("read-threads"))
+            read_threads = atoi(arg);
+
+        ON_OPTION_WITH_ARG(LONGOPT("hash"))
+            hash_bits = atoi(arg);
+            if (hash_bits < 1 || 30 < hash_bits) {
+                std::stringstream ss;
+                ss << "the number of bits for feature hashing must be 1 to 30: " << arg;
+                throw invalid_value(ss.str());
+            }
+
+        ON_OPTION(LONGOPT("hash-signed"))
+            hash_signed = true;
+
+        ON_OPTION(LONGOPT("hash-report"))
+            hash_report = true;
+
+        ON_OPTION(LONGOPT("stream"))
+            stream = true;
+
         ON_OPTION_WITH_ARG(SHORTOPT('s') || LONGOPT("token-separator"))
             if (strcmp(arg, " ") == 0 || strcasecmp(arg, "s") == 0 || strcasecmp(arg, "spc") == 0 || strcasecmp(arg, "space") == 0) {
                 token_separator = ' ';
@@ -184,8 +210,8 @@ static void usage(std::ostream& os, const char *argv0)
     os << "          are specified, this utility assigns a group number (1...N) to the" << std::endl;
     os << "          instances in each file if no file is specified, the utility reads a" << std::endl;
     os << "          data set from STDIN; if a file name has an extension '.gz', '.bz2'," << std::endl;
-    os << "          and '.xz', the utility uses 'gzip', 'bzip2', and 'xv' to decompress" << std::endl;
-    os << "          the input file" << std::endl;
+    os << "          and '.xz', the utility decompresses the input file with zlib, libbz2," << std::endl;
+    os << "          and liblzma (or 'gzip', 'bzip2', and 'xz' if not built with them)" << std::endl;
     os << std::endl;
     os << "OPTIONS:" << std::endl;
     os << "  -t, --type=TYPE       specify a task type (DEFAULT='multi-dense'):" << std::endl;
@@ -231,6 +257,28 @@ static void usage(std::ostream& os, const char *argv0)
     os << "                        The filename is determined automatically by the training" << std::endl;
     os << "                        algorithm, parameters, and source files" << std::endl;
     os << "  -L, --logbase=BASE    set the base name for a log file (used with -l option)" << std::endl;
+    os << "      --cache-out=FILE  store the data set read from the source files to a binary" << std::endl;
+    os << "                        cache FILE, which reflects the options '-b' and '-F'" << std::endl;
+    os << "      --cache-in=FILE   read the data set from a binary cache FILE created by" << std::endl;
+    os << "                        '--cache-out' instead of the source files; the task type" << std::endl;
+    os << "                        (binary, multi, or candidate) and bias value must match" << std::endl;
+    os << "      --read-threads=N  parse the source files with N threads (DEFAULT=1);" << std::endl;
+    os << "                        0 uses all processors; the data set is identical" << std::endl;
+    os << "                        regardless of the number of threads" << std::endl;
+    os << "      --hash=BITS       map attributes into 2^BITS identifiers by hashing their" << std::endl;
+    os << "                        names instead of storing the names; the model is then" << std::endl;
+    os << "                        written as a fixed-size weight array (not available" << std::endl;
+    os << "                        for multi-sparse and with a cache file)" << std::endl;
+    os << "      --hash-signed     multiply attribute values by a sign (+1 or -1)" << std::endl;
+    os << "                        determined by the hash of the attribute name" << std::endl;
+    os << "      --hash-report     count the hashed identifiers shared by different" << std::endl;
+    os << "                        attributes (uses 4 * 2^BITS bytes of memory)" << std::endl;
+    os << "      --stream          train a model with an online algorithm by reading the" << std::endl;
+    os << "                        source files in every epoch instead of storing the" << std::endl;
+    os << "                        data set in memory (binary and candidate only); the" << std::endl;
+    os << "                        instances are shuffled only within chunks, and Pegasos" << std::endl;
+    os << "                        and Truncated Gradient require '-p n=N' (the number" << std::endl;
+    os << "                        of instances); only one epoch is run for STDIN" << std::endl;
 #if     defined(HAVE_REGEX) || defined(HAVE_BOOST_REGEX_HPP)
     os << "  -F, --filter=REGEX    filter attributes whose names are matched by REGEX" << std::endl;
 #endif/*defined(HAVE_REGEX) || defined(HAVE_BOOST_REGEX_HPP)*/
@@ -324,6 +372,51 @@ int main(int argc, char *argv[])
         opt.os = &ofs;
     }
 
+    // Check the options for feature hashing.
+    if (0 < opt.hash_bits) {
+        if (opt.type == option::TYPE_MULTI_SPARSE) {
+            es << "ERROR: feature hashing is not available for the task type multi-sparse" << std::endl;
+            return 1;
+        }
+        if (!opt.cache_in.empty() || !opt.cache_out.empty()) {
+            es << "ERROR: feature hashing cannot be used with a cache file" << std::endl;
+            return 1;
+        }
+    }
+
+    // Check the options for streaming.
+    if (opt.stream) {
+        if (opt.type == option::TYPE_MULTI_SPARSE || opt.type == option::TYPE_MULTI_DENSE) {
+            es << "ERROR: streaming is not available for the task type multi-dense and multi-sparse" << std::endl;
+            return 1;
+        }
+        if (opt.algorithm == "lbfgs.logistic") {
+            es << "ERROR: streaming is available only for online training algorithms" << std::endl;
+            return 1;
+        }
+        if (!opt.cache_in.empty() || !opt.cache_out.empty()) {
+            es << "ERROR: streaming cannot be used with a cache file" << std::endl;
+            return 1;
+        }
+        if (opt.shuffle || 0 < opt.split || 0 < opt.holdout || opt.cross_validation) {
+            es << "ERROR: streaming cannot be used with shuffling, splitting, holdout evaluation, or cross validation" << std::endl;
+            return 1;
+        }
+        if (opt.algorithm.compare(0, 8, "pegasos.") == 0 ||
+            opt.algorithm.compare(0, 19, "truncated_gradient.") == 0) {
+            bool has_n = false;
+            for (int i = 0;i < (int)opt.params.size();++i) {
+                if (opt.params[i].compare(0, 2, "n=") == 0) {
+                    has_n = true;
+                }
+            }
+            if (!has_n) {
+                es << "ERROR: streaming with " << opt.algorithm << " requires the number of instances (-p n=N)" << std::endl;
+                return 1;
+            }
+        }
+    }
+
     // Branch for tasks.
     try {
         switch (opt.type) {
@@ -46,7 +46,9 @@
 #include <classias/train/online_scheduler.h>
 
 #include "option.h"
+#include "reader.h"
 #include "tokenize.h"
+#include "writer.h"
 #include "train.h"
 
 /*
@@ -67,46 +69,33 @@ template <
 >
 static void
 read_line(
-    const std::string& line,
+    const staged_line& sl,
     instance_type& instance,
     attributes_quark_type& attributes,
     label_quark_type& labels,
-    const option& opt,
-    int lines = 0
+    const option& opt
     )
 {
     double value;
-    std::string name;
-
-    // Split the line with tab characters.
-    tokenizer values(line, opt.token_separator);
-    tokenizer::iterator itv = values.begin();
-    if (itv == values.end()) {
-        throw invalid_data("no field found in the line", line, lines);
-    }
+    token name;
+    std::string str;
 
     // Make sure that the first token (class) is not empty.
-    if (itv->empty()) {
-        throw invalid_data("an empty label found", line, lines);
+    if (sl.label.empty()) {
+        throw invalid_data("an empty label found", sl.str(), sl.lines);
     }
 
     // Parse the instance label.
-    get_name_value(*itv, name, value, opt.value_separator);
+    get_name_value(sl.label, name, value, opt.value_separator);
 
     // Set the instance label and weight.
-    instance.set_label(labels(name));
+    name.assign_to(str);
+    instance.set_label(labels(str));
     instance.set_weight(value);
 
     // Set attributes for the instance.
-    for (++itv;itv != values.end();++itv) {
-        if (!itv->empty()) {
-            double value;
-            std::string name;
-            get_name_value(*itv, name, value, opt.value_separator);
-            if (opt.filter_string.empty() || REGEX_SEARCH(name, opt.filter)) {
-                instance.append(attributes(name), value);
-            }
-        }
+    for (const staged_field* it = sl.first;it != sl.last;++it) {
+        append_attribute(instance, attributes, it->name, it->value, str);
     }
 
     // Include a bias feature if necessary.
@@ -115,6 +104,32 @@ read_line(
     }
 }
 
+template <
+    class data_type
+>
+struct multi_line_handler
+{
+    typedef typename data_type::instance_type instance_type;
+
+    data_type& data;
+    const option& opt;
+    int group;
+
+    multi_line_handler(data_type& _data, const option& _opt, int _group)
+        : data(_data), opt(_opt), group(_group)
+    {
+    }
+
+    void operator()(const staged_line& sl)
+    {
+        // Create a new instance.
+        instance_type& inst = data.new_element();
+        inst.set_group(group);
+
+        read_line(sl, inst, data.attributes, data.labels, opt);
+    }
+};
+
 template <
     class data_type
 >
@@ -126,43 +141,18 @@ read_stream(
     int group = 0
     )
 {
-    int lines = 0;
-    typedef typename data_type::instance_type instance_type;
-
     // If necessary, generate a bias attribute here to reserve feature #0.
     if (opt.bias != 0.) {
-        int aid = (int)data.attributes("__BIAS__");
+        int aid = (int)reserve_attribute(data.attributes, "__BIAS__");
         if (aid != 0) {
             throw invalid_data("A bias attribute could not obtain #0");
         }
         // We will reserve the bias feature(s) in finalize_data() function.
     }
 
-    for (;;) {
-        // Read a line.
-        std::string line;
-        std::getline(is, line);
-        if (is.eof()) {
-            break;
-        }
-        ++lines;
-
-        // Skip an empty line.
-        if (line.empty()) {
-            continue;
-        }
-
-        // Skip a comment line.
-        if (line.compare(0, 1, "#") == 0) {
-            continue;
-        }
-
-        // Create a new instance.
-        instance_type& inst = data.new_element();
-        inst.set_group(group);
-
-        read_line(line, inst, data.attributes, data.labels, opt, lines);
-    }
+    // Read the lines (empty and comment lines are skipped by the reader).
+    multi_line_handler<data_type> handler(data, opt, group);
+    read_chunked(is, handler, opt);
 }
 
 template <
@@ -178,7 +168,7 @@ finalize_data(
 
     // If necessary, reserve early feature numbers for bias features.
     if (opt.bias != 0.) {
-        int_t aid = (int_t)data.attributes("__BIAS__");
+        int_t aid = (int_t)reserve_attribute(data.attributes, "__BIAS__");
         if (aid != 0) {
             throw invalid_data("A bias attribute could not obtain #0");
         }
@@ -196,6 +186,33 @@ finalize_data(
     }
 }
 
+template <
+    class data_type
+>
+static int
+read_cache(
+    data_type& data,
+    const option& opt
+    )
+{
+    return read_cache_file(
+        opt.cache_in, data, &data.attributes, &data.labels, CACHE_MULTI, opt);
+}
+
+template <
+    class data_type
+>
+static void
+write_cache(
+    const data_type& data,
+    const option& opt,
+    int num_groups
+    )
+{
+    write_cache_file(
+        opt.cache_out, data, &data.attributes, &data.labels, CACHE_MULTI, num_groups, opt);
+}
+
 template <
     class data_type,
     class model_type
@@ -214,16 +231,18 @@ output_model(
     typedef typename labels_quark_type::item_type label_type;
     typedef typename model_type::value_type value_type;
 
-    // Open a model file for writing.
-    std::ofstream os(opt.model.c_str());
+    // Open a model file for writing; weights are written with the
+    // shortest digits that restore the values exactly.
+    std::ofstream ofs(opt.model.c_str());
+    text_writer os(&ofs);
 
     // Output a model type.
     os << "@classias\tlinear\tmulti\t";
-    os << data.feature_generator.name() << std::endl;
+    os << data.feature_generator.name() << '\n';
 
     // Output a set of labels.
     for (int_t l = 0;l < data.num_labels();++l) {
-        os << "@label\t" << data.labels.to_item(l) << std::endl;
+        os << "@label\t" << data.labels.to_item(l) << '\n';
     }
 
     // Store the feature weights.
@@ -237,92 +256,100 @@ output_model(
             if (attr == "__BIAS__") {
                 w *= opt.bias;
             }
-            os << w << '\t' << attr << '\t' << label << std::endl;
+            os << w << '\t' << attr << '\t' << label << '\n';
         }
     }
 }
 
-int multi_train(option& opt)
+template <
+    class model_type
+>
+static void
+output_model(
+    classias::mhdata& data,
+    const model_type& model,
+    const option& opt
+    )
+{
+    const classias::hashing_quark& attributes = data.attributes;
+    const size_t L = (size_t)data.num_labels();
+
+    // Store the weights of all the features.
+    std::vector<double> weights((size_t)data.num_features());
+    for (size_t i = 0;i < weights.size();++i) {
+        weights[i] = model[i];
+    }
+
+    // Scale the weights of the bias features as a text model does.
+    size_t bid = attributes.to_value("__BIAS__");
+    for (size_t l = 0;l < L;++l) {
+        weights[bid * L + l] *= opt.bias;
+    }
+
+    // Store the labels.
+    std::vector<std::string> labels;
+    for (size_t l = 0;l < L;++l) {
+        labels.push_back(data.labels.to_item(l));
+    }
+
+    write_hashed_model(
+        opt.model, option::TYPE_MULTI_DENSE, attributes, labels, weights);
+}
+
+template <
+    class data_type
+>
+static int
+train_algorithm(option& opt)
 {
     // Branches for training algorithms.
     if (opt.algorithm == "lbfgs.logistic") {
-        if (opt.type == option::TYPE_MULTI_SPARSE) {
-            return train<
-                classias::nsdata,
-                classias::train::lbfgs_logistic_multi<classias::nsdata>
-            >(opt);
-        } else if (opt.type == option::TYPE_MULTI_DENSE) {
-            return train<
-                classias::msdata,
-                classias::train::lbfgs_logistic_multi<classias::msdata>
-            >(opt);
-        }
+        return train<
+            data_type,
+            classias::train::lbfgs_logistic_multi<data_type>
+        >(opt);
     } else if (opt.algorithm == "averaged_perceptron") {
-        if (opt.type == option::TYPE_MULTI_SPARSE) {
-            return train<
-                classias::nsdata,
-                classias::train::online_scheduler_multi<
-                    classias::nsdata,
-                    classias::train::averaged_perceptron_multi<
-                        classias::classify::linear_multi<classias::weight_vector>
-                        >
-                    >
-                >(opt);
-        } else if (opt.type == option::TYPE_MULTI_DENSE) {
-            return train<
-                classias::msdata,
-                classias::train::online_scheduler_multi<
-                    classias::msdata,
-                    classias::train::averaged_perceptron_multi<
-                        classias::classify::linear_multi<classias::weight_vector>
-                        >
+        return train<
+            data_type,
+            classias::train::mixing_online_scheduler_multi<
+                data_type,
+                classias::train::averaged_perceptron_multi<
+                    classias::classify::linear_multi<classias::weight_vector>
                     >
-                >(opt);
-        }
+                >
+            >(opt);
     } else if (opt.algorithm == "pegasos.logistic") {
-        if (opt.type == option::TYPE_MULTI_SPARSE) {
-            return train<
-                classias::nsdata,
-                classias::train::online_scheduler_multi<
-                    classias::nsdata,
-                    classias::train::pegasos_multi<
-                        classias::classify::linear_multi_logistic<classias::weight_vector>
-                        >
+        return train<
+            data_type,
+            classias::train::parallel_online_scheduler_multi<
+                data_type,
+                classias::train::pegasos_multi<
+                    classias::classify::linear_multi_logistic<classias::weight_vector>
                     >
-                >(opt);
-        } else if (opt.type == option::TYPE_MULTI_DENSE) {
-            return train<
-                classias::msdata,
-                classias::train::online_scheduler_multi<
-                    classias::msdata,
-                    classias::train::pegasos_multi<
-                        classias::classify::linear_multi_logistic<classias::weight_vector>
-                        >
-                    >
-                >(opt);
-        }
+                >
+            >(opt);
     } else if (opt.algorithm == "truncated_gradient.logistic") {
-        if (opt.type == option::TYPE_MULTI_SPARSE) {
-            return train<
-                classias::nsdata,
-                classias::train::online_scheduler_multi<
-                    classias::nsdata,
-                    classias::train::truncated_gradient_multi<
-                        classias::classify::linear_multi_logistic<classias::weight_vector>
-                        >
+        return train<
+            data_type,
+            classias::train::parallel_online_scheduler_multi<
+                data_type,
+                classias::train::truncated_gradient_multi<
+                    classias::classify::linear_multi_logistic<classias::weight_vector>
                     >
-                >(opt);
-        } else if (opt.type == option::TYPE_MULTI_DENSE) {
-            return train<
-                classias::msdata,
-                classias::train::online_scheduler_multi<
-                    classias::msdata,
-                    classias::train::truncated_gradient_multi<
-                        classias::classify::linear_multi_logistic<classias::weight_vector>
-                        >
-                    >
-                >(opt);
-        }
+                >
+            >(opt);
     }
     throw invalid_algorithm(opt.algorithm);
 }
+
+int multi_train(option& opt)
+{
+    // Branches for the attribute space and feature generator.
+    if (0 < opt.hash_bits) {
+        return train_algorithm<classias::mhdata>(opt);
+    } else if (opt.type == option::TYPE_MULTI_SPARSE) {
+        return train_algorithm<classias::nsdata>(opt);
+    } else {
+        return train_algorithm<classias::msdata>(opt);
+    }
+}
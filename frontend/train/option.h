@@ -107,6 +107,13 @@ public:
     labels_type negative_labels;
     bool        logfile;
     std::string logbase;
+    std::string cache_in;
+    std::string cache_out;
+    int         read_threads;
+    int         hash_bits;
+    bool        hash_signed;
+    bool        hash_report;
+    bool        stream;
 
     char        token_separator;
     char        value_separator;
@@ -121,7 +128,8 @@ public:
         algorithm("lbfgs.logistic"),        
         shuffle(false), bias(1.),
         split(0), holdout(-1), cross_validation(false),
-        logfile(false), logbase(""),
+        logfile(false), logbase(""), read_threads(1),
+        hash_bits(0), hash_signed(false), hash_report(false), stream(false),
         token_separator(' '), value_separator(':')
     {
     }
@@ -0,0 +1,257 @@
+/*
+ *		Chunked parser of training data.
+ *
+ * Copyright (c) 2008,2009 Naoaki Okazaki
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the names of the authors nor the names of its contributors
+ *       may be used to endorse or promote products derived from this
+ *       software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* $Id$ */
+
+#ifndef __READER_H__
+#define __READER_H__
+
+#include <cstring>
+#include <istream>
+#include <string>
+#include <vector>
+
+#include <classias/parallel.h>
+#include <tokenize.h>
+#include <chunk.h>
+
+#include "option.h"
+
+/*
+ * Parallel ingestion of training data.
+ *
+ *  The reader loads a large block of the source stream, splits the block
+ *  into chunks at line boundaries, and lets worker threads tokenize the
+ *  chunks into staging buffers. A staging buffer stores, for every line
+ *  that is neither empty nor a comment, the first field and the list of
+ *  (name, value) pairs of the other fields; names refer to the block in
+ *  memory and values are already converted into numbers. Features removed
+ *  by the filter (-F) are dropped at this stage.
+ *
+ *  The staged lines are then handed to a handler in the order of the
+ *  source, by the calling thread. Because the handler interns names into
+ *  the quarks sequentially, attribute and label identifiers are identical
+ *  to those assigned by reading the stream line by line.
+ */
+
+/* A (name, value) pair of a field. */
+struct staged_field
+{
+    token   name;
+    double  value;
+};
+
+/* A line that awaits to be stored in a data set. */
+struct staged_line
+{
+    /* The whole line (without the newline character). */
+    token   line;
+    /* The first field of the line (e.g., a label). */
+    token   label;
+    /* The line number in the source stream. */
+    int     lines;
+    /* The range of the other fields. */
+    const staged_field* first;
+    const staged_field* last;
+
+    inline std::string str() const
+    {
+        return line.str();
+    }
+};
+
+class chunk_parser
+{
+public:
+    typedef std::vector<staged_line> lines_type;
+    typedef std::vector<staged_field> fields_type;
+
+    const char* m_first;
+    const char* m_last;
+    const option* m_opt;
+
+    int         m_num_lines;
+    lines_type  m_lines;
+    fields_type m_fields;
+    std::vector<size_t> m_offsets;
+
+    chunk_parser() : m_first(NULL), m_last(NULL), m_opt(NULL), m_num_lines(0)
+    {
+    }
+
+    void operator()()
+    {
+        const option& opt = *m_opt;
+        std::string str;
+
+        m_num_lines = 0;
+        m_lines.clear();
+        m_fields.clear();
+        m_offsets.clear();
+
+        // The chunk consists of lines that are terminated by '\n'.
+        const char* p = m_first;
+        while (p != m_last) {
+            const char* eol = (const char*)std::memchr(p, '\n', m_last - p);
+            if (eol == NULL) {
+                eol = m_last;
+            }
+            ++m_num_lines;
+
+            // Skip an empty line and a comment line.
+            if (p != eol && *p != '#') {
+                staged_line sl;
+                sl.line = token(p, eol);
+                sl.lines = m_num_lines;
+                m_offsets.push_back(m_fields.size());
+
+                // The first field is stored as it is.
+                tokenizer values(p, eol, opt.token_separator);
+                tokenizer::iterator itv = values.begin();
+                sl.label = *itv;
+
+                // Split the other fields into names and values.
+                for (++itv;itv != values.end();++itv) {
+                    if (!itv->empty()) {
+                        staged_field sf;
+                        get_name_value(*itv, sf.name, sf.value, opt.value_separator);
+                        if (!opt.filter_string.empty()) {
+                            sf.name.assign_to(str);
+                            if (!REGEX_SEARCH(str, opt.filter)) {
+                                continue;
+                            }
+                        }
+                        m_fields.push_back(sf);
+                    }
+                }
+                m_lines.push_back(sl);
+            }
+
+            p = (eol != m_last) ? eol + 1 : eol;
+        }
+
+        // Resolve the ranges of fields now that the buffer does not move.
+        const staged_field* base = m_fields.empty() ? NULL : &m_fields[0];
+        for (size_t i = 0;i < m_lines.size();++i) {
+            size_t last = (i+1 < m_lines.size()) ? m_offsets[i+1] : m_fields.size();
+            m_lines[i].first = base + m_offsets[i];
+            m_lines[i].last = base + last;
+        }
+    }
+};
+
+/*
+ * Reads a stream and passes the staged lines to a handler.
+ *  @param  is          The input stream.
+ *  @param  handler     The handler, a function object called with the
+ *                      reference to a staged_line in the order of the
+ *                      source lines.
+ *  @param  opt         The options.
+ *  @param  instances   Keep '@boi' ... '@eoi' blocks in single chunks.
+ */
+template <class handler_type>
+static void
+read_chunked(
+    std::istream& is,
+    handler_type& handler,
+    const option& opt,
+    bool instances = false
+    )
+{
+    const size_t block_size = 16 << 20;
+    const int T = classias::resolve_num_threads(opt.read_threads);
+
+    int lines = 0;
+    size_t size = block_size;
+    std::vector<char> buffer;
+    std::string carry;
+    std::vector<chunk_parser> parsers(T);
+
+    for (;;) {
+        // Fill a block with the remainder of the previous block and the
+        // subsequent bytes from the stream.
+        buffer.resize(carry.size() + size);
+        std::memcpy(&buffer[0], carry.data(), carry.size());
+        is.read(&buffer[carry.size()], (std::streamsize)size);
+        size_t n = carry.size() + (size_t)is.gcount();
+        bool eof = !is;
+
+        // Process complete lines only. A last line without a newline
+        // character is ignored as std::getline() in the sequential reader
+        // would have done.
+        const char* first = &buffer[0];
+        size_t m = n;
+        while (0 < m && first[m-1] != '\n') {
+            --m;
+        }
+        if (m == 0 && !eof) {
+            // The block is shorter than a line; enlarge the block.
+            carry.assign(first, n);
+            size *= 2;
+            continue;
+        }
+        carry.assign(first + m, n - m);
+        const char* last = first + m;
+
+        // Assign chunks to threads.
+        const char* p = first;
+        for (int t = 0;t < T;++t) {
+            const char* q = last;
+            if (t+1 < T) {
+                q = first + (size_t)m * (t+1) / T;
+                q = find_chunk_boundary(q < p ? p : q, first, last, instances);
+            }
+            parsers[t].m_first = p;
+            parsers[t].m_last = q;
+            parsers[t].m_opt = &opt;
+            p = q;
+        }
+
+        // Tokenize the chunks in parallel.
+        classias::parallel_run(parsers);
+
+        // Store the lines sequentially in the order of the source.
+        for (int t = 0;t < T;++t) {
+            chunk_parser& cp = parsers[t];
+            for (size_t i = 0;i < cp.m_lines.size();++i) {
+                staged_line& sl = cp.m_lines[i];
+                sl.lines += lines;
+                handler(sl);
+            }
+            lines += cp.m_num_lines;
+        }
+
+        if (eof) {
+            break;
+        }
+    }
+}
+
+#endif/*__READER_H__*/
@@ -40,7 +40,11 @@
 #include <string>
 #include <vector>
 #include <libexecstream/exec-stream.h>
+#include <decompress.h>
+#include <hashed_model.h>
 #include <util.h>
+#include "cache.h"
+#include "hashing.h"
 
 template <
     class trainer_type,
@@ -131,6 +135,19 @@ read_data(
                     os << ": failed" << std::endl;
                     throw invalid_data("An error occurred when reading a file");
                 }
+            } else if (has_decoder(file)) {
+                // Read a compressed file with an in-process decoder.
+                decompress_stream ifs(file);
+                if (!ifs.fail()) {
+                    read_stream(ifs, data, opt, i);
+                    if (ifs.error()) {
+                        os << ": failed";
+                        throw invalid_data("An error occurred when decompressing a file");
+                    }
+                } else {
+                    os << ": failed" << std::endl;
+                    throw invalid_data("An error occurred when reading a file");
+                }
             } else {
                 // Read a compressed file from an external decompressor.
                 exec_stream_t proc;
@@ -162,15 +179,30 @@ read_dataset(
     const option& opt
     )
 {
-    // Read the training data.
-    read_data(data, opt);
+    int num_groups = 0;
+    std::ostream& os = *opt.os;
+
+    // Read the training data from the source files or a cache file.
+    if (!opt.cache_in.empty()) {
+        os << "- cache: " << opt.cache_in << std::endl;
+        num_groups = read_cache(data, opt);
+    } else {
+        read_data(data, opt);
+        num_groups = (int)opt.files.size();
+    }
+
+    // Store the data to a cache file if necessary.
+    if (!opt.cache_out.empty()) {
+        os << "Writing the cache file: " << opt.cache_out << std::endl;
+        write_cache(data, opt, num_groups);
+    }
 
     // Finalize the data.
     finalize_data(data, opt);
 
     // Shuffle instances if necessary.
     if (opt.shuffle) {
-        std::random_shuffle(data.begin(), data.end());
+        data.shuffle();
     }
 
     // Split the training data if necessary.
@@ -178,10 +210,36 @@ read_dataset(
         split_data(data, opt);
         return opt.split;
     } else {
-        return (int)opt.files.size();
+        return num_groups;
     }
 }
 
+static void
+output_configuration(
+    std::ostream& os,
+    const option& opt
+    )
+{
+    os << "Task type: ";
+    switch (opt.type) {
+    case option::TYPE_BINARY:       os << "binary";         break;
+    case option::TYPE_MULTI_DENSE:  os << "multi-dense";    break;
+    case option::TYPE_MULTI_SPARSE: os << "multi-sparse";   break;
+    case option::TYPE_CANDIDATE:    os << "candidate";      break;
+    }
+    os << std::endl;
+    os << "Training algorithm: " << opt.algorithm << std::endl;
+    os << "Instance shuffle: " << std::boolalpha << opt.shuffle << std::endl;
+    os << "Bias feature value: " << opt.bias << std::endl;
+    os << "Model file: " << opt.model << std::endl;
+    os << "Instance splitting: " << opt.split << std::endl;
+    os << "Holdout group: " << opt.holdout << std::endl;
+    os << "Cross validation: " << std::boolalpha << opt.cross_validation << std::endl;
+    os << "Attribute filter: " << opt.filter_string << std::endl;
+    os << "Start time: " << timestamp << std::endl;
+    os << std::endl;
+}
+
 template <
     class data_type,
     class trainer_type
@@ -202,27 +260,15 @@ train(option& opt)
     }
 
 	// Report the start time and global configurations.
-    os << "Task type: ";
-    switch (opt.type) {
-    case option::TYPE_BINARY:       os << "binary";         break;
-    case option::TYPE_MULTI_DENSE:  os << "multi-dense";    break;
-    case option::TYPE_MULTI_SPARSE: os << "multi-sparse";   break;
-    case option::TYPE_CANDIDATE:    os << "candidate";      break;
-    }
-    os << std::endl;
-    os << "Training algorithm: " << opt.algorithm << std::endl;
-    os << "Instance shuffle: " << std::boolalpha << opt.shuffle << std::endl;
-    os << "Bias feature value: " << opt.bias << std::endl;
-    os << "Model file: " << opt.model << std::endl;
-    os << "Instance splitting: " << opt.split << std::endl;
-    os << "Holdout group: " << opt.holdout << std::endl;
-    os << "Cross validation: " << std::boolalpha << opt.cross_validation << std::endl;
-    os << "Attribute filter: " << opt.filter_string << std::endl;
-    os << "Start time: " << timestamp << std::endl;
-    os << std::endl;
+    output_configuration(os, opt);
 
     // Read the source data.
-    os << "Reading the data set from " << opt.files.size() << " files" << std::endl;
+    if (!opt.cache_in.empty()) {
+        os << "Reading the data set from a cache file" << std::endl;
+    } else {
+        os << "Reading the data set from " << opt.files.size() << " files" << std::endl;
+    }
+    setup_attributes(data.attributes, opt);
     sw.start();
     num_groups = read_dataset(data, opt);
     sw.stop();
@@ -231,6 +277,7 @@ train(option& opt)
     os << "Number of attributes: " << data.num_attributes() << std::endl;
     os << "Number of labels: " << data.num_labels() << std::endl;
     os << "Number of features: " << data.num_features() << std::endl;
+    report_attributes(os, data.attributes);
     os << "Seconds required: " << sw.get() << std::endl;
     os << std::endl;
 
@@ -289,4 +336,134 @@ train(option& opt)
     return 0;
 }
 
+/*
+ * A data set that sends its instances to a trainer in chunks.
+ *  This class replaces new_element() of the data set so that the instances
+ *  read so far are sent to the trainer (and erased) when the number of the
+ *  instances reaches the capacity. The quarks of the data set are kept.
+ */
+template <
+    class data_tmpl,
+    class trainer_tmpl
+>
+class stream_data : public data_tmpl
+{
+public:
+    typedef data_tmpl data_type;
+    typedef trainer_tmpl trainer_type;
+    typedef typename data_type::instance_type instance_type;
+
+    trainer_type*   trainer;
+    size_t          capacity;
+    size_t          num_instances;
+
+    stream_data(trainer_type* _trainer, size_t _capacity)
+        : trainer(_trainer), capacity(_capacity), num_instances(0)
+    {
+    }
+
+    instance_type& new_element()
+    {
+        // The previous instance is complete at this point.
+        if (capacity <= this->size()) {
+            flush();
+        }
+        return data_type::new_element();
+    }
+
+    void flush()
+    {
+        if (!this->empty()) {
+            num_instances += this->size();
+            trainer->stream(*this);
+            this->clear();
+        }
+    }
+};
+
+template <
+    class data_type,
+    class trainer_type
+>
+static int
+train_stream(option& opt)
+{
+    stopwatch sw;
+    std::ostream& os = *opt.os;
+
+    // Show the help message for the algorithm and exit if necessary.
+    if (opt.mode == option::MODE_HELP_ALGORITHM) {
+        trainer_type tr;
+        tr.params().help(os);
+        return 0;
+    }
+
+	// Report the start time and global configurations.
+    output_configuration(os, opt);
+
+    // Set training parameters.
+    trainer_type trainer;
+    stream_data<data_type, trainer_type> data(&trainer, 65536);
+    set_parameters(trainer, data, opt);
+    setup_attributes(data.attributes, opt);
+
+    // Start training.
+    sw.start();
+    trainer.begin_stream(os);
+    for (int k = 1;;++k) {
+        // Read the source data, and send the instances to the trainer.
+        os << "Streaming the data set from " << opt.files.size() << " files" << std::endl;
+        data.num_instances = 0;
+        read_data(data, opt);
+        data.flush();
+        os << "Number of instances: " << data.num_instances << std::endl;
+        os << "Number of features: " << data.num_features() << std::endl;
+
+        // Exit if the data set is empty.
+        if (data.num_instances == 0) {
+            throw invalid_data("The data set is empty", 0);
+        }
+
+        // STDIN cannot be read again.
+        if (trainer.end_stream(k, os) || opt.files.empty()) {
+            break;
+        }
+    }
+    trainer.finish_stream();
+    sw.stop();
+    os << "Seconds required: " << sw.get() << std::endl;
+    os << std::endl;
+    report_attributes(os, data.attributes);
+
+    // Store the model.
+    if (!opt.model.empty()) {
+        finalize_data(static_cast<data_type&>(data), opt);
+        output_model(static_cast<data_type&>(data), trainer.model(), opt);
+    }
+
+	// Report the finish time.
+    os << "Finish time: " << timestamp << std::endl;
+    os << std::endl;
+
+    return 0;
+}
+
+/*
+ * Trains a model with an online training algorithm, which can read the
+ * data set as a stream (--stream).
+ */
+template <
+    class data_type,
+    class trainer_type
+>
+static int
+train_online(option& opt)
+{
+    if (opt.stream) {
+        return train_stream<data_type, trainer_type>(opt);
+    } else {
+        return train<data_type, trainer_type>(opt);
+    }
+}
+
 #endif/*__TRAIN_H__*/
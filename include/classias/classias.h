@@ -44,6 +44,7 @@ namespace classias
 
 typedef std::vector<double> weight_vector;
 typedef default_vector<double> expandable_weight_vector;
+typedef paged_vector<double> paged_weight_vector;
 
 typedef dense_feature_generator_base<int, int, int> dense_feature_generator;
 typedef sparse_feature_generator_base<int, int, int> sparse_feature_generator;
@@ -53,19 +54,29 @@ typedef sparse_vector_base<int, double> sparse_attributes;
 
 typedef binary_instance_base<sparse_attributes> binstance;
 typedef binary_data_base<binstance> bdata;
-typedef binary_data_with_quark_base<binstance, quark> bsdata;
+typedef binary_data_with_quark_base<binstance, string_quark> bsdata;
+typedef binary_csr_data_base<int, double> bcsrdata;
+typedef binary_csr_data_with_quark_base<int, double, string_quark> bcsrsdata;
+typedef binary_csr_data_with_quark_base<int, double, hashing_quark> bcsrhdata;
 
 typedef candidate_instance_base<sparse_attributes> cinstance;
 typedef candidate_data_base<cinstance, thru_feature_generator> cdata;
-typedef candidate_data_with_quark_base<cinstance, quark, quark, thru_feature_generator> csdata;
+typedef candidate_data_with_quark_base<cinstance, string_quark, string_quark, thru_feature_generator> csdata;
+typedef candidate_data_with_quark_base<cinstance, hashing_quark, string_quark, thru_feature_generator> chdata;
 
 typedef multi_instance_base<sparse_attributes> minstance;
 typedef multi_data_base<minstance, dense_feature_generator> mdata;
-typedef multi_data_with_quark_base<minstance, quark, quark, dense_feature_generator> msdata;
+typedef multi_data_with_quark_base<minstance, string_quark, string_quark, dense_feature_generator> msdata;
+typedef multi_data_with_quark_base<minstance, hashing_quark, string_quark, dense_feature_generator> mhdata;
 
 typedef multi_instance_base<sparse_attributes> ninstance;
 typedef multi_data_base<ninstance, sparse_feature_generator> ndata;
-typedef multi_data_with_quark_base<ninstance, quark, quark, sparse_feature_generator> nsdata;
+typedef multi_data_with_quark_base<ninstance, string_quark, string_quark, sparse_feature_generator> nsdata;
+
+typedef compact_sparse_vector<int, double> compact_attributes;
+typedef compact_binary_instance<int, double> compact_binstance;
+typedef compact_multi_instance<int, double> compact_minstance;
+typedef compact_candidate_instance<compact_attributes> compact_cinstance;
 
 };
 
@@ -85,11 +96,21 @@ typedef multi_data_with_quark_base<ninstance, quark, quark, sparse_feature_gener
         \ref classias::multi_instance_base
     - Candidate instance:
         \ref classias::candidate_instance_base
+    - Compact binary instance without virtual tables:
+        \ref classias::compact_binary_instance
+    - Compact multi-class instance without virtual tables:
+        \ref classias::compact_multi_instance
+    - Compact candidate instance without virtual tables:
+        \ref classias::compact_candidate_instance
 - Data set
     - Binary data set:
         \ref classias::binary_data_base
     - Binary data set with a string quark for attributes:
         \ref classias::binary_data_with_quark_base
+    - Binary data set in compressed sparse row (CSR) format:
+        \ref classias::binary_csr_data_base
+    - Binary data set in CSR format with a string quark for attributes:
+        \ref classias::binary_csr_data_with_quark_base
     - Multi-class data set:
         \ref classias::multi_data_base
     - Multi-class data set with string quarks for attributes and labels:
@@ -145,10 +166,18 @@ typedef multi_data_with_quark_base<ninstance, quark, quark, sparse_feature_gener
         \ref classias::group_base
     - Sparse vector:
         \ref classias::sparse_vector_base
+    - Sparse vector without a virtual table:
+        \ref classias::compact_sparse_vector
     - Quark with one item (item-to-integer mapping):
         \ref classias::quark_base
     - Quark with two items (item-pair-to-integer mapping):
         \ref classias::quark2_base
+    - Quark with two integers in a flat hash table:
+        \ref classias::int_pair_quark
+    - Quark with strings in a flat hash table and an arena:
+        \ref classias::string_quark
+    - Quark with hashed identifiers (feature hashing):
+        \ref classias::hashing_quark
     - Quark exception:
         \ref classias::quark_error
 - Miscellaneous utilities
@@ -124,6 +124,16 @@ public:
         return m_score;
     }
 
+    /**
+     * Sets the score of the classification result.
+     *  This function is useful for reusing the score computed previously.
+     *  @param  score       The score.
+     */
+    inline void set_score(const value_type& score)
+    {
+        m_score = score;
+    }
+
     /**
      * Applies a scaling factor to the score.
      *  @param  scale       The scaling factor.
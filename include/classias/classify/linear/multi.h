@@ -33,7 +33,11 @@
 #ifndef __CLASSIAS_CLASSIFY_LINEAR_MULTI_H__
 #define __CLASSIAS_CLASSIFY_LINEAR_MULTI_H__
 
+#include <algorithm>
 #include <cmath>
+#include <vector>
+#include <classias/feature_generator.h>
+#include <classias/simd.h>
 
 namespace classias
 {
@@ -154,6 +158,17 @@ public:
         return m_scores[i];
     }
 
+    /**
+     * Sets the score of a candidate.
+     *  This function is useful for reusing the score computed previously.
+     *  @param  i           The index for the candidate.
+     *  @param  score       The score.
+     */
+    inline void set_score(int i, const value_type& score)
+    {
+        m_scores[i] = score;
+    }
+
     /**
      * Applies a scaling factor to a score.
      *  @param  i           The index for the candidate.
@@ -224,6 +239,99 @@ public:
         }
     }
 
+    /**
+     * Computes the scores of all candidates of an instance.
+     *
+     *  This function calls inner_product() for every candidate #i with the
+     *  attributes of the candidate and the label i. Call resize() to set
+     *  the number of candidates before calling this function.
+     *
+     *  @param  fgen        The feature generator.
+     *  @param  inst        The instance.
+     */
+    template <class feature_generator_type, class instance_type>
+    inline void inner_products(
+        const feature_generator_type& fgen,
+        const instance_type& inst
+        )
+    {
+        for (int i = 0;i < this->size();++i) {
+            this->inner_product(
+                i, fgen, inst.attributes(i).begin(), inst.attributes(i).end(), i);
+        }
+    }
+
+    /**
+     * Computes the scores of all labels of a multi-class instance.
+     *
+     *  The dense feature generator assigns the features of an attribute to
+     *  consecutive identifiers (a * L + l), so that this function traverses
+     *  the attributes of the instance only once and adds each attribute to
+     *  the scores of all labels from the contiguous row of weights. The
+     *  scores are identical to those of inner_product(). The attributes of
+     *  the instance must be shared by all labels.
+     *
+     *  @param  fgen        The feature generator.
+     *  @param  inst        The instance.
+     */
+    template <class attribute_type, class label_type, class feature_type, class instance_type>
+    inline void inner_products(
+        const dense_feature_generator_base<attribute_type, label_type, feature_type>& fgen,
+        const instance_type& inst
+        )
+    {
+        const int L = this->size();
+        if (L == 0 || (size_t)L != fgen.num_labels()) {
+            for (int i = 0;i < L;++i) {
+                this->inner_product(i, fgen, inst.begin(), inst.end(), i);
+            }
+            return;
+        }
+
+        std::fill(m_scores.begin(), m_scores.end(), 0.);
+        for (typename instance_type::const_iterator it = inst.begin();it != inst.end();++it) {
+            add_row(&m_scores[0], m_model, (size_t)it->first * L, L, it->second);
+        }
+    }
+
+    /**
+     * Computes the scores of all labels of a multi-class instance.
+     *
+     *  This function walks the compiled rows of the sparse feature
+     *  generator, which list the (label, feature) pairs of every attribute,
+     *  instead of looking up the feature of every pair of attribute and
+     *  label. The scores are identical to those of inner_product(). The
+     *  attributes of the instance must be shared by all labels.
+     *
+     *  @param  fgen        The feature generator.
+     *  @param  inst        The instance.
+     */
+    template <class attribute_type, class label_type, class feature_type, class instance_type>
+    inline void inner_products(
+        const sparse_feature_generator_base<attribute_type, label_type, feature_type>& fgen,
+        const instance_type& inst
+        )
+    {
+        typedef typename sparse_feature_generator_base<
+            attribute_type, label_type, feature_type>::label_feature_type
+            label_feature_type;
+
+        if (!fgen.compiled()) {
+            for (int i = 0;i < this->size();++i) {
+                this->inner_product(i, fgen, inst.begin(), inst.end(), i);
+            }
+            return;
+        }
+
+        std::fill(m_scores.begin(), m_scores.end(), 0.);
+        for (typename instance_type::const_iterator it = inst.begin();it != inst.end();++it) {
+            const label_feature_type* last = fgen.row_end(it->first);
+            for (const label_feature_type* p = fgen.row_begin(it->first);p != last;++p) {
+                m_scores[p->first] += m_model[p->second] * it->second;
+            }
+        }
+    }
+
     /**
      * Finalize the classification.
      *  Call this function before using argmax() function.
@@ -254,6 +362,50 @@ public:
         const static char *str = "linear classifier (multi)";
         return str;
     }
+
+protected:
+    /**
+     * Adds a row of feature weights, multiplied by a value, to the scores.
+     *  @param  s           The array of the scores [L].
+     *  @param  model       The model.
+     *  @param  base        The index of the first weight of the row.
+     *  @param  L           The number of labels.
+     *  @param  v           The value by which the weights are multiplied.
+     */
+    template <class vector_type>
+    static inline void add_row(
+        value_type* s,
+        const vector_type& model,
+        size_t base,
+        int L,
+        value_type v
+        )
+    {
+        for (int l = 0;l < L;++l) {
+            s[l] += model[base + l] * v;
+        }
+    }
+
+    /**
+     * Adds a row of feature weights, multiplied by a value, to the scores.
+     *  The weights of a std::vector are contiguous, so that this function
+     *  uses the vectorized simd::axpy().
+     *  @param  s           The array of the scores [L].
+     *  @param  model       The model.
+     *  @param  base        The index of the first weight of the row.
+     *  @param  L           The number of labels.
+     *  @param  v           The value by which the weights are multiplied.
+     */
+    static inline void add_row(
+        double* s,
+        const std::vector<double>& model,
+        size_t base,
+        int L,
+        double v
+        )
+    {
+        simd::axpy(s, &model[base], L, v);
+    }
 };
 
 
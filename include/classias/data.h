@@ -33,6 +33,10 @@
 #ifndef __CLASSIAS_DATA_H__
 #define __CLASSIAS_DATA_H__
 
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include <utility>
 #include <vector>
 
 namespace classias
@@ -202,6 +206,14 @@ public:
         return this->back();
     }
 
+    /**
+     * Reorders the instances randomly.
+     */
+    void shuffle()
+    {
+        std::random_shuffle(instances.begin(), instances.end());
+    }
+
     /**
      * Sets the start index of user features.
      *  @param  index       The start index of user features.
@@ -344,6 +356,716 @@ public:
 
 
 
+/**
+ * A random-access iterator over the elements of a CSR row.
+ *
+ *  This iterator walks through two parallel arrays, identifiers and values,
+ *  and exposes each element as a (identifier, value) pair so that the
+ *  member \c it->first presents an identifier and the member \c it->second
+ *  presents a value, as an iterator of sparse_vector_base does.
+ *
+ *  @param  identifier_tmpl The type of an identifier.
+ *  @param  value_tmpl      The type of a value.
+ */
+template <
+    class identifier_tmpl,
+    class value_tmpl
+>
+class csr_element_iterator
+{
+public:
+    /// The type of an element.
+    typedef std::pair<identifier_tmpl, value_tmpl> value_type;
+    /// The iterator category.
+    typedef std::random_access_iterator_tag iterator_category;
+    /// The type of the distance between iterators.
+    typedef std::ptrdiff_t difference_type;
+    /// The type of a pointer to an element.
+    typedef const value_type* pointer;
+    /// The type of a reference to an element.
+    typedef const value_type& reference;
+
+protected:
+    const identifier_tmpl* m_id;
+    const value_tmpl* m_value;
+    mutable value_type m_elem;
+
+public:
+    /**
+     * Constructs an iterator.
+     */
+    csr_element_iterator() : m_id(NULL), m_value(NULL)
+    {
+    }
+
+    /**
+     * Constructs an iterator.
+     *  @param  id          The pointer to the identifier of the element.
+     *  @param  value       The pointer to the value of the element.
+     */
+    csr_element_iterator(const identifier_tmpl* id, const value_tmpl* value)
+        : m_id(id), m_value(value)
+    {
+    }
+
+    inline reference operator*() const
+    {
+        m_elem.first = *m_id;
+        m_elem.second = *m_value;
+        return m_elem;
+    }
+
+    inline pointer operator->() const
+    {
+        return &operator*();
+    }
+
+    inline csr_element_iterator& operator++()
+    {
+        ++m_id;
+        ++m_value;
+        return *this;
+    }
+
+    inline csr_element_iterator& operator--()
+    {
+        --m_id;
+        --m_value;
+        return *this;
+    }
+
+    inline csr_element_iterator& operator+=(difference_type n)
+    {
+        m_id += n;
+        m_value += n;
+        return *this;
+    }
+
+    inline csr_element_iterator operator+(difference_type n) const
+    {
+        return csr_element_iterator(m_id + n, m_value + n);
+    }
+
+    inline difference_type operator-(const csr_element_iterator& x) const
+    {
+        return m_id - x.m_id;
+    }
+
+    inline bool operator==(const csr_element_iterator& x) const
+    {
+        return (m_id == x.m_id);
+    }
+
+    inline bool operator!=(const csr_element_iterator& x) const
+    {
+        return (m_id != x.m_id);
+    }
+
+    inline bool operator<(const csr_element_iterator& x) const
+    {
+        return (m_id < x.m_id);
+    }
+};
+
+
+
+/**
+ * A binary instance stored in a CSR data set.
+ *
+ *  This class is a lightweight reference to a row of binary_csr_data_base.
+ *  It provides the same interface as binary_instance_base, i.e., the label,
+ *  weight, group number, and iterators over the features of the instance.
+ *  Features can be appended only to the last instance of the data set.
+ *
+ *  @param  data_tmpl       The type of the data set.
+ */
+template <
+    class data_tmpl
+>
+class csr_binary_instance
+{
+public:
+    /// The type of this class, which also represents a feature vector.
+    typedef csr_binary_instance features_type;
+    /// The type of a feature identifier.
+    typedef typename data_tmpl::identifier_type identifier_type;
+    /// The type of an attribute identifier.
+    typedef identifier_type attribute_type;
+    /// The type of a feature value.
+    typedef typename data_tmpl::value_type value_type;
+    /// A type providing a read-only random-access iterator for features.
+    typedef csr_element_iterator<identifier_type, value_type> const_iterator;
+    /// A type providing a random-access iterator for features.
+    typedef const_iterator iterator;
+    /// A type counting the number of features.
+    typedef size_t size_type;
+
+protected:
+    data_tmpl* m_data;
+    size_t m_i;
+
+public:
+    /**
+     * Constructs an object.
+     *  @param  data        The pointer to the data set.
+     *  @param  i           The index of the instance.
+     */
+    csr_binary_instance(data_tmpl* data = NULL, size_t i = 0)
+        : m_data(data), m_i(i)
+    {
+    }
+
+    inline void set_label(bool l)
+    {
+        m_data->m_labels[m_i] = l;
+    }
+
+    inline bool get_label() const
+    {
+        return (m_data->m_labels[m_i] != 0);
+    }
+
+    inline void set_weight(double weight)
+    {
+        m_data->m_weights[m_i] = weight;
+    }
+
+    inline double get_weight() const
+    {
+        return m_data->m_weights[m_i];
+    }
+
+    inline void set_group(int group)
+    {
+        m_data->m_groups[m_i] = group;
+    }
+
+    inline int get_group() const
+    {
+        return m_data->m_groups[m_i];
+    }
+
+    inline const_iterator begin() const
+    {
+        const size_t k = m_data->m_offsets[m_i];
+        return const_iterator(m_data->ids() + k, m_data->values() + k);
+    }
+
+    inline const_iterator end() const
+    {
+        const size_t k = m_data->m_offsets[m_i+1];
+        return const_iterator(m_data->ids() + k, m_data->values() + k);
+    }
+
+    inline size_type size() const
+    {
+        return m_data->m_offsets[m_i+1] - m_data->m_offsets[m_i];
+    }
+
+    inline bool empty() const
+    {
+        return (size() == 0);
+    }
+
+    /**
+     * Appends a feature to the instance (the last one in the data set).
+     *  @param  id          The feature identifier.
+     *  @param  value       The feature value.
+     */
+    inline void append(const identifier_type& id, const value_type& value)
+    {
+        m_data->m_ids.push_back(id);
+        m_data->m_values.push_back(value);
+        ++m_data->m_offsets[m_i+1];
+    }
+
+    /**
+     * Reserves the memory for features of the instance.
+     *  The capacity of the arrays grows geometrically so that reserving
+     *  memory for every instance does not cause quadratic copies.
+     *  @param  n           The number of features.
+     */
+    inline void reserve(size_type n)
+    {
+        const size_t size = m_data->m_ids.size() + n;
+        if (m_data->m_ids.capacity() < size) {
+            const size_t capacity = std::max(size, 2 * m_data->m_ids.capacity());
+            m_data->m_ids.reserve(capacity);
+            m_data->m_values.reserve(capacity);
+        }
+    }
+};
+
+
+
+/**
+ * A random-access iterator over the instances of a CSR data set.
+ *  @param  data_tmpl       The type of the data set.
+ */
+template <
+    class data_tmpl
+>
+class csr_instance_iterator
+{
+public:
+    /// The type of an instance.
+    typedef csr_binary_instance<data_tmpl> value_type;
+    /// The iterator category.
+    typedef std::random_access_iterator_tag iterator_category;
+    /// The type of the distance between iterators.
+    typedef std::ptrdiff_t difference_type;
+    /// The type of a pointer to an instance.
+    typedef value_type* pointer;
+    /// The type of a reference to an instance.
+    typedef value_type& reference;
+
+protected:
+    data_tmpl* m_data;
+    size_t m_i;
+    mutable value_type m_inst;
+
+public:
+    /**
+     * Constructs an iterator.
+     */
+    csr_instance_iterator() : m_data(NULL), m_i(0)
+    {
+    }
+
+    /**
+     * Constructs an iterator.
+     *  @param  data        The pointer to the data set.
+     *  @param  i           The index of the instance.
+     */
+    csr_instance_iterator(data_tmpl* data, size_t i)
+        : m_data(data), m_i(i)
+    {
+    }
+
+    inline reference operator*() const
+    {
+        m_inst = value_type(m_data, m_i);
+        return m_inst;
+    }
+
+    inline pointer operator->() const
+    {
+        return &operator*();
+    }
+
+    inline csr_instance_iterator& operator++()
+    {
+        ++m_i;
+        return *this;
+    }
+
+    inline csr_instance_iterator& operator--()
+    {
+        --m_i;
+        return *this;
+    }
+
+    inline csr_instance_iterator& operator+=(difference_type n)
+    {
+        m_i += n;
+        return *this;
+    }
+
+    inline csr_instance_iterator operator+(difference_type n) const
+    {
+        return csr_instance_iterator(m_data, m_i + n);
+    }
+
+    inline difference_type operator-(const csr_instance_iterator& x) const
+    {
+        return (difference_type)m_i - (difference_type)x.m_i;
+    }
+
+    inline bool operator==(const csr_instance_iterator& x) const
+    {
+        return (m_i == x.m_i);
+    }
+
+    inline bool operator!=(const csr_instance_iterator& x) const
+    {
+        return (m_i != x.m_i);
+    }
+
+    inline bool operator<(const csr_instance_iterator& x) const
+    {
+        return (m_i < x.m_i);
+    }
+};
+
+
+
+/**
+ * A template class for a collection of binary-classification instances
+ * in compressed sparse row (CSR) format.
+ *
+ *  This class stores the features of all instances in two contiguous
+ *  arrays, feature identifiers and values, indexed by the array of row
+ *  offsets; labels, weights, and group numbers are stored in arrays
+ *  parallel to the instances. Compared with binary_data_base, this class
+ *  needs no heap block per instance and keeps the features of consecutive
+ *  instances adjacent in memory.
+ *
+ *  This class is interchangeable with binary_data_base for the training
+ *  algorithms: an iterator yields a csr_binary_instance, which provides
+ *  the interface of binary_instance_base. Instances must be built in
+ *  order; new_element() appends an instance to which features are added.
+ *
+ *  @param  identifier_tmpl The type of a feature identifier.
+ *  @param  value_tmpl      The type of a feature value.
+ */
+template <
+    class identifier_tmpl,
+    class value_tmpl
+>
+class binary_csr_data_base
+{
+public:
+    /// The type of this class.
+    typedef binary_csr_data_base<identifier_tmpl, value_tmpl> this_class;
+    /// The type of a feature identifier.
+    typedef identifier_tmpl identifier_type;
+    /// The type of a feature value.
+    typedef value_tmpl value_type;
+    /// The type of an instance.
+    typedef csr_binary_instance<this_class> instance_type;
+    /// A type counting the number of instances.
+    typedef size_t size_type;
+    /// A type providing a random-access iterator.
+    typedef csr_instance_iterator<this_class> iterator;
+    /// A type providing a read-only random-access iterator.
+    typedef csr_instance_iterator<this_class> const_iterator;
+    /// The type of an attribute.
+    typedef identifier_type attribute_type;
+
+    friend class csr_binary_instance<this_class>;
+
+protected:
+    /// The labels of instances (0 or 1).
+    std::vector<char> m_labels;
+    /// The weights of instances.
+    std::vector<double> m_weights;
+    /// The group numbers of instances.
+    std::vector<int> m_groups;
+    /// The offsets of the features of instances [size()+1].
+    std::vector<size_t> m_offsets;
+    /// The feature identifiers of all instances.
+    std::vector<identifier_type> m_ids;
+    /// The feature values of all instances.
+    std::vector<value_type> m_values;
+    /// The reference to the last instance.
+    instance_type m_back;
+    /// The number of features.
+    int m_num_features;
+    /// The start index of features.
+    int m_feature_start_index;
+
+public:
+    /**
+     * Constructs the object.
+     */
+    binary_csr_data_base()
+        : m_offsets(1, 0), m_num_features(0), m_feature_start_index(0)
+    {
+    }
+
+    /**
+     * Destructs the object.
+     */
+    virtual ~binary_csr_data_base()
+    {
+    }
+
+    /**
+     * Erases all the instances of the data.
+     */
+    inline void clear()
+    {
+        m_labels.clear();
+        m_weights.clear();
+        m_groups.clear();
+        m_offsets.assign(1, 0);
+        m_ids.clear();
+        m_values.clear();
+    }
+
+    /**
+     * Tests if the data is empty.
+     *  @retval bool        \c true if the data is empty,
+     *                      \c false otherwise.
+     */
+    inline bool empty() const
+    {
+        return m_labels.empty();
+    }
+
+    /**
+     * Returns the number of instances in the data.
+     *  @retval size_type   The current size of the data.
+     */
+    inline size_type size() const
+    {
+        return m_labels.size();
+    }
+
+    /**
+     * Returns the total number of features in the instances.
+     *  @retval size_t      The number of (identifier, value) elements.
+     */
+    inline size_t num_elements() const
+    {
+        return m_ids.size();
+    }
+
+    /**
+     * Returns a reference to an instance.
+     *  @param  i               The index number for an instance.
+     *  @retval instance_type   Reference to the instance.
+     */
+    inline instance_type operator[](size_type i) const
+    {
+        return instance_type(const_cast<this_class*>(this), i);
+    }
+
+    /**
+     * Returns a random-access iterator to the first instance.
+     *  @retval const_iterator  A random-access iterator addressing the
+     *                          first instance in the data.
+     */
+    inline const_iterator begin() const
+    {
+        return const_iterator(const_cast<this_class*>(this), 0);
+    }
+
+    /**
+     * Returns a random-access iterator pointing just beyond the last instance.
+     *  @retval const_iterator  A random-access iterator addressing the end
+     *                          of the instances.
+     */
+    inline const_iterator end() const
+    {
+        return const_iterator(const_cast<this_class*>(this), size());
+    }
+
+    /**
+     * Returns the reference to the last instance.
+     *  @retval instance_type&  The reference pointing to the last instance
+     *                          in the data.
+     */
+    inline instance_type& back()
+    {
+        m_back = instance_type(this, size()-1);
+        return m_back;
+    }
+
+    /**
+     * Creates and returns a new instance.
+     *  @retval instance_type&  The reference to the new instance.
+     */
+    inline instance_type& new_element()
+    {
+        m_labels.push_back(0);
+        m_weights.push_back(1.);
+        m_groups.push_back(0);
+        m_offsets.push_back(m_offsets.back());
+        return this->back();
+    }
+
+    /**
+     * Reorders the instances randomly.
+     *  The instances are permuted exactly as std::random_shuffle() permutes
+     *  the instances of binary_data_base.
+     */
+    void shuffle()
+    {
+        const size_t n = size();
+        std::vector<size_t> perm(n);
+        for (size_t i = 0;i < n;++i) {
+            perm[i] = i;
+        }
+        std::random_shuffle(perm.begin(), perm.end());
+
+        this_class dst;
+        dst.m_labels.reserve(n);
+        dst.m_weights.reserve(n);
+        dst.m_groups.reserve(n);
+        dst.m_offsets.reserve(n+1);
+        dst.m_ids.reserve(m_ids.size());
+        dst.m_values.reserve(m_values.size());
+        for (size_t i = 0;i < n;++i) {
+            const size_t j = perm[i];
+            dst.m_labels.push_back(m_labels[j]);
+            dst.m_weights.push_back(m_weights[j]);
+            dst.m_groups.push_back(m_groups[j]);
+            dst.m_ids.insert(dst.m_ids.end(),
+                m_ids.begin() + m_offsets[j], m_ids.begin() + m_offsets[j+1]);
+            dst.m_values.insert(dst.m_values.end(),
+                m_values.begin() + m_offsets[j], m_values.begin() + m_offsets[j+1]);
+            dst.m_offsets.push_back(dst.m_ids.size());
+        }
+
+        m_labels.swap(dst.m_labels);
+        m_weights.swap(dst.m_weights);
+        m_groups.swap(dst.m_groups);
+        m_offsets.swap(dst.m_offsets);
+        m_ids.swap(dst.m_ids);
+        m_values.swap(dst.m_values);
+    }
+
+    /**
+     * Sets the start index of user features.
+     *  @param  index       The start index of user features.
+     */
+    inline void set_user_feature_start(int index)
+    {
+        m_feature_start_index = index;
+    }
+
+    /**
+     * Returns the start index of user features.
+     *  @return fid_type    The start index of user features.
+     */
+    inline int get_user_feature_start() const
+    {
+        return m_feature_start_index;
+    }
+
+    /**
+     * Sets the total number of features.
+     *  @param  num         The number of features.
+     */
+    inline void set_num_features(int num)
+    {
+        m_num_features = num;
+    }
+
+    /**
+     * Returns the total number of attributes.
+     *  @return int         The total number of attributes.
+     */
+    int num_attributes() const
+    {
+        return m_num_features;
+    }
+
+    /**
+     * Returns the total number of labels.
+     *  @return int         The total number of labels. This is always 2 for
+     *                      the data collection for binary instances.
+     */
+    int num_labels() const
+    {
+        return 2;
+    }
+
+    /**
+     * Returns the total number of features.
+     *  @return int         The total number of features.
+     */
+    int num_features() const
+    {
+        return m_num_features;
+    }
+
+protected:
+    inline const identifier_type* ids() const
+    {
+        return m_ids.empty() ? NULL : &m_ids[0];
+    }
+
+    inline const value_type* values() const
+    {
+        return m_values.empty() ? NULL : &m_values[0];
+    }
+};
+
+
+
+/**
+ * A template class for a collection of binary-classification instances
+ * in CSR format with a quark assigning attribute identifiers.
+ *
+ *  @param  identifier_tmpl         The type of a feature identifier.
+ *  @param  value_tmpl              The type of a feature value.
+ *  @param  attributes_quark_tmpl   The type of an attribute quark.
+ */
+template <
+    class identifier_tmpl,
+    class value_tmpl,
+    class attributes_quark_tmpl
+>
+class binary_csr_data_with_quark_base :
+    public binary_csr_data_base<identifier_tmpl, value_tmpl>
+{
+public:
+    /// The type of the base class.
+    typedef binary_csr_data_base<identifier_tmpl, value_tmpl> base_type;
+    /// The type of an instance.
+    typedef typename base_type::instance_type instance_type;
+    /// The type of a feature vector.
+    typedef attributes_quark_tmpl attributes_quark_type;
+
+    /// A type counting the number of instances.
+    typedef typename base_type::size_type size_type;
+    /// A type providing a random-access iterator.
+    typedef typename base_type::iterator iterator;
+    /// A type providing a read-only random-access iterator.
+    typedef typename base_type::const_iterator const_iterator;
+    /// The type of an attribute.
+    typedef typename base_type::attribute_type attribute_type;
+
+    /// A feature quark.
+    attributes_quark_type attributes;
+
+    /**
+     * Constructs the object.
+     */
+    binary_csr_data_with_quark_base()
+    {
+    }
+
+    /**
+     * Destructs the object.
+     */
+    virtual ~binary_csr_data_with_quark_base()
+    {
+    }
+
+    /**
+     * Returns the total number of attributes.
+     *  @return int         The total number of attributes.
+     */
+    int num_attributes() const
+    {
+        return attributes.size();
+    }
+
+    /**
+     * Returns the total number of labels.
+     *  @return int         The total number of labels. This is always 2 for
+     *                      the data collection for binary instances.
+     */
+    int num_labels() const
+    {
+        return 2;
+    }
+
+    /**
+     * Returns the total number of features.
+     *  @return int         The total number of features.
+     */
+    int num_features() const
+    {
+        return attributes.size();
+    }
+};
+
+
+
 /**
  * A template class for a collection of candidate-classification instances.
  *
@@ -680,6 +1402,9 @@ public:
                 }
             }
         }
+
+        // Fix the features of every attribute for the trainers.
+        this->feature_generator.compile();
     }
 };
 
@@ -815,6 +1540,9 @@ public:
                 }
             }
         }
+
+        // Fix the features of every attribute for the trainers.
+        this->feature_generator.compile();
     }
 };
 
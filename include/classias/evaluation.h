@@ -77,6 +77,16 @@ public:
         ++m_n;
     }
 
+    /**
+     * Accumulates the counts of another object.
+     *  @param  rho         The counter to be merged.
+     */
+    inline void merge(const accuracy& rho)
+    {
+        m_m += rho.m_m;
+        m_n += rho.m_n;
+    }
+
     /**
      * Gets the accuracy.
      *  @return double      The accuracy.
@@ -162,6 +172,39 @@ public:
         if (r == p) m_stat[p].num_match++;
     }
 
+    /**
+     * Accumulates the counts of another object.
+     *  The label #i of \c rho corresponds to the label \c ids[i] of this
+     *  object; this object is enlarged to store the labels if necessary.
+     *  @param  rho         The counter to be merged.
+     *  @param  ids         The label identifiers for the labels of \c rho.
+     */
+    void merge(const precall& rho, const std::vector<int>& ids)
+    {
+        for (int i = 0;i < (int)rho.m_stat.size();++i) {
+            int j = ids[i];
+            if ((int)m_stat.size() <= j) {
+                m_stat.resize(j+1);
+            }
+            m_stat[j].num_match += rho.m_stat[i].num_match;
+            m_stat[j].num_reference += rho.m_stat[i].num_reference;
+            m_stat[j].num_prediction += rho.m_stat[i].num_prediction;
+        }
+    }
+
+    /**
+     * Accumulates the counts of another object with the same labels.
+     *  @param  rho         The counter to be merged.
+     */
+    void merge(const precall& rho)
+    {
+        std::vector<int> ids(rho.m_stat.size());
+        for (int i = 0;i < (int)ids.size();++i) {
+            ids[i] = i;
+        }
+        merge(rho, ids);
+    }
+
     template <class labels_type, class positive_iterator_type>
     void output_labelwise(
         std::ostream& os,
@@ -378,16 +421,7 @@ static void holdout_evaluation_multi(
 
         // Tell the classifier the number of possible labels.
         cls.resize(it->num_candidates(L));
-
-        for (int i = 0;i < it->num_candidates(L);++i) {
-            cls.inner_product(
-                i,
-                fgen,
-                it->attributes(i).begin(),
-                it->attributes(i).end(),
-                i
-                );
-        }
+        cls.inner_products(fgen, *it);
         cls.finalize();
 
         int argmax = cls.argmax();
@@ -33,6 +33,8 @@
 #ifndef __CLASSIAS_FEATURE_GENERATOR_H__
 #define __CLASSIAS_FEATURE_GENERATOR_H__
 
+#include <algorithm>
+#include <vector>
 #include "quark.h"
 
 namespace classias
@@ -138,6 +140,14 @@ public:
     {
     }
 
+    /**
+     * Compiles the feature generator after all features are registered.
+     *  This class does not need compilation; this function does nothing.
+     */
+    void compile()
+    {
+    }
+
     /**
      * Returns if this class requires registration.
      *  @return bool            This class always returns \c false.
@@ -308,6 +318,14 @@ public:
         m_num_labels = num_labels;
     }
 
+    /**
+     * Compiles the feature generator after all features are registered.
+     *  This class does not need compilation; this function does nothing.
+     */
+    void compile()
+    {
+    }
+
     /**
      * Returns if this class requires registration.
      *  @return bool    This class always returns \c false.
@@ -382,7 +400,9 @@ public:
  *  features is the unique number of combinations between attributes and
  *  labels. A conversion between attribute-label space and feature space is
  *  slower than dense_feature_generator_base, but feature space will be
- *  compact.
+ *  compact. Call compile() after registration to build the rows of
+ *  (label, feature) pairs of every attribute, with which trainers enumerate
+ *  the features of a multi-class instance without lookups.
  *
  *  @param  attribute_tmpl  The type of an attribute.
  *  @param  label_tmpl      The type of a label.
@@ -411,10 +431,20 @@ protected:
 
 protected:
     /// Class for associations from (attribute, label) to feature.
-    typedef quark2_base<attribute_type, label_type> feature_generator_type;
+    typedef int_pair_quark<attribute_type, label_type> feature_generator_type;
     /// Associations between (attribute, label) and features.
     feature_generator_type m_features;
 
+public:
+    /// A pair of a label and the feature for (attribute, label).
+    typedef std::pair<label_type, feature_type> label_feature_type;
+
+protected:
+    /// The offsets of the compiled rows, indexed by attributes.
+    std::vector<size_t> m_row_offsets;
+    /// The (label, feature) pairs of all attributes, sorted by labels.
+    std::vector<label_feature_type> m_rows;
+
 public:
     /**
      * Constructs an object.
@@ -494,9 +524,95 @@ public:
      */
     inline feature_type regist(const attribute_type& a, const label_type& l)
     {
+        if (!m_row_offsets.empty()) {
+            // A new feature invalidates the compiled rows.
+            m_row_offsets.clear();
+            m_rows.clear();
+        }
         return m_features.associate(a, l);
     }
 
+    /**
+     * Compiles the rows of (label, feature) pairs for every attribute.
+     *  Call this function after the last call of regist(). The mapping
+     *  from (attribute, label) to features is fixed after registration,
+     *  so that a trainer can enumerate the features of an attribute by
+     *  row_begin() and row_end() instead of calling forward() for every
+     *  label.
+     */
+    void compile()
+    {
+        const size_t K = m_features.size();
+        attribute_type a;
+        label_type l;
+
+        // Count the number of features for each attribute.
+        m_row_offsets.clear();
+        for (size_t f = 0;f < K;++f) {
+            m_features.to_item(f, a, l);
+            if (m_row_offsets.size() < (size_t)a + 2) {
+                m_row_offsets.resize((size_t)a + 2, 0);
+            }
+            ++m_row_offsets[a+1];
+        }
+        for (size_t i = 1;i < m_row_offsets.size();++i) {
+            m_row_offsets[i] += m_row_offsets[i-1];
+        }
+
+        // Store the (label, feature) pairs into the rows.
+        std::vector<size_t> pos(m_row_offsets);
+        m_rows.resize(K);
+        for (size_t f = 0;f < K;++f) {
+            m_features.to_item(f, a, l);
+            m_rows[pos[a]++] = label_feature_type(l, (feature_type)f);
+        }
+
+        // Sort the pairs in each row by labels.
+        for (size_t i = 0;i + 1 < m_row_offsets.size();++i) {
+            std::sort(
+                m_rows.begin() + m_row_offsets[i],
+                m_rows.begin() + m_row_offsets[i+1]
+                );
+        }
+    }
+
+    /**
+     * Returns if the rows have been compiled.
+     *  @return bool            \c true if compile() has been called after
+     *                          the last registration.
+     */
+    inline bool compiled() const
+    {
+        return !m_row_offsets.empty();
+    }
+
+    /**
+     * Returns the first (label, feature) pair of an attribute.
+     *  @param  a               The attribute.
+     *  @return const label_feature_type*   The pointer to the first pair.
+     */
+    inline const label_feature_type* row_begin(const attribute_type& a) const
+    {
+        if ((size_t)a + 1 < m_row_offsets.size()) {
+            return &m_rows[0] + m_row_offsets[a];
+        }
+        return NULL;
+    }
+
+    /**
+     * Returns the end of (label, feature) pairs of an attribute.
+     *  @param  a               The attribute.
+     *  @return const label_feature_type*   The pointer just beyond the last
+     *                          pair.
+     */
+    inline const label_feature_type* row_end(const attribute_type& a) const
+    {
+        if ((size_t)a + 1 < m_row_offsets.size()) {
+            return &m_rows[0] + m_row_offsets[a+1];
+        }
+        return NULL;
+    }
+
     /**
      * Returns the feature associated with a pair of an attribute and label.
      *  @param  a               The attribute.
@@ -33,6 +33,10 @@
 #ifndef __CLASSIAS_INSTANCE_H__
 #define __CLASSIAS_INSTANCE_H__
 
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
 #include <vector>
 #include "types.h"
 
@@ -446,6 +450,658 @@ public:
     }
 };
 
+
+
+/**
+ * A template class implementing the common part of compact instances.
+ *
+ *  This class stores a feature vector, a label, an instance weight, and a
+ *  group number in 24 bytes on 64-bit systems (with the default types):
+ *  a pointer to the elements, the number of elements, the label, the
+ *  weight, and the group number. The class has no virtual table, and the
+ *  capacity of the elements is implied by the number of elements (see
+ *  compact_capacity()). The elements are stored as compact_pair objects,
+ *  which are trivially copyable.
+ *
+ *  @param  identifier_tmpl The type of an attribute identifier.
+ *  @param  value_tmpl      The type of an attribute value.
+ *  @param  weight_tmpl     The type storing an instance weight.
+ */
+template <
+    class identifier_tmpl,
+    class value_tmpl,
+    class weight_tmpl
+>
+class compact_instance_base
+{
+public:
+    /// The type of an attribute identifier.
+    typedef identifier_tmpl identifier_type;
+    /// The type of an attribute identifier.
+    typedef identifier_tmpl attribute_type;
+    /// The type of an attribute value.
+    typedef value_tmpl value_type;
+    /// A type representing an element, a pair of (identifier, value).
+    typedef compact_pair<identifier_type, value_type> element_type;
+    /// A type counting the number of elements.
+    typedef size_t size_type;
+    /// A type providing a random-access iterator.
+    typedef element_type* iterator;
+    /// A type providing a read-only random-access iterator.
+    typedef const element_type* const_iterator;
+
+protected:
+    /// The array of (identifier, value) pairs.
+    element_type* m_elems;
+    /// The number of elements.
+    unsigned int m_size;
+    /// The label of this instance.
+    int m_label;
+    /// The instance weight.
+    weight_tmpl m_weight;
+    /// The group number.
+    int m_group;
+
+public:
+    /**
+     * Constructs an object.
+     *  @param  label       The initial label.
+     */
+    compact_instance_base(int label = 0)
+        : m_elems(NULL), m_size(0), m_label(label), m_weight(1), m_group(0)
+    {
+    }
+
+    /**
+     * Constructs an object by copying another.
+     *  @param  x           The instance to be copied.
+     */
+    compact_instance_base(const compact_instance_base& x)
+        : m_elems(NULL), m_size(0)
+    {
+        assign(x);
+    }
+
+#if     __cplusplus >= 201103L
+    /**
+     * Constructs an object by moving another.
+     *  @param  x           The instance to be moved.
+     */
+    compact_instance_base(compact_instance_base&& x) noexcept
+        : m_elems(x.m_elems), m_size(x.m_size), m_label(x.m_label),
+        m_weight(x.m_weight), m_group(x.m_group)
+    {
+        x.m_elems = NULL;
+        x.m_size = 0;
+    }
+#endif/*__cplusplus >= 201103L*/
+
+    /**
+     * Destructs the object.
+     */
+    ~compact_instance_base()
+    {
+        std::free(m_elems);
+    }
+
+    /**
+     * Copies another instance.
+     *  @param  x           The instance to be copied.
+     *  @return compact_instance_base&  The reference to this object.
+     */
+    compact_instance_base& operator=(const compact_instance_base& x)
+    {
+        if (this != &x) {
+            assign(x);
+        }
+        return *this;
+    }
+
+    /**
+     * Exchanges the content with another instance.
+     *  @param  x           The instance.
+     */
+    inline void swap(compact_instance_base& x)
+    {
+        std::swap(m_elems, x.m_elems);
+        std::swap(m_size, x.m_size);
+        std::swap(m_label, x.m_label);
+        std::swap(m_weight, x.m_weight);
+        std::swap(m_group, x.m_group);
+    }
+
+    inline void clear()
+    {
+        m_size = 0;
+    }
+
+    inline bool empty() const
+    {
+        return (m_size == 0);
+    }
+
+    inline size_type size() const
+    {
+        return m_size;
+    }
+
+    inline iterator begin()
+    {
+        return m_elems;
+    }
+
+    inline const_iterator begin() const
+    {
+        return m_elems;
+    }
+
+    inline iterator end()
+    {
+        return m_elems + m_size;
+    }
+
+    inline const_iterator end() const
+    {
+        return m_elems + m_size;
+    }
+
+    /**
+     * Reserves the storage for elements.
+     *  This function does nothing because the capacity is implied by the
+     *  number of elements; it exists for the compatibility with
+     *  sparse_vector_base.
+     *  @param  n           The number of elements to reserve.
+     */
+    inline void reserve(size_type n)
+    {
+    }
+
+    /**
+     * Appends an element (name, value) to the end of the vector.
+     *  @param  id          The element identifier.
+     *  @param  value       The element value.
+     */
+    inline void append(const identifier_type& id, const value_type& value)
+    {
+        if (m_size == compact_capacity(m_size)) {
+            m_elems = compact_realloc(m_elems, compact_capacity(m_size+1));
+        }
+        m_elems[m_size++] = element_type(id, value);
+    }
+
+    /**
+     * Sets the instance weight.
+     *  @param  weight      The instance weight.
+     */
+    inline void set_weight(double weight)
+    {
+        m_weight = (weight_tmpl)weight;
+    }
+
+    /**
+     * Gets the instance weight.
+     *  @return double      The instance weight.
+     */
+    inline double get_weight() const
+    {
+        return (double)m_weight;
+    }
+
+    /**
+     * Sets the group number.
+     *  @param  group       The group number.
+     */
+    inline void set_group(int group)
+    {
+        m_group = group;
+    }
+
+    /**
+     * Gets the group number.
+     *  @return int         The group number.
+     */
+    inline int get_group() const
+    {
+        return m_group;
+    }
+
+protected:
+    void assign(const compact_instance_base& x)
+    {
+        if (compact_capacity(m_size) < x.m_size) {
+            m_elems = compact_realloc(m_elems, compact_capacity(x.m_size));
+        }
+        if (0 < x.m_size) {
+            std::memcpy(m_elems, x.m_elems, sizeof(element_type) * x.m_size);
+        }
+        m_size = x.m_size;
+        m_label = x.m_label;
+        m_weight = x.m_weight;
+        m_group = x.m_group;
+    }
+};
+
+
+
+/**
+ * A template class for compact binary instances.
+ *
+ *  This class provides the interface of binary_instance_base with the
+ *  layout of compact_instance_base, i.e., without virtual tables and with
+ *  24 bytes of header per instance. The instance weight is stored in
+ *  single precision by default; specify \c double for weight_tmpl to keep
+ *  weights in double precision (32 bytes per instance).
+ *
+ *  @param  identifier_tmpl The type of a feature identifier.
+ *  @param  value_tmpl      The type of a feature value.
+ *  @param  weight_tmpl     The type storing an instance weight.
+ */
+template <
+    class identifier_tmpl = int,
+    class value_tmpl = double,
+    class weight_tmpl = float
+>
+class compact_binary_instance :
+    public compact_instance_base<identifier_tmpl, value_tmpl, weight_tmpl>
+{
+public:
+    /// The type of a feature vector (this class).
+    typedef compact_binary_instance features_type;
+
+    /**
+     * Constructs an object.
+     */
+    compact_binary_instance()
+    {
+    }
+
+    /**
+     * Sets the boolean label of the instance.
+     *  @param  l           The boolean label.
+     */
+    inline void set_label(bool l)
+    {
+        this->m_label = l ? 1 : 0;
+    }
+
+    /**
+     * Gets the boolean label of the instance.
+     *  @return bool        The boolean label of this instance.
+     */
+    inline bool get_label() const
+    {
+        return (this->m_label != 0);
+    }
+};
+
+template <class identifier_tmpl, class value_tmpl, class weight_tmpl>
+inline void swap(
+    compact_binary_instance<identifier_tmpl, value_tmpl, weight_tmpl>& x,
+    compact_binary_instance<identifier_tmpl, value_tmpl, weight_tmpl>& y
+    )
+{
+    x.swap(y);
+}
+
+
+
+/**
+ * A template class for compact multi-class instances.
+ *
+ *  This class provides the interface of multi_instance_base with the
+ *  layout of compact_instance_base, i.e., without virtual tables and with
+ *  24 bytes of header per instance.
+ *
+ *  @param  identifier_tmpl The type of an attribute identifier.
+ *  @param  value_tmpl      The type of an attribute value.
+ *  @param  weight_tmpl     The type storing an instance weight.
+ */
+template <
+    class identifier_tmpl = int,
+    class value_tmpl = double,
+    class weight_tmpl = float
+>
+class compact_multi_instance :
+    public compact_instance_base<identifier_tmpl, value_tmpl, weight_tmpl>
+{
+public:
+    /// The type of an attribute vector (this class).
+    typedef compact_multi_instance attributes_type;
+
+    /**
+     * Constructs an object.
+     */
+    compact_multi_instance()
+        : compact_instance_base<identifier_tmpl, value_tmpl, weight_tmpl>(-1)
+    {
+    }
+
+    /**
+     * Sets the label.
+     *  @param  i           The label index.
+     */
+    inline void set_label(int i)
+    {
+        this->m_label = i;
+    }
+
+    /**
+     * Gets the label.
+     *  @return int         The label index of this instance.
+     */
+    inline int get_label() const
+    {
+        return this->m_label;
+    }
+
+    /**
+     * Returns the number of possible candidate labels (always L).
+     *  @param  L           The total number of labels in the dataset.
+     *  @return int         The number of labels.
+     */
+    inline int num_candidates(const int L) const
+    {
+        return L;
+    }
+
+    /**
+     * Returns a read-only access to the attribute vector.
+     *  @param  i           Reserved only for the compatibility with
+     *                      candidate instances.
+     *  @return const attributes_type&  The reference to this object.
+     */
+    inline const attributes_type& attributes(int i) const
+    {
+        return *this;
+    }
+
+    /**
+     * Returns an access to the attribute vector.
+     *  @param  i           Reserved only for the compatibility with
+     *                      candidate instances.
+     *  @return attributes_type&        The reference to this object.
+     */
+    inline attributes_type& attributes(int i)
+    {
+        return *this;
+    }
+};
+
+template <class identifier_tmpl, class value_tmpl, class weight_tmpl>
+inline void swap(
+    compact_multi_instance<identifier_tmpl, value_tmpl, weight_tmpl>& x,
+    compact_multi_instance<identifier_tmpl, value_tmpl, weight_tmpl>& y
+    )
+{
+    x.swap(y);
+}
+
+
+
+/**
+ * A template class for compact candidate instances.
+ *
+ *  This class provides the interface of candidate_instance_base without
+ *  virtual tables: an instance consists of a pointer to the candidates,
+ *  the number of candidates, the label, the weight, and the group number
+ *  (24 bytes on 64-bit systems with the default types). The type of a
+ *  candidate must implement swap() as compact_sparse_vector does, because
+ *  candidates are moved to a resized array by compact_relocate().
+ *
+ *  @param  attributes_tmpl The type of an attribute vector.
+ *  @param  weight_tmpl     The type storing an instance weight.
+ */
+template <
+    class attributes_tmpl = compact_sparse_vector<int, double>,
+    class weight_tmpl = float
+>
+class compact_candidate_instance
+{
+public:
+    /// A type representing an attribute vector.
+    typedef attributes_tmpl attributes_type;
+    /// A type representing a candidate (a synonym of attributes_type).
+    typedef attributes_type candidate_type;
+    /// A type counting the number of candidates in the instance.
+    typedef size_t size_type;
+    /// A type providing a random-access iterator for candidates.
+    typedef candidate_type* iterator;
+    /// A type providing a read-only random-access iterator for candidates.
+    typedef const candidate_type* const_iterator;
+    /// The type of an attribute identifier.
+    typedef typename attributes_type::identifier_type attribute_type;
+    /// The type of an attribute value.
+    typedef typename attributes_type::value_type value_type;
+
+protected:
+    /// The array of candidates.
+    candidate_type* m_cands;
+    /// The number of candidates.
+    unsigned int m_size;
+    /// The label of this instance.
+    int m_label;
+    /// The instance weight.
+    weight_tmpl m_weight;
+    /// The group number.
+    int m_group;
+
+public:
+    /**
+     * Constructs an object.
+     */
+    compact_candidate_instance()
+        : m_cands(NULL), m_size(0), m_label(-1), m_weight(1), m_group(0)
+    {
+    }
+
+    /**
+     * Constructs an object by copying another.
+     *  @param  x           The instance to be copied.
+     */
+    compact_candidate_instance(const compact_candidate_instance& x)
+        : m_cands(NULL), m_size(0)
+    {
+        assign(x);
+    }
+
+#if     __cplusplus >= 201103L
+    /**
+     * Constructs an object by moving another.
+     *  @param  x           The instance to be moved.
+     */
+    compact_candidate_instance(compact_candidate_instance&& x) noexcept
+        : m_cands(x.m_cands), m_size(x.m_size), m_label(x.m_label),
+        m_weight(x.m_weight), m_group(x.m_group)
+    {
+        x.m_cands = NULL;
+        x.m_size = 0;
+    }
+#endif/*__cplusplus >= 201103L*/
+
+    /**
+     * Destructs the object.
+     */
+    ~compact_candidate_instance()
+    {
+        destroy();
+    }
+
+    /**
+     * Copies another instance.
+     *  @param  x           The instance to be copied.
+     *  @return compact_candidate_instance& The reference to this object.
+     */
+    compact_candidate_instance& operator=(const compact_candidate_instance& x)
+    {
+        if (this != &x) {
+            destroy();
+            assign(x);
+        }
+        return *this;
+    }
+
+    /**
+     * Exchanges the content with another instance.
+     *  @param  x           The instance.
+     */
+    inline void swap(compact_candidate_instance& x)
+    {
+        std::swap(m_cands, x.m_cands);
+        std::swap(m_size, x.m_size);
+        std::swap(m_label, x.m_label);
+        std::swap(m_weight, x.m_weight);
+        std::swap(m_group, x.m_group);
+    }
+
+    inline void clear()
+    {
+        destroy();
+        m_label = -1;
+    }
+
+    inline bool empty() const
+    {
+        return (m_size == 0);
+    }
+
+    inline size_type size() const
+    {
+        return m_size;
+    }
+
+    inline iterator begin()
+    {
+        return m_cands;
+    }
+
+    inline const_iterator begin() const
+    {
+        return m_cands;
+    }
+
+    inline iterator end()
+    {
+        return m_cands + m_size;
+    }
+
+    inline const_iterator end() const
+    {
+        return m_cands + m_size;
+    }
+
+    /**
+     * Adds an candidate to the object.
+     *  @param  candidate   The candidate to be inserted to this object.
+     */
+    inline void append(const candidate_type& candidate)
+    {
+        new_element() = candidate;
+    }
+
+    /**
+     * Creates a new candidate.
+     *  @retval candidate_type&     The reference to the new candidate.
+     */
+    inline candidate_type& new_element()
+    {
+        if (m_size == compact_capacity(m_size)) {
+            m_cands = compact_relocate(m_cands, m_size, compact_capacity(m_size+1));
+        }
+        return *new(&m_cands[m_size++]) candidate_type();
+    }
+
+    inline void set_label(int i)
+    {
+        m_label = i;
+    }
+
+    inline int get_label() const
+    {
+        return m_label;
+    }
+
+    inline void set_weight(double weight)
+    {
+        m_weight = (weight_tmpl)weight;
+    }
+
+    inline double get_weight() const
+    {
+        return (double)m_weight;
+    }
+
+    inline void set_group(int group)
+    {
+        m_group = group;
+    }
+
+    inline int get_group() const
+    {
+        return m_group;
+    }
+
+    /**
+     * Returns the number of candidates associated with the instance.
+     *  @param  L           Ignored.
+     *  @return int         The number of candidates.
+     */
+    inline int num_candidates(const int L) const
+    {
+        return (int)m_size;
+    }
+
+    /**
+     * Returns a read-only access to the attribute vector of a candidate.
+     *  @param  i           The index of the candidate.
+     *  @return const attributes_type&  The attribute vector.
+     */
+    inline const candidate_type& attributes(int i) const
+    {
+        return m_cands[i];
+    }
+
+    /**
+     * Returns an access to the attribute vector of a candidate.
+     *  @param  i           The index of the candidate.
+     *  @return attributes_type&        The attribute vector.
+     */
+    inline candidate_type& attributes(int i)
+    {
+        return m_cands[i];
+    }
+
+protected:
+    void destroy()
+    {
+        for (unsigned int i = 0;i < m_size;++i) {
+            m_cands[i].~candidate_type();
+        }
+        std::free(m_cands);
+        m_cands = NULL;
+        m_size = 0;
+    }
+
+    void assign(const compact_candidate_instance& x)
+    {
+        m_cands = compact_relocate(m_cands, m_size, compact_capacity(x.m_size));
+        for (m_size = 0;m_size < x.m_size;++m_size) {
+            new(&m_cands[m_size]) candidate_type(x.m_cands[m_size]);
+        }
+        m_label = x.m_label;
+        m_weight = x.m_weight;
+        m_group = x.m_group;
+    }
+};
+
+template <class attributes_tmpl, class weight_tmpl>
+inline void swap(
+    compact_candidate_instance<attributes_tmpl, weight_tmpl>& x,
+    compact_candidate_instance<attributes_tmpl, weight_tmpl>& y
+    )
+{
+    x.swap(y);
+}
+
 };
 
 #endif/*__CLASSIAS_INSTANCE_H__*/
@@ -0,0 +1,281 @@
+/*
+ *		Utilities for thread-parallel computation.
+ *
+ * Copyright (c) 2008,2009 Naoaki Okazaki
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the names of the authors nor the names of its contributors
+ *       may be used to endorse or promote products derived from this
+ *       software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* $Id$ */
+
+#ifndef __CLASSIAS_PARALLEL_H__
+#define __CLASSIAS_PARALLEL_H__
+
+#include <cstddef>
+#include <vector>
+
+#if     defined(_MSC_VER)
+#include <windows.h>
+#include <process.h>
+#else
+#include <pthread.h>
+#include <sys/time.h>
+#include <unistd.h>
+#endif/*defined(_MSC_VER)*/
+
+namespace classias
+{
+
+/**
+ * Obtains the number of processors available on the system.
+ *  @return int         The number of online processors (at least one).
+ */
+inline int num_processors()
+{
+#if     defined(_MSC_VER)
+    SYSTEM_INFO si;
+    GetSystemInfo(&si);
+    return (0 < (int)si.dwNumberOfProcessors) ? (int)si.dwNumberOfProcessors : 1;
+#else
+    long n = sysconf(_SC_NPROCESSORS_ONLN);
+    return (0 < n) ? (int)n : 1;
+#endif/*defined(_MSC_VER)*/
+}
+
+/**
+ * Obtains the wall-clock time.
+ *  Unlike std::clock(), the value does not include the processor time
+ *  consumed by other threads, which makes it suitable for measuring the
+ *  elapsed time of multi-threaded computation.
+ *  @return double      The current time in seconds.
+ */
+inline double wallclock()
+{
+#if     defined(_MSC_VER)
+    LARGE_INTEGER freq, count;
+    QueryPerformanceFrequency(&freq);
+    QueryPerformanceCounter(&count);
+    return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (double)tv.tv_sec + (double)tv.tv_usec * 1e-6;
+#endif/*defined(_MSC_VER)*/
+}
+
+/**
+ * Resolves the number of threads requested by a user.
+ *  @param  n           The number of threads; zero or a negative value
+ *                      requests as many threads as the processors.
+ *  @return int         The number of threads to use.
+ */
+inline int resolve_num_threads(int n)
+{
+    return (0 < n) ? n : num_processors();
+}
+
+/**
+ * Splits a sequence of items into contiguous ranges of similar costs.
+ *  This function determines T+1 boundaries, \c bounds[0] = 0, ...,
+ *  \c bounds[T] = N, such that the t-th range [bounds[t], bounds[t+1])
+ *  receives about 1/T of the total cost. The partition depends only on the
+ *  costs, not on the timing of threads.
+ *  @param  bounds      The vector receiving the boundaries.
+ *  @param  costs       The costs of items [N].
+ *  @param  T           The number of ranges.
+ */
+inline void balanced_partition(
+    std::vector<size_t>& bounds,
+    const std::vector<size_t>& costs,
+    int T
+    )
+{
+    const size_t N = costs.size();
+    double total = 0.;
+    for (size_t i = 0;i < N;++i) {
+        total += (double)costs[i];
+    }
+
+    bounds.assign(T+1, N);
+    bounds[0] = 0;
+
+    int t = 1;
+    double sum = 0.;
+    for (size_t i = 0;i < N && t < T;++i) {
+        while (t < T && total * t / T <= sum) {
+            bounds[t++] = i;
+        }
+        sum += (double)costs[i];
+    }
+}
+
+#if     defined(_MSC_VER)
+template <class task_tmpl>
+static unsigned __stdcall __parallel_entry(void *arg)
+{
+    (*reinterpret_cast<task_tmpl*>(arg))();
+    return 0;
+}
+#else
+template <class task_tmpl>
+static void* __parallel_entry(void *arg)
+{
+    (*reinterpret_cast<task_tmpl*>(arg))();
+    return NULL;
+}
+#endif/*defined(_MSC_VER)*/
+
+/**
+ * Runs tasks in parallel and waits for their completion.
+ *  A task is a function object with operator()(). This function runs
+ *  \c tasks[0] on the calling thread and each of the other tasks on a
+ *  thread of its own; the function returns when all the tasks finish. A
+ *  task is run on the calling thread when the system cannot create a
+ *  thread for it, so that the result never depends on the availability
+ *  of threads.
+ *  @param  tasks       The tasks.
+ */
+template <class task_tmpl>
+inline void parallel_run(std::vector<task_tmpl>& tasks)
+{
+    const size_t T = tasks.size();
+    if (T == 0) {
+        return;
+    }
+
+#if     defined(_MSC_VER)
+    std::vector<HANDLE> threads(T, (HANDLE)0);
+    for (size_t t = 1;t < T;++t) {
+        threads[t] = (HANDLE)_beginthreadex(
+            NULL, 0, __parallel_entry<task_tmpl>, &tasks[t], 0, NULL);
+    }
+    tasks[0]();
+    for (size_t t = 1;t < T;++t) {
+        if (threads[t] != 0) {
+            WaitForSingleObject(threads[t], INFINITE);
+            CloseHandle(threads[t]);
+        } else {
+            tasks[t]();
+        }
+    }
+#else
+    std::vector<pthread_t> threads(T);
+    std::vector<bool> running(T, false);
+    for (size_t t = 1;t < T;++t) {
+        running[t] = (pthread_create(
+            &threads[t], NULL, __parallel_entry<task_tmpl>, &tasks[t]) == 0);
+    }
+    tasks[0]();
+    for (size_t t = 1;t < T;++t) {
+        if (running[t]) {
+            pthread_join(threads[t], NULL);
+        } else {
+            tasks[t]();
+        }
+    }
+#endif/*defined(_MSC_VER)*/
+}
+
+/**
+ * A task running on a background thread.
+ *  This class runs a task (a function object with operator()()) on a
+ *  thread of its own while the calling thread does other work; join()
+ *  waits for the completion of the task. The task is run on the calling
+ *  thread (in start()) when the system cannot create a thread.
+ *  @param  task_tmpl   The type of a task.
+ */
+template <class task_tmpl>
+class background_task
+{
+protected:
+    bool m_running;
+#if     defined(_MSC_VER)
+    HANDLE m_thread;
+#else
+    pthread_t m_thread;
+#endif/*defined(_MSC_VER)*/
+
+public:
+    /**
+     * Constructs an object.
+     */
+    background_task() : m_running(false)
+    {
+    }
+
+    /**
+     * Destructs an object after waiting for the running task.
+     */
+    virtual ~background_task()
+    {
+        join();
+    }
+
+    /**
+     * Starts a task.
+     *  The task object must be alive until the task finishes.
+     *  @param  task        The task.
+     */
+    void start(task_tmpl& task)
+    {
+        join();
+#if     defined(_MSC_VER)
+        m_thread = (HANDLE)_beginthreadex(
+            NULL, 0, __parallel_entry<task_tmpl>, &task, 0, NULL);
+        m_running = (m_thread != 0);
+#else
+        m_running = (pthread_create(
+            &m_thread, NULL, __parallel_entry<task_tmpl>, &task) == 0);
+#endif/*defined(_MSC_VER)*/
+        if (!m_running) {
+            task();
+        }
+    }
+
+    /**
+     * Waits for the completion of the task started last.
+     */
+    void join()
+    {
+        if (m_running) {
+#if     defined(_MSC_VER)
+            WaitForSingleObject(m_thread, INFINITE);
+            CloseHandle(m_thread);
+#else
+            pthread_join(m_thread, NULL);
+#endif/*defined(_MSC_VER)*/
+            m_running = false;
+        }
+    }
+
+private:
+    // Non-copyable.
+    background_task(const background_task&);
+    background_task& operator=(const background_task&);
+};
+
+};
+
+#endif/*__CLASSIAS_PARALLEL_H__*/
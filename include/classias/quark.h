@@ -33,7 +33,9 @@
 #ifndef __CLASSIAS_QUARK_H__
 #define __CLASSIAS_QUARK_H__
 
+#include <cstring>
 #include <stdexcept>
+#include <string>
 #include <vector>
 
 #if defined(_MSC_VER)
@@ -446,6 +448,901 @@ public:
 /// The string quark.
 typedef quark_base<std::string> quark;
 
+
+
+/**
+ * Computes the 32-bit MurmurHash3 value of a byte sequence.
+ *  The value does not depend on the byte order of the machine.
+ *  @param  str             The pointer to the byte sequence.
+ *  @param  n               The number of bytes.
+ *  @param  seed            The seed of the hash function.
+ *  @return unsigned int    The hash value.
+ */
+inline unsigned int murmurhash3(const char *str, size_t n, unsigned int seed)
+{
+    const unsigned char *p = reinterpret_cast<const unsigned char*>(str);
+    const unsigned int c1 = 0xCC9E2D51U;
+    const unsigned int c2 = 0x1B873593U;
+    unsigned int h = seed;
+    unsigned int k = 0;
+    size_t i;
+
+    for (i = 0;i + 4 <= n;i += 4) {
+        k = (unsigned int)p[i] | ((unsigned int)p[i+1] << 8) |
+            ((unsigned int)p[i+2] << 16) | ((unsigned int)p[i+3] << 24);
+        k *= c1;
+        k = (k << 15) | (k >> 17);
+        k *= c2;
+        h ^= k;
+        h = (h << 13) | (h >> 19);
+        h = h * 5 + 0xE6546B64U;
+    }
+
+    k = 0;
+    switch (n & 3) {
+    case 3:
+        k ^= (unsigned int)p[i+2] << 16;
+        /* fall through */
+    case 2:
+        k ^= (unsigned int)p[i+1] << 8;
+        /* fall through */
+    case 1:
+        k ^= (unsigned int)p[i];
+        k *= c1;
+        k = (k << 15) | (k >> 17);
+        k *= c2;
+        h ^= k;
+    }
+
+    h ^= (unsigned int)n;
+    h ^= h >> 16;
+    h *= 0x85EBCA6BU;
+    h ^= h >> 13;
+    h *= 0xC2B2AE35U;
+    h ^= h >> 16;
+    return h;
+}
+
+/**
+ * Quark for associating a string with a hashed identifier.
+ *
+ *  This class implements the feature hashing (the hashing trick) with the
+ *  interface of quark_base<std::string>. Instead of storing strings in a
+ *  dictionary, this class computes the identifier of a string from its
+ *  MurmurHash3 value; different strings may thus share an identifier.
+ *  The identifier space consists of reserved identifiers [0, R) for the
+ *  strings registered by reserve() (e.g., a bias attribute), followed by
+ *  2^bits hashed identifiers [R, R + 2^bits). The memory usage does not
+ *  depend on the number of distinct strings.
+ *
+ *  With the signed hash, a hash value also determines the sign (+1 or -1)
+ *  by which the value of an attribute should be multiplied, so that the
+ *  collisions cancel out in expectation.
+ *
+ *  This class optionally reports collisions: it stores a fingerprint (a
+ *  32-bit hash value with another seed) of a string for each identifier,
+ *  and counts the identifiers that were assigned to strings with different
+ *  fingerprints.
+ */
+class hashing_quark {
+public:
+    /// The type representing an item.
+    typedef std::string item_type;
+    /// The type representing an identifier.
+    typedef size_t value_type;
+
+protected:
+    /// The number of bits of hashed identifiers.
+    int m_bits;
+    /// Whether the signed hash is used.
+    bool m_signed;
+    /// Whether a string has been hashed.
+    bool m_hashed;
+    /// The reserved strings.
+    std::vector<item_type> m_reserved;
+    /// The fingerprints of strings for hashed identifiers (for reporting).
+    std::vector<unsigned int> m_fingerprints;
+    /// The number of hashed identifiers assigned to strings.
+    value_type m_num_used;
+    /// The number of hashed identifiers shared by different strings.
+    value_type m_num_shared;
+
+public:
+    /**
+     * Constructs the object.
+     *  @param  bits            The number of bits of hashed identifiers.
+     *  @param  signed_hash     \c true to use the signed hash.
+     */
+    hashing_quark(int bits = 18, bool signed_hash = false)
+        : m_bits(bits), m_signed(signed_hash), m_hashed(false),
+        m_num_used(0), m_num_shared(0)
+    {
+    }
+
+    /**
+     * Destructs the object.
+     */
+    virtual ~hashing_quark()
+    {
+    }
+
+    /**
+     * Sets the number of bits of hashed identifiers.
+     *  Call this function before associating strings.
+     *  @param  bits            The number of bits (from 1 to 30).
+     */
+    void set_bits(int bits)
+    {
+        m_bits = bits;
+        if (!m_fingerprints.empty()) {
+            m_fingerprints.assign((size_t)1 << m_bits, 0);
+        }
+    }
+
+    /**
+     * Returns the number of bits of hashed identifiers.
+     *  @return int             The number of bits.
+     */
+    int bits() const
+    {
+        return m_bits;
+    }
+
+    /**
+     * Enables or disables the signed hash.
+     *  @param  signed_hash     \c true to use the signed hash.
+     */
+    void set_signed(bool signed_hash)
+    {
+        m_signed = signed_hash;
+    }
+
+    /**
+     * Tests whether the signed hash is used.
+     *  @retval bool            \c true if the signed hash is used.
+     */
+    bool is_signed() const
+    {
+        return m_signed;
+    }
+
+    /**
+     * Enables or disables the report of collisions.
+     *  Enabling the report allocates 4 * 2^bits bytes of memory.
+     *  @param  report          \c true to count collisions.
+     */
+    void set_report(bool report)
+    {
+        m_fingerprints.assign(report ? ((size_t)1 << m_bits) : 0, 0);
+        m_num_used = 0;
+        m_num_shared = 0;
+    }
+
+    /**
+     * Returns the number of identifiers.
+     *  @retval value_type      The number of identifiers, R + 2^bits.
+     */
+    inline value_type size() const
+    {
+        return m_reserved.size() + ((value_type)1 << m_bits);
+    }
+
+    /**
+     * Returns the number of reserved identifiers.
+     *  @retval value_type      The number of reserved identifiers, R.
+     */
+    inline value_type num_reserved() const
+    {
+        return m_reserved.size();
+    }
+
+    /**
+     * Returns the number of hashed identifiers assigned to strings.
+     *  This is available only when the report is enabled.
+     *  @retval value_type      The number of identifiers used.
+     */
+    inline value_type num_used() const
+    {
+        return m_num_used;
+    }
+
+    /**
+     * Returns the number of hashed identifiers shared by different strings.
+     *  This is available only when the report is enabled.
+     *  @retval value_type      The number of identifiers with collisions.
+     */
+    inline value_type num_shared() const
+    {
+        return m_num_shared;
+    }
+
+    /**
+     * Reserves an identifier for a string.
+     *  A reserved string is associated with an identifier in [0, R)
+     *  without hashing. Strings must be reserved before hashing strings.
+     *  @param  x               The string.
+     *  @return value_type      The reserved identifier.
+     *  @throws quark_error.
+     */
+    value_type reserve(const item_type& x)
+    {
+        for (value_type i = 0;i < m_reserved.size();++i) {
+            if (m_reserved[i] == x) {
+                return i;
+            }
+        }
+        if (m_hashed) {
+            throw quark_error("Strings must be reserved before hashing strings");
+        }
+        m_reserved.push_back(x);
+        return m_reserved.size() - 1;
+    }
+
+    /**
+     * Returns the identifier for a string.
+     *  The sign of the signed hash is ignored.
+     *  @param  x               The string.
+     *  @return value_type      The identifier.
+     */
+    inline value_type operator() (const item_type& x)
+    {
+        return associate(x);
+    }
+
+    /**
+     * Returns the identifier for a string.
+     *  The sign of the signed hash is ignored.
+     *  @param  x               The string.
+     *  @return value_type      The identifier.
+     */
+    inline value_type associate(const item_type& x)
+    {
+        double sign;
+        return associate(x.c_str(), x.size(), sign);
+    }
+
+    /**
+     * Returns the identifier and sign for a string.
+     *  @param  str             The pointer to the string.
+     *  @param  n               The length of the string.
+     *  @param  sign            The sign by which the attribute value should
+     *                          be multiplied (always 1 for the unsigned
+     *                          hash and reserved strings).
+     *  @return value_type      The identifier.
+     */
+    inline value_type associate(const char *str, size_t n, double& sign)
+    {
+        m_hashed = true;
+        value_type v = to_value(str, n, sign);
+        if (!m_fingerprints.empty() && m_reserved.size() <= v) {
+            unsigned int& fp = m_fingerprints[v - m_reserved.size()];
+            unsigned int h = murmurhash3(str, n, 0x9747B28CU) | 1U;
+            if (fp == 0) {
+                // The first string for this identifier.
+                fp = h;
+                ++m_num_used;
+            } else if (fp != h && fp != 2) {
+                // A collision; mark the identifier with an even number.
+                fp = 2;
+                ++m_num_shared;
+            }
+        }
+        return v;
+    }
+
+    /**
+     * Returns the identifier and sign for a string.
+     *  @param  str             The pointer to the string.
+     *  @param  n               The length of the string.
+     *  @param  sign            The sign by which the attribute value should
+     *                          be multiplied (always 1 for the unsigned
+     *                          hash and reserved strings).
+     *  @return value_type      The identifier.
+     */
+    inline value_type to_value(const char *str, size_t n, double& sign) const
+    {
+        for (value_type i = 0;i < m_reserved.size();++i) {
+            const item_type& r = m_reserved[i];
+            if (r.size() == n && std::memcmp(r.c_str(), str, n) == 0) {
+                sign = 1.;
+                return i;
+            }
+        }
+
+        unsigned int h = murmurhash3(str, n, 0);
+        sign = (m_signed && (h & 0x80000000U)) ? -1. : 1.;
+        return m_reserved.size() + (h & (((value_type)1 << m_bits) - 1));
+    }
+
+    /**
+     * Returns the identifier for a string.
+     *  The sign of the signed hash is ignored.
+     *  @param  x               The string.
+     *  @return value_type      The identifier.
+     */
+    inline value_type to_value(const item_type& x) const
+    {
+        double sign;
+        return to_value(x.c_str(), x.size(), sign);
+    }
+
+    /**
+     * Returns the reserved string for an identifier.
+     *  A hashed identifier has no string; this function throws quark_error
+     *  for an identifier that is not reserved.
+     *  @param  v               The identifier.
+     *  @return item_type&      The reference to the reserved string.
+     *  @throws quark_error.
+     */
+    inline const item_type& to_item(const value_type& v) const
+    {
+        if (v < m_reserved.size()) {
+            return m_reserved[v];
+        } else {
+            throw quark_error("No string for a hashed identifier");
+        }
+    }
+};
+
+
+
+/**
+ * Quark for associating a string with an identifier in a flat hash table.
+ *
+ *  This class provides the interface of quark_base<std::string> with a
+ *  compact layout. A string is copied only once into an append-only arena
+ *  of memory blocks (terminated by a NUL character), and an entry for the
+ *  string stores the pointer to the copy, its length, and its hash value.
+ *  An open-addressing hash table with linear probing maps a hash value to
+ *  the identifier of an entry; the table stores 32-bit identifiers only,
+ *  and the cached hash values make rehashing and most of the unsuccessful
+ *  comparisons cheap. A lookup accepts a pointer and length so that
+ *  callers do not have to construct a std::string.
+ *
+ *  Because the strings do not exist as std::string objects, to_item()
+ *  returns a copy of a string; use c_str() and length() to access a string
+ *  without copying it.
+ */
+class string_quark {
+public:
+    /// The type representing an item.
+    typedef std::string item_type;
+    /// The type of this class.
+    typedef string_quark this_class;
+    /// The type representing a unique identifier.
+    typedef size_t value_type;
+
+protected:
+    /// An entry for a string.
+    struct entry_type
+    {
+        /// The pointer to the string in the arena.
+        const char *str;
+        /// The length of the string.
+        unsigned int size;
+        /// The hash value of the string.
+        unsigned int hash;
+    };
+
+    /// The minimum size of a block in the arena.
+    enum { BLOCK_SIZE = 65536 };
+
+    /// The entries (identifier -> string).
+    std::vector<entry_type> m_entries;
+    /// The hash table (identifier + 1, or zero for an empty slot).
+    std::vector<unsigned int> m_slots;
+    /// The blocks of the arena.
+    std::vector<char*> m_blocks;
+    /// The number of bytes available in the last block.
+    size_t m_avail;
+    /// The pointer to the available space in the last block.
+    char *m_next;
+
+public:
+    /**
+     * Constructs the object.
+     */
+    string_quark() : m_avail(0), m_next(NULL)
+    {
+    }
+
+    /**
+     * Constructs the object by copying the source object.
+     *  @param  src             The source object.
+     */
+    string_quark(const this_class& src) : m_avail(0), m_next(NULL)
+    {
+        assign(src);
+    }
+
+    /**
+     * Destructs the object.
+     */
+    virtual ~string_quark()
+    {
+        clear();
+    }
+
+    /**
+     * Copies another object to this object.
+     *  @param  src             The source object.
+     *  @return this_class&     The reference to this object.
+     */
+    this_class& operator=(const this_class& src)
+    {
+        if (this != &src) {
+            clear();
+            assign(src);
+        }
+        return *this;
+    }
+
+    /**
+     * Removes all strings.
+     */
+    void clear()
+    {
+        for (size_t i = 0;i < m_blocks.size();++i) {
+            delete[] m_blocks[i];
+        }
+        m_blocks.clear();
+        m_entries.clear();
+        m_slots.clear();
+        m_avail = 0;
+        m_next = NULL;
+    }
+
+    /**
+     * Returns the number of item-identifier associations.
+     *  @retval value_type      The number of associations between items and
+     *                          identifiers.
+     */
+    inline value_type size() const
+    {
+        return m_entries.size();
+    }
+
+    /**
+     * Tests whether an item has an identifier assigned.
+     *  @param  x               The item.
+     *  @retval bool            \c true if the item is known.
+     */
+    inline bool exists(const item_type& x) const
+    {
+        return find(x.c_str(), x.size(), hash(x.c_str(), x.size())) != NULL;
+    }
+
+    /**
+     * Assigns the unique identifier for an item.
+     *  If the item is unknown, this function assigns a new unique identifier
+     *  to the item and return it.
+     *  @param  x               The item.
+     *  @return value_type      The unique identifier.
+     */
+    inline value_type operator() (const item_type& x)
+    {
+        return associate(x.c_str(), x.size());
+    }
+
+    /**
+     * Assigns a unique identifier for a new item.
+     *  If the item is unknown, this function assigns a new unique identifier
+     *  to the item and return it. If the item is known, this function returns
+     *  the existing identifier that was associated with the item.
+     *  @param  x               The item.
+     *  @return value_type      The unique identifier.
+     */
+    inline value_type associate(const item_type& x)
+    {
+        return associate(x.c_str(), x.size());
+    }
+
+    /**
+     * Assigns a unique identifier for a new item given by a byte sequence.
+     *  @param  str             The pointer to the item.
+     *  @param  n               The length of the item.
+     *  @return value_type      The unique identifier.
+     */
+    inline value_type associate(const char *str, size_t n)
+    {
+        const unsigned int h = hash(str, n);
+        const unsigned int *slot = find(str, n, h);
+        if (slot != NULL) {
+            return *slot - 1;
+        }
+
+        // Grow the table to keep its load factor no greater than 1/2.
+        if (m_slots.size() < 2 * (m_entries.size() + 1)) {
+            rehash(m_slots.empty() ? 16 : 2 * m_slots.size());
+        }
+
+        // Store the item in the arena.
+        entry_type e;
+        e.str = store(str, n);
+        e.size = (unsigned int)n;
+        e.hash = h;
+        value_type v = m_entries.size();
+        m_entries.push_back(e);
+        insert(h, v);
+        return v;
+    }
+
+    /**
+     * Returns the unique identifier for an item.
+     *  If the item is unknown, this function throws quark_error.
+     *  @param  x               The item.
+     *  @return value_type      The unique identifier.
+     *  @throws quark_error.
+     */
+    inline value_type to_value(const item_type& x) const
+    {
+        const unsigned int *slot = find(x.c_str(), x.size(), hash(x.c_str(), x.size()));
+        if (slot != NULL) {
+            return *slot - 1;
+        } else {
+            throw quark_error("Unknown forward mapping");
+        }
+    }
+
+    /**
+     * Returns the unique identifier for an item.
+     *  If the item is unknown, this function returns the default identifier.
+     *  @param  x               The item.
+     *  @param  def             The default identifier if the item is unknown.
+     *  @return value_type      The unique identifier.
+     */
+    inline value_type to_value(const item_type& x, const value_type& def) const
+    {
+        return to_value(x.c_str(), x.size(), def);
+    }
+
+    /**
+     * Returns the unique identifier for an item given by a byte sequence.
+     *  If the item is unknown, this function returns the default identifier.
+     *  @param  str             The pointer to the item.
+     *  @param  n               The length of the item.
+     *  @param  def             The default identifier if the item is unknown.
+     *  @return value_type      The unique identifier.
+     */
+    inline value_type to_value(const char *str, size_t n, const value_type& def) const
+    {
+        const unsigned int *slot = find(str, n, hash(str, n));
+        return (slot != NULL) ? (*slot - 1) : def;
+    }
+
+    /**
+     * Returns the item for the unique identifier.
+     *  If the unique identifier is unknown, this function throws quark_error.
+     *  @param  v               The unique identifier.
+     *  @return item_type       The copy of the item associated with the
+     *                          identifier.
+     *  @throws quark_error.
+     */
+    inline item_type to_item(const value_type& v) const
+    {
+        if (v < m_entries.size()) {
+            return item_type(m_entries[v].str, m_entries[v].size);
+        } else {
+            throw quark_error("Unknown inverse mapping");
+        }
+    }
+
+    /**
+     * Returns the pointer to the item for the unique identifier.
+     *  The item is terminated by a NUL character. The pointer is valid
+     *  until the object is cleared or destructed.
+     *  @param  v               The unique identifier (must be known).
+     *  @return const char*     The pointer to the item.
+     */
+    inline const char *c_str(const value_type& v) const
+    {
+        return m_entries[v].str;
+    }
+
+    /**
+     * Returns the length of the item for the unique identifier.
+     *  @param  v               The unique identifier (must be known).
+     *  @return size_t          The length of the item.
+     */
+    inline size_t length(const value_type& v) const
+    {
+        return m_entries[v].size;
+    }
+
+protected:
+    static inline unsigned int hash(const char *str, size_t n)
+    {
+        return murmurhash3(str, n, 0);
+    }
+
+    const unsigned int *find(const char *str, size_t n, unsigned int h) const
+    {
+        if (m_slots.empty()) {
+            return NULL;
+        }
+        const size_t mask = m_slots.size() - 1;
+        for (size_t i = (h & mask);;i = ((i+1) & mask)) {
+            const unsigned int& s = m_slots[i];
+            if (s == 0) {
+                return NULL;
+            }
+            const entry_type& e = m_entries[s-1];
+            if (e.hash == h && e.size == n && std::memcmp(e.str, str, n) == 0) {
+                return &s;
+            }
+        }
+    }
+
+    void insert(unsigned int h, value_type v)
+    {
+        const size_t mask = m_slots.size() - 1;
+        size_t i = (h & mask);
+        while (m_slots[i] != 0) {
+            i = ((i+1) & mask);
+        }
+        m_slots[i] = (unsigned int)(v + 1);
+    }
+
+    void rehash(size_t n)
+    {
+        m_slots.assign(n, 0);
+        for (value_type v = 0;v < m_entries.size();++v) {
+            insert(m_entries[v].hash, v);
+        }
+    }
+
+    const char *store(const char *str, size_t n)
+    {
+        if (m_avail < n + 1) {
+            size_t size = (n + 1 < BLOCK_SIZE) ? (size_t)BLOCK_SIZE : n + 1;
+            m_blocks.push_back(new char[size]);
+            m_next = m_blocks.back();
+            m_avail = size;
+        }
+        char *p = m_next;
+        std::memcpy(p, str, n);
+        p[n] = 0;
+        m_next += n + 1;
+        m_avail -= n + 1;
+        return p;
+    }
+
+    void assign(const this_class& src)
+    {
+        m_entries.reserve(src.m_entries.size());
+        for (value_type v = 0;v < src.m_entries.size();++v) {
+            entry_type e = src.m_entries[v];
+            e.str = store(e.str, e.size);
+            m_entries.push_back(e);
+        }
+        m_slots = src.m_slots;
+    }
+};
+
+
+
+/**
+ * Quark for associating a pair of integers with an identifier in a flat
+ * hash table.
+ *
+ *  This class provides the interface of quark2_base for integer items
+ *  (e.g., pairs of attribute and label identifiers). The pairs are stored
+ *  in an open-addressing hash table with linear probing; a slot holds the
+ *  pair itself and its identifier, so that a lookup reads no memory other
+ *  than the probed slots. The hash value of a pair is computed by the
+ *  finalizer of MurmurHash3 over both items, which distributes pairs
+ *  evenly even when one of the items takes a large range of values.
+ *
+ *  @param  item0_base      The type of an item #0 (an integer type).
+ *  @param  item1_base      The type of an item #1 (an integer type).
+ */
+template <class item0_base, class item1_base>
+class int_pair_quark {
+public:
+    /// The type representing an item #0.
+    typedef item0_base item0_type;
+    /// The type representing an item #1.
+    typedef item1_base item1_type;
+    /// The type representing a pair of items.
+    typedef std::pair<item0_type, item1_type> elem_type;
+    /// The type representing a unique identifier.
+    typedef size_t value_type;
+
+protected:
+    /// A slot of the hash table.
+    struct slot_type
+    {
+        /// The item #0.
+        item0_type x;
+        /// The item #1.
+        item1_type y;
+        /// The identifier plus one, or zero for an empty slot.
+        unsigned int v;
+    };
+
+    /// The hash table.
+    std::vector<slot_type> m_slots;
+    /// Inverse mapping: value -> (item0, item1).
+    std::vector<elem_type> m_inv;
+
+public:
+    /**
+     * Constructs the object.
+     */
+    int_pair_quark()
+    {
+    }
+
+    /**
+     * Destructs the object.
+     */
+    virtual ~int_pair_quark()
+    {
+    }
+
+    /**
+     * Returns the number of item-identifier associations.
+     *  @retval value_type      The number of associations between items and
+     *                          identifiers.
+     */
+    inline value_type size() const
+    {
+        return m_inv.size();
+    }
+
+    /**
+     * Tests whether a pair of items has an identifier assigned.
+     *  @param  x               The item #0.
+     *  @param  y               The item #1.
+     *  @retval bool            \c true if the pair of items is known.
+     */
+    inline bool exists(const item0_type& x, const item1_type& y) const
+    {
+        return find(x, y).v != 0;
+    }
+
+    /**
+     * Assigns the unique identifier for a pair of items.
+     *  @param  x               The item #0.
+     *  @param  y               The item #1.
+     *  @return value_type      The unique identifier.
+     */
+    inline value_type operator() (const item0_type& x, const item1_type& y)
+    {
+        return associate(x, y);
+    }
+
+    /**
+     * Assigns the unique identifier for a pair of items.
+     *  If the pair is unknown, this function assigns a new unique identifier
+     *  to the pair and return it.  If the item is known, this function returns
+     *  the existing identifier that was associated with the item.
+     *  @param  x               The item #0.
+     *  @param  y               The item #1.
+     *  @return value_type      The unique identifier.
+     */
+    inline value_type associate(const item0_type& x, const item1_type& y)
+    {
+        // Grow the table to keep its load factor no greater than 1/2.
+        if (m_slots.size() < 2 * (m_inv.size() + 1)) {
+            rehash(m_slots.empty() ? 16 : 2 * m_slots.size());
+        }
+
+        slot_type& s = find(x, y);
+        if (s.v == 0) {
+            s.x = x;
+            s.y = y;
+            s.v = (unsigned int)m_inv.size() + 1;
+            m_inv.push_back(elem_type(x, y));
+        }
+        return s.v - 1;
+    }
+
+    /**
+     * Returns the unique identifier for a pair of items.
+     *  If the pair is unknown, this function throws quark_error.
+     *  @param  x               The item #0.
+     *  @param  y               The item #1.
+     *  @return value_type      The unique identifier.
+     *  @throws quark_error.
+     */
+    inline value_type to_value(const item0_type& x, const item1_type& y) const
+    {
+        const slot_type& s = find(x, y);
+        if (s.v != 0) {
+            return s.v - 1;
+        } else {
+            throw quark_error("Unknown forward mapping");
+        }
+    }
+
+    /**
+     * Returns the unique identifier for a pair of items.
+     *  If the pair is unknown, this function returns the default identifier.
+     *  @param  x               The item #0.
+     *  @param  y               The item #1.
+     *  @param  def             The default identifier if the pair is unknown.
+     *  @return value_type      The unique identifier.
+     */
+    inline value_type to_value(const item0_type& x, const item1_type& y, const value_type& def) const
+    {
+        const slot_type& s = find(x, y);
+        return (s.v != 0) ? (value_type)(s.v - 1) : def;
+    }
+
+    /**
+     * Returns the pair for the unique identifier.
+     *  If the unique identifier is unknown, this function throws quark_error.
+     *  @param  v               The unique identifier.
+     *  @param  x               The reference to item #0.
+     *  @param  y               The reference to item #1.
+     *  @throws quark_error.
+     */
+    inline void to_item(const value_type& v, item0_type& x, item1_type& y) const
+    {
+        if (v < m_inv.size()) {
+            x = m_inv[v].first;
+            y = m_inv[v].second;
+        } else {
+            throw quark_error("Unknown inverse mapping");
+        }
+    }
+
+protected:
+    static inline unsigned int mix(unsigned int h)
+    {
+        h ^= h >> 16;
+        h *= 0x85EBCA6BU;
+        h ^= h >> 13;
+        h *= 0xC2B2AE35U;
+        h ^= h >> 16;
+        return h;
+    }
+
+    static inline unsigned int hash(const item0_type& x, const item1_type& y)
+    {
+        return mix((unsigned int)x * 0x9E3779B1U + mix((unsigned int)y));
+    }
+
+    inline const slot_type& find(const item0_type& x, const item1_type& y) const
+    {
+        static const slot_type empty = {item0_type(), item1_type(), 0};
+        if (m_slots.empty()) {
+            return empty;
+        }
+        const size_t mask = m_slots.size() - 1;
+        for (size_t i = (hash(x, y) & mask);;i = ((i+1) & mask)) {
+            const slot_type& s = m_slots[i];
+            if (s.v == 0 || (s.x == x && s.y == y)) {
+                return s;
+            }
+        }
+    }
+
+    inline slot_type& find(const item0_type& x, const item1_type& y)
+    {
+        const size_t mask = m_slots.size() - 1;
+        for (size_t i = (hash(x, y) & mask);;i = ((i+1) & mask)) {
+            slot_type& s = m_slots[i];
+            if (s.v == 0 || (s.x == x && s.y == y)) {
+                return s;
+            }
+        }
+    }
+
+    void rehash(size_t n)
+    {
+        slot_type empty = {item0_type(), item1_type(), 0};
+        m_slots.assign(n, empty);
+        for (value_type v = 0;v < m_inv.size();++v) {
+            slot_type& s = find(m_inv[v].first, m_inv[v].second);
+            s.x = m_inv[v].first;
+            s.y = m_inv[v].second;
+            s.v = (unsigned int)v + 1;
+        }
+    }
+};
+
 };
 
 #endif/*__CLASSIAS_QUARK_H__*/
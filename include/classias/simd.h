@@ -0,0 +1,1307 @@
+/*
+ *		Vector kernels with SIMD instructions.
+ *
+ * Copyright (c) 2008,2009 Naoaki Okazaki
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the names of the authors nor the names of its contributors
+ *       may be used to endorse or promote products derived from this
+ *       software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* $Id$ */
+
+#ifndef __CLASSIAS_SIMD_H__
+#define __CLASSIAS_SIMD_H__
+
+#include <cmath>
+#include <cstddef>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "types.h"
+
+/*
+ * The SIMD kernels are available for x86 processors with GCC (4.9 or
+ * later), Clang, or Microsoft Visual C++ (2017 or later). Define
+ * CLASSIAS_NO_SIMD to use the scalar kernels only.
+ */
+#if     !defined(CLASSIAS_NO_SIMD)
+#if     (defined(__x86_64__) || defined(__i386__)) && \
+        (defined(__clang__) || \
+         (defined(__GNUC__) && (4 < __GNUC__ || (__GNUC__ == 4 && 9 <= __GNUC_MINOR__))))
+#define CLASSIAS_SIMD_X86   1
+#define CLASSIAS_SIMD_GNUC  1
+#elif   (defined(_M_X64) || defined(_M_IX86)) && defined(_MSC_VER) && 1910 <= _MSC_VER
+#define CLASSIAS_SIMD_X86   1
+#endif
+#endif/*!defined(CLASSIAS_NO_SIMD)*/
+
+#if     defined(CLASSIAS_SIMD_X86)
+#include <immintrin.h>
+#if     defined(_MSC_VER)
+#include <intrin.h>
+#endif/*defined(_MSC_VER)*/
+#endif/*defined(CLASSIAS_SIMD_X86)*/
+
+/*
+ * GCC would fuse a multiplication and an addition into an FMA instruction
+ * when the target supports it (e.g., AVX-512 or -march=native), which would
+ * make the results depend on the instruction set; CLASSIAS_SIMD_EXACT keeps
+ * the roundings of all kernels identical. GCC and Clang compile a kernel
+ * for an instruction set that is not enabled by the compiler options with
+ * the target attribute.
+ */
+#if     defined(__GNUC__) && !defined(__clang__)
+#define CLASSIAS_SIMD_EXACT     __attribute__((optimize("fp-contract=off")))
+#else
+#define CLASSIAS_SIMD_EXACT
+#endif
+
+#if     defined(CLASSIAS_SIMD_GNUC)
+#define CLASSIAS_TARGET_SSE2    __attribute__((target("sse2"))) CLASSIAS_SIMD_EXACT
+#define CLASSIAS_TARGET_AVX2    __attribute__((target("avx2"))) CLASSIAS_SIMD_EXACT
+#define CLASSIAS_TARGET_AVX512  __attribute__((target("avx512f"))) CLASSIAS_SIMD_EXACT
+#else
+#define CLASSIAS_TARGET_SSE2
+#define CLASSIAS_TARGET_AVX2
+#define CLASSIAS_TARGET_AVX512
+#endif/*defined(CLASSIAS_SIMD_GNUC)*/
+
+namespace classias
+{
+
+/**
+ * Vector kernels for the O(K) passes of training algorithms.
+ *
+ *  The kernels in this namespace process arrays of double-precision values
+ *  (and the single-precision corrections of L-BFGS in axpy() and dot())
+ *  with SSE2, AVX2, or AVX-512 instructions, choosing the widest instruction
+ *  set that the processor supports at run time, or with scalar code on the
+ *  other processors. Reductions (dot() and norm1()) accumulate eight
+ *  partial sums in a fixed order whatever instruction set is used, so that
+ *  a training process yields the same model on any processor. The
+ *  environment variable CLASSIAS_SIMD (\c "scalar", \c "sse2", \c "avx2",
+ *  or \c "avx512") restricts the instruction set.
+ */
+namespace simd
+{
+
+/// Instruction sets of the kernels.
+enum {
+    /// Scalar code.
+    SCALAR = 0,
+    /// SSE2 (two doubles per register).
+    SSE2,
+    /// AVX2 (four doubles per register).
+    AVX2,
+    /// AVX-512 Foundation (eight doubles per register).
+    AVX512
+};
+
+/**
+ * Detects the widest instruction set supported by the processor.
+ *  @return int         The instruction set.
+ */
+inline int detect()
+{
+    int supported = SCALAR;
+
+#if     defined(CLASSIAS_SIMD_X86)
+#if     defined(CLASSIAS_SIMD_GNUC)
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("sse2")) {
+        supported = SSE2;
+    }
+    if (__builtin_cpu_supports("avx2")) {
+        supported = AVX2;
+    }
+    if (__builtin_cpu_supports("avx512f")) {
+        supported = AVX512;
+    }
+#else
+    int info[4];
+    __cpuid(info, 0);
+    const int max_leaf = info[0];
+    __cpuid(info, 1);
+    if (info[3] & (1 << 26)) {
+        supported = SSE2;
+    }
+    // AVX requires the operating system to save YMM (and ZMM) registers.
+    if ((info[2] & (1 << 27)) && 7 <= max_leaf) {
+        unsigned __int64 xcr0 = _xgetbv(0);
+        __cpuidex(info, 7, 0);
+        if ((xcr0 & 0x06) == 0x06 && (info[1] & (1 << 5))) {
+            supported = AVX2;
+        }
+        if ((xcr0 & 0xE6) == 0xE6 && (info[1] & (1 << 16))) {
+            supported = AVX512;
+        }
+    }
+#endif/*defined(CLASSIAS_SIMD_GNUC)*/
+#endif/*defined(CLASSIAS_SIMD_X86)*/
+
+    // Restrict the instruction set as specified by CLASSIAS_SIMD.
+    const char *env = std::getenv("CLASSIAS_SIMD");
+    if (env != NULL) {
+        int requested = supported;
+        if (std::strcmp(env, "scalar") == 0) {
+            requested = SCALAR;
+        } else if (std::strcmp(env, "sse2") == 0) {
+            requested = SSE2;
+        } else if (std::strcmp(env, "avx2") == 0) {
+            requested = AVX2;
+        } else if (std::strcmp(env, "avx512") == 0) {
+            requested = AVX512;
+        }
+        if (requested < supported) {
+            supported = requested;
+        }
+    }
+    return supported;
+}
+
+/**
+ * Returns the instruction set used by the kernels.
+ *  @return int         The instruction set.
+ */
+inline int level()
+{
+    static const int value = detect();
+    return value;
+}
+
+/**
+ * Returns the name of the instruction set used by the kernels.
+ *  @return const char* The name of the instruction set.
+ */
+inline const char *name()
+{
+    switch (level()) {
+    case SSE2:
+        return "sse2";
+    case AVX2:
+        return "avx2";
+    case AVX512:
+        return "avx512";
+    }
+    return "scalar";
+}
+
+/**
+ * Sums up eight partial sums in the fixed order.
+ *  @param  p           The partial sums.
+ *  @return double      The sum.
+ */
+inline double sum8(const double *p)
+{
+    return ((p[0] + p[1]) + (p[2] + p[3])) + ((p[4] + p[5]) + (p[6] + p[7]));
+}
+
+/**
+ * Scalar implementations of the kernels.
+ */
+struct scalar
+{
+    static CLASSIAS_SIMD_EXACT void fill(double *x, size_t n, double a)
+    {
+        for (size_t i = 0;i < n;++i) {
+            x[i] = a;
+        }
+    }
+
+    static CLASSIAS_SIMD_EXACT void scale(double *x, size_t n, double a)
+    {
+        for (size_t i = 0;i < n;++i) {
+            x[i] *= a;
+        }
+    }
+
+    static CLASSIAS_SIMD_EXACT void axpy(double *y, const double *x, size_t n, double a)
+    {
+        for (size_t i = 0;i < n;++i) {
+            y[i] += a * x[i];
+        }
+    }
+
+    static CLASSIAS_SIMD_EXACT double dot(const double *x, const double *y, size_t n)
+    {
+        size_t i = 0;
+        double p[8] = {0., 0., 0., 0., 0., 0., 0., 0.};
+        for (;i + 8 <= n;i += 8) {
+            for (int j = 0;j < 8;++j) {
+                p[j] += x[i+j] * y[i+j];
+            }
+        }
+        double s = sum8(p);
+        for (;i < n;++i) {
+            s += x[i] * y[i];
+        }
+        return s;
+    }
+
+    static CLASSIAS_SIMD_EXACT void axpy(double *y, const float *x, size_t n, double a)
+    {
+        for (size_t i = 0;i < n;++i) {
+            y[i] += a * (double)x[i];
+        }
+    }
+
+    static CLASSIAS_SIMD_EXACT double dot(const float *x, const double *y, size_t n)
+    {
+        size_t i = 0;
+        double p[8] = {0., 0., 0., 0., 0., 0., 0., 0.};
+        for (;i + 8 <= n;i += 8) {
+            for (int j = 0;j < 8;++j) {
+                p[j] += (double)x[i+j] * y[i+j];
+            }
+        }
+        double s = sum8(p);
+        for (;i < n;++i) {
+            s += (double)x[i] * y[i];
+        }
+        return s;
+    }
+
+    static CLASSIAS_SIMD_EXACT double axpy_sqnorm(double *y, const double *x, size_t n, double a)
+    {
+        size_t i = 0;
+        double p[8] = {0., 0., 0., 0., 0., 0., 0., 0.};
+        for (;i + 8 <= n;i += 8) {
+            for (int j = 0;j < 8;++j) {
+                y[i+j] += a * x[i+j];
+                p[j] += x[i+j] * x[i+j];
+            }
+        }
+        double s = sum8(p);
+        for (;i < n;++i) {
+            y[i] += a * x[i];
+            s += x[i] * x[i];
+        }
+        return s;
+    }
+
+    static CLASSIAS_SIMD_EXACT double scale_sqnorm(double *x, size_t n, double a)
+    {
+        size_t i = 0;
+        double p[8] = {0., 0., 0., 0., 0., 0., 0., 0.};
+        for (;i + 8 <= n;i += 8) {
+            for (int j = 0;j < 8;++j) {
+                x[i+j] *= a;
+                p[j] += x[i+j] * x[i+j];
+            }
+        }
+        double s = sum8(p);
+        for (;i < n;++i) {
+            x[i] *= a;
+            s += x[i] * x[i];
+        }
+        return s;
+    }
+
+    static CLASSIAS_SIMD_EXACT double norm1(const double *x, size_t n)
+    {
+        size_t i = 0;
+        double p[8] = {0., 0., 0., 0., 0., 0., 0., 0.};
+        for (;i + 8 <= n;i += 8) {
+            for (int j = 0;j < 8;++j) {
+                p[j] += std::fabs(x[i+j]);
+            }
+        }
+        double s = sum8(p);
+        for (;i < n;++i) {
+            s += std::fabs(x[i]);
+        }
+        return s;
+    }
+
+    static CLASSIAS_SIMD_EXACT size_t count_nonzero(const double *x, size_t n)
+    {
+        size_t c = 0;
+        for (size_t i = 0;i < n;++i) {
+            if (x[i] != 0.) {
+                ++c;
+            }
+        }
+        return c;
+    }
+
+    static CLASSIAS_SIMD_EXACT void truncate(double *w, double *u, size_t n, double sum)
+    {
+        for (size_t i = 0;i < n;++i) {
+            double alpha = sum - u[i];
+            if (0 < alpha) {
+                if (0 < w[i]) {
+                    w[i] -= alpha;
+                    if (w[i] < 0) {
+                        w[i] = 0;
+                        u[i] = 0;
+                        continue;
+                    }
+                } else if (w[i] < 0) {
+                    w[i] += alpha;
+                    if (0 < w[i]) {
+                        w[i] = 0;
+                        u[i] = 0;
+                        continue;
+                    }
+                }
+                u[i] = sum;
+            }
+        }
+    }
+};
+
+#if     defined(CLASSIAS_SIMD_X86)
+
+/**
+ * SSE2 implementations of the kernels.
+ */
+struct sse2
+{
+    static CLASSIAS_TARGET_SSE2 inline __m128d select(__m128d m, __m128d a, __m128d b)
+    {
+        return _mm_or_pd(_mm_and_pd(m, a), _mm_andnot_pd(m, b));
+    }
+
+    static CLASSIAS_TARGET_SSE2 void fill(double *x, size_t n, double a)
+    {
+        size_t i = 0;
+        const __m128d va = _mm_set1_pd(a);
+        for (;i + 2 <= n;i += 2) {
+            _mm_storeu_pd(x+i, va);
+        }
+        scalar::fill(x+i, n-i, a);
+    }
+
+    static CLASSIAS_TARGET_SSE2 void scale(double *x, size_t n, double a)
+    {
+        size_t i = 0;
+        const __m128d va = _mm_set1_pd(a);
+        for (;i + 2 <= n;i += 2) {
+            _mm_storeu_pd(x+i, _mm_mul_pd(_mm_loadu_pd(x+i), va));
+        }
+        scalar::scale(x+i, n-i, a);
+    }
+
+    static CLASSIAS_TARGET_SSE2 void axpy(double *y, const double *x, size_t n, double a)
+    {
+        size_t i = 0;
+        const __m128d va = _mm_set1_pd(a);
+        for (;i + 2 <= n;i += 2) {
+            __m128d vy = _mm_loadu_pd(y+i);
+            __m128d vx = _mm_loadu_pd(x+i);
+            _mm_storeu_pd(y+i, _mm_add_pd(vy, _mm_mul_pd(va, vx)));
+        }
+        scalar::axpy(y+i, x+i, n-i, a);
+    }
+
+    static CLASSIAS_TARGET_SSE2 double dot(const double *x, const double *y, size_t n)
+    {
+        size_t i = 0;
+        double p[8];
+        __m128d s0 = _mm_setzero_pd(), s1 = s0, s2 = s0, s3 = s0;
+        for (;i + 8 <= n;i += 8) {
+            s0 = _mm_add_pd(s0, _mm_mul_pd(_mm_loadu_pd(x+i+0), _mm_loadu_pd(y+i+0)));
+            s1 = _mm_add_pd(s1, _mm_mul_pd(_mm_loadu_pd(x+i+2), _mm_loadu_pd(y+i+2)));
+            s2 = _mm_add_pd(s2, _mm_mul_pd(_mm_loadu_pd(x+i+4), _mm_loadu_pd(y+i+4)));
+            s3 = _mm_add_pd(s3, _mm_mul_pd(_mm_loadu_pd(x+i+6), _mm_loadu_pd(y+i+6)));
+        }
+        _mm_storeu_pd(p+0, s0);
+        _mm_storeu_pd(p+2, s1);
+        _mm_storeu_pd(p+4, s2);
+        _mm_storeu_pd(p+6, s3);
+        double s = sum8(p);
+        for (;i < n;++i) {
+            s += x[i] * y[i];
+        }
+        return s;
+    }
+
+    static CLASSIAS_TARGET_SSE2 inline __m128d load2f(const float *x)
+    {
+        return _mm_cvtps_pd(_mm_castsi128_ps(_mm_loadl_epi64((const __m128i*)x)));
+    }
+
+    static CLASSIAS_TARGET_SSE2 void axpy(double *y, const float *x, size_t n, double a)
+    {
+        size_t i = 0;
+        const __m128d va = _mm_set1_pd(a);
+        for (;i + 2 <= n;i += 2) {
+            __m128d vy = _mm_loadu_pd(y+i);
+            _mm_storeu_pd(y+i, _mm_add_pd(vy, _mm_mul_pd(va, load2f(x+i))));
+        }
+        scalar::axpy(y+i, x+i, n-i, a);
+    }
+
+    static CLASSIAS_TARGET_SSE2 double dot(const float *x, const double *y, size_t n)
+    {
+        size_t i = 0;
+        double p[8];
+        __m128d s0 = _mm_setzero_pd(), s1 = s0, s2 = s0, s3 = s0;
+        for (;i + 8 <= n;i += 8) {
+            s0 = _mm_add_pd(s0, _mm_mul_pd(load2f(x+i+0), _mm_loadu_pd(y+i+0)));
+            s1 = _mm_add_pd(s1, _mm_mul_pd(load2f(x+i+2), _mm_loadu_pd(y+i+2)));
+            s2 = _mm_add_pd(s2, _mm_mul_pd(load2f(x+i+4), _mm_loadu_pd(y+i+4)));
+            s3 = _mm_add_pd(s3, _mm_mul_pd(load2f(x+i+6), _mm_loadu_pd(y+i+6)));
+        }
+        _mm_storeu_pd(p+0, s0);
+        _mm_storeu_pd(p+2, s1);
+        _mm_storeu_pd(p+4, s2);
+        _mm_storeu_pd(p+6, s3);
+        double s = sum8(p);
+        for (;i < n;++i) {
+            s += (double)x[i] * y[i];
+        }
+        return s;
+    }
+
+    static CLASSIAS_TARGET_SSE2 double axpy_sqnorm(double *y, const double *x, size_t n, double a)
+    {
+        size_t i = 0;
+        double p[8];
+        const __m128d va = _mm_set1_pd(a);
+        __m128d s[4] = {_mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd()};
+        for (;i + 8 <= n;i += 8) {
+            for (int j = 0;j < 4;++j) {
+                __m128d vx = _mm_loadu_pd(x+i+2*j);
+                __m128d vy = _mm_loadu_pd(y+i+2*j);
+                _mm_storeu_pd(y+i+2*j, _mm_add_pd(vy, _mm_mul_pd(va, vx)));
+                s[j] = _mm_add_pd(s[j], _mm_mul_pd(vx, vx));
+            }
+        }
+        for (int j = 0;j < 4;++j) {
+            _mm_storeu_pd(p+2*j, s[j]);
+        }
+        double t = sum8(p);
+        for (;i < n;++i) {
+            y[i] += a * x[i];
+            t += x[i] * x[i];
+        }
+        return t;
+    }
+
+    static CLASSIAS_TARGET_SSE2 double scale_sqnorm(double *x, size_t n, double a)
+    {
+        size_t i = 0;
+        double p[8];
+        const __m128d va = _mm_set1_pd(a);
+        __m128d s[4] = {_mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd(), _mm_setzero_pd()};
+        for (;i + 8 <= n;i += 8) {
+            for (int j = 0;j < 4;++j) {
+                __m128d vx = _mm_mul_pd(_mm_loadu_pd(x+i+2*j), va);
+                _mm_storeu_pd(x+i+2*j, vx);
+                s[j] = _mm_add_pd(s[j], _mm_mul_pd(vx, vx));
+            }
+        }
+        for (int j = 0;j < 4;++j) {
+            _mm_storeu_pd(p+2*j, s[j]);
+        }
+        double t = sum8(p);
+        for (;i < n;++i) {
+            x[i] *= a;
+            t += x[i] * x[i];
+        }
+        return t;
+    }
+
+    static CLASSIAS_TARGET_SSE2 double norm1(const double *x, size_t n)
+    {
+        size_t i = 0;
+        double p[8];
+        const __m128d sign = _mm_set1_pd(-0.);
+        __m128d s0 = _mm_setzero_pd(), s1 = s0, s2 = s0, s3 = s0;
+        for (;i + 8 <= n;i += 8) {
+            s0 = _mm_add_pd(s0, _mm_andnot_pd(sign, _mm_loadu_pd(x+i+0)));
+            s1 = _mm_add_pd(s1, _mm_andnot_pd(sign, _mm_loadu_pd(x+i+2)));
+            s2 = _mm_add_pd(s2, _mm_andnot_pd(sign, _mm_loadu_pd(x+i+4)));
+            s3 = _mm_add_pd(s3, _mm_andnot_pd(sign, _mm_loadu_pd(x+i+6)));
+        }
+        _mm_storeu_pd(p+0, s0);
+        _mm_storeu_pd(p+2, s1);
+        _mm_storeu_pd(p+4, s2);
+        _mm_storeu_pd(p+6, s3);
+        double s = sum8(p);
+        for (;i < n;++i) {
+            s += std::fabs(x[i]);
+        }
+        return s;
+    }
+
+    static CLASSIAS_TARGET_SSE2 size_t count_nonzero(const double *x, size_t n)
+    {
+        size_t i = 0, c = 0;
+        const __m128d zero = _mm_setzero_pd();
+        for (;i + 2 <= n;i += 2) {
+            int m = _mm_movemask_pd(_mm_cmpneq_pd(_mm_loadu_pd(x+i), zero));
+            c += (m & 1) + (m >> 1);
+        }
+        return c + scalar::count_nonzero(x+i, n-i);
+    }
+
+    static CLASSIAS_TARGET_SSE2 void truncate(double *w, double *u, size_t n, double sum)
+    {
+        size_t i = 0;
+        const __m128d zero = _mm_setzero_pd();
+        const __m128d vs = _mm_set1_pd(sum);
+        for (;i + 2 <= n;i += 2) {
+            __m128d vw = _mm_loadu_pd(w+i);
+            __m128d vu = _mm_loadu_pd(u+i);
+            __m128d alpha = _mm_sub_pd(vs, vu);
+            __m128d active = _mm_cmpgt_pd(alpha, zero);
+            __m128d pos = _mm_cmpgt_pd(vw, zero);
+            __m128d neg = _mm_cmplt_pd(vw, zero);
+            __m128d wn = select(pos, _mm_sub_pd(vw, alpha),
+                select(neg, _mm_add_pd(vw, alpha), vw));
+            __m128d clip = _mm_or_pd(
+                _mm_and_pd(pos, _mm_cmplt_pd(wn, zero)),
+                _mm_and_pd(neg, _mm_cmpgt_pd(wn, zero)));
+            _mm_storeu_pd(w+i, select(active, _mm_andnot_pd(clip, wn), vw));
+            _mm_storeu_pd(u+i, select(active, _mm_andnot_pd(clip, vs), vu));
+        }
+        scalar::truncate(w+i, u+i, n-i, sum);
+    }
+};
+
+/**
+ * AVX2 implementations of the kernels.
+ */
+struct avx2
+{
+    static CLASSIAS_TARGET_AVX2 void fill(double *x, size_t n, double a)
+    {
+        size_t i = 0;
+        const __m256d va = _mm256_set1_pd(a);
+        for (;i + 4 <= n;i += 4) {
+            _mm256_storeu_pd(x+i, va);
+        }
+        scalar::fill(x+i, n-i, a);
+    }
+
+    static CLASSIAS_TARGET_AVX2 void scale(double *x, size_t n, double a)
+    {
+        size_t i = 0;
+        const __m256d va = _mm256_set1_pd(a);
+        for (;i + 4 <= n;i += 4) {
+            _mm256_storeu_pd(x+i, _mm256_mul_pd(_mm256_loadu_pd(x+i), va));
+        }
+        scalar::scale(x+i, n-i, a);
+    }
+
+    static CLASSIAS_TARGET_AVX2 void axpy(double *y, const double *x, size_t n, double a)
+    {
+        size_t i = 0;
+        const __m256d va = _mm256_set1_pd(a);
+        for (;i + 4 <= n;i += 4) {
+            __m256d vy = _mm256_loadu_pd(y+i);
+            __m256d vx = _mm256_loadu_pd(x+i);
+            _mm256_storeu_pd(y+i, _mm256_add_pd(vy, _mm256_mul_pd(va, vx)));
+        }
+        scalar::axpy(y+i, x+i, n-i, a);
+    }
+
+    static CLASSIAS_TARGET_AVX2 double dot(const double *x, const double *y, size_t n)
+    {
+        size_t i = 0;
+        double p[8];
+        __m256d s0 = _mm256_setzero_pd(), s1 = s0;
+        for (;i + 8 <= n;i += 8) {
+            s0 = _mm256_add_pd(s0, _mm256_mul_pd(_mm256_loadu_pd(x+i+0), _mm256_loadu_pd(y+i+0)));
+            s1 = _mm256_add_pd(s1, _mm256_mul_pd(_mm256_loadu_pd(x+i+4), _mm256_loadu_pd(y+i+4)));
+        }
+        _mm256_storeu_pd(p+0, s0);
+        _mm256_storeu_pd(p+4, s1);
+        double s = sum8(p);
+        for (;i < n;++i) {
+            s += x[i] * y[i];
+        }
+        return s;
+    }
+
+    static CLASSIAS_TARGET_AVX2 void axpy(double *y, const float *x, size_t n, double a)
+    {
+        size_t i = 0;
+        const __m256d va = _mm256_set1_pd(a);
+        for (;i + 4 <= n;i += 4) {
+            __m256d vy = _mm256_loadu_pd(y+i);
+            __m256d vx = _mm256_cvtps_pd(_mm_loadu_ps(x+i));
+            _mm256_storeu_pd(y+i, _mm256_add_pd(vy, _mm256_mul_pd(va, vx)));
+        }
+        scalar::axpy(y+i, x+i, n-i, a);
+    }
+
+    static CLASSIAS_TARGET_AVX2 double dot(const float *x, const double *y, size_t n)
+    {
+        size_t i = 0;
+        double p[8];
+        __m256d s0 = _mm256_setzero_pd(), s1 = s0;
+        for (;i + 8 <= n;i += 8) {
+            s0 = _mm256_add_pd(s0, _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(x+i+0)), _mm256_loadu_pd(y+i+0)));
+            s1 = _mm256_add_pd(s1, _mm256_mul_pd(_mm256_cvtps_pd(_mm_loadu_ps(x+i+4)), _mm256_loadu_pd(y+i+4)));
+        }
+        _mm256_storeu_pd(p+0, s0);
+        _mm256_storeu_pd(p+4, s1);
+        double s = sum8(p);
+        for (;i < n;++i) {
+            s += (double)x[i] * y[i];
+        }
+        return s;
+    }
+
+    static CLASSIAS_TARGET_AVX2 double axpy_sqnorm(double *y, const double *x, size_t n, double a)
+    {
+        size_t i = 0;
+        double p[8];
+        const __m256d va = _mm256_set1_pd(a);
+        __m256d s[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+        for (;i + 8 <= n;i += 8) {
+            for (int j = 0;j < 2;++j) {
+                __m256d vx = _mm256_loadu_pd(x+i+4*j);
+                __m256d vy = _mm256_loadu_pd(y+i+4*j);
+                _mm256_storeu_pd(y+i+4*j, _mm256_add_pd(vy, _mm256_mul_pd(va, vx)));
+                s[j] = _mm256_add_pd(s[j], _mm256_mul_pd(vx, vx));
+            }
+        }
+        _mm256_storeu_pd(p+0, s[0]);
+        _mm256_storeu_pd(p+4, s[1]);
+        double t = sum8(p);
+        for (;i < n;++i) {
+            y[i] += a * x[i];
+            t += x[i] * x[i];
+        }
+        return t;
+    }
+
+    static CLASSIAS_TARGET_AVX2 double scale_sqnorm(double *x, size_t n, double a)
+    {
+        size_t i = 0;
+        double p[8];
+        const __m256d va = _mm256_set1_pd(a);
+        __m256d s[2] = {_mm256_setzero_pd(), _mm256_setzero_pd()};
+        for (;i + 8 <= n;i += 8) {
+            for (int j = 0;j < 2;++j) {
+                __m256d vx = _mm256_mul_pd(_mm256_loadu_pd(x+i+4*j), va);
+                _mm256_storeu_pd(x+i+4*j, vx);
+                s[j] = _mm256_add_pd(s[j], _mm256_mul_pd(vx, vx));
+            }
+        }
+        _mm256_storeu_pd(p+0, s[0]);
+        _mm256_storeu_pd(p+4, s[1]);
+        double t = sum8(p);
+        for (;i < n;++i) {
+            x[i] *= a;
+            t += x[i] * x[i];
+        }
+        return t;
+    }
+
+    static CLASSIAS_TARGET_AVX2 double norm1(const double *x, size_t n)
+    {
+        size_t i = 0;
+        double p[8];
+        const __m256d sign = _mm256_set1_pd(-0.);
+        __m256d s0 = _mm256_setzero_pd(), s1 = s0;
+        for (;i + 8 <= n;i += 8) {
+            s0 = _mm256_add_pd(s0, _mm256_andnot_pd(sign, _mm256_loadu_pd(x+i+0)));
+            s1 = _mm256_add_pd(s1, _mm256_andnot_pd(sign, _mm256_loadu_pd(x+i+4)));
+        }
+        _mm256_storeu_pd(p+0, s0);
+        _mm256_storeu_pd(p+4, s1);
+        double s = sum8(p);
+        for (;i < n;++i) {
+            s += std::fabs(x[i]);
+        }
+        return s;
+    }
+
+    static CLASSIAS_TARGET_AVX2 size_t count_nonzero(const double *x, size_t n)
+    {
+        size_t i = 0, c = 0;
+        const __m256d zero = _mm256_setzero_pd();
+        for (;i + 4 <= n;i += 4) {
+            unsigned m = (unsigned)_mm256_movemask_pd(
+                _mm256_cmp_pd(_mm256_loadu_pd(x+i), zero, _CMP_NEQ_UQ));
+            c += (m & 1) + ((m >> 1) & 1) + ((m >> 2) & 1) + (m >> 3);
+        }
+        return c + scalar::count_nonzero(x+i, n-i);
+    }
+
+    static CLASSIAS_TARGET_AVX2 void truncate(double *w, double *u, size_t n, double sum)
+    {
+        size_t i = 0;
+        const __m256d zero = _mm256_setzero_pd();
+        const __m256d vs = _mm256_set1_pd(sum);
+        for (;i + 4 <= n;i += 4) {
+            __m256d vw = _mm256_loadu_pd(w+i);
+            __m256d vu = _mm256_loadu_pd(u+i);
+            __m256d alpha = _mm256_sub_pd(vs, vu);
+            __m256d active = _mm256_cmp_pd(alpha, zero, _CMP_GT_OQ);
+            __m256d pos = _mm256_cmp_pd(vw, zero, _CMP_GT_OQ);
+            __m256d neg = _mm256_cmp_pd(vw, zero, _CMP_LT_OQ);
+            __m256d wn = _mm256_blendv_pd(
+                _mm256_blendv_pd(vw, _mm256_add_pd(vw, alpha), neg),
+                _mm256_sub_pd(vw, alpha), pos);
+            __m256d clip = _mm256_or_pd(
+                _mm256_and_pd(pos, _mm256_cmp_pd(wn, zero, _CMP_LT_OQ)),
+                _mm256_and_pd(neg, _mm256_cmp_pd(wn, zero, _CMP_GT_OQ)));
+            _mm256_storeu_pd(w+i, _mm256_blendv_pd(vw, _mm256_andnot_pd(clip, wn), active));
+            _mm256_storeu_pd(u+i, _mm256_blendv_pd(vu, _mm256_andnot_pd(clip, vs), active));
+        }
+        scalar::truncate(w+i, u+i, n-i, sum);
+    }
+};
+
+/**
+ * AVX-512 implementations of the kernels.
+ */
+struct avx512
+{
+    static CLASSIAS_TARGET_AVX512 void fill(double *x, size_t n, double a)
+    {
+        size_t i = 0;
+        const __m512d va = _mm512_set1_pd(a);
+        for (;i + 8 <= n;i += 8) {
+            _mm512_storeu_pd(x+i, va);
+        }
+        scalar::fill(x+i, n-i, a);
+    }
+
+    static CLASSIAS_TARGET_AVX512 void scale(double *x, size_t n, double a)
+    {
+        size_t i = 0;
+        const __m512d va = _mm512_set1_pd(a);
+        for (;i + 8 <= n;i += 8) {
+            _mm512_storeu_pd(x+i, _mm512_mul_pd(_mm512_loadu_pd(x+i), va));
+        }
+        scalar::scale(x+i, n-i, a);
+    }
+
+    static CLASSIAS_TARGET_AVX512 void axpy(double *y, const double *x, size_t n, double a)
+    {
+        size_t i = 0;
+        const __m512d va = _mm512_set1_pd(a);
+        for (;i + 8 <= n;i += 8) {
+            __m512d vy = _mm512_loadu_pd(y+i);
+            __m512d vx = _mm512_loadu_pd(x+i);
+            _mm512_storeu_pd(y+i, _mm512_add_pd(vy, _mm512_mul_pd(va, vx)));
+        }
+        for (;i < n;++i) {
+            y[i] += a * x[i];
+        }
+    }
+
+    static CLASSIAS_TARGET_AVX512 double dot(const double *x, const double *y, size_t n)
+    {
+        size_t i = 0;
+        double p[8];
+        __m512d s0 = _mm512_setzero_pd();
+        for (;i + 8 <= n;i += 8) {
+            s0 = _mm512_add_pd(s0, _mm512_mul_pd(_mm512_loadu_pd(x+i), _mm512_loadu_pd(y+i)));
+        }
+        _mm512_storeu_pd(p, s0);
+        double s = sum8(p);
+        for (;i < n;++i) {
+            s += x[i] * y[i];
+        }
+        return s;
+    }
+
+    static CLASSIAS_TARGET_AVX512 inline __m512d load8f(const float *x)
+    {
+        // The zero-masking form avoids the undefined pass-through operand.
+        return _mm512_maskz_cvtps_pd((__mmask8)-1, _mm256_loadu_ps(x));
+    }
+
+    static CLASSIAS_TARGET_AVX512 void axpy(double *y, const float *x, size_t n, double a)
+    {
+        size_t i = 0;
+        const __m512d va = _mm512_set1_pd(a);
+        for (;i + 8 <= n;i += 8) {
+            __m512d vy = _mm512_loadu_pd(y+i);
+            __m512d vx = load8f(x+i);
+            _mm512_storeu_pd(y+i, _mm512_add_pd(vy, _mm512_mul_pd(va, vx)));
+        }
+        for (;i < n;++i) {
+            y[i] += a * (double)x[i];
+        }
+    }
+
+    static CLASSIAS_TARGET_AVX512 double dot(const float *x, const double *y, size_t n)
+    {
+        size_t i = 0;
+        double p[8];
+        __m512d s0 = _mm512_setzero_pd();
+        for (;i + 8 <= n;i += 8) {
+            s0 = _mm512_add_pd(s0, _mm512_mul_pd(load8f(x+i), _mm512_loadu_pd(y+i)));
+        }
+        _mm512_storeu_pd(p, s0);
+        double s = sum8(p);
+        for (;i < n;++i) {
+            s += (double)x[i] * y[i];
+        }
+        return s;
+    }
+
+    static CLASSIAS_TARGET_AVX512 double axpy_sqnorm(double *y, const double *x, size_t n, double a)
+    {
+        size_t i = 0;
+        double p[8];
+        const __m512d va = _mm512_set1_pd(a);
+        __m512d s0 = _mm512_setzero_pd();
+        for (;i + 8 <= n;i += 8) {
+            __m512d vx = _mm512_loadu_pd(x+i);
+            __m512d vy = _mm512_loadu_pd(y+i);
+            _mm512_storeu_pd(y+i, _mm512_add_pd(vy, _mm512_mul_pd(va, vx)));
+            s0 = _mm512_add_pd(s0, _mm512_mul_pd(vx, vx));
+        }
+        _mm512_storeu_pd(p, s0);
+        double t = sum8(p);
+        for (;i < n;++i) {
+            y[i] += a * x[i];
+            t += x[i] * x[i];
+        }
+        return t;
+    }
+
+    static CLASSIAS_TARGET_AVX512 double scale_sqnorm(double *x, size_t n, double a)
+    {
+        size_t i = 0;
+        double p[8];
+        const __m512d va = _mm512_set1_pd(a);
+        __m512d s0 = _mm512_setzero_pd();
+        for (;i + 8 <= n;i += 8) {
+            __m512d vx = _mm512_mul_pd(_mm512_loadu_pd(x+i), va);
+            _mm512_storeu_pd(x+i, vx);
+            s0 = _mm512_add_pd(s0, _mm512_mul_pd(vx, vx));
+        }
+        _mm512_storeu_pd(p, s0);
+        double t = sum8(p);
+        for (;i < n;++i) {
+            x[i] *= a;
+            t += x[i] * x[i];
+        }
+        return t;
+    }
+
+    static CLASSIAS_TARGET_AVX512 double norm1(const double *x, size_t n)
+    {
+        size_t i = 0;
+        double p[8];
+        __m512d s0 = _mm512_setzero_pd();
+        for (;i + 8 <= n;i += 8) {
+            s0 = _mm512_add_pd(s0, _mm512_abs_pd(_mm512_loadu_pd(x+i)));
+        }
+        _mm512_storeu_pd(p, s0);
+        double s = sum8(p);
+        for (;i < n;++i) {
+            s += std::fabs(x[i]);
+        }
+        return s;
+    }
+
+    static CLASSIAS_TARGET_AVX512 size_t count_nonzero(const double *x, size_t n)
+    {
+        size_t i = 0, c = 0;
+        const __m512d zero = _mm512_setzero_pd();
+        for (;i + 8 <= n;i += 8) {
+            unsigned m = (unsigned)_mm512_cmp_pd_mask(_mm512_loadu_pd(x+i), zero, _CMP_NEQ_UQ);
+            while (m) {
+                m &= m - 1;
+                ++c;
+            }
+        }
+        return c + scalar::count_nonzero(x+i, n-i);
+    }
+
+    static CLASSIAS_TARGET_AVX512 void truncate(double *w, double *u, size_t n, double sum)
+    {
+        size_t i = 0;
+        const __m512d zero = _mm512_setzero_pd();
+        const __m512d vs = _mm512_set1_pd(sum);
+        for (;i + 8 <= n;i += 8) {
+            __m512d vw = _mm512_loadu_pd(w+i);
+            __m512d vu = _mm512_loadu_pd(u+i);
+            __m512d alpha = _mm512_sub_pd(vs, vu);
+            __mmask8 active = _mm512_cmp_pd_mask(alpha, zero, _CMP_GT_OQ);
+            __mmask8 pos = _mm512_cmp_pd_mask(vw, zero, _CMP_GT_OQ);
+            __mmask8 neg = _mm512_cmp_pd_mask(vw, zero, _CMP_LT_OQ);
+            __m512d wn = _mm512_mask_blend_pd(neg, vw, _mm512_add_pd(vw, alpha));
+            wn = _mm512_mask_blend_pd(pos, wn, _mm512_sub_pd(vw, alpha));
+            __mmask8 clip = (__mmask8)(
+                (pos & _mm512_cmp_pd_mask(wn, zero, _CMP_LT_OQ)) |
+                (neg & _mm512_cmp_pd_mask(wn, zero, _CMP_GT_OQ)));
+            wn = _mm512_mask_blend_pd(clip, wn, zero);
+            _mm512_storeu_pd(w+i, _mm512_mask_blend_pd(active, vw, wn));
+            _mm512_storeu_pd(u+i, _mm512_mask_blend_pd(
+                active, vu, _mm512_mask_blend_pd(clip, vs, zero)));
+        }
+        scalar::truncate(w+i, u+i, n-i, sum);
+    }
+};
+
+#define CLASSIAS_SIMD_DISPATCH(call) \
+    switch (level()) { \
+    case AVX512: \
+        return avx512::call; \
+    case AVX2: \
+        return avx2::call; \
+    case SSE2: \
+        return sse2::call; \
+    } \
+    return scalar::call;
+
+#else
+
+#define CLASSIAS_SIMD_DISPATCH(call) \
+    return scalar::call;
+
+#endif/*defined(CLASSIAS_SIMD_X86)*/
+
+/**
+ * Sets a value to all elements of an array: x[i] = a.
+ *  @param  x           The array.
+ *  @param  n           The number of elements.
+ *  @param  a           The value.
+ */
+inline void fill(double *x, size_t n, double a)
+{
+    CLASSIAS_SIMD_DISPATCH(fill(x, n, a));
+}
+
+/**
+ * Multiplies all elements of an array by a value: x[i] *= a.
+ *  @param  x           The array.
+ *  @param  n           The number of elements.
+ *  @param  a           The multiplier.
+ */
+inline void scale(double *x, size_t n, double a)
+{
+    CLASSIAS_SIMD_DISPATCH(scale(x, n, a));
+}
+
+/**
+ * Adds a scaled array to another: y[i] += a * x[i].
+ *  @param  y           The array to which the values are added.
+ *  @param  x           The array to be scaled.
+ *  @param  n           The number of elements.
+ *  @param  a           The scaling factor.
+ */
+inline void axpy(double *y, const double *x, size_t n, double a)
+{
+    CLASSIAS_SIMD_DISPATCH(axpy(y, x, n, a));
+}
+
+/**
+ * Computes the inner product of two arrays.
+ *  @param  x           The first array.
+ *  @param  y           The second array.
+ *  @param  n           The number of elements.
+ *  @return double      The inner product.
+ */
+inline double dot(const double *x, const double *y, size_t n)
+{
+    CLASSIAS_SIMD_DISPATCH(dot(x, y, n));
+}
+
+/**
+ * Adds a scaled array of single-precision values to another:
+ * y[i] += a * x[i].
+ *  @param  y           The array to which the values are added.
+ *  @param  x           The array to be scaled.
+ *  @param  n           The number of elements.
+ *  @param  a           The scaling factor.
+ */
+inline void axpy(double *y, const float *x, size_t n, double a)
+{
+    CLASSIAS_SIMD_DISPATCH(axpy(y, x, n, a));
+}
+
+/**
+ * Computes the inner product of an array of single-precision values and
+ * an array of double-precision values in double precision.
+ *  @param  x           The array of single-precision values.
+ *  @param  y           The array of double-precision values.
+ *  @param  n           The number of elements.
+ *  @return double      The inner product.
+ */
+inline double dot(const float *x, const double *y, size_t n)
+{
+    CLASSIAS_SIMD_DISPATCH(dot(x, y, n));
+}
+
+/**
+ * Adds a scaled array to another and computes the squared L2 norm of the
+ * scaled array in one pass: y[i] += a * x[i].
+ *  @param  y           The array to which the values are added.
+ *  @param  x           The array to be scaled.
+ *  @param  n           The number of elements.
+ *  @param  a           The scaling factor.
+ *  @return double      The squared L2 norm of x, identical to dot(x, x, n).
+ */
+inline double axpy_sqnorm(double *y, const double *x, size_t n, double a)
+{
+    CLASSIAS_SIMD_DISPATCH(axpy_sqnorm(y, x, n, a));
+}
+
+/**
+ * Multiplies all elements of an array by a value and computes the squared
+ * L2 norm of the result in one pass: x[i] *= a.
+ *  @param  x           The array.
+ *  @param  n           The number of elements.
+ *  @param  a           The multiplier.
+ *  @return double      The squared L2 norm of the result.
+ */
+inline double scale_sqnorm(double *x, size_t n, double a)
+{
+    CLASSIAS_SIMD_DISPATCH(scale_sqnorm(x, n, a));
+}
+
+/**
+ * Computes the L1 norm of an array.
+ *  @param  x           The array.
+ *  @param  n           The number of elements.
+ *  @return double      The sum of the absolute values.
+ */
+inline double norm1(const double *x, size_t n)
+{
+    CLASSIAS_SIMD_DISPATCH(norm1(x, n));
+}
+
+/**
+ * Counts the number of non-zero elements in an array.
+ *  @param  x           The array.
+ *  @param  n           The number of elements.
+ *  @return size_t      The number of non-zero elements.
+ */
+inline size_t count_nonzero(const double *x, size_t n)
+{
+    CLASSIAS_SIMD_DISPATCH(count_nonzero(x, n));
+}
+
+/**
+ * Applies lazy L1 penalties to an array (Truncated Gradient).
+ *  For an element whose penalty u[i] falls behind the cumulative penalty
+ *  (sum), this function moves w[i] toward zero by (sum - u[i]) without
+ *  crossing zero, and sets u[i] to sum (or zero when w[i] is truncated).
+ *  @param  w           The weights.
+ *  @param  u           The cumulative penalties applied to the weights.
+ *  @param  n           The number of elements.
+ *  @param  sum         The cumulative penalty.
+ */
+inline void truncate(double *w, double *u, size_t n, double sum)
+{
+    CLASSIAS_SIMD_DISPATCH(truncate(w, u, n, sum));
+}
+
+#undef  CLASSIAS_SIMD_DISPATCH
+
+/*
+ * Kernels for weight vectors (containers).
+ *  The training algorithms apply the kernels to a weight vector through
+ *  the following overloads, which accept a std::vector<double> (including
+ *  default_vector) or a paged_vector<double>. The overloads for a
+ *  paged_vector process the touched pages only; an untouched page holds
+ *  zeros, which the kernels leave as they are (except for fill() with a
+ *  non-zero value).
+ */
+
+/**
+ * Fills a weight vector with a value.
+ *  @param  x           The weight vector.
+ *  @param  a           The value.
+ */
+inline void fill(std::vector<double>& x, double a)
+{
+    if (!x.empty()) {
+        fill(&x[0], x.size(), a);
+    }
+}
+
+/**
+ * Computes y += a * x for weight vectors.
+ *  @param  y           The weight vector to be updated (at least as long
+ *                      as x).
+ *  @param  x           The weight vector.
+ *  @param  a           The scalar.
+ */
+inline void axpy(std::vector<double>& y, const std::vector<double>& x, double a)
+{
+    if (!x.empty()) {
+        axpy(&y[0], &x[0], x.size(), a);
+    }
+}
+
+/**
+ * Computes the dot product of weight vectors.
+ *  @param  x           The weight vector.
+ *  @param  y           The weight vector (at least as long as x).
+ *  @return double      The dot product.
+ */
+inline double dot(const std::vector<double>& x, const std::vector<double>& y)
+{
+    return x.empty() ? 0. : dot(&x[0], &y[0], x.size());
+}
+
+/**
+ * Scales a weight vector and computes its squared L2-norm.
+ *  @param  x           The weight vector.
+ *  @param  a           The scalar.
+ *  @return double      The squared L2-norm of the scaled vector.
+ */
+inline double scale_sqnorm(std::vector<double>& x, double a)
+{
+    return x.empty() ? 0. : scale_sqnorm(&x[0], x.size(), a);
+}
+
+/**
+ * Computes the L1-norm of a weight vector.
+ *  @param  x           The weight vector.
+ *  @return double      The L1-norm.
+ */
+inline double norm1(const std::vector<double>& x)
+{
+    return x.empty() ? 0. : norm1(&x[0], x.size());
+}
+
+/**
+ * Counts the non-zero elements of a weight vector.
+ *  @param  x           The weight vector.
+ *  @return size_t      The number of non-zero elements.
+ */
+inline size_t count_nonzero(const std::vector<double>& x)
+{
+    return x.empty() ? 0 : count_nonzero(&x[0], x.size());
+}
+
+/**
+ * Applies lazy L1 penalties to a weight vector (Truncated Gradient).
+ *  @param  w           The weight vector.
+ *  @param  u           The cumulative penalties (as long as w).
+ *  @param  sum         The cumulative penalty.
+ */
+inline void truncate(std::vector<double>& w, std::vector<double>& u, double sum)
+{
+    if (!w.empty()) {
+        truncate(&w[0], &u[0], w.size(), sum);
+    }
+}
+
+template <int page_bits>
+inline void fill(paged_vector<double, page_bits>& x, double a)
+{
+    for (size_t p = 0;p < x.num_pages();++p) {
+        if (a != 0. || x.page(p) != NULL) {
+            fill(x.touch_page(p), x.page_length(p), a);
+        }
+    }
+}
+
+template <int page_bits>
+inline void axpy(
+    paged_vector<double, page_bits>& y,
+    const paged_vector<double, page_bits>& x,
+    double a
+    )
+{
+    if (y.size() < x.size()) {
+        y.resize(x.size());
+    }
+    for (size_t p = 0;p < x.num_pages();++p) {
+        if (x.page(p) != NULL) {
+            axpy(y.touch_page(p), x.page(p), x.page_length(p), a);
+        }
+    }
+}
+
+template <int page_bits>
+inline double dot(
+    const paged_vector<double, page_bits>& x,
+    const paged_vector<double, page_bits>& y
+    )
+{
+    double s = 0.;
+    for (size_t p = 0;p < x.num_pages() && p < y.num_pages();++p) {
+        if (x.page(p) != NULL && y.page(p) != NULL) {
+            s += dot(x.page(p), y.page(p), x.page_length(p));
+        }
+    }
+    return s;
+}
+
+template <int page_bits>
+inline double scale_sqnorm(paged_vector<double, page_bits>& x, double a)
+{
+    double s = 0.;
+    for (size_t p = 0;p < x.num_pages();++p) {
+        if (x.page(p) != NULL) {
+            s += scale_sqnorm(x.touch_page(p), x.page_length(p), a);
+        }
+    }
+    return s;
+}
+
+template <int page_bits>
+inline double norm1(const paged_vector<double, page_bits>& x)
+{
+    double s = 0.;
+    for (size_t p = 0;p < x.num_pages();++p) {
+        if (x.page(p) != NULL) {
+            s += norm1(x.page(p), x.page_length(p));
+        }
+    }
+    return s;
+}
+
+template <int page_bits>
+inline size_t count_nonzero(const paged_vector<double, page_bits>& x)
+{
+    size_t n = 0;
+    for (size_t p = 0;p < x.num_pages();++p) {
+        if (x.page(p) != NULL) {
+            n += count_nonzero(x.page(p), x.page_length(p));
+        }
+    }
+    return n;
+}
+
+template <int page_bits>
+inline void truncate(
+    paged_vector<double, page_bits>& w,
+    paged_vector<double, page_bits>& u,
+    double sum
+    )
+{
+    if (u.size() < w.size()) {
+        u.resize(w.size());
+    }
+    for (size_t p = 0;p < w.num_pages();++p) {
+        if (w.page(p) != NULL) {
+            truncate(w.touch_page(p), u.touch_page(p), w.page_length(p), sum);
+        }
+    }
+}
+
+};
+
+};
+
+#endif/*__CLASSIAS_SIMD_H__*/
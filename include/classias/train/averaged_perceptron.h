@@ -33,10 +33,13 @@
 #ifndef __CLASSIAS_TRAIN_AVERAGED_PERCEPTRON_H__
 #define __CLASSIAS_TRAIN_AVERAGED_PERCEPTRON_H__
 
+#include <algorithm>
 #include <iostream>
+#include <vector>
 
 #include <classias/types.h>
 #include <classias/parameters.h>
+#include <classias/simd.h>
 
 namespace classias
 {
@@ -77,11 +80,13 @@ public:
     report_type m_report;
 
 protected:
-    /// The array of feature weights (unaveraged or averaged).
+    /// The array of feature weights (unaveraged).
     model_type m_w;
     /// The array of cumulative feature weights used for computing the average.
     model_type m_ws;
-    /// The indicator whether m_w is averaged or not.
+    /// The array of averaged feature weights.
+    model_type m_wa;
+    /// The indicator whether m_wa is up to date or not.
     bool m_averaged;
 
     /// The loss.
@@ -116,6 +121,7 @@ public:
         // Clear the weight vector.
         m_w.clear();
         m_ws.clear();
+        m_wa.clear();
         this->initialize_weights();
     }
 
@@ -131,6 +137,20 @@ public:
         this->initialize_weights();
     }
 
+    /**
+     * Expands the weight vector for new features.
+     *  This function appends zero weights for the features that are unseen
+     *  so far, without resetting the training process.
+     *  @param  size        The number of features.
+     */
+    void expand_num_features(size_t size)
+    {
+        if (m_w.size() < size) {
+            m_w.resize(size, 0.);
+            m_ws.resize(size, 0.);
+        }
+    }
+
 public:
     /**
      * Starts a training process.
@@ -162,11 +182,7 @@ public:
 
         // Fill the progress information.
         m_report.loss = m_loss;
-        m_report.norm2 = 0;
-        for (size_t i = 0;i < m_w.size();++i) {
-            m_report.norm2 += m_w[i] * m_w[i];
-        }
-        m_report.norm2 = std::sqrt(m_report.norm2);
+        m_report.norm2 = std::sqrt(simd::dot(m_wa, m_wa));
 
         // Reset the run-time information.
         m_loss = 0;
@@ -199,29 +215,114 @@ protected:
      */
     void initialize_weights()
     {
-        for (size_t i = 0;i < m_w.size();++i) {
-            m_w[i] = 0.;
-            m_ws[i] = 0.;
-        }
+        m_ws.resize(m_w.size());
+        simd::fill(m_w, 0.);
+        simd::fill(m_ws, 0.);
         m_c = 1;
+        m_averaged = false;
     }
 
     /**
      * Finalizes the weight vector.
-     *  This function computes the actual weight vector W from the internal
-     *  representation.
+     *  This function computes the averaged weight vector, W - WS / c, from
+     *  the internal representation into a separate vector, so that the
+     *  vectors W and WS are kept intact for resuming the training.
      */
     void average_weights()
     {
         if (!m_averaged) {
-            for (size_t i = 0;i < m_w.size();++i) {
-                m_w[i] -= m_ws[i] / m_c;
+            m_ws.resize(m_w.size());
+            m_wa = m_w;
+            simd::axpy(m_wa, m_ws, -1. / m_c);
+            m_averaged = true;
+        }
+    }
+
+public:
+    /**
+     * Invalidates the averaged weight vector before updates.
+     *  The averaged weight vector is computed again by average_weights()
+     *  after the updates.
+     */
+    void unaverage_weights()
+    {
+        m_averaged = false;
+    }
+
+    /**
+     * Starts an epoch of a shard in iterative parameter mixing.
+     *  This function copies the (unaveraged) weight vector of the master,
+     *  and resets the local averaging.
+     *  @param  master      The master of the shards.
+     */
+    void begin_shard(const averaged_perceptron_base& master)
+    {
+        m_w = master.m_w;
+        m_ws.resize(m_w.size());
+        simd::fill(m_ws, 0.);
+        m_c = 1;
+        m_loss = 0;
+        m_averaged = false;
+    }
+
+    /**
+     * Mixes the weight vectors of shards (iterative parameter mixing).
+     *  This function sets the weight vector to the mixture of the weight
+     *  vectors of the shards, sum_k mu_k W_k. The k-th shard started from
+     *  the weight vector W with the count c, and its update with the local
+     *  count c_k is equivalent to the update with the count (c + c_k - 1);
+     *  the cumulative weights of the averaging are mixed accordingly:
+     *      WS += sum_k mu_k (WS_k + (c - 1) (W_k - W)).
+     *  The detail of the algorithm is described in:
+     *
+     *  -   Ryan McDonald, Keith Hall, and Gideon Mann.
+     *      Distributed Training Strategies for the Structured Perceptron.
+     *      In Proc. of NAACL-HLT 2010, pp 456-464, 2010.
+     *
+     *  @param  shards      The pointers to the shards.
+     *  @param  weighted    The mixing coefficients mu_k are proportional
+     *                      to the number of errors in the shards if
+     *                      \c true; uniform otherwise.
+     */
+    template <class shard_type>
+    void mix_weights(const std::vector<shard_type*>& shards, bool weighted)
+    {
+        const size_t T = shards.size();
+        this->unaverage_weights();
+
+        // Compute the mixing coefficients.
+        value_type total = 0.;
+        for (size_t k = 0;k < T;++k) {
+            const this_class& shard = *shards[k];
+            total += shard.m_loss;
+        }
+        std::vector<value_type> mu(T, 1. / T);
+        if (weighted && 0 < total) {
+            for (size_t k = 0;k < T;++k) {
+                const this_class& shard = *shards[k];
+                mu[k] = shard.m_loss / total;
             }
-            for (size_t i = 0;i < m_w.size();++i) {
-                m_ws[i] = m_w[i];
+        }
+
+        // Mix the weights.
+        int n = 0;
+        const value_type c1 = (value_type)(m_c - 1);
+        simd::axpy(m_ws, m_w, -c1);
+        simd::fill(m_w, 0.);
+        for (size_t k = 0;k < T;++k) {
+            const this_class& shard = *shards[k];
+            simd::axpy(m_ws, shard.m_ws, mu[k]);
+            simd::axpy(m_ws, shard.m_w, mu[k] * c1);
+            simd::axpy(m_w, shard.m_w, mu[k]);
+        }
+        for (size_t k = 0;k < T;++k) {
+            const this_class& shard = *shards[k];
+            if (n < shard.m_c - 1) {
+                n = shard.m_c - 1;
             }
-            m_averaged = true;
         }
+        m_c += n;
+        m_loss += total;
     }
 
 public:
@@ -243,7 +344,7 @@ public:
     model_type& model()
     {
         this->average_weights();
-        return m_w;
+        return m_wa;
     }
 
     /**
@@ -302,6 +403,7 @@ public:
         model_type& w = this->m_w;
         model_type& ws = this->m_ws;
 
+        this->unaverage_weights();
         error_type cls(w);
         cls.inner_product(it->begin(), it->end());
         if (static_cast<bool>(cls) != it->get_label()) {
@@ -330,6 +432,86 @@ public:
         }
     }
 
+
+    /**
+     * Prepares for a mini-batch of training instances.
+     *  @param  insts       The iterators of the training instances.
+     *  @param  first       The position of the first instance of the
+     *                      mini-batch.
+     *  @param  last        The position just beyond the last instance of
+     *                      the mini-batch.
+     */
+    template <class iterator_type>
+    void begin_batch(
+        const std::vector<iterator_type>& insts,
+        size_t first,
+        size_t last
+        )
+    {
+        this->unaverage_weights();
+    }
+
+    /**
+     * Computes the error of a training instance in a mini-batch.
+     *  This function does not change the model, and can be called by
+     *  multiple threads between begin_batch() and update_batch().
+     *  @param  it          An interator for the training instance.
+     *  @param  err         The variable that receives the update for the
+     *                      instance (zero if the prediction is correct).
+     *  @return value_type  The loss (one for a misclassified instance).
+     */
+    template <class iterator_type>
+    value_type batch_error(iterator_type it, value_type& err)
+    {
+        error_type cls(this->m_w);
+        cls.inner_product(it->begin(), it->end());
+        if (static_cast<bool>(cls) != it->get_label()) {
+            int y = static_cast<int>(it->get_label()) * 2 - 1;
+            err = y * it->get_weight();
+            return 1;
+        }
+        err = 0;
+        return 0;
+    }
+
+    /**
+     * Updates feature weights with the errors of a mini-batch.
+     *  This function applies the updates for the misclassified instances
+     *  of the mini-batch as a single update.
+     *  @param  insts       The iterators of the training instances.
+     *  @param  first       The position of the first instance of the
+     *                      mini-batch.
+     *  @param  last        The position just beyond the last instance of
+     *                      the mini-batch.
+     *  @param  errs        The errors of the instances [last-first].
+     *  @param  losses      The losses of the instances [last-first].
+     */
+    template <class iterator_type>
+    void update_batch(
+        const std::vector<iterator_type>& insts,
+        size_t first,
+        size_t last,
+        const value_type *errs,
+        const value_type *losses
+        )
+    {
+        // Define synonyms to avoid using "this->" for member variables.
+        int& c = this->m_c;
+        model_type& w = this->m_w;
+        model_type& ws = this->m_ws;
+
+        for (size_t i = 0;i < last - first;++i) {
+            if (errs[i] != 0) {
+                iterator_type it = insts[first+i];
+                update_weights(w, it->begin(), it->end(), errs[i]);
+                update_weights(ws, it->begin(), it->end(), c * errs[i]);
+            }
+            this->m_loss += losses[i];
+        }
+
+        ++c;
+    }
+
 protected:
     /**
      * Adds a value to weights associated with a feature vector.
@@ -397,17 +579,10 @@ public:
         model_type& w = this->m_w;
         model_type& ws = this->m_ws;
 
+        this->unaverage_weights();
         error_type cls(w);
         cls.resize(it->num_candidates(L));
-        for (int i = 0;i < it->num_candidates(L);++i) {
-            cls.inner_product(
-                i,
-                fgen,
-                it->attributes(i).begin(),
-                it->attributes(i).end(),
-                i
-                );
-        }
+        cls.inner_products(fgen, *it);
         cls.finalize();
 
         if (cls.argmax() != it->get_label()) {
@@ -468,6 +643,116 @@ public:
         }
     }
 
+
+    /**
+     * Prepares for a mini-batch of training instances.
+     *  @param  insts       The iterators of the training instances.
+     *  @param  first       The position of the first instance of the
+     *                      mini-batch.
+     *  @param  last        The position just beyond the last instance of
+     *                      the mini-batch.
+     *  @param  fgen        The feature generator.
+     */
+    template <class iterator_type, class feature_generator_type>
+    void begin_batch(
+        const std::vector<iterator_type>& insts,
+        size_t first,
+        size_t last,
+        feature_generator_type& fgen
+        )
+    {
+        this->unaverage_weights();
+    }
+
+    /**
+     * Computes the errors of a training instance in a mini-batch.
+     *  This function does not change the model, and can be called by
+     *  multiple threads between begin_batch() and update_batch().
+     *  @param  it          An interator for the training instance.
+     *  @param  fgen        The feature generator.
+     *  @param  errs        The vector that receives the updates for the
+     *                      labels (candidates).
+     *  @return value_type  The loss (one for a misclassified instance).
+     */
+    template <class iterator_type, class feature_generator_type>
+    value_type batch_error(
+        iterator_type it,
+        feature_generator_type& fgen,
+        std::vector<value_type>& errs
+        )
+    {
+        const int L = (int)fgen.num_labels();
+
+        error_type cls(this->m_w);
+        cls.resize(it->num_candidates(L));
+        cls.inner_products(fgen, *it);
+        cls.finalize();
+
+        errs.assign(it->num_candidates(L), 0.);
+        if (cls.argmax() != it->get_label()) {
+            errs[it->get_label()] += it->get_weight();
+            errs[cls.argmax()] -= it->get_weight();
+            return 1;
+        }
+        return 0;
+    }
+
+    /**
+     * Updates feature weights with the errors of a mini-batch.
+     *  This function applies the updates for the misclassified instances
+     *  of the mini-batch as a single update.
+     *  @param  insts       The iterators of the training instances.
+     *  @param  first       The position of the first instance of the
+     *                      mini-batch.
+     *  @param  last        The position just beyond the last instance of
+     *                      the mini-batch.
+     *  @param  fgen        The feature generator.
+     *  @param  errs        The errors of the instances [last-first].
+     *  @param  losses      The losses of the instances [last-first].
+     */
+    template <class iterator_type, class feature_generator_type>
+    void update_batch(
+        const std::vector<iterator_type>& insts,
+        size_t first,
+        size_t last,
+        feature_generator_type& fgen,
+        const std::vector<value_type> *errs,
+        const value_type *losses
+        )
+    {
+        // Define synonyms to avoid using "this->" for member variables.
+        int& c = this->m_c;
+        model_type& w = this->m_w;
+        model_type& ws = this->m_ws;
+
+        for (size_t i = 0;i < last - first;++i) {
+            iterator_type it = insts[first+i];
+            for (int l = 0;l < (int)errs[i].size();++l) {
+                if (errs[i][l] != 0) {
+                    update_weights(
+                        w,
+                        l,
+                        fgen,
+                        it->attributes(l).begin(),
+                        it->attributes(l).end(),
+                        errs[i][l]
+                        );
+                    update_weights(
+                        ws,
+                        l,
+                        fgen,
+                        it->attributes(l).begin(),
+                        it->attributes(l).end(),
+                        c * errs[i][l]
+                        );
+                }
+            }
+            this->m_loss += losses[i];
+        }
+
+        ++c;
+    }
+
 protected:
     /**
      * Adds a value to weights associated with a feature vector.
@@ -42,13 +42,14 @@
 #include <string>
 #include <vector>
 
-#include <lbfgs.h>
-
 #include <classias/types.h>
 #include <classias/parameters.h>
+#include <classias/parallel.h>
+#include <classias/simd.h>
 #include <classias/evaluation.h>
 #include <classias/classify/linear/binary.h>
 #include <classias/classify/linear/multi.h>
+#include <classias/train/lbfgs_solver.h>
 
 namespace classias
 {
@@ -76,6 +77,9 @@ public:
     /// A synonym of this class.
     typedef lbfgs_base<model_tmpl> this_class;
 
+    /// The solver calls back lbfgs_evaluate() and lbfgs_progress().
+    template <class history_tmpl> friend class lbfgs_solver;
+
 protected:
     /// The array of feature weights.
     model_type m_w;
@@ -101,6 +105,12 @@ protected:
     std::string m_lbfgs_linesearch;
     /// The maximum number of trials for the line search algorithm.
     int m_lbfgs_max_linesearch;
+    /// The flag for storing the L-BFGS memories in single precision.
+    int m_lbfgs_float_memories;
+    /// The number of threads for computing the loss and gradients.
+    int m_num_threads;
+    /// The flag for caching the scores of instances in line searches.
+    int m_cache_scores;
 
     /// A group number for holdout evaluation.
     int m_holdout;
@@ -108,10 +118,42 @@ protected:
     std::ostream* m_os;
 
     /// An internal variable (previous timestamp).
-    clock_t m_clk_prev;
+    double m_clk_prev;
     /// The start index for regularization.
     int m_regularization_start;
 
+    /// The boundaries of the instances assigned to the threads [T+1].
+    std::vector<size_t> m_bounds;
+    /// The gradient buffers of the threads except for the first one [T][K].
+    std::vector<std::vector<value_type> > m_gradients;
+    /// The elapsed time of evaluations in the current iteration.
+    double m_eval_elapsed;
+    /// The sum of the busy time of the threads in the current iteration.
+    double m_eval_busy;
+
+    /// The accuracy parameter (ftol) of the line search algorithm.
+    value_type m_lbfgs_ftol;
+    /// The number of the cached scores (zero if the cache is disabled).
+    size_t m_num_scores;
+    /// The flag indicating whether the trials to be rejected skip gradients.
+    bool m_lazy_gradient;
+    /// The scores at the start point of the current line search [S].
+    std::vector<value_type> m_scores0;
+    /// The scores of the last trial computed from the features [S].
+    std::vector<value_type> m_scores1;
+    /// The step of the trial stored in m_scores1 (zero if it is off the line).
+    value_type m_step1;
+    /// The ratio of the step of the current trial to m_step1.
+    value_type m_ratio;
+    /// The number of trials in the current line search.
+    int m_num_trials;
+    /// The start point of the current line search [K].
+    std::vector<value_type> m_x0;
+    /// The (pseudo-)gradients at the start point of the current line search [K].
+    std::vector<value_type> m_g0;
+    /// The objective value at the start point of the current line search.
+    value_type m_f0;
+
 public:
     /**
      * Constructs the object.
@@ -138,6 +180,13 @@ public:
         // Initialize the members.
         m_holdout = -1;
         m_os = NULL;
+        m_num_scores = 0;
+        m_lazy_gradient = false;
+        m_scores0.clear();
+        m_scores1.clear();
+        m_step1 = 0.;
+        m_ratio = 1.;
+        m_num_trials = 0;
 
         // Initialize the parameters.
         m_params.init("c1", &m_c1, 0.0,
@@ -161,6 +210,16 @@ public:
             "{'MoreThuente': More and Thuente's method, 'Backtracking': backtracking}");
         m_params.init("max_linesearch", &m_lbfgs_max_linesearch, 20,
             "The maximum number of trials for the line search algorithm.");
+        m_params.init("float_memories", &m_lbfgs_float_memories, 0,
+            "Store the L-BFGS memories (corrections) in single precision to halve the\n"
+            "memory of the optimizer: {0: double, 1: float}");
+        m_params.init("num_threads", &m_num_threads, 1,
+            "The number of threads for computing the loss and gradients:\n"
+            "{0: the number of processors, 1: no parallelization, N: N threads}");
+        m_params.init("cache_scores", &m_cache_scores, 1,
+            "Cache the scores of instances so that line-search trials interpolate them\n"
+            "along the search direction; the cache stores two values for every instance\n"
+            "(or candidate): {0: disabled, 1: enabled}");
     }
 
 protected:
@@ -172,17 +231,249 @@ protected:
     void initialize_weights(const size_t K)
     {
         m_w.resize(K);
-        for (size_t k = 0;k < K;++k) {
-            m_w[k] = 0;
+        if (0 < K) {
+            simd::fill(&m_w[0], K, 0.);
+        }
+    }
+
+    /**
+     * Assigns instances to threads.
+     *  This function splits the instances into as many contiguous ranges
+     *  as the threads so that the ranges have similar costs, and prepares
+     *  the gradient buffers for the threads.
+     *  @param  costs       The costs for processing the instances.
+     *  @param  K           The number of features.
+     */
+    void initialize_threads(const std::vector<size_t>& costs, const size_t K)
+    {
+        int T = resolve_num_threads(m_num_threads);
+        if (costs.size() < (size_t)T) {
+            T = costs.empty() ? 1 : (int)costs.size();
+        }
+
+        balanced_partition(m_bounds, costs, T);
+        m_gradients.clear();
+        m_gradients.resize(T);
+        for (int t = 1;t < T;++t) {
+            m_gradients[t].resize(K);
+        }
+    }
+
+    /**
+     * Prepares the cache of the scores of instances.
+     *  The cache holds two arrays of the scores when the parameter
+     *  cache_scores is enabled. This function reports the state of the
+     *  cache in the configuration log.
+     *  @param  S           The number of the scores of the data set.
+     *  @param  os          The output stream.
+     */
+    void initialize_scores(const size_t S, std::ostream& os)
+    {
+        m_num_scores = 0;
+        m_scores0.clear();
+        m_scores1.clear();
+        if (m_cache_scores != 0 && 0 < S) {
+            m_num_scores = S;
+            m_scores0.resize(S);
+            m_scores1.resize(S);
+        }
+
+        os << "lbfgs.score_cache: ";
+        if (0 < m_num_scores) {
+            os << "enabled (" << S << " scores, " <<
+                (2 * S * sizeof(value_type)) / (1024. * 1024.) << " MB)" << std::endl;
+        } else {
+            os << "disabled" << std::endl;
+        }
+    }
+
+    /**
+     * Returns a cached score for the current trial.
+     *  The scores of a linear model are linear along the search direction,
+     *  s(x0 + a * d) = s(x0) + a * s(d), so that this function interpolates
+     *  the score from those at the start point and the last trial computed
+     *  from the features.
+     *  @param  i           The index of the score.
+     *  @return value_type  The score.
+     */
+    inline value_type cached_score(size_t i) const
+    {
+        if (m_ratio == 1.) {
+            return m_scores1[i];
+        }
+        return m_scores0[i] + m_ratio * (m_scores1[i] - m_scores0[i]);
+    }
+
+    /**
+     * Tests whether a trial lies on the line of the search direction.
+     *  The L-BFGS routine moves the variables from the start point along
+     *  the search direction, but OWL-QN projects the variables crossing
+     *  zero onto the orthant of the start point.
+     *  @param  x           The variables of the trial.
+     *  @param  n           The number of variables.
+     *  @return bool        \c true if the trial is on the line.
+     */
+    bool on_line(const value_type *x, const int n) const
+    {
+        if (m_c1 == 0.) {
+            return true;
+        }
+        for (int i = m_regularization_start;i < n;++i) {
+            if (x[i] == 0. && m_x0[i] != 0.) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    /**
+     * Tests whether the backtracking line search rejects a trial.
+     *  This function tests the sufficient decrease condition,
+     *  f(x) <= f(x0) + ftol * (x - x0) . g0, with a safety margin for
+     *  rounding errors. The L-BFGS routine never reads the gradients of
+     *  a rejected trial.
+     *  @param  x           The variables of the trial.
+     *  @param  f           The objective value of the trial (without the
+     *                      L1 norm).
+     *  @param  n           The number of variables.
+     *  @return bool        \c true if the trial will be rejected.
+     */
+    bool rejected(const value_type *x, value_type f, const int n) const
+    {
+        if (m_c1 != 0. && m_regularization_start < n) {
+            const int i = m_regularization_start;
+            f += m_c1 * simd::norm1(x + i, n - i);
+        }
+
+        value_type dg = 0., mag = 0.;
+        for (int i = 0;i < n;++i) {
+            const value_type d = (x[i] - m_x0[i]) * m_g0[i];
+            dg += d;
+            mag += std::fabs(d);
+        }
+
+        const value_type margin =
+            1e-8 * (std::fabs(f) + std::fabs(m_f0) + m_lbfgs_ftol * mag);
+        return (m_f0 + m_lbfgs_ftol * dg + margin < f);
+    }
+
+    /**
+     * Starts a line search from the point accepted last.
+     *  @param  x           The variables of the start point.
+     *  @param  g           The gradients at the start point.
+     *  @param  n           The number of variables.
+     *  @param  f           The objective value at the start point
+     *                      (including the L1 norm).
+     */
+    void begin_linesearch(
+        const value_type *x, const value_type *g, const int n, const value_type f)
+    {
+        // The scores of the accepted trial become those of the start point.
+        if (m_ratio == 1.) {
+            m_scores0.swap(m_scores1);
+        } else {
+            for (size_t i = 0;i < m_num_scores;++i) {
+                m_scores0[i] = cached_score(i);
+            }
+        }
+        m_step1 = 0.;
+        m_ratio = 1.;
+        m_num_trials = 0;
+
+        if (m_lazy_gradient) {
+            // Store the pseudo-gradients of OWL-QN for the L1-regularized
+            // variables, and the gradients for the others.
+            m_f0 = f;
+            for (int i = 0;i < n;++i) {
+                value_type v = g[i];
+                if (m_c1 != 0. && m_regularization_start <= i) {
+                    if (x[i] < 0.) {
+                        v -= m_c1;
+                    } else if (0. < x[i]) {
+                        v += m_c1;
+                    } else if (g[i] + m_c1 < 0.) {
+                        v += m_c1;
+                    } else if (m_c1 < g[i]) {
+                        v -= m_c1;
+                    } else {
+                        v = 0.;
+                    }
+                }
+                m_x0[i] = x[i];
+                m_g0[i] = v;
+            }
         }
     }
 
-    static value_type
-    __lbfgs_evaluate(
-        void *inst, const value_type *x, value_type *g, const int n, const value_type step)
+    /**
+     * Returns the number of threads used for computing the gradients.
+     *  @return int         The number of threads.
+     */
+    int num_threads() const
     {
-        lbfgs_base* pt = reinterpret_cast<lbfgs_base*>(inst);
-        return pt->lbfgs_evaluate(x, g, n, step);
+        return (int)m_gradients.size();
+    }
+
+    /**
+     * Returns the gradient buffer for a thread.
+     *  The first thread stores its gradients directly into the vector
+     *  given by the L-BFGS routine; the other threads have their own
+     *  buffers so that they never write to the same element.
+     *  @param  t           The thread number.
+     *  @param  g           The gradient vector of the L-BFGS routine.
+     *  @return value_type* The gradient buffer for the thread.
+     */
+    value_type* gradient_buffer(int t, value_type* g)
+    {
+        return (t == 0) ? g : &m_gradients[t][0];
+    }
+
+    /**
+     * A task summing up the gradient buffers in a range of features.
+     */
+    struct reduction_task
+    {
+        /// The gradient vector to which the buffers are added.
+        value_type* g;
+        /// The gradient buffers.
+        const std::vector<std::vector<value_type> >* gradients;
+        /// The first index of features.
+        int first;
+        /// The last index (exclusive) of features.
+        int last;
+
+        void operator()()
+        {
+            // Add the buffers in the order of threads so that the sum
+            // never depends on the scheduling of the threads.
+            for (size_t t = 1;t < gradients->size();++t) {
+                const value_type* b = &(*gradients)[t][0];
+                simd::axpy(g + first, b + first, last - first, 1.);
+            }
+        }
+    };
+
+    /**
+     * Adds the gradient buffers of the threads into the gradient vector.
+     *  @param  g           The gradient vector (storing the gradients
+     *                      computed by the first thread).
+     *  @param  n           The number of features.
+     */
+    void reduce_gradients(value_type* g, const int n)
+    {
+        const int T = num_threads();
+        if (T <= 1) {
+            return;
+        }
+
+        std::vector<reduction_task> tasks(T);
+        for (int t = 0;t < T;++t) {
+            tasks[t].g = g;
+            tasks[t].gradients = &m_gradients;
+            tasks[t].first = (int)((size_t)n * t / T);
+            tasks[t].last = (int)((size_t)n * (t+1) / T);
+        }
+        parallel_run(tasks);
     }
 
     value_type lbfgs_evaluate(
@@ -192,38 +483,57 @@ protected:
         const value_type step
         )
     {
-        // Compute the loss and gradients.
-        value_type loss = loss_and_gradient(x, g, n);
+        double clk = wallclock();
+        const int i = m_regularization_start;
+        const value_type lambda = 2 * m_c2;
+
+        // A trial on the line of the trial whose scores are in the cache
+        // interpolates the scores instead of computing them.
+        const bool cached = (
+            0 < m_num_scores && 0. < step && 0. < m_step1 && on_line(x, n));
+        m_ratio = cached ? step / m_step1 : 1.;
+
+        // The backtracking line search accepts the first trial in most
+        // iterations. The other trials compute the gradients only if they
+        // can satisfy the sufficient decrease condition.
+        const bool lazy = (m_lazy_gradient && 0. < step && 0 < m_num_trials++);
+
+        // Compute the loss (and gradients).
+        value_type loss = loss_and_gradient(x, g, n, !cached, !lazy);
+        if (0 < m_num_scores && !cached) {
+            m_step1 = (0. < step && on_line(x, n)) ? step : 0.;
+        }
 
-	    // L2 regularization.
-	    if (m_c2 != 0.) {
-            value_type norm = 0.;
-            const value_type lambda = 2 * m_c2;
-            for (int i = m_regularization_start;i < n;++i) {
-                g[i] += (lambda * x[i]);
-                norm += x[i] * x[i];
+        if (lazy) {
+            // L2 regularization.
+            if (m_c2 != 0. && i < n) {
+                loss += (m_c2 * simd::dot(x + i, x + i, n - i));
             }
-            loss += (m_c2 * norm);
-	    }
 
-        return loss;
-    }
+            // Compute the gradients from the scores of the trial.
+            if (!rejected(x, loss, n)) {
+                loss_and_gradient(x, g, n, false, true);
+                if (m_c2 != 0. && i < n) {
+                    simd::axpy(g + i, x + i, n - i, lambda);
+                }
+            }
 
-    static int
-    __lbfgs_progress(
-        void *inst,
-        const double *x, const double *g, const double fx,
-        const double xnorm, const double gnorm,
-        const double step,
-        int n, int k, int ls
-        )
-    {
-        lbfgs_base* pt = reinterpret_cast<lbfgs_base*>(inst);
-        int ret = pt->lbfgs_progress(x, g, fx, xnorm, gnorm, step, n, k, ls);
-        if (ret != 0) {
-            return LBFGSERR_MAXIMUMITERATION;
+        } else if (m_c2 != 0. && i < n) {
+            // L2 regularization.
+            loss += (m_c2 * simd::axpy_sqnorm(g + i, x + i, n - i, lambda));
         }
-        return 0;
+
+        // The initial point starts the first line search.
+        if (0 < m_num_scores && step == 0.) {
+            value_type f = loss;
+            if (m_c1 != 0. && i < n) {
+                f += m_c1 * simd::norm1(x + i, n - i);
+            }
+            begin_linesearch(x, g, n, f);
+        }
+
+        m_eval_elapsed += (wallclock() - clk);
+        return loss;
     }
 
     int lbfgs_progress(
@@ -237,19 +547,19 @@ protected:
         int k,
         int ls)
     {
+        // The accepted trial starts the next line search.
+        if (0 < m_num_scores) {
+            begin_linesearch(x, g, n, fx);
+        }
+
         // Compute the duration required for this iteration.
         std::ostream& os = *m_os;
-        clock_t duration, clk = std::clock();
-        duration = clk - m_clk_prev;
+        double clk = wallclock();
+        double duration = clk - m_clk_prev;
         m_clk_prev = clk;
 
         // Count the number of active features.
-        int num_active = 0;
-        for (int i = 0;i < n;++i) {
-            if (x[i] != 0.) {
-                ++num_active;
-            }
-        }
+        int num_active = (int)simd::count_nonzero(x, n);
 
         // Output the current progress.
         os << "***** Iteration #" << k << " *****" << std::endl;
@@ -259,9 +569,14 @@ protected:
         os << "Active features: " << num_active << " / " << n << std::endl;
         os << "Line search trials: " << ls << std::endl;
         os << "Line search step: " << step << std::endl;
-        os << "Seconds required for this iteration: " <<
-            duration / (double)CLOCKS_PER_SEC << std::endl;
+        if (1 < num_threads() && 0. < m_eval_elapsed) {
+            os << "Speedup of evaluations: " << m_eval_busy / m_eval_elapsed <<
+                " (" << num_threads() << " threads)" << std::endl;
+        }
+        os << "Seconds required for this iteration: " << duration << std::endl;
         os.flush();
+        m_eval_elapsed = 0.;
+        m_eval_busy = 0.;
 
         // Holdout evaluation if necessary.
         if (0 <= m_holdout) {
@@ -283,8 +598,7 @@ protected:
         )
     {
         // Set L-BFGS parameters.
-        lbfgs_parameter_t param;
-        lbfgs_parameter_init(&param);
+        lbfgs_parameter param;
         param.m = m_lbfgs_num_memories;
         param.epsilon = m_lbfgs_epsilon;
         param.past = m_lbfgs_stop;
@@ -300,20 +614,36 @@ protected:
 
         // Store the start clock.
         m_os = &os;
-        m_clk_prev = clock();
+        m_clk_prev = wallclock();
+        m_eval_elapsed = 0.;
+        m_eval_busy = 0.;
         m_holdout = holdout;
         m_regularization_start = regularization_start;
 
+        // Prepare the line search with the cached scores.
+        m_lbfgs_ftol = param.ftol;
+        m_lazy_gradient = (
+            0 < m_num_scores && param.linesearch == LBFGS_LINESEARCH_BACKTRACKING);
+        m_step1 = 0.;
+        m_ratio = 1.;
+        m_num_trials = 0;
+        m_x0.clear();
+        m_g0.clear();
+        if (m_lazy_gradient) {
+            m_x0.resize(K);
+            m_g0.resize(K);
+        }
+
         // Call L-BFGS routine.
-        return lbfgs(
-            K,
-            &this->m_w[0],
-            NULL,
-            __lbfgs_evaluate,
-            __lbfgs_progress,
-            this,
-            &param
-            );
+        if (m_lbfgs_float_memories) {
+            lbfgs_solver<float> solver;
+            solver.params() = param;
+            return solver.minimize(K, &this->m_w[0], NULL, *this);
+        } else {
+            lbfgs_solver<double> solver;
+            solver.params() = param;
+            return solver.minimize(K, &this->m_w[0], NULL, *this);
+        }
     }
 
     void lbfgs_output_status(std::ostream& os, int status)
@@ -330,7 +660,9 @@ protected:
     virtual value_type loss_and_gradient(
         const value_type *x,
         value_type *g,
-        const int n
+        const int n,
+        bool scoring,
+        bool gradient
         ) = 0;
 
     virtual void holdout_evaluation() = 0;
@@ -424,17 +756,105 @@ public:
     }
 
 protected:
+    /**
+     * A task computing the loss and gradients of a range of instances.
+     */
+    struct gradient_task
+    {
+        /// The trainer.
+        this_class* trainer;
+        /// The gradient vector to which this task stores.
+        value_type* g;
+        /// The number of features.
+        int n;
+        /// The flag indicating whether this task computes the scores.
+        bool scoring;
+        /// The flag indicating whether this task computes the gradients.
+        bool gradient;
+        /// The index of the first instance.
+        size_t first;
+        /// The index of the last instance (exclusive).
+        size_t last;
+        /// The loss of the instances.
+        value_type loss;
+        /// The elapsed time of this task.
+        double elapsed;
+
+        void operator()()
+        {
+            double clk = wallclock();
+            loss = trainer->partial_loss_and_gradient(
+                g, n, scoring, gradient, first, last);
+            elapsed = wallclock() - clk;
+        }
+    };
+
     /**
      * Computes the loss and gradients of the data set.
      *  @param  x           The current feature weights.
      *  @param  g           The gradient vector to which this function stores.
      *  @param  n           The number of features.
+     *  @param  scoring     The flag indicating whether the scores of the
+     *                      instances are computed from the features (and
+     *                      stored in the cache) or read from the cache.
+     *  @param  gradient    The flag indicating whether the gradients are
+     *                      computed.
      *  @return value_type  The loss of the data set on the current weights.
      */
     virtual value_type loss_and_gradient(
         const value_type *x,
         value_type *g,
-        const int n
+        const int n,
+        bool scoring,
+        bool gradient
+        )
+    {
+        const int T = this->num_threads();
+        std::vector<gradient_task> tasks(T);
+        for (int t = 0;t < T;++t) {
+            tasks[t].trainer = this;
+            tasks[t].g = this->gradient_buffer(t, g);
+            tasks[t].n = n;
+            tasks[t].scoring = scoring;
+            tasks[t].gradient = gradient;
+            tasks[t].first = this->m_bounds[t];
+            tasks[t].last = this->m_bounds[t+1];
+        }
+
+        // Compute the partial losses and gradients.
+        parallel_run(tasks);
+        if (gradient) {
+            this->reduce_gradients(g, n);
+        }
+
+        // Sum up the partial losses in the order of threads.
+        value_type loss = 0;
+        for (int t = 0;t < T;++t) {
+            loss += tasks[t].loss;
+            this->m_eval_busy += tasks[t].elapsed;
+        }
+        return loss;
+    }
+
+    /**
+     * Computes the loss and gradients of a range of instances.
+     *  @param  g           The gradient vector to which this function stores.
+     *  @param  n           The number of features.
+     *  @param  scoring     The flag indicating whether the scores are
+     *                      computed from the features or read from the cache.
+     *  @param  gradient    The flag indicating whether the gradients are
+     *                      computed.
+     *  @param  first       The index of the first instance.
+     *  @param  last        The index of the last instance (exclusive).
+     *  @return value_type  The loss of the instances on the current weights.
+     */
+    value_type partial_loss_and_gradient(
+        value_type *g,
+        const int n,
+        bool scoring,
+        bool gradient,
+        size_t first,
+        size_t last
         )
     {
         typename data_type::const_iterator iti;
@@ -443,19 +863,29 @@ protected:
         error_type cls(this->m_w); // we know that &m_w[0] and x are identical.
 
         // Initialize the gradients with zero.
-        for (int i = 0;i < n;++i) {
-            g[i] = 0.;
+        if (gradient) {
+            simd::fill(g, n, 0.);
         }
 
-        // For each instance in the data.
-        for (iti = m_data->begin();iti != m_data->end();++iti) {
+        // For each instance in the range.
+        const_iterator begin = m_data->begin() + first;
+        const_iterator end = m_data->begin() + last;
+        for (iti = begin;iti != end;++iti) {
             // Exclude instances for holdout evaluation.
             if (iti->get_group() == this->m_holdout) {
                 continue;
             }
 
             // Compute the score for the instance.
-            cls.inner_product(iti->begin(), iti->end());
+            const size_t i = (size_t)(iti - m_data->begin());
+            if (!scoring) {
+                cls.set_score(this->cached_score(i));
+            } else {
+                cls.inner_product(iti->begin(), iti->end());
+                if (0 < this->m_num_scores) {
+                    this->m_scores1[i] = cls.score();
+                }
+            }
 
             // Compute the error.
             value_type nlogp = 0.;
@@ -465,9 +895,11 @@ protected:
             loss += (iti->get_weight() * nlogp);
 
             // Update the gradients for the weights.
-            err *= iti->get_weight();
-            for (it = iti->begin();it != iti->end();++it) {
-                g[it->first] += err * it->second;
+            if (gradient) {
+                err *= iti->get_weight();
+                for (it = iti->begin();it != iti->end();++it) {
+                    g[it->first] += err * it->second;
+                }
             }
         }
 
@@ -500,6 +932,21 @@ public:
         os << "Binary logistic regression using L-BFGS" << std::endl;
         this->m_params.show(os);
         os << "lbfgs.regularization_start: " << data.get_user_feature_start() << std::endl;
+
+        // Balance the threads by the number of non-zero elements.
+        std::vector<size_t> costs;
+        costs.reserve(data.size());
+        for (const_iterator iti = data.begin();iti != data.end();++iti) {
+            if (iti->get_group() == holdout) {
+                costs.push_back(0);
+            } else {
+                costs.push_back(1 + (iti->end() - iti->begin()));
+            }
+        }
+        this->initialize_threads(costs, K);
+
+        // Cache the score of every instance.
+        this->initialize_scores(data.size(), os);
         os << std::endl;
 
         // Call the L-BFGS solver.
@@ -574,6 +1021,10 @@ protected:
 
     /// An array [K] of observation expectations.
     value_type *m_oexps;
+    /// The index of the first score of each instance in the cache [N+1].
+    std::vector<size_t> m_offsets;
+    /// The buffers of the label probabilities of the threads [T][C].
+    std::vector<std::vector<value_type> > m_probs;
     /// A data set for training.
     const data_type* m_data;
     /// The flag indicating whether 
@@ -606,22 +1057,128 @@ public:
     {
         delete[] m_oexps;
         m_oexps = NULL;
+        m_offsets.clear();
+        m_probs.clear();
         m_data = NULL;
         base_class::clear();
     }
 
 protected:
+    /**
+     * A task computing the loss and gradients of a range of instances.
+     */
+    struct gradient_task
+    {
+        /// The trainer.
+        this_class* trainer;
+        /// The gradient vector to which this task stores.
+        value_type* g;
+        /// The number of features.
+        int n;
+        /// The flag indicating whether this task computes the scores.
+        bool scoring;
+        /// The flag indicating whether this task computes the gradients.
+        bool gradient;
+        /// The flag indicating whether this task initializes the gradients
+        /// with the observation expectations.
+        bool oexps;
+        /// The index of the first instance.
+        size_t first;
+        /// The index of the last instance (exclusive).
+        size_t last;
+        /// The buffer of the label probabilities.
+        value_type* probs;
+        /// The loss of the instances.
+        value_type loss;
+        /// The elapsed time of this task.
+        double elapsed;
+
+        void operator()()
+        {
+            double clk = wallclock();
+            loss = trainer->partial_loss_and_gradient(
+                g, n, scoring, gradient, oexps, first, last, probs);
+            elapsed = wallclock() - clk;
+        }
+    };
+
     /**
      * Computes the loss and gradients of the data set.
      *  @param  x           The current feature weights.
      *  @param  g           The gradient vector to which this function stores.
      *  @param  n           The number of features.
+     *  @param  scoring     The flag indicating whether the scores of the
+     *                      instances are computed from the features (and
+     *                      stored in the cache) or read from the cache.
+     *  @param  gradient    The flag indicating whether the gradients are
+     *                      computed.
      *  @return value_type  The loss of the data set on the current weights.
      */
     virtual value_type loss_and_gradient(
         const value_type *x,
         value_type *g,
-        const int n
+        const int n,
+        bool scoring,
+        bool gradient
+        )
+    {
+        const int T = this->num_threads();
+        std::vector<gradient_task> tasks(T);
+        for (int t = 0;t < T;++t) {
+            tasks[t].trainer = this;
+            tasks[t].g = this->gradient_buffer(t, g);
+            tasks[t].n = n;
+            tasks[t].scoring = scoring;
+            tasks[t].gradient = gradient;
+            tasks[t].oexps = (t == 0);
+            tasks[t].first = this->m_bounds[t];
+            tasks[t].last = this->m_bounds[t+1];
+            tasks[t].probs = &m_probs[t][0];
+        }
+
+        // Compute the partial losses and gradients.
+        parallel_run(tasks);
+        if (gradient) {
+            this->reduce_gradients(g, n);
+        }
+
+        // Sum up the partial losses in the order of threads.
+        value_type loss = 0;
+        for (int t = 0;t < T;++t) {
+            loss += tasks[t].loss;
+            this->m_eval_busy += tasks[t].elapsed;
+        }
+        return loss;
+    }
+
+    /**
+     * Computes the loss and gradients of a range of instances.
+     *  Each call uses a classifier of its own, so that multiple threads
+     *  can compute the scores of different instances simultaneously.
+     *  @param  g           The gradient vector to which this function stores.
+     *  @param  n           The number of features.
+     *  @param  scoring     The flag indicating whether the scores are
+     *                      computed from the features or read from the cache.
+     *  @param  gradient    The flag indicating whether the gradients are
+     *                      computed.
+     *  @param  oexps       The flag indicating whether the gradients are
+     *                      initialized with (the negative of) observation
+     *                      expectations (\c true) or with zero (\c false).
+     *  @param  first       The index of the first instance.
+     *  @param  last        The index of the last instance (exclusive).
+     *  @param  probs       The buffer of the label probabilities, which has
+     *                      room for the candidates of any instance.
+     *  @return value_type  The loss of the instances on the current weights.
+     */
+    value_type partial_loss_and_gradient(
+        value_type *g,
+        const int n,
+        bool scoring,
+        bool gradient,
+        bool oexps,
+        size_t first,
+        size_t last,
+        value_type *probs
         )
     {
         value_type loss = 0;
@@ -630,12 +1187,18 @@ protected:
         error_type cls(this->m_w); // We know that &m_w[0] and x are identical.
 
         // Initialize the gradients with (the negative of) observation expexcations.
-        for (int i = 0;i < n;++i) {
-            g[i] = -m_oexps[i];
+        if (gradient && oexps) {
+            for (int i = 0;i < n;++i) {
+                g[i] = -m_oexps[i];
+            }
+        } else if (gradient) {
+            simd::fill(g, n, 0.);
         }
 
-        // For each instance in the data.
-        for (const_iterator iti = data.begin();iti != data.end();++iti) {
+        // For each instance in the range.
+        const_iterator begin = data.begin() + first;
+        const_iterator end = data.begin() + last;
+        for (const_iterator iti = begin;iti != end;++iti) {
             const instance_type& inst = *iti;
 
             // Exclude instances for holdout evaluation.
@@ -647,17 +1210,24 @@ protected:
             cls.resize(inst.num_candidates(L));
 
             // Compute the probability prob[l] for each label #l.
-            for (int i = 0;i < inst.num_candidates(L);++i) {
-                const attributes_type& v = inst.attributes(i);
-                cls.inner_product(i, data.feature_generator, v.begin(), v.end(), i);
+            const size_t s = m_offsets[iti - data.begin()];
+            if (!scoring) {
+                for (int i = 0;i < cls.size();++i) {
+                    cls.set_score(i, this->cached_score(s + i));
+                }
+            } else {
+                cls.inner_products(data.feature_generator, inst);
+                if (0 < this->m_num_scores) {
+                    for (int i = 0;i < cls.size();++i) {
+                        this->m_scores1[s + i] = cls.score(i);
+                    }
+                }
             }
             cls.finalize();
 
             // Accumulate the model expectations of features.
-            for (int i = 0;i < inst.num_candidates(L);++i) {
-                const attributes_type& v = inst.attributes(i);
-                this->add_weights(
-                    g, i, data.feature_generator, v.begin(), v.end(), cls.prob(i));
+            if (gradient) {
+                this->add_expectations(g, probs, data.feature_generator, inst, cls);
             }
 
             // Accumulate the loss for predicting the instance.
@@ -691,15 +1261,12 @@ public:
         // Initialize feature expectations and weights.
         this->initialize_weights(K);
         m_oexps = new double[K];
-        for (size_t k = 0;k < K;++k) {
-            m_oexps[k] = 0.;
-        }
+        simd::fill(m_oexps, K, 0.);
 
         // Report the training parameters.
         os << "Multi-class logistic regression using L-BFGS" << std::endl;
         this->m_params.show(os);
         os << "lbfgs.regularization_start: " << data.get_user_feature_start() << std::endl;
-        os << std::endl;
 
         // Compute observation expectations of the features.
         for (const_iterator iti = data.begin();iti != data.end();++iti) {
@@ -715,6 +1282,37 @@ public:
                 m_oexps, l, data.feature_generator, v.begin(), v.end(), 1.0);
         }
 
+        // Balance the threads by the amount of work for the instances,
+        // i.e., the total number of attributes of the candidates.
+        std::vector<size_t> costs;
+        costs.reserve(data.size());
+        m_offsets.clear();
+        m_offsets.reserve(data.size() + 1);
+        m_offsets.push_back(0);
+        int max_candidates = 1;
+        for (const_iterator iti = data.begin();iti != data.end();++iti) {
+            size_t cost = 0;
+            const int C = iti->num_candidates((int)L);
+            if (max_candidates < C) {
+                max_candidates = C;
+            }
+            if (iti->get_group() != holdout) {
+                for (int i = 0;i < C;++i) {
+                    const attributes_type& v = iti->attributes(i);
+                    cost += 1 + (v.end() - v.begin());
+                }
+            }
+            costs.push_back(cost);
+            m_offsets.push_back(m_offsets.back() + C);
+        }
+        this->initialize_threads(costs, K);
+        m_probs.assign(
+            this->num_threads(), std::vector<value_type>(max_candidates));
+
+        // Cache the scores of all candidates of the instances.
+        this->initialize_scores(m_offsets.back(), os);
+        os << std::endl;
+
         // Call the L-BFGS solver.
         m_data = &data;
         m_acconly = acconly;
@@ -780,6 +1378,106 @@ protected:
             }
         }
     }
+
+    /**
+     * Adds the model expectations of the features of an instance.
+     *  @param  g           The gradient vector to which an update occurs.
+     *  @param  probs       The buffer of the label probabilities.
+     *  @param  fgen        The feature generator.
+     *  @param  inst        The instance.
+     *  @param  cls         The classifier that has scored the instance.
+     */
+    template <class feature_generator_type>
+    inline void add_expectations(
+        value_type* g,
+        value_type* probs,
+        const feature_generator_type& fgen,
+        const instance_type& inst,
+        error_type& cls
+        )
+    {
+        for (int i = 0;i < cls.size();++i) {
+            const attributes_type& v = inst.attributes(i);
+            this->add_weights(g, i, fgen, v.begin(), v.end(), cls.prob(i));
+        }
+    }
+
+    /**
+     * Adds the model expectations of the features of a multi-class instance.
+     *  The features of an attribute are consecutive with the dense feature
+     *  generator, so that this function scatters the probabilities of all
+     *  labels to the row of each attribute at once.
+     *  @param  g           The gradient vector to which an update occurs.
+     *  @param  probs       The buffer of the label probabilities.
+     *  @param  fgen        The feature generator.
+     *  @param  inst        The instance.
+     *  @param  cls         The classifier that has scored the instance.
+     */
+    template <class attribute_tmpl, class label_tmpl, class feature_tmpl>
+    inline void add_expectations(
+        value_type* g,
+        value_type* probs,
+        const dense_feature_generator_base<attribute_tmpl, label_tmpl, feature_tmpl>& fgen,
+        const instance_type& inst,
+        error_type& cls
+        )
+    {
+        const int L = cls.size();
+        if (L == 0 || (size_t)L != fgen.num_labels()) {
+            for (int i = 0;i < L;++i) {
+                this->add_weights(g, i, fgen, inst.begin(), inst.end(), cls.prob(i));
+            }
+            return;
+        }
+
+        for (int i = 0;i < L;++i) {
+            probs[i] = cls.prob(i);
+        }
+        for (typename instance_type::const_iterator it = inst.begin();it != inst.end();++it) {
+            simd::axpy(g + (size_t)it->first * L, probs, L, it->second);
+        }
+    }
+
+    /**
+     * Adds the model expectations of the features of a multi-class instance.
+     *  This function walks the compiled rows of the sparse feature
+     *  generator, computing the probability of every label only once.
+     *  @param  g           The gradient vector to which an update occurs.
+     *  @param  probs       The buffer of the label probabilities.
+     *  @param  fgen        The feature generator.
+     *  @param  inst        The instance.
+     *  @param  cls         The classifier that has scored the instance.
+     */
+    template <class attribute_tmpl, class label_tmpl, class feature_tmpl>
+    inline void add_expectations(
+        value_type* g,
+        value_type* probs,
+        const sparse_feature_generator_base<attribute_tmpl, label_tmpl, feature_tmpl>& fgen,
+        const instance_type& inst,
+        error_type& cls
+        )
+    {
+        typedef typename sparse_feature_generator_base<
+            attribute_tmpl, label_tmpl, feature_tmpl>::label_feature_type
+            label_feature_type;
+
+        if (!fgen.compiled()) {
+            for (int i = 0;i < cls.size();++i) {
+                this->add_weights(g, i, fgen, inst.begin(), inst.end(), cls.prob(i));
+            }
+            return;
+        }
+
+        for (int i = 0;i < cls.size();++i) {
+            probs[i] = cls.prob(i);
+        }
+        for (typename instance_type::const_iterator it = inst.begin();it != inst.end();++it) {
+            const label_feature_type* last = fgen.row_end(it->first);
+            for (const label_feature_type* p = fgen.row_begin(it->first);p != last;++p) {
+                g[p->second] += (probs[p->first] * it->second);
+            }
+        }
+    }
 };
 
 };
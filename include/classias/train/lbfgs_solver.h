@@ -0,0 +1,1186 @@
+/*
+ *		L-BFGS and OWL-QN solver.
+ *
+ * Copyright (c) 2008,2009 Naoaki Okazaki
+ * All rights reserved.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are met:
+ *     * Redistributions of source code must retain the above copyright
+ *       notice, this list of conditions and the following disclaimer.
+ *     * Redistributions in binary form must reproduce the above copyright
+ *       notice, this list of conditions and the following disclaimer in the
+ *       documentation and/or other materials provided with the distribution.
+ *     * Neither the names of the authors nor the names of its contributors
+ *       may be used to endorse or promote products derived from this
+ *       software without specific prior written permission.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS
+ * "AS IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT
+ * LIMITED TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY AND FITNESS FOR
+ * A PARTICULAR PURPOSE ARE DISCLAIMED. IN NO EVENT SHALL THE COPYRIGHT OWNER
+ * OR CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT, INCIDENTAL, SPECIAL,
+ * EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT NOT LIMITED TO,
+ * PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF USE, DATA, OR
+ * PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON ANY THEORY OF
+ * LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT (INCLUDING
+ * NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF THIS
+ * SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
+
+/* $Id$ */
+
+#ifndef __CLASSIAS_TRAIN_LBFGS_SOLVER_H__
+#define __CLASSIAS_TRAIN_LBFGS_SOLVER_H__
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include <classias/simd.h>
+
+namespace classias
+{
+
+namespace train
+{
+
+/**
+ * Return values of lbfgs_solver::minimize().
+ *  The values are compatible with those of libLBFGS; a negative value
+ *  indicates an error.
+ */
+enum {
+    /// L-BFGS reaches convergence.
+    LBFGS_SUCCESS = 0,
+    LBFGS_CONVERGENCE = 0,
+    /// L-BFGS satisfies the stopping criterion (delta).
+    LBFGS_STOP,
+    /// The initial variables already minimize the objective function.
+    LBFGS_ALREADY_MINIMIZED,
+    /// Unknown error.
+    LBFGSERR_UNKNOWNERROR = -1024,
+    /// Logic error.
+    LBFGSERR_LOGICERROR,
+    /// Insufficient memory.
+    LBFGSERR_OUTOFMEMORY,
+    /// The minimization process has been canceled.
+    LBFGSERR_CANCELED,
+    /// Invalid number of variables specified.
+    LBFGSERR_INVALID_N,
+    /// Invalid number of variables (for SSE) specified.
+    LBFGSERR_INVALID_N_SSE,
+    /// The array x must be aligned to 16 (for SSE).
+    LBFGSERR_INVALID_X_SSE,
+    /// Invalid parameter lbfgs_parameter::epsilon specified.
+    LBFGSERR_INVALID_EPSILON,
+    /// Invalid parameter lbfgs_parameter::past specified.
+    LBFGSERR_INVALID_TESTPERIOD,
+    /// Invalid parameter lbfgs_parameter::delta specified.
+    LBFGSERR_INVALID_DELTA,
+    /// Invalid parameter lbfgs_parameter::linesearch specified.
+    LBFGSERR_INVALID_LINESEARCH,
+    /// Invalid parameter lbfgs_parameter::min_step specified.
+    LBFGSERR_INVALID_MINSTEP,
+    /// Invalid parameter lbfgs_parameter::max_step specified.
+    LBFGSERR_INVALID_MAXSTEP,
+    /// Invalid parameter lbfgs_parameter::ftol specified.
+    LBFGSERR_INVALID_FTOL,
+    /// Invalid parameter lbfgs_parameter::gtol specified.
+    LBFGSERR_INVALID_GTOL,
+    /// Invalid parameter lbfgs_parameter::xtol specified.
+    LBFGSERR_INVALID_XTOL,
+    /// Invalid parameter lbfgs_parameter::max_linesearch specified.
+    LBFGSERR_INVALID_MAXLINESEARCH,
+    /// Invalid parameter lbfgs_parameter::orthantwise_c specified.
+    LBFGSERR_INVALID_ORTHANTWISE,
+    /// Invalid parameter lbfgs_parameter::orthantwise_start specified.
+    LBFGSERR_INVALID_ORTHANTWISE_START,
+    /// Invalid parameter lbfgs_parameter::orthantwise_end specified.
+    LBFGSERR_INVALID_ORTHANTWISE_END,
+    /// The line-search step went out of the interval of uncertainty.
+    LBFGSERR_OUTOFINTERVAL,
+    /// A logic error occurred; alternatively, the interval of uncertainty
+    /// became too small.
+    LBFGSERR_INCORRECT_TMINMAX,
+    /// A rounding error occurred; alternatively, no line-search step
+    /// satisfies the sufficient decrease and curvature conditions.
+    LBFGSERR_ROUNDING_ERROR,
+    /// The line-search step became smaller than lbfgs_parameter::min_step.
+    LBFGSERR_MINIMUMSTEP,
+    /// The line-search step became larger than lbfgs_parameter::max_step.
+    LBFGSERR_MAXIMUMSTEP,
+    /// The line-search routine reaches the maximum number of evaluations.
+    LBFGSERR_MAXIMUMLINESEARCH,
+    /// The algorithm routine reaches the maximum number of iterations.
+    LBFGSERR_MAXIMUMITERATION,
+    /// Relative width of the interval of uncertainty is at most
+    /// lbfgs_parameter::xtol.
+    LBFGSERR_WIDTHTOOSMALL,
+    /// A logic error (negative line-search step) occurred.
+    LBFGSERR_INVALIDPARAMETERS,
+    /// The current search direction increases the objective function value.
+    LBFGSERR_INCREASEGRADIENT
+};
+
+/**
+ * Line search algorithms.
+ */
+enum {
+    /// MoreThuente method proposed by More and Thuente (default).
+    LBFGS_LINESEARCH_MORETHUENTE = 0,
+    /// Backtracking method with the strong Wolfe condition.
+    LBFGS_LINESEARCH_BACKTRACKING_STRONG,
+    /// Backtracking method with the regular Wolfe condition.
+    LBFGS_LINESEARCH_BACKTRACKING
+};
+
+/**
+ * Parameters of the L-BFGS solver.
+ *  The constructor sets the default values, which are identical to those
+ *  of libLBFGS.
+ */
+struct lbfgs_parameter
+{
+    /// The number of corrections to approximate the inverse hessian matrix.
+    int m;
+    /// Epsilon for the convergence test, ||g|| < epsilon * max(1, ||x||).
+    double epsilon;
+    /// The distance of iterations for the delta-based stopping criterion.
+    int past;
+    /// The threshold of the rate of decrease for the stopping criterion.
+    double delta;
+    /// The maximum number of iterations (zero for no limit).
+    int max_iterations;
+    /// The line search algorithm.
+    int linesearch;
+    /// The maximum number of trials for the line search.
+    int max_linesearch;
+    /// The minimum step of the line search.
+    double min_step;
+    /// The maximum step of the line search.
+    double max_step;
+    /// The accuracy of the sufficient decrease condition.
+    double ftol;
+    /// The accuracy of the curvature condition.
+    double gtol;
+    /// The machine precision for the interval of uncertainty.
+    double xtol;
+    /// The coefficient of the L1 norm of variables (OWL-QN if positive).
+    double orthantwise_c;
+    /// The start index of the variables regularized by the L1 norm.
+    int orthantwise_start;
+    /// The end index (exclusive) of the variables regularized by the L1
+    /// norm; a negative value for the number of variables.
+    int orthantwise_end;
+
+    /**
+     * Constructs the parameters with the default values.
+     */
+    lbfgs_parameter()
+        : m(6), epsilon(1e-5), past(0), delta(1e-5), max_iterations(0),
+        linesearch(LBFGS_LINESEARCH_MORETHUENTE), max_linesearch(40),
+        min_step(1e-20), max_step(1e20), ftol(1e-4), gtol(0.9),
+        xtol(1e-16), orthantwise_c(0.), orthantwise_start(0),
+        orthantwise_end(-1)
+    {
+    }
+};
+
+
+
+/**
+ * Limited-memory BFGS (L-BFGS) and Orthant-Wise Limited-memory
+ * Quasi-Newton (OWL-QN) solver.
+ *
+ *  This class minimizes an objective function F(x) (combined with the L1
+ *  norm C |x| when lbfgs_parameter::orthantwise_c is positive). The
+ *  implementation is based on libLBFGS, and stores the history of the
+ *  corrections (s and y vectors) in the type history_tmpl; storing the
+ *  corrections in \c float halves the memory of the solver, whereas
+ *  vector operations are computed in double precision.
+ *
+ *  A client is a class that implements the following member functions:
+ *  - <tt>double lbfgs_evaluate(const double *x, double *g, const int n,
+ *    const double step)</tt> computes the value and gradients of F(x).
+ *  - <tt>int lbfgs_progress(const double *x, const double *g,
+ *    const double fx, const double xnorm, const double gnorm,
+ *    const double step, int n, int k, int ls)</tt> receives the progress
+ *    of every iteration, and returns a non-zero value to cancel the
+ *    minimization; minimize() returns the value as the status code.
+ *
+ *  @param  history_tmpl    The type of elements of the corrections
+ *                          (\c double or \c float).
+ */
+template <class history_tmpl = double>
+class lbfgs_solver
+{
+public:
+    /// The type representing a value.
+    typedef double value_type;
+    /// The type of elements of the corrections.
+    typedef history_tmpl history_type;
+
+protected:
+    /// A correction pair.
+    struct correction_type
+    {
+        /// A coefficient of the two-loop recursion.
+        value_type alpha;
+        /// The inner product of s and y.
+        value_type ys;
+        /// The difference of the variables [n].
+        std::vector<history_type> s;
+        /// The difference of the gradients [n].
+        std::vector<history_type> y;
+    };
+
+    /// The parameters.
+    lbfgs_parameter m_param;
+
+public:
+    /**
+     * Constructs the object.
+     */
+    lbfgs_solver()
+    {
+    }
+
+    /**
+     * Destructs the object.
+     */
+    virtual ~lbfgs_solver()
+    {
+    }
+
+    /**
+     * Obtains the parameters of the solver.
+     *  @return lbfgs_parameter&    The parameters.
+     */
+    lbfgs_parameter& params()
+    {
+        return m_param;
+    }
+
+    /**
+     * Minimizes the objective function.
+     *  @param  n           The number of variables.
+     *  @param  x           The array of variables, which stores the initial
+     *                      values at the call and receives the final values.
+     *  @param  ptr_fx      The pointer to the variable that receives the
+     *                      final value of the objective function (can be
+     *                      \c NULL).
+     *  @param  client      The client computing the objective function.
+     *  @return int         The status code (LBFGS_SUCCESS,
+     *                      LBFGS_ALREADY_MINIMIZED, or an error code).
+     */
+    template <class client_type>
+    int minimize(
+        const int n,
+        value_type *x,
+        value_type *ptr_fx,
+        client_type& client
+        )
+    {
+        const lbfgs_parameter& param = m_param;
+        const int m = param.m;
+        const int end = (param.orthantwise_end < 0) ? n : param.orthantwise_end;
+        const bool owlqn = (param.orthantwise_c != 0.);
+
+        // Check the parameters for errors.
+        int ret = check_parameters(n, end);
+        if (ret != 0) {
+            return ret;
+        }
+
+        // Allocate the working space.
+        std::vector<value_type> xp(n), g(n), gp(n), d(n), pg, wp;
+        if (owlqn) {
+            pg.resize(n);
+            wp.resize(n);
+        }
+        std::vector<correction_type> lm(m);
+        for (int i = 0;i < m;++i) {
+            lm[i].alpha = 0.;
+            lm[i].ys = 0.;
+            lm[i].s.resize(n);
+            lm[i].y.resize(n);
+        }
+        std::vector<value_type> pf(0 < param.past ? param.past : 0);
+
+        // Evaluate the function value and its gradient.
+        value_type fx = client.lbfgs_evaluate(x, &g[0], n, 0.);
+        if (owlqn) {
+            fx += param.orthantwise_c * x1norm(x, end);
+            pseudo_gradient(&pg[0], x, &g[0], n, end);
+        }
+
+        // Store the initial value of the objective function.
+        if (!pf.empty()) {
+            pf[0] = fx;
+        }
+
+        // Compute the direction; we assume the initial hessian matrix H_0
+        // as the identity matrix.
+        const value_type* gd = owlqn ? &pg[0] : &g[0];
+        for (int i = 0;i < n;++i) {
+            d[i] = -gd[i];
+        }
+
+        // Make sure that the initial variables are not a minimizer.
+        value_type xnorm = std::sqrt(simd::dot(x, x, n));
+        value_type gnorm = std::sqrt(simd::dot(gd, gd, n));
+        if (xnorm < 1.0) {
+            xnorm = 1.0;
+        }
+        if (gnorm / xnorm <= param.epsilon) {
+            if (ptr_fx != NULL) {
+                *ptr_fx = fx;
+            }
+            return LBFGS_ALREADY_MINIMIZED;
+        }
+
+        // Compute the initial step: step = 1.0 / ||d||.
+        value_type step = 1. / std::sqrt(simd::dot(&d[0], &d[0], n));
+
+        int k = 1;
+        int cur = 0;
+        for (;;) {
+            // Store the current position and gradient vectors.
+            std::copy(x, x + n, xp.begin());
+            std::copy(g.begin(), g.end(), gp.begin());
+
+            // Search for an optimal step.
+            int ls = 0;
+            if (owlqn) {
+                ls = line_search_owlqn(
+                    n, end, x, fx, &g[0], &d[0], step, &xp[0], &pg[0], &wp[0], client);
+                pseudo_gradient(&pg[0], x, &g[0], n, end);
+            } else if (param.linesearch == LBFGS_LINESEARCH_MORETHUENTE) {
+                ls = line_search_morethuente(
+                    n, x, fx, &g[0], &d[0], step, &xp[0], client);
+            } else {
+                ls = line_search_backtracking(
+                    n, x, fx, &g[0], &d[0], step, &xp[0], client);
+            }
+            if (ls < 0) {
+                // Revert to the previous point.
+                std::copy(xp.begin(), xp.end(), x);
+                std::copy(gp.begin(), gp.end(), g.begin());
+                ret = ls;
+                break;
+            }
+
+            // Compute x and g norms.
+            xnorm = std::sqrt(simd::dot(x, x, n));
+            gnorm = std::sqrt(simd::dot(gd, gd, n));
+
+            // Report the progress.
+            ret = client.lbfgs_progress(x, &g[0], fx, xnorm, gnorm, step, n, k, ls);
+            if (ret != 0) {
+                break;
+            }
+
+            // Convergence test: |g(x)| / max(1, |x|) < epsilon.
+            if (xnorm < 1.0) {
+                xnorm = 1.0;
+            }
+            if (gnorm / xnorm <= param.epsilon) {
+                ret = LBFGS_SUCCESS;
+                break;
+            }
+
+            // Stopping criterion: (f(past_x) - f(x)) / f(x) < delta.
+            if (!pf.empty()) {
+                if (param.past <= k) {
+                    const value_type rate = (pf[k % param.past] - fx) / fx;
+                    if (rate < param.delta) {
+                        ret = LBFGS_STOP;
+                        break;
+                    }
+                }
+                pf[k % param.past] = fx;
+            }
+
+            if (param.max_iterations != 0 && param.max_iterations < k+1) {
+                ret = LBFGSERR_MAXIMUMITERATION;
+                break;
+            }
+
+            // Update the vectors s and y:
+            //  s_{k+1} = x_{k+1} - x_{k} = step * d_{k}.
+            //  y_{k+1} = g_{k+1} - g_{k}.
+            // The inner products are computed from the stored values so
+            // that they are consistent with the corrections.
+            correction_type& it = lm[cur];
+            value_type ys = 0., yy = 0.;
+            for (int i = 0;i < n;++i) {
+                const history_type s = (history_type)(x[i] - xp[i]);
+                const history_type y = (history_type)(g[i] - gp[i]);
+                it.s[i] = s;
+                it.y[i] = y;
+                ys += (value_type)y * (value_type)s;
+                yy += (value_type)y * (value_type)y;
+            }
+            it.ys = ys;
+
+            // Recursive formula to compute dir = -(H \cdot g).
+            //  This is described in page 779 of:
+            //  Jorge Nocedal.
+            //  Updating Quasi-Newton Matrices with Limited Storage.
+            //  Mathematics of Computation, Vol. 35, No. 151,
+            //  pp. 773--782, 1980.
+            const int bound = (m <= k) ? m : k;
+            ++k;
+            cur = (cur + 1) % m;
+
+            // Compute the steepest direction.
+            for (int i = 0;i < n;++i) {
+                d[i] = -gd[i];
+            }
+
+            int j = cur;
+            for (int i = 0;i < bound;++i) {
+                j = (j + m - 1) % m;    // if (--j == -1) j = m-1;
+                correction_type& c = lm[j];
+                // \alpha_{j} = \rho_{j} s^{t}_{j} \cdot q_{k+1}.
+                c.alpha = simd::dot(&c.s[0], &d[0], n) / c.ys;
+                // q_{i} = q_{i+1} - \alpha_{i} y_{i}.
+                simd::axpy(&d[0], &c.y[0], n, -c.alpha);
+            }
+
+            simd::scale(&d[0], n, ys / yy);
+
+            for (int i = 0;i < bound;++i) {
+                correction_type& c = lm[j];
+                // \beta_{j} = \rho_{j} y^t_{j} \cdot \gamma_{i}.
+                const value_type beta = simd::dot(&c.y[0], &d[0], n) / c.ys;
+                // \gamma_{i+1} = \gamma_{i} + (\alpha_{j} - \beta_{j}) s_{j}.
+                simd::axpy(&d[0], &c.s[0], n, c.alpha - beta);
+                j = (j + 1) % m;        // if (++j == m) j = 0;
+            }
+
+            // Constrain the search direction for orthant-wise updates.
+            if (owlqn) {
+                for (int i = param.orthantwise_start;i < end;++i) {
+                    if (0. <= d[i] * pg[i]) {
+                        d[i] = 0.;
+                    }
+                }
+            }
+
+            // Now the search direction d is ready. We try step = 1 first.
+            step = 1.0;
+        }
+
+        if (ptr_fx != NULL) {
+            *ptr_fx = fx;
+        }
+        return ret;
+    }
+
+protected:
+    /**
+     * Checks the parameters for errors.
+     *  @param  n           The number of variables.
+     *  @param  end         The end index of the L1-regularized variables.
+     *  @return int         Zero if the parameters are valid, or an error code.
+     */
+    int check_parameters(const int n, const int end) const
+    {
+        const lbfgs_parameter& param = m_param;
+        if (n <= 0) {
+            return LBFGSERR_INVALID_N;
+        }
+        if (param.m <= 0) {
+            return LBFGSERR_INVALID_N;
+        }
+        if (param.epsilon < 0.) {
+            return LBFGSERR_INVALID_EPSILON;
+        }
+        if (param.past < 0) {
+            return LBFGSERR_INVALID_TESTPERIOD;
+        }
+        if (param.delta < 0.) {
+            return LBFGSERR_INVALID_DELTA;
+        }
+        if (param.min_step < 0.) {
+            return LBFGSERR_INVALID_MINSTEP;
+        }
+        if (param.max_step < param.min_step) {
+            return LBFGSERR_INVALID_MAXSTEP;
+        }
+        if (param.ftol < 0.) {
+            return LBFGSERR_INVALID_FTOL;
+        }
+        if (param.linesearch != LBFGS_LINESEARCH_MORETHUENTE &&
+            param.linesearch != LBFGS_LINESEARCH_BACKTRACKING &&
+            param.linesearch != LBFGS_LINESEARCH_BACKTRACKING_STRONG) {
+            return LBFGSERR_INVALID_LINESEARCH;
+        }
+        if (param.gtol < 0.) {
+            return LBFGSERR_INVALID_GTOL;
+        }
+        if (param.xtol < 0.) {
+            return LBFGSERR_INVALID_XTOL;
+        }
+        if (param.max_linesearch <= 0) {
+            return LBFGSERR_INVALID_MAXLINESEARCH;
+        }
+        if (param.orthantwise_c < 0.) {
+            return LBFGSERR_INVALID_ORTHANTWISE;
+        }
+        if (param.orthantwise_start < 0 || n < param.orthantwise_start) {
+            return LBFGSERR_INVALID_ORTHANTWISE_START;
+        }
+        if (n < end || end < param.orthantwise_start) {
+            return LBFGSERR_INVALID_ORTHANTWISE_END;
+        }
+        if (param.orthantwise_c != 0. &&
+            param.linesearch != LBFGS_LINESEARCH_BACKTRACKING) {
+            return LBFGSERR_INVALID_LINESEARCH;
+        }
+        return 0;
+    }
+
+    /**
+     * Computes the L1 norm of the regularized variables.
+     */
+    value_type x1norm(const value_type *x, const int end) const
+    {
+        const int start = m_param.orthantwise_start;
+        return (start < end) ? simd::norm1(x + start, end - start) : 0.;
+    }
+
+    /**
+     * Computes the pseudo-gradients of OWL-QN.
+     */
+    void pseudo_gradient(
+        value_type *pg,
+        const value_type *x,
+        const value_type *g,
+        const int n,
+        const int end
+        ) const
+    {
+        const int start = m_param.orthantwise_start;
+        const value_type c = m_param.orthantwise_c;
+
+        // Compute the negative of gradients.
+        for (int i = 0;i < start;++i) {
+            pg[i] = g[i];
+        }
+
+        // Compute the psuedo-gradients.
+        for (int i = start;i < end;++i) {
+            if (x[i] < 0.) {
+                // Differentiable.
+                pg[i] = g[i] - c;
+            } else if (0. < x[i]) {
+                // Differentiable.
+                pg[i] = g[i] + c;
+            } else {
+                if (g[i] < -c) {
+                    // Take the right partial derivative.
+                    pg[i] = g[i] + c;
+                } else if (c < g[i]) {
+                    // Take the left partial derivative.
+                    pg[i] = g[i] - c;
+                } else {
+                    pg[i] = 0.;
+                }
+            }
+        }
+
+        for (int i = end;i < n;++i) {
+            pg[i] = g[i];
+        }
+    }
+
+    /**
+     * Backtracking line search with the (strong) Wolfe condition.
+     */
+    template <class client_type>
+    int line_search_backtracking(
+        const int n,
+        value_type *x,
+        value_type& f,
+        value_type *g,
+        const value_type *s,
+        value_type& stp,
+        const value_type *xp,
+        client_type& client
+        )
+    {
+        const lbfgs_parameter& param = m_param;
+        const value_type dec = 0.5, inc = 2.1;
+        int count = 0;
+
+        // Check the input parameters for errors.
+        if (stp <= 0.) {
+            return LBFGSERR_INVALIDPARAMETERS;
+        }
+
+        // Compute the initial gradient in the search direction.
+        const value_type dginit = simd::dot(g, s, n);
+
+        // Make sure that s points to a descent direction.
+        if (0 < dginit) {
+            return LBFGSERR_INCREASEGRADIENT;
+        }
+
+        // The initial value of the objective function.
+        const value_type finit = f;
+        const value_type dgtest = param.ftol * dginit;
+
+        for (;;) {
+            std::copy(xp, xp + n, x);
+            simd::axpy(x, s, n, stp);
+
+            // Evaluate the function and gradient values.
+            f = client.lbfgs_evaluate(x, g, n, stp);
+            ++count;
+
+            value_type width = dec;
+            if (f > finit + stp * dgtest) {
+                width = dec;
+            } else {
+                // The sufficient decrease condition (Armijo condition).
+                // The client may skip the gradients of a trial that fails
+                // this condition.
+                const value_type dg = simd::dot(g, s, n);
+                if (dg < param.gtol * dginit) {
+                    width = inc;
+                } else {
+                    // The regular Wolfe condition.
+                    if (param.linesearch == LBFGS_LINESEARCH_BACKTRACKING) {
+                        return count;
+                    }
+                    if (dg > -param.gtol * dginit) {
+                        width = dec;
+                    } else {
+                        // The strong Wolfe condition.
+                        return count;
+                    }
+                }
+            }
+
+            if (stp < param.min_step) {
+                return LBFGSERR_MINIMUMSTEP;
+            }
+            if (stp > param.max_step) {
+                return LBFGSERR_MAXIMUMSTEP;
+            }
+            if (param.max_linesearch <= count) {
+                return LBFGSERR_MAXIMUMLINESEARCH;
+            }
+
+            stp *= width;
+        }
+    }
+
+    /**
+     * Backtracking line search for OWL-QN.
+     */
+    template <class client_type>
+    int line_search_owlqn(
+        const int n,
+        const int end,
+        value_type *x,
+        value_type& f,
+        value_type *g,
+        const value_type *s,
+        value_type& stp,
+        const value_type *xp,
+        const value_type *gp,
+        value_type *wp,
+        client_type& client
+        )
+    {
+        const lbfgs_parameter& param = m_param;
+        const int start = param.orthantwise_start;
+        const value_type width = 0.5;
+        int count = 0;
+
+        // Check the input parameters for errors.
+        if (stp <= 0.) {
+            return LBFGSERR_INVALIDPARAMETERS;
+        }
+
+        // Choose the orthant for the new point.
+        for (int i = 0;i < n;++i) {
+            wp[i] = (xp[i] == 0.) ? -gp[i] : xp[i];
+        }
+
+        // The initial value of the objective function.
+        const value_type finit = f;
+
+        for (;;) {
+            // Update the current point, and project it onto the orthant.
+            std::copy(xp, xp + n, x);
+            simd::axpy(x, s, n, stp);
+            for (int i = start;i < end;++i) {
+                if (x[i] * wp[i] <= 0.) {
+                    x[i] = 0.;
+                }
+            }
+
+            // Evaluate the function and gradient values.
+            f = client.lbfgs_evaluate(x, g, n, stp);
+
+            // Compute the L1 norm of the variables and add it to the object value.
+            f += param.orthantwise_c * x1norm(x, end);
+            ++count;
+
+            value_type dgtest = 0.;
+            for (int i = 0;i < n;++i) {
+                dgtest += (x[i] - xp[i]) * gp[i];
+            }
+
+            if (f <= finit + param.ftol * dgtest) {
+                // The sufficient decrease condition.
+                return count;
+            }
+
+            if (stp < param.min_step) {
+                return LBFGSERR_MINIMUMSTEP;
+            }
+            if (stp > param.max_step) {
+                return LBFGSERR_MAXIMUMSTEP;
+            }
+            if (param.max_linesearch <= count) {
+                return LBFGSERR_MAXIMUMLINESEARCH;
+            }
+
+            stp *= width;
+        }
+    }
+
+    /**
+     * Line search by More and Thuente.
+     */
+    template <class client_type>
+    int line_search_morethuente(
+        const int n,
+        value_type *x,
+        value_type& f,
+        value_type *g,
+        const value_type *s,
+        value_type& stp,
+        const value_type *xp,
+        client_type& client
+        )
+    {
+        const lbfgs_parameter& param = m_param;
+        int count = 0;
+        int uinfo = 0;
+        bool brackt = false, stage1 = true;
+        value_type stmin = 0., stmax = 0.;
+
+        // Check the input parameters for errors.
+        if (stp <= 0.) {
+            return LBFGSERR_INVALIDPARAMETERS;
+        }
+
+        // Compute the initial gradient in the search direction.
+        const value_type dginit = simd::dot(g, s, n);
+
+        // Make sure that s points to a descent direction.
+        if (0 < dginit) {
+            return LBFGSERR_INCREASEGRADIENT;
+        }
+
+        // Initialize local variables.
+        const value_type finit = f;
+        const value_type dgtest = param.ftol * dginit;
+        value_type width = param.max_step - param.min_step;
+        value_type prev_width = 2.0 * width;
+
+        // The variables stx, fx, dgx contain the values of the step,
+        // function, and directional derivative at the best step.
+        // The variables sty, fy, dgy contain the value of the step,
+        // function, and derivative at the other endpoint of
+        // the interval of uncertainty.
+        // The variables stp, f, dg contain the values of the step,
+        // function, and derivative at the current step.
+        value_type stx = 0., sty = 0.;
+        value_type fx = finit, fy = finit;
+        value_type dgx = dginit, dgy = dginit;
+
+        for (;;) {
+            // Set the minimum and maximum steps to correspond to the
+            // present interval of uncertainty.
+            if (brackt) {
+                stmin = std::min(stx, sty);
+                stmax = std::max(stx, sty);
+            } else {
+                stmin = stx;
+                stmax = stp + 4.0 * (stp - stx);
+            }
+
+            // Clip the step in the range of [stpmin, stpmax].
+            if (stp < param.min_step) {
+                stp = param.min_step;
+            }
+            if (param.max_step < stp) {
+                stp = param.max_step;
+            }
+
+            // If an unusual termination is to occur then let
+            // stp be the lowest point obtained so far.
+            if ((brackt && ((stp <= stmin || stmax <= stp) ||
+                param.max_linesearch <= count + 1 || uinfo != 0)) ||
+                (brackt && (stmax - stmin <= param.xtol * stmax))) {
+                stp = stx;
+            }
+
+            // Compute the current value of x: x <- x + stp * s.
+            std::copy(xp, xp + n, x);
+            simd::axpy(x, s, n, stp);
+
+            // Evaluate the function and gradient values.
+            f = client.lbfgs_evaluate(x, g, n, stp);
+            const value_type dg = simd::dot(g, s, n);
+
+            const value_type ftest1 = finit + stp * dgtest;
+            ++count;
+
+            // Test for errors and convergence.
+            if (brackt && ((stp <= stmin || stmax <= stp) || uinfo != 0)) {
+                // Rounding errors prevent further progress.
+                return LBFGSERR_ROUNDING_ERROR;
+            }
+            if (stp == param.max_step && f <= ftest1 && dg <= dgtest) {
+                // The step is the maximum value.
+                return LBFGSERR_MAXIMUMSTEP;
+            }
+            if (stp == param.min_step && (ftest1 < f || dgtest <= dg)) {
+                // The step is the minimum value.
+                return LBFGSERR_MINIMUMSTEP;
+            }
+            if (brackt && (stmax - stmin) <= param.xtol * stmax) {
+                // Relative width of the interval of uncertainty is at most xtol.
+                return LBFGSERR_WIDTHTOOSMALL;
+            }
+            if (param.max_linesearch <= count) {
+                // Maximum number of iteration.
+                return LBFGSERR_MAXIMUMLINESEARCH;
+            }
+            if (f <= ftest1 && std::fabs(dg) <= param.gtol * (-dginit)) {
+                // The sufficient decrease condition and the directional
+                // derivative condition hold.
+                return count;
+            }
+
+            // In the first stage we seek a step for which the modified
+            // function has a nonpositive value and nonnegative derivative.
+            if (stage1 && f <= ftest1 && std::min(param.ftol, param.gtol) * dginit <= dg) {
+                stage1 = false;
+            }
+
+            // A modified function is used to predict the step only if
+            // we have not obtained a step for which the modified
+            // function has a nonpositive function value and nonnegative
+            // derivative, and if a lower function value has been
+            // obtained but the decrease is not sufficient.
+            if (stage1 && ftest1 < f && f <= fx) {
+                // Define the modified function and derivative values.
+                value_type fm = f - stp * dgtest;
+                value_type fxm = fx - stx * dgtest;
+                value_type fym = fy - sty * dgtest;
+                value_type dgm = dg - dgtest;
+                value_type dgxm = dgx - dgtest;
+                value_type dgym = dgy - dgtest;
+
+                // Call update_trial_interval() to update the interval of
+                // uncertainty and to compute the new step.
+                uinfo = update_trial_interval(
+                    stx, fxm, dgxm, sty, fym, dgym, stp, fm, dgm,
+                    stmin, stmax, brackt);
+
+                // Reset the function and gradient values for f.
+                fx = fxm + stx * dgtest;
+                fy = fym + sty * dgtest;
+                dgx = dgxm + dgtest;
+                dgy = dgym + dgtest;
+            } else {
+                // Call update_trial_interval() to update the interval of
+                // uncertainty and to compute the new step.
+                value_type ft = f, dgt = dg;
+                uinfo = update_trial_interval(
+                    stx, fx, dgx, sty, fy, dgy, stp, ft, dgt,
+                    stmin, stmax, brackt);
+            }
+
+            // Force a sufficient decrease in the interval of uncertainty.
+            if (brackt) {
+                if (0.66 * prev_width <= std::fabs(sty - stx)) {
+                    stp = stx + 0.5 * (sty - stx);
+                }
+                prev_width = width;
+                width = std::fabs(sty - stx);
+            }
+        }
+    }
+
+    /**
+     * Finds a minimizer of an interpolated cubic function.
+     *  @param  u           The value of one point, u.
+     *  @param  fu          The value of f(u).
+     *  @param  du          The value of f'(u).
+     *  @param  v           The value of another point, v.
+     *  @param  fv          The value of f(v).
+     *  @param  dv          The value of f'(v).
+     *  @return value_type  The minimizer.
+     */
+    static value_type cubic_minimizer(
+        value_type u, value_type fu, value_type du,
+        value_type v, value_type fv, value_type dv)
+    {
+        const value_type d = v - u;
+        const value_type theta = (fu - fv) * 3 / d + du + dv;
+        const value_type s = std::max(std::max(std::fabs(theta), std::fabs(du)), std::fabs(dv));
+        const value_type a = theta / s;
+        value_type gamma = s * std::sqrt(a * a - (du / s) * (dv / s));
+        if (v < u) {
+            gamma = -gamma;
+        }
+        const value_type p = gamma - du + theta;
+        const value_type q = gamma - du + gamma + dv;
+        return u + (p / q) * d;
+    }
+
+    /**
+     * Finds a minimizer of an interpolated cubic function, which is
+     * clipped in the range [xmin, xmax].
+     */
+    static value_type cubic_minimizer2(
+        value_type u, value_type fu, value_type du,
+        value_type v, value_type fv, value_type dv,
+        value_type xmin, value_type xmax)
+    {
+        const value_type d = v - u;
+        const value_type theta = (fu - fv) * 3 / d + du + dv;
+        const value_type s = std::max(std::max(std::fabs(theta), std::fabs(du)), std::fabs(dv));
+        const value_type a = theta / s;
+        value_type gamma = s * std::sqrt(std::max(0., a * a - (du / s) * (dv / s)));
+        if (u < v) {
+            gamma = -gamma;
+        }
+        const value_type p = gamma - dv + theta;
+        const value_type q = gamma - dv + gamma + du;
+        const value_type r = p / q;
+        if (r < 0. && gamma != 0.) {
+            return v - r * d;
+        } else if (a < 0) {
+            return xmax;
+        } else {
+            return xmin;
+        }
+    }
+
+    /**
+     * Finds a minimizer of an interpolated quadratic function from the
+     * function values and the derivative at u.
+     */
+    static value_type quard_minimizer(
+        value_type u, value_type fu, value_type du, value_type v, value_type fv)
+    {
+        const value_type a = v - u;
+        return u + du / ((fu - fv) / a + du) / 2 * a;
+    }
+
+    /**
+     * Finds a minimizer of an interpolated quadratic function from the
+     * derivatives at u and v.
+     */
+    static value_type quard_minimizer2(
+        value_type u, value_type du, value_type v, value_type dv)
+    {
+        const value_type a = u - v;
+        return v + dv / (dv - du) * a;
+    }
+
+    /**
+     * Updates a safeguarded trial value and interval for line search.
+     *
+     *  The parameter x represents the step with the least function value.
+     *  The parameter t represents the current step. This function assumes
+     *  that the derivative at the point of x in the direction of the step.
+     *  If the bracket is set to true, the minimizer has been bracketed in
+     *  an interval of uncertainty with endpoints between x and y.
+     *
+     *  @param  x           The value of one endpoint.
+     *  @param  fx          The value of f(x).
+     *  @param  dx          The value of f'(x).
+     *  @param  y           The value of another endpoint.
+     *  @param  fy          The value of f(y).
+     *  @param  dy          The value of f'(y).
+     *  @param  t           The value of the trial value, t.
+     *  @param  ft          The value of f(t).
+     *  @param  dt          The value of f'(t).
+     *  @param  tmin        The minimum value for the trial value, t.
+     *  @param  tmax        The maximum value for the trial value, t.
+     *  @param  brackt      The predicate if the trial value is bracketed.
+     *  @return int         Status value. Zero indicates a normal termination.
+     */
+    static int update_trial_interval(
+        value_type& x, value_type& fx, value_type& dx,
+        value_type& y, value_type& fy, value_type& dy,
+        value_type& t, value_type& ft, value_type& dt,
+        const value_type tmin, const value_type tmax,
+        bool& brackt
+        )
+    {
+        bool bound = false;
+        const bool dsign = (dt * (dx / std::fabs(dx)) < 0.);
+        value_type mc = 0.;     // minimizer of an interpolated cubic.
+        value_type mq = 0.;     // minimizer of an interpolated quadratic.
+        value_type newt = 0.;   // new trial value.
+
+        // Check the input parameters for errors.
+        if (brackt) {
+            if (t <= std::min(x, y) || std::max(x, y) <= t) {
+                // The trival value t is out of the interval.
+                return LBFGSERR_OUTOFINTERVAL;
+            }
+            if (0. <= dx * (t - x)) {
+                // The function must decrease from x.
+                return LBFGSERR_INCREASEGRADIENT;
+            }
+            if (tmax < tmin) {
+                // Incorrect tmin and tmax specified.
+                return LBFGSERR_INCORRECT_TMINMAX;
+            }
+        }
+
+        // Trial value selection.
+        if (fx < ft) {
+            // Case 1: a higher function value. The minimum is brackt.
+            // If the cubic minimizer is closer to x than the quadratic
+            // one, the cubic one is taken, else the average of the
+            // minimizers is taken.
+            brackt = true;
+            bound = true;
+            mc = cubic_minimizer(x, fx, dx, t, ft, dt);
+            mq = quard_minimizer(x, fx, dx, t, ft);
+            if (std::fabs(mc - x) < std::fabs(mq - x)) {
+                newt = mc;
+            } else {
+                newt = mc + 0.5 * (mq - mc);
+            }
+        } else if (dsign) {
+            // Case 2: a lower function value and derivatives of opposite
+            // sign. The minimum is brackt. If the cubic minimizer is
+            // closer to x than the quadratic (secant) one, the cubic one
+            // is taken, else the quadratic one is taken.
+            brackt = true;
+            bound = false;
+            mc = cubic_minimizer(x, fx, dx, t, ft, dt);
+            mq = quard_minimizer2(x, dx, t, dt);
+            if (std::fabs(mc - t) > std::fabs(mq - t)) {
+                newt = mc;
+            } else {
+                newt = mq;
+            }
+        } else if (std::fabs(dt) < std::fabs(dx)) {
+            // Case 3: a lower function value, derivatives of the same
+            // sign, and the magnitude of the derivative decreases. The
+            // cubic minimizer is only used if the cubic tends to infinity
+            // in the direction of the minimizer or if the minimum of the
+            // cubic is beyond t. Otherwise the cubic minimizer is defined
+            // to be either tmin or tmax. The quadratic (secant) minimizer
+            // is also computed and if the minimum is brackt then the
+            // minimizer closest to x is taken, else the one farthest
+            // away is taken.
+            bound = true;
+            mc = cubic_minimizer2(x, fx, dx, t, ft, dt, tmin, tmax);
+            mq = quard_minimizer2(x, dx, t, dt);
+            if (brackt) {
+                if (std::fabs(t - mc) < std::fabs(t - mq)) {
+                    newt = mc;
+                } else {
+                    newt = mq;
+                }
+            } else {
+                if (std::fabs(t - mc) > std::fabs(t - mq)) {
+                    newt = mc;
+                } else {
+                    newt = mq;
+                }
+            }
+        } else {
+            // Case 4: a lower function value, derivatives of the same
+            // sign, and the magnitude of the derivative does not
+            // decrease. If the minimum is not brackt, the step is either
+            // tmin or tmax, else the cubic minimizer is taken.
+            bound = false;
+            if (brackt) {
+                newt = cubic_minimizer(t, ft, dt, y, fy, dy);
+            } else if (x < t) {
+                newt = tmax;
+            } else {
+                newt = tmin;
+            }
+        }
+
+        // Update the interval of uncertainty. This update does not
+        // depend on the new step or the case analysis above.
+        // - Case a: if f(x) < f(t),
+        //      x <- x, y <- t.
+        // - Case b: if f(t) <= f(x) && f'(t)*f'(x) > 0,
+        //      x <- t, y <- y.
+        // - Case c: if f(t) <= f(x) && f'(t)*f'(x) < 0,
+        //      x <- t, y <- x.
+        if (fx < ft) {
+            // Case a.
+            y = t;
+            fy = ft;
+            dy = dt;
+        } else {
+            // Case c.
+            if (dsign) {
+                y = x;
+                fy = fx;
+                dy = dx;
+            }
+            // Cases b and c.
+            x = t;
+            fx = ft;
+            dx = dt;
+        }
+
+        // Clip the new trial value in [tmin, tmax].
+        if (tmax < newt) {
+            newt = tmax;
+        }
+        if (newt < tmin) {
+            newt = tmin;
+        }
+
+        // Redefine the new trial value if it is close to the upper bound
+        // of the interval.
+        if (brackt && bound) {
+            mq = x + 0.66 * (y - x);
+            if (x < y) {
+                if (mq < newt) {
+                    newt = mq;
+                }
+            } else {
+                if (newt < mq) {
+                    newt = mq;
+                }
+            }
+        }
+
+        // Return the new trial value.
+        t = newt;
+        return 0;
+    }
+};
+
+};
+
+};
+
+#endif/*__CLASSIAS_TRAIN_LBFGS_SOLVER_H__*/
@@ -41,6 +41,7 @@
 #include <iterator>
 #include <vector>
 #include <classias/parameters.h>
+#include <classias/parallel.h>
 #include <classias/evaluation.h>
 
 namespace classias {
@@ -72,6 +73,55 @@ shuffle_permutation(
     std::random_shuffle(cont.begin(), cont.end());
 }
 
+/**
+ * Chooses the instances for an epoch in the order of updates.
+ *  @param  insts       The vector receiving the iterators of the instances.
+ *  @param  first       The iterator pointing to the first instance.
+ *  @param  last        The iterator pointing just beyond the last instance.
+ *  @param  method      The sampling method ("random", "cycle", or
+ *                      "shuffle").
+ *  @param  holdout     The group number for holdout evaluation.
+ */
+template <class container_type, class iterator_type>
+static void
+sample_instances(
+    container_type& insts, iterator_type first, iterator_type last,
+    const std::string& method, int holdout
+    )
+{
+    const size_t n = (size_t)std::distance(first, last);
+    insts.clear();
+    insts.reserve(n);
+
+    if (method == "random") {
+        // Choose N instances at random.
+        for (size_t i = 0;i < n;++i) {
+            iterator_type it = random_sample(first, last);
+            if (it->get_group() != holdout) {
+                insts.push_back(it);
+            }
+        }
+    } else if (method == "cycle") {
+        // Do not change the ordering of instances.
+        for (iterator_type it = first;it != last;++it) {
+            if (it->get_group() != holdout) {
+                insts.push_back(it);
+            }
+        }
+    } else if (method == "shuffle") {
+        // Shuffle N instances first.
+        container_type perm(n);
+        shuffle_permutation(perm, first, last);
+        for (size_t i = 0;i < perm.size();++i) {
+            if (perm[i]->get_group() != holdout) {
+                insts.push_back(perm[i]);
+            }
+        }
+    } else {
+        throw invalid_parameter("Unknown sampling method for instances");
+    }
+}
+
 template <class value_type, class iterator_type>
 static value_type compute_variance(iterator_type first, iterator_type last, value_type avg)
 {
@@ -135,6 +185,13 @@ protected:
     /// The epsilon for improvement ratio.
     value_type m_epsilon;
 
+    /// Ring buffer of the recent losses for moving averages.
+    std::vector<value_type> m_pf;
+    /// The number of instances streamed in the current epoch.
+    size_t m_stream_size;
+    /// The time when the current epoch of streaming started.
+    double m_stream_clk;
+
 public:
     /**
      * Constructs the object.
@@ -191,6 +248,98 @@ public:
         return m_trainer.model();
     }
 
+protected:
+    /**
+     * Sends the instances of an epoch to the training algorithm.
+     *  @param  insts       The iterators of the instances in the order of
+     *                      updates.
+     *  @param  data        The data set for training.
+     */
+    virtual void feed(const std::vector<const_iterator>& insts, const data_type& data)
+    {
+        for (size_t i = 0;i < insts.size();++i) {
+            m_trainer.update(insts[i]);
+        }
+    }
+
+    /**
+     * Reports the progress of an epoch.
+     *  @param  os          The output stream.
+     */
+    virtual void report(std::ostream& os)
+    {
+        m_trainer.report(os);
+    }
+
+    /**
+     * Prepares the training algorithm for a training process.
+     *  @param  num_features    The number of features.
+     *  @param  os              The output stream for progress reports.
+     */
+    void begin_training(size_t num_features, std::ostream& os)
+    {
+        // Reserve the weight vector.
+        m_trainer.set_num_features(num_features);
+
+        // Show the algorithm name and parameters.
+        m_trainer.copyright(os);
+        m_trainer.params().show(os);
+        os << std::endl;
+
+        // Initialize the training algorithm.
+        m_trainer.start();
+        m_pf.assign(m_period, 0.);
+    }
+
+    /**
+     * Terminates an epoch and reports the progress.
+     *  @param  k               The epoch number (starting from one).
+     *  @param  n               The number of instances in the epoch.
+     *  @param  clk             The time when the epoch started.
+     *  @param  os              The output stream for progress reports.
+     *  @return bool            \c true if the stopping criterion is
+     *                          satisfied.
+     */
+    bool end_epoch(int k, size_t n, double clk, std::ostream& os)
+    {
+        value_type loss = 0;
+        value_type avg = 0, var = 0, nvar = m_epsilon;
+
+        // Pause the training process, and compute the loss.
+        m_trainer.discontinue();
+        loss = m_trainer.loss();
+
+        // Store the current loss to the ring buffer
+        m_pf[(k-1) % m_period] = loss;
+        if (m_period < k) {
+            // Compute the average and variance of the recent losses.
+            avg = std::accumulate(m_pf.begin(), m_pf.end(), 0.) / m_pf.size();
+            var = compute_variance(m_pf.begin(), m_pf.end(), avg);
+            // nvar = var / min(1, fabs(loss))
+            nvar = fabs(loss);
+            if (1. < nvar) {
+                nvar = var / nvar;
+            } else {
+                nvar = var;
+            }
+        }
+
+        // Report the progress.
+        os << "***** Iteration #" << k << " *****" << std::endl;
+        this->report(os);
+        if (m_period < k) {
+            os << "Loss variance: " << nvar << std::endl;
+        }
+        double duration = wallclock() - clk;
+        os << "Seconds required for this iteration: " << duration << std::endl;
+        if (0. < duration) {
+            os << "Instances per second: " << n / duration << std::endl;
+        }
+
+        return (nvar < m_epsilon);
+    }
+
+public:
     /**
      * Trains a model on a data set.
      *  @param  data        The data set for training (and holdout evaluation).
@@ -208,87 +357,26 @@ public:
         bool acconly = true
         )
     {
-        // Ring buffer for moving averages.
-        std::vector<value_type> pf(m_period);
+        // The instances for an epoch.
+        std::vector<const_iterator> insts;
 
         // Set the number of instances for the target algorithm.
         parameter_exchange& par = this->params();
         par.set("n", (double)data.size(), false);
 
-        // Reserve the weight vector.
-        m_trainer.set_num_features(data.num_features());
-
-        // Show the algorithm name and parameters.
-        m_trainer.copyright(os);
-        m_trainer.params().show(os);
-        os << std::endl;
-
         // Initialize the training algorithm.
-        m_trainer.start();
+        this->begin_training(data.num_features(), os);
 
         // Loop for iterations.
         for (int k = 1;k <= m_max_iterations;++k) {
-            value_type loss = 0;
-            value_type avg = 0, var = 0, nvar = m_epsilon;
-            clock_t clk = std::clock();
+            double clk = wallclock();
 
             // Send instances to the algorithm.
-            if (m_sample == "random") {
-                // Choose N instances at random.
-                for (size_t i = 0;i < data.size();++i) {
-                    const_iterator it = random_sample(data.begin(), data.end());
-                    if (it->get_group() != holdout) {
-                        m_trainer.update(it);
-                    }
-                }
-            } else if (m_sample == "cycle") {
-                // Do not change the ordering of instances.
-                for (const_iterator it = data.begin();it != data.end();++it) {
-                    if (it->get_group() != holdout) {
-                        m_trainer.update(it);
-                    }
-                }
-            } else if (m_sample == "shuffle") {
-                // Shuffle N instances first.
-                std::vector<const_iterator> perm(data.size());
-                shuffle_permutation(perm, data.begin(), data.end());
-                for (size_t i = 0;i < perm.size();++i) {
-                    const_iterator it = perm[i];
-                    if (it->get_group() != holdout) {
-                        m_trainer.update(it);
-                    }
-                }
-            } else {
-                throw invalid_parameter("Unknown sampling method for instances");
-            }
+            sample_instances(insts, data.begin(), data.end(), m_sample, holdout);
+            this->feed(insts, data);
 
-            // Pause the training process, and compute the loss.
-            m_trainer.discontinue();
-            loss = m_trainer.loss();
-
-            // Store the current loss to the ring buffer
-            pf[(k-1) % m_period] = loss;
-            if (m_period < k) {
-                // Compute the average and variance of the recent losses.
-                avg = std::accumulate(pf.begin(), pf.end(), 0.) / pf.size();
-                var = compute_variance(pf.begin(), pf.end(), avg);
-                // nvar = var / min(1, fabs(loss))
-                nvar = fabs(loss);
-                if (1. < nvar) {
-                    nvar = var / nvar;
-                } else {
-                    nvar = var;
-                }
-            }
-
-            // Report the progress.
-            os << "***** Iteration #" << k << " *****" << std::endl;
-            m_trainer.report(os);
-            if (m_period < k) {
-                os << "Loss variance: " << nvar << std::endl;
-            }
-            os << "Seconds required for this iteration: " <<
-                (std::clock() - clk) / (double)CLOCKS_PER_SEC << std::endl;
+            // Terminate the epoch, and report the progress.
+            bool converged = this->end_epoch(k, insts.size(), clk, os);
 
             // Holdout evaluation if necessary.
             if (0 <= holdout) {
@@ -307,7 +395,7 @@ public:
             os.flush();
 
             // Terminate if the stopping criterion is satisfied.
-            if (nvar < m_epsilon) {
+            if (converged) {
                 os << "Terminated with the stopping criterion" << std::endl;
                 os << std::endl;
                 os.flush();
@@ -318,14 +406,90 @@ public:
         // Finalize the training procedure.
         m_trainer.finish();
     }
+
+    /**
+     * Starts training a model on a stream of instances.
+     *  Instead of train(), an application can send the instances of every
+     *  epoch in chunks with stream() and terminate the epoch with
+     *  end_stream(); the data set is then never stored in memory at once.
+     *  The number of instances is unknown in advance in this mode, so that
+     *  the parameter "n" of the training algorithm (if any) must be set
+     *  explicitly; this function throws invalid_parameter otherwise.
+     *  @param  os          The output stream for progress reports.
+     */
+    void begin_stream(std::ostream& os)
+    {
+        if (m_trainer.params().get_stamp("n") == 0) {
+            throw invalid_parameter(
+                "The parameter \"n\" must be set for training on a stream");
+        }
+        this->begin_training(0, os);
+        m_stream_size = 0;
+        m_stream_clk = wallclock();
+    }
+
+    /**
+     * Sends a chunk of instances in the current epoch.
+     *  The weight vector is expanded for the features that are new to the
+     *  training algorithm. The instances are ordered within the chunk by
+     *  the sampling method.
+     *  @param  data        The chunk of instances.
+     */
+    void stream(const data_type& data)
+    {
+        std::vector<const_iterator> insts;
+        m_trainer.expand_num_features(data.num_features());
+        sample_instances(insts, data.begin(), data.end(), m_sample, -1);
+        this->feed(insts, data);
+        m_stream_size += insts.size();
+    }
+
+    /**
+     * Terminates an epoch of streaming.
+     *  @param  k           The epoch number (starting from one).
+     *  @param  os          The output stream for progress reports.
+     *  @return bool        \c true if the training process should stop,
+     *                      i.e., the stopping criterion is satisfied or the
+     *                      number of epochs reaches ${max_iterations}.
+     */
+    bool end_stream(int k, std::ostream& os)
+    {
+        bool converged = this->end_epoch(k, m_stream_size, m_stream_clk, os);
+        os << std::endl;
+        os.flush();
+
+        if (converged) {
+            os << "Terminated with the stopping criterion" << std::endl;
+            os << std::endl;
+            os.flush();
+            return true;
+        }
+
+        m_stream_size = 0;
+        m_stream_clk = wallclock();
+        return (m_max_iterations <= k);
+    }
+
+    /**
+     * Finishes training a model on a stream of instances.
+     */
+    void finish_stream()
+    {
+        m_trainer.finish();
+    }
 };
 
 
 
 /**
- * A scheduler of online algorithms for training multi/candidate classifiers.
- *  This is a utility class to use online training algorithms from a data set
- *  transparently as a batch training algorithm.
+ * A mini-batch scheduler of online algorithms for binary classifiers.
+ *  This scheduler splits the instances of an epoch into mini-batches of
+ *  ${batch_size} instances. Worker threads compute the errors of the
+ *  instances in a mini-batch against the same model, and the training
+ *  algorithm then applies the errors as a single update. Because the
+ *  update does not depend on the timing of threads, the model is
+ *  identical for any number of threads. The training algorithm
+ *  implements begin_batch(), batch_error(), and update_batch().
  *
  *  @param  data_tmpl       The type of a data set.
  *  @param  trainer_tmpl    The type of an online training algorithm.
@@ -334,201 +498,659 @@ template <
     class data_tmpl,
     class trainer_tmpl
 >
-class online_scheduler_multi
+class minibatch_online_scheduler_binary :
+    public online_scheduler_binary<data_tmpl, trainer_tmpl>
 {
 public:
     /// The type representing a data set for training.
     typedef data_tmpl data_type;
     /// The type implementing a training algorithm.
     typedef trainer_tmpl trainer_type;
+    /// A synonym of the base class.
+    typedef online_scheduler_binary<data_tmpl, trainer_tmpl> base_class;
 
     /// A type providing a read-only random-access iterator for instances.
     typedef typename data_type::const_iterator const_iterator;
     /// The type representing an instance in the training data.
     typedef typename data_type::instance_type instance_type;
-    /// The type representing an attribute in an instance.
-    typedef typename data_type::attribute_type attribute_type;
     /// The type representing a value.
     typedef typename instance_type::value_type value_type;
-    /// The type implementing an error function.
-    typedef typename trainer_type::error_type error_type;
-    /// The type implementing a model (weight vector for features).
-    typedef typename trainer_type::model_type model_type;
 
 protected:
-    /// Trainer type.
-    trainer_type m_trainer;
-    /// The sample method.
-    std::string m_sample;
-    /// The maximum number of iterations.
-    int m_max_iterations;
-    /// The parameter for regularization.
-    value_type m_c;
-    /// The period to measure the improvement ratio of loss.
-    int m_period;
-    /// The epsilon for improvement ratio.
-    value_type m_epsilon;
+    /// The number of instances in a mini-batch.
+    int m_batch_size;
+    /// The number of threads.
+    int m_num_threads;
+
+    /// A task that computes the errors of instances in a mini-batch.
+    struct error_task
+    {
+        /// The training algorithm.
+        trainer_type* trainer;
+        /// The iterators of the instances in the epoch.
+        const std::vector<const_iterator>* insts;
+        /// The position of the first instance of the mini-batch.
+        size_t first;
+        /// The position just beyond the last instance of the mini-batch.
+        size_t last;
+        /// The offset of the first instance processed by this task.
+        size_t offset;
+        /// The stride of the positions (the number of threads).
+        size_t stride;
+        /// The errors of the instances in the mini-batch.
+        value_type* errs;
+        /// The losses of the instances in the mini-batch.
+        value_type* losses;
+
+        void operator()()
+        {
+            const std::vector<const_iterator>& v = *insts;
+            for (size_t i = offset;first + i < last;i += stride) {
+                losses[i] = trainer->batch_error(v[first+i], errs[i]);
+            }
+        }
+    };
 
 public:
     /**
      * Constructs the object.
      */
-    online_scheduler_multi()
+    minibatch_online_scheduler_binary()
     {
-        clear();
+        parameter_exchange& par = this->params();
+        par.init("batch_size", &m_batch_size, 1,
+            "The number of instances in a mini-batch, whose errors are computed in\n"
+            "parallel and applied as a single update (1: no mini-batch).");
+        par.init("num_threads", &m_num_threads, 1,
+            "The number of threads for parallel updates:\n"
+            "{0: the number of processors, 1: no parallelization, N: N threads}");
     }
 
     /**
      * Destructs the object.
      */
-    virtual ~online_scheduler_multi()
+    virtual ~minibatch_online_scheduler_binary()
     {
     }
 
+protected:
     /**
-     * Resets the internal states and parameters to default.
+     * Sends the instances of an epoch to the training algorithm.
+     *  @param  insts       The iterators of the instances in the order of
+     *                      updates.
+     *  @param  data        The data set for training.
      */
-    void clear()
+    virtual void feed(const std::vector<const_iterator>& insts, const data_type& data)
     {
-        m_trainer.clear();
+        if (m_batch_size <= 1) {
+            base_class::feed(insts, data);
+            return;
+        }
 
-        parameter_exchange& par = this->params();
-        par.init("sample", &m_sample, "shuffle",
-            "The method for sampling instances.");
-        par.init("max_iterations", &m_max_iterations, 1000,
-            "The maximum number of iterations (epochs).");
-        par.init("c", &m_c, 1,
-            "Coefficient (C) for regularization.");
-        par.init("period", &m_period, 20,
-            "The period to measure the improvement ratio");
-        par.init("epsilon", &m_epsilon, 1e-6,
-            "The stopping criterion for the improvement ratio");
+        const size_t B = (size_t)m_batch_size;
+        const size_t T = (size_t)resolve_num_threads(m_num_threads);
+        std::vector<value_type> errs(B), losses(B);
+        std::vector<error_task> tasks(std::min(T, B));
+        for (size_t t = 0;t < tasks.size();++t) {
+            tasks[t].trainer = &this->m_trainer;
+            tasks[t].insts = &insts;
+            tasks[t].offset = t;
+            tasks[t].stride = tasks.size();
+            tasks[t].errs = &errs[0];
+            tasks[t].losses = &losses[0];
+        }
+
+        for (size_t first = 0;first < insts.size();first += B) {
+            const size_t last = std::min(first + B, insts.size());
+
+            this->m_trainer.begin_batch(insts, first, last);
+            for (size_t t = 0;t < tasks.size();++t) {
+                tasks[t].first = first;
+                tasks[t].last = last;
+            }
+            parallel_run(tasks);
+            this->m_trainer.update_batch(insts, first, last, &errs[0], &losses[0]);
+        }
     }
+};
+
+
+
+/**
+ * A lock-free parallel scheduler of online algorithms for binary classifiers.
+ *  This scheduler runs worker threads over disjoint shards of the
+ *  (shuffled) instances in an epoch, the t-th thread receiving the
+ *  instances at the positions t, t+T, t+2T, ... The threads update the
+ *  shared weight vector without locks (Hogwild!). The training algorithm
+ *  implements begin_parallel(), update_parallel(), and end_parallel() to
+ *  derive the global state of an update (e.g., the learning rate) from its
+ *  position in the epoch. The scheduler runs the mini-batch updates of the
+ *  base class instead when ${batch_size} is greater than one. The detail of
+ *  the lock-free updates is described in:
+ *
+ *  -   Feng Niu, Benjamin Recht, Christopher Re, and Stephen J. Wright.
+ *      Hogwild!: A Lock-Free Approach to Parallelizing Stochastic Gradient
+ *      Descent. In Proc. of NIPS 2011, pp 693-701, 2011.
+ *
+ *  @param  data_tmpl       The type of a data set.
+ *  @param  trainer_tmpl    The type of an online training algorithm.
+ */
+template <
+    class data_tmpl,
+    class trainer_tmpl
+>
+class parallel_online_scheduler_binary :
+    public minibatch_online_scheduler_binary<data_tmpl, trainer_tmpl>
+{
+public:
+    /// The type representing a data set for training.
+    typedef data_tmpl data_type;
+    /// The type implementing a training algorithm.
+    typedef trainer_tmpl trainer_type;
+    /// A synonym of the base class.
+    typedef minibatch_online_scheduler_binary<data_tmpl, trainer_tmpl> base_class;
+
+    /// A type providing a read-only random-access iterator for instances.
+    typedef typename data_type::const_iterator const_iterator;
+    /// The type representing an instance in the training data.
+    typedef typename data_type::instance_type instance_type;
+    /// The type representing a value.
+    typedef typename instance_type::value_type value_type;
+
+protected:
+    /// A task that sends a shard of instances to the training algorithm.
+    struct update_task
+    {
+        /// The training algorithm.
+        trainer_type* trainer;
+        /// The iterators of the instances in the epoch.
+        const std::vector<const_iterator>* insts;
+        /// The position of the first instance of the shard.
+        size_t first;
+        /// The stride of the positions (the number of threads).
+        size_t stride;
+        /// The loss of the shard.
+        value_type loss;
+
+        void operator()()
+        {
+            const std::vector<const_iterator>& v = *insts;
+            value_type sum = 0.;
+            for (size_t i = first;i < v.size();i += stride) {
+                trainer->update_parallel(v[i], i, sum);
+            }
+            loss = sum;
+        }
+    };
 
+public:
     /**
-     * Obtains the parameter interface.
-     *  @return parameter_exchange& The parameter interface associated with
-     *                              this algorithm.
+     * Constructs the object.
      */
-    parameter_exchange& params()
+    parallel_online_scheduler_binary()
     {
-        // Forward to the training algorithm.
-        return m_trainer.params();
     }
 
     /**
-     * Obtains a read-only access to the weight vector (model).
-     *  @return const model_type&   The weight vector (model).
+     * Destructs the object.
      */
-    const model_type& model() const
+    virtual ~parallel_online_scheduler_binary()
     {
-        return m_trainer.model();
     }
 
+protected:
     /**
-     * Trains a model on a data set.
-     *  @param  data        The data set for training (and holdout evaluation).
-     *  @param  os          The output stream for progress reports.
-     *  @param  holdout     The group number for holdout evaluation. Specify
-     *                      a negative value if a holdout evaluation is
-     *                      unnecessary.
-     *  @param  acconly     The flag indicating whether precision, recall, and
-     *                      F1 scores are unnecessary.
+     * Sends the instances of an epoch to the training algorithm.
+     *  @param  insts       The iterators of the instances in the order of
+     *                      updates.
+     *  @param  data        The data set for training.
      */
-    void train(
-        const data_type& data,
-        std::ostream& os,
-        int holdout = -1,
-        bool acconly = true
-        )
+    virtual void feed(const std::vector<const_iterator>& insts, const data_type& data)
     {
-        // Ring buffer for moving averages.
-        std::vector<value_type> pf(m_period);
-
-        // Set the number of instances for the target algorithm.
-        parameter_exchange& par = this->params();
-        par.set("n", (double)data.size(), false);
-
-        // Reserve the weight vector.
-        m_trainer.set_num_features(data.num_features());
+        const size_t T = (size_t)resolve_num_threads(this->m_num_threads);
+        if (1 < this->m_batch_size || T <= 1 || insts.size() < T) {
+            // Mini-batch or serial updates.
+            base_class::feed(insts, data);
+            return;
+        }
 
-        // Show the algorithm name and parameters.
-        m_trainer.copyright(os);
-        m_trainer.params().show(os);
-        os << std::endl;
+        std::vector<update_task> tasks(T);
+        for (size_t t = 0;t < T;++t) {
+            tasks[t].trainer = &this->m_trainer;
+            tasks[t].insts = &insts;
+            tasks[t].first = t;
+            tasks[t].stride = T;
+            tasks[t].loss = 0.;
+        }
 
-        // Initialize the training algorithm.
-        m_trainer.start();
+        this->m_trainer.begin_parallel(insts.size());
+        parallel_run(tasks);
 
-        // Loop for iterations.
-        for (int k = 1;k <= m_max_iterations;++k) {
-            value_type loss = 0;
-            value_type avg = 0, var = 0, nvar = m_epsilon;
-            clock_t clk = std::clock();
+        value_type loss = 0.;
+        for (size_t t = 0;t < T;++t) {
+            loss += tasks[t].loss;
+        }
+        this->m_trainer.end_parallel(insts.size(), loss);
+    }
+};
 
-            // Send instances to the algorithm.
-            if (m_sample == "random") {
-                // Choose N instances at random.
-                for (size_t i = 0;i < data.size();++i) {
-                    const_iterator it = random_sample(data.begin(), data.end());
-                    if (it->get_group() != holdout) {
-                        m_trainer.update(
-                            it, const_cast<data_type&>(data).feature_generator);
-                    }
-                }
-            } else if (m_sample == "cycle") {
-                // Do not change the ordering of instances.
-                for (const_iterator it = data.begin();it != data.end();++it) {
-                    if (it->get_group() != holdout) {
-                        m_trainer.update(
-                            it, const_cast<data_type&>(data).feature_generator);
-                    }
-                }
-            } else if (m_sample == "shuffle") {
-                // Shuffle N instances first.
-                std::vector<const_iterator> perm(data.size());
-                shuffle_permutation(perm, data.begin(), data.end());
-                for (size_t i = 0;i < perm.size();++i) {
-                    const_iterator it = perm[i];
-                    if (it->get_group() != holdout) {
-                        m_trainer.update(
-                            it, const_cast<data_type&>(data).feature_generator);
-                    }
-                }
-            } else {
-                throw invalid_parameter("Unknown sampling method for instances");
-            }
 
-            // Pause the training process, and compute the loss.
-            m_trainer.discontinue();
-            loss = m_trainer.loss();
-
-            // Store the current loss to the ring buffer
-            pf[(k-1) % m_period] = loss;
-            if (m_period < k) {
-                // Compute the average and variance of the recent losses.
-                avg = std::accumulate(pf.begin(), pf.end(), 0.) / pf.size();
-                var = compute_variance(pf.begin(), pf.end(), avg);
-                // nvar = var / min(1, fabs(loss))
-                nvar = fabs(loss);
-                if (1. < nvar) {
-                    nvar = var / nvar;
-                } else {
-                    nvar = var;
-                }
-            }
 
-            // Report the progress.
-            os << "***** Iteration #" << k << " *****" << std::endl;
-            m_trainer.report(os);
-            if (m_period < k) {
-                os << "Loss variance: " << nvar << std::endl;
-            }
-            os << "Seconds required for this iteration: " <<
-                (std::clock() - clk) / (double)CLOCKS_PER_SEC << std::endl;
+/**
+ * A parameter-mixing scheduler of online algorithms for binary classifiers.
+ *  This scheduler runs worker threads over disjoint shards of the
+ *  (shuffled) instances in an epoch, the t-th thread receiving the
+ *  instances at the positions t, t+T, t+2T, ... Each thread trains a local
+ *  copy of the model on its shard, and the scheduler mixes the local models
+ *  at the end of the epoch, uniformly (${mixing}=uniform) or in proportion
+ *  to the number of errors in the shards (${mixing}=error). The training
+ *  algorithm implements begin_shard() and mix_weights(). The scheduler
+ *  runs the updates of the base class instead when ${mixing} is "none".
+ *  The detail of the iterative parameter mixing is described in:
+ *
+ *  -   Ryan McDonald, Keith Hall, and Gideon Mann.
+ *      Distributed Training Strategies for the Structured Perceptron.
+ *      In Proc. of NAACL-HLT 2010, pp 456-464, 2010.
+ *
+ *  @param  data_tmpl       The type of a data set.
+ *  @param  trainer_tmpl    The type of an online training algorithm.
+ */
+template <
+    class data_tmpl,
+    class trainer_tmpl
+>
+class mixing_online_scheduler_binary :
+    public minibatch_online_scheduler_binary<data_tmpl, trainer_tmpl>
+{
+public:
+    /// The type representing a data set for training.
+    typedef data_tmpl data_type;
+    /// The type implementing a training algorithm.
+    typedef trainer_tmpl trainer_type;
+    /// A synonym of the base class.
+    typedef minibatch_online_scheduler_binary<data_tmpl, trainer_tmpl> base_class;
 
-            // Holdout evaluation if necessary.
-            if (0 <= holdout) {
+    /// A type providing a read-only random-access iterator for instances.
+    typedef typename data_type::const_iterator const_iterator;
+    /// The type representing an instance in the training data.
+    typedef typename data_type::instance_type instance_type;
+    /// The type representing a value.
+    typedef typename instance_type::value_type value_type;
+
+protected:
+    /// The method for mixing the local models.
+    std::string m_mixing;
+    /// The local training algorithms (shards).
+    std::vector<trainer_type*> m_shards;
+    /// The seconds elapsed for the slowest shard in the last epoch.
+    double m_shard_seconds;
+    /// The seconds elapsed for mixing the local models in the last epoch.
+    double m_mixing_seconds;
+
+    /// A task that trains a local model on a shard of instances.
+    struct shard_task
+    {
+        /// The local training algorithm.
+        trainer_type* trainer;
+        /// The master training algorithm.
+        const trainer_type* master;
+        /// The iterators of the instances in the epoch.
+        const std::vector<const_iterator>* insts;
+        /// The position of the first instance of the shard.
+        size_t first;
+        /// The stride of the positions (the number of threads).
+        size_t stride;
+        /// The seconds elapsed for the shard.
+        double seconds;
+
+        void operator()()
+        {
+            double clk = wallclock();
+            const std::vector<const_iterator>& v = *insts;
+            trainer->begin_shard(*master);
+            for (size_t i = first;i < v.size();i += stride) {
+                trainer->update(v[i]);
+            }
+            seconds = wallclock() - clk;
+        }
+    };
+
+public:
+    /**
+     * Constructs the object.
+     */
+    mixing_online_scheduler_binary()
+    {
+        m_shard_seconds = 0.;
+        m_mixing_seconds = 0.;
+
+        parameter_exchange& par = this->params();
+        par.init("mixing", &m_mixing, "none",
+            "The method for mixing the models trained on shards in parallel:\n"
+            "{'none': no parallelization, 'uniform': uniform mixing,\n"
+            " 'error': mixing weighted by the number of errors}");
+    }
+
+    /**
+     * Destructs the object.
+     */
+    virtual ~mixing_online_scheduler_binary()
+    {
+        for (size_t t = 0;t < m_shards.size();++t) {
+            delete m_shards[t];
+        }
+    }
+
+protected:
+    /**
+     * Sends the instances of an epoch to the training algorithm.
+     *  @param  insts       The iterators of the instances in the order of
+     *                      updates.
+     *  @param  data        The data set for training.
+     */
+    virtual void feed(const std::vector<const_iterator>& insts, const data_type& data)
+    {
+        const size_t T = (size_t)resolve_num_threads(this->m_num_threads);
+        if (m_mixing == "none" || 1 < this->m_batch_size || insts.size() < T) {
+            // Mini-batch or serial updates.
+            base_class::feed(insts, data);
+            return;
+        }
+        if (m_mixing != "uniform" && m_mixing != "error") {
+            throw invalid_parameter("Unknown method for mixing models");
+        }
+
+        // Allocate the local training algorithms.
+        while (m_shards.size() < T) {
+            trainer_type* trainer = new trainer_type;
+            trainer->set_num_features(data.num_features());
+            m_shards.push_back(trainer);
+        }
+        std::vector<trainer_type*> shards(m_shards.begin(), m_shards.begin() + T);
+
+        std::vector<shard_task> tasks(T);
+        for (size_t t = 0;t < T;++t) {
+            tasks[t].trainer = shards[t];
+            tasks[t].master = &this->m_trainer;
+            tasks[t].insts = &insts;
+            tasks[t].first = t;
+            tasks[t].stride = T;
+            tasks[t].seconds = 0.;
+        }
+
+        parallel_run(tasks);
+
+        double clk = wallclock();
+        this->m_trainer.mix_weights(shards, m_mixing == "error");
+        m_mixing_seconds = wallclock() - clk;
+
+        m_shard_seconds = 0.;
+        for (size_t t = 0;t < T;++t) {
+            if (m_shard_seconds < tasks[t].seconds) {
+                m_shard_seconds = tasks[t].seconds;
+            }
+        }
+    }
+
+    /**
+     * Reports the progress of an epoch.
+     *  @param  os          The output stream.
+     */
+    virtual void report(std::ostream& os)
+    {
+        base_class::report(os);
+        if (m_mixing != "none") {
+            os << "Seconds required for the slowest shard: " << m_shard_seconds << std::endl;
+            os << "Seconds required for mixing: " << m_mixing_seconds << std::endl;
+        }
+    }
+};
+
+
+
+/**
+ * A scheduler of online algorithms for training multi/candidate classifiers.
+ *  This is a utility class to use online training algorithms from a data set
+ *  transparently as a batch training algorithm.
+ *
+ *  @param  data_tmpl       The type of a data set.
+ *  @param  trainer_tmpl    The type of an online training algorithm.
+ */
+template <
+    class data_tmpl,
+    class trainer_tmpl
+>
+class online_scheduler_multi
+{
+public:
+    /// The type representing a data set for training.
+    typedef data_tmpl data_type;
+    /// The type implementing a training algorithm.
+    typedef trainer_tmpl trainer_type;
+
+    /// A type providing a read-only random-access iterator for instances.
+    typedef typename data_type::const_iterator const_iterator;
+    /// The type representing an instance in the training data.
+    typedef typename data_type::instance_type instance_type;
+    /// The type representing an attribute in an instance.
+    typedef typename data_type::attribute_type attribute_type;
+    /// The type representing a value.
+    typedef typename instance_type::value_type value_type;
+    /// The type implementing an error function.
+    typedef typename trainer_type::error_type error_type;
+    /// The type implementing a model (weight vector for features).
+    typedef typename trainer_type::model_type model_type;
+
+protected:
+    /// Trainer type.
+    trainer_type m_trainer;
+    /// The sample method.
+    std::string m_sample;
+    /// The maximum number of iterations.
+    int m_max_iterations;
+    /// The parameter for regularization.
+    value_type m_c;
+    /// The period to measure the improvement ratio of loss.
+    int m_period;
+    /// The epsilon for improvement ratio.
+    value_type m_epsilon;
+
+    /// Ring buffer of the recent losses for moving averages.
+    std::vector<value_type> m_pf;
+    /// The number of instances streamed in the current epoch.
+    size_t m_stream_size;
+    /// The time when the current epoch of streaming started.
+    double m_stream_clk;
+
+public:
+    /**
+     * Constructs the object.
+     */
+    online_scheduler_multi()
+    {
+        clear();
+    }
+
+    /**
+     * Destructs the object.
+     */
+    virtual ~online_scheduler_multi()
+    {
+    }
+
+    /**
+     * Resets the internal states and parameters to default.
+     */
+    void clear()
+    {
+        m_trainer.clear();
+
+        parameter_exchange& par = this->params();
+        par.init("sample", &m_sample, "shuffle",
+            "The method for sampling instances.");
+        par.init("max_iterations", &m_max_iterations, 1000,
+            "The maximum number of iterations (epochs).");
+        par.init("c", &m_c, 1,
+            "Coefficient (C) for regularization.");
+        par.init("period", &m_period, 20,
+            "The period to measure the improvement ratio");
+        par.init("epsilon", &m_epsilon, 1e-6,
+            "The stopping criterion for the improvement ratio");
+    }
+
+    /**
+     * Obtains the parameter interface.
+     *  @return parameter_exchange& The parameter interface associated with
+     *                              this algorithm.
+     */
+    parameter_exchange& params()
+    {
+        // Forward to the training algorithm.
+        return m_trainer.params();
+    }
+
+    /**
+     * Obtains a read-only access to the weight vector (model).
+     *  @return const model_type&   The weight vector (model).
+     */
+    const model_type& model() const
+    {
+        return m_trainer.model();
+    }
+
+protected:
+    /**
+     * Sends the instances of an epoch to the training algorithm.
+     *  @param  insts       The iterators of the instances in the order of
+     *                      updates.
+     *  @param  data        The data set for training.
+     */
+    virtual void feed(const std::vector<const_iterator>& insts, const data_type& data)
+    {
+        for (size_t i = 0;i < insts.size();++i) {
+            m_trainer.update(
+                insts[i], const_cast<data_type&>(data).feature_generator);
+        }
+    }
+
+    /**
+     * Reports the progress of an epoch.
+     *  @param  os          The output stream.
+     */
+    virtual void report(std::ostream& os)
+    {
+        m_trainer.report(os);
+    }
+
+    /**
+     * Prepares the training algorithm for a training process.
+     *  @param  num_features    The number of features.
+     *  @param  os              The output stream for progress reports.
+     */
+    void begin_training(size_t num_features, std::ostream& os)
+    {
+        // Reserve the weight vector.
+        m_trainer.set_num_features(num_features);
+
+        // Show the algorithm name and parameters.
+        m_trainer.copyright(os);
+        m_trainer.params().show(os);
+        os << std::endl;
+
+        // Initialize the training algorithm.
+        m_trainer.start();
+        m_pf.assign(m_period, 0.);
+    }
+
+    /**
+     * Terminates an epoch and reports the progress.
+     *  @param  k               The epoch number (starting from one).
+     *  @param  n               The number of instances in the epoch.
+     *  @param  clk             The time when the epoch started.
+     *  @param  os              The output stream for progress reports.
+     *  @return bool            \c true if the stopping criterion is
+     *                          satisfied.
+     */
+    bool end_epoch(int k, size_t n, double clk, std::ostream& os)
+    {
+        value_type loss = 0;
+        value_type avg = 0, var = 0, nvar = m_epsilon;
+
+        // Pause the training process, and compute the loss.
+        m_trainer.discontinue();
+        loss = m_trainer.loss();
+
+        // Store the current loss to the ring buffer
+        m_pf[(k-1) % m_period] = loss;
+        if (m_period < k) {
+            // Compute the average and variance of the recent losses.
+            avg = std::accumulate(m_pf.begin(), m_pf.end(), 0.) / m_pf.size();
+            var = compute_variance(m_pf.begin(), m_pf.end(), avg);
+            // nvar = var / min(1, fabs(loss))
+            nvar = fabs(loss);
+            if (1. < nvar) {
+                nvar = var / nvar;
+            } else {
+                nvar = var;
+            }
+        }
+
+        // Report the progress.
+        os << "***** Iteration #" << k << " *****" << std::endl;
+        this->report(os);
+        if (m_period < k) {
+            os << "Loss variance: " << nvar << std::endl;
+        }
+        double duration = wallclock() - clk;
+        os << "Seconds required for this iteration: " << duration << std::endl;
+        if (0. < duration) {
+            os << "Instances per second: " << n / duration << std::endl;
+        }
+
+        return (nvar < m_epsilon);
+    }
+
+public:
+    /**
+     * Trains a model on a data set.
+     *  @param  data        The data set for training (and holdout evaluation).
+     *  @param  os          The output stream for progress reports.
+     *  @param  holdout     The group number for holdout evaluation. Specify
+     *                      a negative value if a holdout evaluation is
+     *                      unnecessary.
+     *  @param  acconly     The flag indicating whether precision, recall, and
+     *                      F1 scores are unnecessary.
+     */
+    void train(
+        const data_type& data,
+        std::ostream& os,
+        int holdout = -1,
+        bool acconly = true
+        )
+    {
+        // The instances for an epoch.
+        std::vector<const_iterator> insts;
+
+        // Set the number of instances for the target algorithm.
+        parameter_exchange& par = this->params();
+        par.set("n", (double)data.size(), false);
+
+        // Initialize the training algorithm.
+        this->begin_training(data.num_features(), os);
+
+        // Loop for iterations.
+        for (int k = 1;k <= m_max_iterations;++k) {
+            double clk = wallclock();
+
+            // Send instances to the algorithm.
+            sample_instances(insts, data.begin(), data.end(), m_sample, holdout);
+            this->feed(insts, data);
+
+            // Terminate the epoch, and report the progress.
+            bool converged = this->end_epoch(k, insts.size(), clk, os);
+
+            // Holdout evaluation if necessary.
+            if (0 <= holdout) {
                 error_type cla(m_trainer.model());
                 holdout_evaluation_multi(
                     os,
@@ -549,7 +1171,7 @@ public:
             os.flush();
 
             // Terminate if the stopping criterion is satisfied.
-            if (nvar < m_epsilon) {
+            if (converged) {
                 os << "Terminated with the stopping criterion" << std::endl;
                 os << std::endl;
                 os.flush();
@@ -560,6 +1182,524 @@ public:
         // Finalize the training procedure.
         m_trainer.finish();
     }
+
+    /**
+     * Starts training a model on a stream of instances.
+     *  Instead of train(), an application can send the instances of every
+     *  epoch in chunks with stream() and terminate the epoch with
+     *  end_stream(); the data set is then never stored in memory at once.
+     *  The number of instances is unknown in advance in this mode, so that
+     *  the parameter "n" of the training algorithm (if any) must be set
+     *  explicitly; this function throws invalid_parameter otherwise.
+     *  @param  os          The output stream for progress reports.
+     */
+    void begin_stream(std::ostream& os)
+    {
+        if (m_trainer.params().get_stamp("n") == 0) {
+            throw invalid_parameter(
+                "The parameter \"n\" must be set for training on a stream");
+        }
+        this->begin_training(0, os);
+        m_stream_size = 0;
+        m_stream_clk = wallclock();
+    }
+
+    /**
+     * Sends a chunk of instances in the current epoch.
+     *  The weight vector is expanded for the features that are new to the
+     *  training algorithm. The instances are ordered within the chunk by
+     *  the sampling method.
+     *  @param  data        The chunk of instances.
+     */
+    void stream(const data_type& data)
+    {
+        std::vector<const_iterator> insts;
+        m_trainer.expand_num_features(data.num_features());
+        sample_instances(insts, data.begin(), data.end(), m_sample, -1);
+        this->feed(insts, data);
+        m_stream_size += insts.size();
+    }
+
+    /**
+     * Terminates an epoch of streaming.
+     *  @param  k           The epoch number (starting from one).
+     *  @param  os          The output stream for progress reports.
+     *  @return bool        \c true if the training process should stop,
+     *                      i.e., the stopping criterion is satisfied or the
+     *                      number of epochs reaches ${max_iterations}.
+     */
+    bool end_stream(int k, std::ostream& os)
+    {
+        bool converged = this->end_epoch(k, m_stream_size, m_stream_clk, os);
+        os << std::endl;
+        os.flush();
+
+        if (converged) {
+            os << "Terminated with the stopping criterion" << std::endl;
+            os << std::endl;
+            os.flush();
+            return true;
+        }
+
+        m_stream_size = 0;
+        m_stream_clk = wallclock();
+        return (m_max_iterations <= k);
+    }
+
+    /**
+     * Finishes training a model on a stream of instances.
+     */
+    void finish_stream()
+    {
+        m_trainer.finish();
+    }
+};
+
+
+/**
+ * A mini-batch scheduler of online algorithms for multi/candidate classifiers.
+ *  This scheduler splits the instances of an epoch into mini-batches of
+ *  ${batch_size} instances. Worker threads compute the errors of the
+ *  instances in a mini-batch against the same model, and the training
+ *  algorithm then applies the errors as a single update. Because the
+ *  update does not depend on the timing of threads, the model is
+ *  identical for any number of threads. The training algorithm
+ *  implements begin_batch(), batch_error(), and update_batch().
+ *
+ *  @param  data_tmpl       The type of a data set.
+ *  @param  trainer_tmpl    The type of an online training algorithm.
+ */
+template <
+    class data_tmpl,
+    class trainer_tmpl
+>
+class minibatch_online_scheduler_multi :
+    public online_scheduler_multi<data_tmpl, trainer_tmpl>
+{
+public:
+    /// The type representing a data set for training.
+    typedef data_tmpl data_type;
+    /// The type implementing a training algorithm.
+    typedef trainer_tmpl trainer_type;
+    /// A synonym of the base class.
+    typedef online_scheduler_multi<data_tmpl, trainer_tmpl> base_class;
+
+    /// A type providing a read-only random-access iterator for instances.
+    typedef typename data_type::const_iterator const_iterator;
+    /// The type representing an instance in the training data.
+    typedef typename data_type::instance_type instance_type;
+    /// The type representing a value.
+    typedef typename instance_type::value_type value_type;
+    /// The type of a feature generator.
+    typedef typename data_type::feature_generator_type feature_generator_type;
+
+protected:
+    /// The number of instances in a mini-batch.
+    int m_batch_size;
+    /// The number of threads.
+    int m_num_threads;
+
+    /// A task that computes the errors of instances in a mini-batch.
+    struct error_task
+    {
+        /// The training algorithm.
+        trainer_type* trainer;
+        /// The feature generator.
+        feature_generator_type* fgen;
+        /// The iterators of the instances in the epoch.
+        const std::vector<const_iterator>* insts;
+        /// The position of the first instance of the mini-batch.
+        size_t first;
+        /// The position just beyond the last instance of the mini-batch.
+        size_t last;
+        /// The offset of the first instance processed by this task.
+        size_t offset;
+        /// The stride of the positions (the number of threads).
+        size_t stride;
+        /// The errors of the instances in the mini-batch.
+        std::vector<value_type>* errs;
+        /// The losses of the instances in the mini-batch.
+        value_type* losses;
+
+        void operator()()
+        {
+            const std::vector<const_iterator>& v = *insts;
+            for (size_t i = offset;first + i < last;i += stride) {
+                losses[i] = trainer->batch_error(v[first+i], *fgen, errs[i]);
+            }
+        }
+    };
+
+public:
+    /**
+     * Constructs the object.
+     */
+    minibatch_online_scheduler_multi()
+    {
+        parameter_exchange& par = this->params();
+        par.init("batch_size", &m_batch_size, 1,
+            "The number of instances in a mini-batch, whose errors are computed in\n"
+            "parallel and applied as a single update (1: no mini-batch).");
+        par.init("num_threads", &m_num_threads, 1,
+            "The number of threads for parallel updates:\n"
+            "{0: the number of processors, 1: no parallelization, N: N threads}");
+    }
+
+    /**
+     * Destructs the object.
+     */
+    virtual ~minibatch_online_scheduler_multi()
+    {
+    }
+
+protected:
+    /**
+     * Sends the instances of an epoch to the training algorithm.
+     *  @param  insts       The iterators of the instances in the order of
+     *                      updates.
+     *  @param  data        The data set for training.
+     */
+    virtual void feed(const std::vector<const_iterator>& insts, const data_type& data)
+    {
+        if (m_batch_size <= 1) {
+            base_class::feed(insts, data);
+            return;
+        }
+
+        const size_t B = (size_t)m_batch_size;
+        const size_t T = (size_t)resolve_num_threads(m_num_threads);
+        feature_generator_type& fgen =
+            const_cast<data_type&>(data).feature_generator;
+        std::vector<std::vector<value_type> > errs(B);
+        std::vector<value_type> losses(B);
+        std::vector<error_task> tasks(std::min(T, B));
+        for (size_t t = 0;t < tasks.size();++t) {
+            tasks[t].trainer = &this->m_trainer;
+            tasks[t].fgen = &fgen;
+            tasks[t].insts = &insts;
+            tasks[t].offset = t;
+            tasks[t].stride = tasks.size();
+            tasks[t].errs = &errs[0];
+            tasks[t].losses = &losses[0];
+        }
+
+        for (size_t first = 0;first < insts.size();first += B) {
+            const size_t last = std::min(first + B, insts.size());
+
+            this->m_trainer.begin_batch(insts, first, last, fgen);
+            for (size_t t = 0;t < tasks.size();++t) {
+                tasks[t].first = first;
+                tasks[t].last = last;
+            }
+            parallel_run(tasks);
+            this->m_trainer.update_batch(
+                insts, first, last, fgen, &errs[0], &losses[0]);
+        }
+    }
+};
+
+
+
+/**
+ * A lock-free parallel scheduler of online algorithms for multi/candidate classifiers.
+ *  This scheduler runs worker threads over disjoint shards of the
+ *  (shuffled) instances in an epoch, the t-th thread receiving the
+ *  instances at the positions t, t+T, t+2T, ... The threads update the
+ *  shared weight vector without locks (Hogwild!). The training algorithm
+ *  implements begin_parallel(), update_parallel(), and end_parallel() to
+ *  derive the global state of an update (e.g., the learning rate) from its
+ *  position in the epoch. The scheduler runs the mini-batch updates of the
+ *  base class instead when ${batch_size} is greater than one. The detail of
+ *  the lock-free updates is described in:
+ *
+ *  -   Feng Niu, Benjamin Recht, Christopher Re, and Stephen J. Wright.
+ *      Hogwild!: A Lock-Free Approach to Parallelizing Stochastic Gradient
+ *      Descent. In Proc. of NIPS 2011, pp 693-701, 2011.
+ *
+ *  @param  data_tmpl       The type of a data set.
+ *  @param  trainer_tmpl    The type of an online training algorithm.
+ */
+template <
+    class data_tmpl,
+    class trainer_tmpl
+>
+class parallel_online_scheduler_multi :
+    public minibatch_online_scheduler_multi<data_tmpl, trainer_tmpl>
+{
+public:
+    /// The type representing a data set for training.
+    typedef data_tmpl data_type;
+    /// The type implementing a training algorithm.
+    typedef trainer_tmpl trainer_type;
+    /// A synonym of the base class.
+    typedef minibatch_online_scheduler_multi<data_tmpl, trainer_tmpl> base_class;
+
+    /// A type providing a read-only random-access iterator for instances.
+    typedef typename data_type::const_iterator const_iterator;
+    /// The type representing an instance in the training data.
+    typedef typename data_type::instance_type instance_type;
+    /// The type representing a value.
+    typedef typename instance_type::value_type value_type;
+    /// The type of a feature generator.
+    typedef typename data_type::feature_generator_type feature_generator_type;
+
+protected:
+    /// A task that sends a shard of instances to the training algorithm.
+    struct update_task
+    {
+        /// The training algorithm.
+        trainer_type* trainer;
+        /// The feature generator.
+        feature_generator_type* fgen;
+        /// The iterators of the instances in the epoch.
+        const std::vector<const_iterator>* insts;
+        /// The position of the first instance of the shard.
+        size_t first;
+        /// The stride of the positions (the number of threads).
+        size_t stride;
+        /// The loss of the shard.
+        value_type loss;
+
+        void operator()()
+        {
+            const std::vector<const_iterator>& v = *insts;
+            value_type sum = 0.;
+            for (size_t i = first;i < v.size();i += stride) {
+                trainer->update_parallel(v[i], *fgen, i, sum);
+            }
+            loss = sum;
+        }
+    };
+
+public:
+    /**
+     * Constructs the object.
+     */
+    parallel_online_scheduler_multi()
+    {
+    }
+
+    /**
+     * Destructs the object.
+     */
+    virtual ~parallel_online_scheduler_multi()
+    {
+    }
+
+protected:
+    /**
+     * Sends the instances of an epoch to the training algorithm.
+     *  @param  insts       The iterators of the instances in the order of
+     *                      updates.
+     *  @param  data        The data set for training.
+     */
+    virtual void feed(const std::vector<const_iterator>& insts, const data_type& data)
+    {
+        const size_t T = (size_t)resolve_num_threads(this->m_num_threads);
+        if (1 < this->m_batch_size || T <= 1 || insts.size() < T) {
+            // Mini-batch or serial updates.
+            base_class::feed(insts, data);
+            return;
+        }
+
+        std::vector<update_task> tasks(T);
+        for (size_t t = 0;t < T;++t) {
+            tasks[t].trainer = &this->m_trainer;
+            tasks[t].fgen = &const_cast<data_type&>(data).feature_generator;
+            tasks[t].insts = &insts;
+            tasks[t].first = t;
+            tasks[t].stride = T;
+            tasks[t].loss = 0.;
+        }
+
+        this->m_trainer.begin_parallel(insts.size());
+        parallel_run(tasks);
+
+        value_type loss = 0.;
+        for (size_t t = 0;t < T;++t) {
+            loss += tasks[t].loss;
+        }
+        this->m_trainer.end_parallel(insts.size(), loss);
+    }
+};
+
+
+
+/**
+ * A parameter-mixing scheduler of online algorithms for multi-class classifiers.
+ *  This scheduler runs worker threads over disjoint shards of the
+ *  (shuffled) instances in an epoch, the t-th thread receiving the
+ *  instances at the positions t, t+T, t+2T, ... Each thread trains a local
+ *  copy of the model on its shard, and the scheduler mixes the local models
+ *  at the end of the epoch, uniformly (${mixing}=uniform) or in proportion
+ *  to the number of errors in the shards (${mixing}=error). The training
+ *  algorithm implements begin_shard() and mix_weights(). The scheduler
+ *  runs the updates of the base class instead when ${mixing} is "none".
+ *  The detail of the iterative parameter mixing is described in:
+ *
+ *  -   Ryan McDonald, Keith Hall, and Gideon Mann.
+ *      Distributed Training Strategies for the Structured Perceptron.
+ *      In Proc. of NAACL-HLT 2010, pp 456-464, 2010.
+ *
+ *  @param  data_tmpl       The type of a data set.
+ *  @param  trainer_tmpl    The type of an online training algorithm.
+ */
+template <
+    class data_tmpl,
+    class trainer_tmpl
+>
+class mixing_online_scheduler_multi :
+    public minibatch_online_scheduler_multi<data_tmpl, trainer_tmpl>
+{
+public:
+    /// The type representing a data set for training.
+    typedef data_tmpl data_type;
+    /// The type implementing a training algorithm.
+    typedef trainer_tmpl trainer_type;
+    /// A synonym of the base class.
+    typedef minibatch_online_scheduler_multi<data_tmpl, trainer_tmpl> base_class;
+
+    /// A type providing a read-only random-access iterator for instances.
+    typedef typename data_type::const_iterator const_iterator;
+    /// The type representing an instance in the training data.
+    typedef typename data_type::instance_type instance_type;
+    /// The type representing a value.
+    typedef typename instance_type::value_type value_type;
+    /// The type of a feature generator.
+    typedef typename data_type::feature_generator_type feature_generator_type;
+
+protected:
+    /// The method for mixing the local models.
+    std::string m_mixing;
+    /// The local training algorithms (shards).
+    std::vector<trainer_type*> m_shards;
+    /// The seconds elapsed for the slowest shard in the last epoch.
+    double m_shard_seconds;
+    /// The seconds elapsed for mixing the local models in the last epoch.
+    double m_mixing_seconds;
+
+    /// A task that trains a local model on a shard of instances.
+    struct shard_task
+    {
+        /// The local training algorithm.
+        trainer_type* trainer;
+        /// The master training algorithm.
+        const trainer_type* master;
+        /// The feature generator.
+        feature_generator_type* fgen;
+        /// The iterators of the instances in the epoch.
+        const std::vector<const_iterator>* insts;
+        /// The position of the first instance of the shard.
+        size_t first;
+        /// The stride of the positions (the number of threads).
+        size_t stride;
+        /// The seconds elapsed for the shard.
+        double seconds;
+
+        void operator()()
+        {
+            double clk = wallclock();
+            const std::vector<const_iterator>& v = *insts;
+            trainer->begin_shard(*master);
+            for (size_t i = first;i < v.size();i += stride) {
+                trainer->update(v[i], *fgen);
+            }
+            seconds = wallclock() - clk;
+        }
+    };
+
+public:
+    /**
+     * Constructs the object.
+     */
+    mixing_online_scheduler_multi()
+    {
+        m_shard_seconds = 0.;
+        m_mixing_seconds = 0.;
+
+        parameter_exchange& par = this->params();
+        par.init("mixing", &m_mixing, "none",
+            "The method for mixing the models trained on shards in parallel:\n"
+            "{'none': no parallelization, 'uniform': uniform mixing,\n"
+            " 'error': mixing weighted by the number of errors}");
+    }
+
+    /**
+     * Destructs the object.
+     */
+    virtual ~mixing_online_scheduler_multi()
+    {
+        for (size_t t = 0;t < m_shards.size();++t) {
+            delete m_shards[t];
+        }
+    }
+
+protected:
+    /**
+     * Sends the instances of an epoch to the training algorithm.
+     *  @param  insts       The iterators of the instances in the order of
+     *                      updates.
+     *  @param  data        The data set for training.
+     */
+    virtual void feed(const std::vector<const_iterator>& insts, const data_type& data)
+    {
+        const size_t T = (size_t)resolve_num_threads(this->m_num_threads);
+        if (m_mixing == "none" || 1 < this->m_batch_size || insts.size() < T) {
+            // Mini-batch or serial updates.
+            base_class::feed(insts, data);
+            return;
+        }
+        if (m_mixing != "uniform" && m_mixing != "error") {
+            throw invalid_parameter("Unknown method for mixing models");
+        }
+        feature_generator_type& fgen =
+            const_cast<data_type&>(data).feature_generator;
+
+        // Allocate the local training algorithms.
+        while (m_shards.size() < T) {
+            trainer_type* trainer = new trainer_type;
+            trainer->set_num_features(data.num_features());
+            m_shards.push_back(trainer);
+        }
+        std::vector<trainer_type*> shards(m_shards.begin(), m_shards.begin() + T);
+
+        std::vector<shard_task> tasks(T);
+        for (size_t t = 0;t < T;++t) {
+            tasks[t].trainer = shards[t];
+            tasks[t].master = &this->m_trainer;
+            tasks[t].fgen = &fgen;
+            tasks[t].insts = &insts;
+            tasks[t].first = t;
+            tasks[t].stride = T;
+            tasks[t].seconds = 0.;
+        }
+
+        parallel_run(tasks);
+
+        double clk = wallclock();
+        this->m_trainer.mix_weights(shards, m_mixing == "error");
+        m_mixing_seconds = wallclock() - clk;
+
+        m_shard_seconds = 0.;
+        for (size_t t = 0;t < T;++t) {
+            if (m_shard_seconds < tasks[t].seconds) {
+                m_shard_seconds = tasks[t].seconds;
+            }
+        }
+    }
+
+    /**
+     * Reports the progress of an epoch.
+     *  @param  os          The output stream.
+     */
+    virtual void report(std::ostream& os)
+    {
+        base_class::report(os);
+        if (m_mixing != "none") {
+            os << "Seconds required for the slowest shard: " << m_shard_seconds << std::endl;
+            os << "Seconds required for mixing: " << m_mixing_seconds << std::endl;
+        }
+    }
 };
 
 };
@@ -34,9 +34,12 @@
 #define __CLASSIAS_TRAIN_PEGASOS_H__
 
 #include <iostream>
+#include <vector>
 
 #include <classias/types.h>
 #include <classias/parameters.h>
+#include <classias/simd.h>
+#include <classias/feature_generator.h>
 
 namespace classias
 {
@@ -105,6 +108,8 @@ protected:
     value_type m_loss;
     /// The update count.
     value_type m_t;
+    /// The numerator of the scaling factor during parallel updates.
+    value_type m_parallel_base;
 
     /// Parameter interface.
     parameter_exchange m_params;
@@ -160,6 +165,19 @@ public:
         this->initialize_weights();
     }
 
+    /**
+     * Expands the weight vector for new features.
+     *  This function appends zero weights for the features that are unseen
+     *  so far, without resetting the training process.
+     *  @param  size        The number of features.
+     */
+    void expand_num_features(size_t size)
+    {
+        if (m_model.size() < size) {
+            m_model.resize(size, 0.);
+        }
+    }
+
 public:
     /**
      * Starts a training process.
@@ -216,12 +234,7 @@ public:
     void report(std::ostream& os)
     {
         // Count the number of active features.
-        int num_active = 0;
-        for (size_t i = 0;i < m_model.size();++i) {
-            if (m_model[i] != 0.) {
-                ++num_active;
-            }
-        }
+        int num_active = (int)simd::count_nonzero(m_model);
 
         os << "Loss: " << m_report.loss << std::endl;
         os << "Feature L2-norm: " << m_report.norm2 << std::endl;
@@ -237,9 +250,7 @@ protected:
      */
     void initialize_weights()
     {
-        for (size_t i = 0;i < m_model.size();++i) {
-            m_model[i] = 0.;
-        }
+        simd::fill(m_model, 0.);
         m_norm22 = 0;
         m_decay = 1;
         m_proj = 1;
@@ -253,11 +264,7 @@ protected:
      */
     void rescale_weights()
     {
-        m_norm22 = 0;
-        for (size_t i = 0;i < m_model.size();++i) {
-            m_model[i] *= m_scale;
-            m_norm22 += (m_model[i] * m_model[i]);
-        }
+        m_norm22 = simd::scale_sqnorm(m_model, m_scale);
 
         m_decay = 1;
         m_proj = 1;
@@ -303,6 +310,64 @@ public:
     {
         return m_report.loss;
     }
+
+public:
+    /**
+     * Starts lock-free parallel updates.
+     *  Worker threads update the shared vector V without locks during
+     *  parallel updates. The i-th update of the parallel updates receives
+     *  the update count (t + i), and computes the scaling factor from the
+     *  count; the decay factors telescope to:
+     *      decay = (t0 + t - 1) / (t0 + t + i - 1),
+     *  so that the workers need not share the decay factor. The
+     *  projection onto the L2 ball is applied in end_parallel().
+     *  @param  n           The number of updates.
+     */
+    void begin_parallel(size_t n)
+    {
+        if (m_scale != 1.) {
+            this->rescale_weights();
+        }
+        m_parallel_base = m_t0 + m_t - 1;
+        if (m_parallel_base <= 0) {
+            // The first update clears W (decay <= 0), which is zero
+            // at this point; start decaying from the second update.
+            m_parallel_base = m_t0 + m_t;
+        }
+    }
+
+    /**
+     * Finishes lock-free parallel updates.
+     *  @param  n           The number of updates performed.
+     *  @param  loss        The sum of the losses of the updates.
+     */
+    void end_parallel(size_t n, value_type loss)
+    {
+        // W = decay * V after the n updates.
+        m_decay = parallel_scale(m_t + (value_type)n);
+        m_scale = m_decay;
+        m_t += (value_type)n;
+        m_eta = 1. / (m_lambda * (m_t0 + m_t - 1));
+        m_loss += loss;
+        this->rescale_weights();
+
+        // Project the weight vector within an L2 ball.
+        if (1 < m_lambda * m_norm22) {
+            m_scale = 1.0 / std::sqrt(m_lambda * m_norm22);
+            this->rescale_weights();
+        }
+    }
+
+protected:
+    /**
+     * Computes the scaling factor of V before an update in parallel.
+     *  @param  t           The update count.
+     *  @return value_type  The scaling factor.
+     */
+    inline value_type parallel_scale(value_type t) const
+    {
+        return (t <= m_t) ? 1. : m_parallel_base / (m_t0 + t - 1);
+    }
 };
 
 
@@ -382,7 +447,8 @@ public:
         }
 
         // Update the feature weights.
-        update_weights(it->begin(), it->end(), -gain * err * it->get_weight());
+        update_weights(
+            it->begin(), it->end(), -gain * err * it->get_weight(), norm22);
 
         // Project the weight vector within an L2 ball.
         if (1 < lambda * norm22 * scale * scale) {
@@ -409,6 +475,141 @@ public:
         }
     }
 
+    /**
+     * Receives a training instance in lock-free parallel updates.
+     *  This function can be called by multiple threads between
+     *  begin_parallel() and end_parallel().
+     *  @param  it          An interator for the training instance.
+     *  @param  i           The index of the update in the parallel updates.
+     *  @param  loss        The loss to which this function adds the loss
+     *                      of the instance.
+     */
+    template <class iterator_type>
+    void update_parallel(iterator_type it, size_t i, value_type& loss)
+    {
+        const value_type t = this->m_t + (value_type)i;
+        const value_type eta = 1. / (this->m_lambda * (this->m_t0 + t));
+
+        // Compute the error for the instance.
+        value_type nlogp = 0.;
+        error_type cls(this->m_model);
+        cls.inner_product(it->begin(), it->end());
+        cls.scale(this->parallel_scale(t));
+        value_type err = cls.error(it->get_label(), nlogp);
+        loss += (it->get_weight() * nlogp);
+
+        // W -= (err * eta * x) <==> V -= (err * eta * x) / decay.
+        value_type norm22 = 0.;
+        value_type gain = eta / this->parallel_scale(t + 1);
+        update_weights(
+            it->begin(), it->end(), -gain * err * it->get_weight(), norm22);
+    }
+
+
+    /**
+     * Prepares for a mini-batch of training instances.
+     *  @param  insts       The iterators of the training instances.
+     *  @param  first       The position of the first instance of the
+     *                      mini-batch.
+     *  @param  last        The position just beyond the last instance of
+     *                      the mini-batch.
+     */
+    template <class iterator_type>
+    void begin_batch(
+        const std::vector<iterator_type>& insts,
+        size_t first,
+        size_t last
+        )
+    {
+        // Learning rate: eta = 1. / (lambda * (t0 + t)).
+        this->m_eta = 1. / (this->m_lambda * (this->m_t0 + this->m_t));
+    }
+
+    /**
+     * Computes the error of a training instance in a mini-batch.
+     *  This function does not change the model, and can be called by
+     *  multiple threads between begin_batch() and update_batch().
+     *  @param  it          An interator for the training instance.
+     *  @param  err         The variable that receives the error of the
+     *                      instance.
+     *  @return value_type  The loss of the instance.
+     */
+    template <class iterator_type>
+    value_type batch_error(iterator_type it, value_type& err)
+    {
+        value_type nlogp = 0.;
+        error_type cls(this->m_model);
+        cls.inner_product(it->begin(), it->end());
+        cls.scale(this->m_scale);
+        err = cls.error(it->get_label(), nlogp) * it->get_weight();
+        return it->get_weight() * nlogp;
+    }
+
+    /**
+     * Updates feature weights with the errors of a mini-batch.
+     *  This function applies the average of the gradients of the
+     *  instances as a single update, as described in the Pegasos paper.
+     *  @param  insts       The iterators of the training instances.
+     *  @param  first       The position of the first instance of the
+     *                      mini-batch.
+     *  @param  last        The position just beyond the last instance of
+     *                      the mini-batch.
+     *  @param  errs        The errors of the instances [last-first].
+     *  @param  losses      The losses of the instances [last-first].
+     */
+    template <class iterator_type>
+    void update_batch(
+        const std::vector<iterator_type>& insts,
+        size_t first,
+        size_t last,
+        const value_type *errs,
+        const value_type *losses
+        )
+    {
+        // Define synonyms to avoid using "this->" for member variables.
+        value_type& eta = this->m_eta;
+        value_type& lambda = this->m_lambda;
+        value_type& decay = this->m_decay;
+        value_type& proj = this->m_proj;
+        value_type& scale = this->m_scale;
+        value_type& norm22 = this->m_norm22;
+        const size_t n = last - first;
+
+        for (size_t i = 0;i < n;++i) {
+            this->m_loss += losses[i];
+        }
+
+        // W *= (1 - eta * lambda).
+        decay *= (1. - eta * lambda);
+        scale = decay * proj;
+
+        // W -= (eta / n) * sum(err * x).
+        value_type gain = 1;
+        if (0 < decay) {
+            gain = eta / scale;
+        } else {
+            // decay = 0 implies that W should be initialized to 0.
+            this->initialize_weights();
+            gain = 1;
+        }
+        gain /= (value_type)n;
+
+        // Update the feature weights.
+        for (size_t i = 0;i < n;++i) {
+            iterator_type it = insts[first+i];
+            update_weights(it->begin(), it->end(), -gain * errs[i], norm22);
+        }
+
+        // Project the weight vector within an L2 ball.
+        if (1 < lambda * norm22 * scale * scale) {
+            proj = 1.0 / (sqrt(lambda * norm22) * scale);
+            scale = decay * proj;
+        }
+
+        // Increment the update count.
+        ++this->m_t;
+    }
+
 protected:
     /**
      * Adds a value to weights associated with a feature vector.
@@ -417,12 +618,17 @@ protected:
      *  @param  last        The iterator pointing just beyond the last
      *                      element of the feature vector.
      *  @param  delta       The value to be added to the weights.
+     *  @param  norm22      The square of the L2-norm to be updated.
      */
     template <class iterator_type>
-    inline void update_weights(iterator_type first, iterator_type last, value_type delta)
+    inline void update_weights(
+        iterator_type first,
+        iterator_type last,
+        value_type delta,
+        value_type& norm22
+        )
     {
         model_type& model = this->m_model;
-        value_type& norm22 = this->m_norm22;
 
         for (iterator_type it = first;it != last;++it) {
             value_type w = model[it->first];
@@ -490,14 +696,8 @@ public:
         value_type nlogp = 0.;
         error_type cls(model);
         cls.resize(it->num_candidates(L));
+        cls.inner_products(fgen, *it);
         for (int i = 0;i < it->num_candidates(L);++i) {
-            cls.inner_product(
-                i,
-                fgen,
-                it->attributes(i).begin(),
-                it->attributes(i).end(),
-                i
-                );
             cls.scale(i, scale);
         }
         cls.finalize();
@@ -525,21 +725,15 @@ public:
         }
         gain *= it->get_weight();
 
-        // Updates the feature weights.
+        // Computes the errors for the labels (candidates).
+        std::vector<value_type> deltas(it->num_candidates(L));
         for (int i = 0;i < it->num_candidates(L);++i) {
-            // Computes the error for the label (candidate).
-            value_type err = cls.error(i, it->get_label());
-
-            // Update the feature weights.
-            update_weights(
-                i,
-                fgen,
-                it->attributes(i).begin(),
-                it->attributes(i).end(),
-                -err * gain
-                );
+            deltas[i] = -cls.error(i, it->get_label()) * gain;
         }
 
+        // Updates the feature weights.
+        update_weights(fgen, *it, deltas, norm22);
+
 
         // Project the weight vector within an L2 ball.
         if (1 < lambda * norm22 * scale * scale) {
@@ -566,6 +760,185 @@ public:
         }
     }
 
+    /**
+     * Receives a training instance in lock-free parallel updates.
+     *  This function can be called by multiple threads between
+     *  begin_parallel() and end_parallel().
+     *  @param  it          An interator for the training instance.
+     *  @param  fgen        The feature generator.
+     *  @param  i           The index of the update in the parallel updates.
+     *  @param  loss        The loss to which this function adds the loss
+     *                      of the instance.
+     */
+    template <class iterator_type, class feature_generator_type>
+    void update_parallel(
+        iterator_type it,
+        feature_generator_type& fgen,
+        size_t i,
+        value_type& loss
+        )
+    {
+        const int L = (int)fgen.num_labels();
+        const value_type t = this->m_t + (value_type)i;
+        const value_type eta = 1. / (this->m_lambda * (this->m_t0 + t));
+        const value_type scale = this->parallel_scale(t);
+
+        // Compute the scores for the labels (candidates) in the instance.
+        error_type cls(this->m_model);
+        cls.resize(it->num_candidates(L));
+        cls.inner_products(fgen, *it);
+        for (int j = 0;j < it->num_candidates(L);++j) {
+            cls.scale(j, scale);
+        }
+        cls.finalize();
+
+        // Compute the loss for the instance.
+        loss += -it->get_weight() * cls.logprob(it->get_label());
+
+        // W -= (err * eta * x) <==> V -= (err * eta * x) / decay.
+        value_type gain = eta / this->parallel_scale(t + 1);
+        gain *= it->get_weight();
+
+        // Computes the errors for the labels (candidates).
+        std::vector<value_type> deltas(it->num_candidates(L));
+        for (int j = 0;j < it->num_candidates(L);++j) {
+            deltas[j] = -cls.error(j, it->get_label()) * gain;
+        }
+
+        // Updates the feature weights.
+        value_type norm22 = 0.;
+        update_weights(fgen, *it, deltas, norm22);
+    }
+
+
+    /**
+     * Prepares for a mini-batch of training instances.
+     *  @param  insts       The iterators of the training instances.
+     *  @param  first       The position of the first instance of the
+     *                      mini-batch.
+     *  @param  last        The position just beyond the last instance of
+     *                      the mini-batch.
+     *  @param  fgen        The feature generator.
+     */
+    template <class iterator_type, class feature_generator_type>
+    void begin_batch(
+        const std::vector<iterator_type>& insts,
+        size_t first,
+        size_t last,
+        feature_generator_type& fgen
+        )
+    {
+        // Learning rate: eta = 1. / (lambda * (t0 + t)).
+        this->m_eta = 1. / (this->m_lambda * (this->m_t0 + this->m_t));
+    }
+
+    /**
+     * Computes the errors of a training instance in a mini-batch.
+     *  This function does not change the model, and can be called by
+     *  multiple threads between begin_batch() and update_batch().
+     *  @param  it          An interator for the training instance.
+     *  @param  fgen        The feature generator.
+     *  @param  errs        The vector that receives the errors of the
+     *                      labels (candidates).
+     *  @return value_type  The loss of the instance.
+     */
+    template <class iterator_type, class feature_generator_type>
+    value_type batch_error(
+        iterator_type it,
+        feature_generator_type& fgen,
+        std::vector<value_type>& errs
+        )
+    {
+        const int L = (int)fgen.num_labels();
+
+        // Compute the scores for the labels (candidates) in the instance.
+        error_type cls(this->m_model);
+        cls.resize(it->num_candidates(L));
+        cls.inner_products(fgen, *it);
+        for (int i = 0;i < it->num_candidates(L);++i) {
+            cls.scale(i, this->m_scale);
+        }
+        cls.finalize();
+
+        // Computes the errors for the labels (candidates).
+        errs.resize(it->num_candidates(L));
+        for (int i = 0;i < it->num_candidates(L);++i) {
+            errs[i] = cls.error(i, it->get_label()) * it->get_weight();
+        }
+        return -it->get_weight() * cls.logprob(it->get_label());
+    }
+
+    /**
+     * Updates feature weights with the errors of a mini-batch.
+     *  This function applies the average of the gradients of the
+     *  instances as a single update, as described in the Pegasos paper.
+     *  @param  insts       The iterators of the training instances.
+     *  @param  first       The position of the first instance of the
+     *                      mini-batch.
+     *  @param  last        The position just beyond the last instance of
+     *                      the mini-batch.
+     *  @param  fgen        The feature generator.
+     *  @param  errs        The errors of the instances [last-first].
+     *  @param  losses      The losses of the instances [last-first].
+     */
+    template <class iterator_type, class feature_generator_type>
+    void update_batch(
+        const std::vector<iterator_type>& insts,
+        size_t first,
+        size_t last,
+        feature_generator_type& fgen,
+        const std::vector<value_type> *errs,
+        const value_type *losses
+        )
+    {
+        // Define synonyms to avoid using "this->" for member variables.
+        value_type& eta = this->m_eta;
+        value_type& lambda = this->m_lambda;
+        value_type& decay = this->m_decay;
+        value_type& proj = this->m_proj;
+        value_type& scale = this->m_scale;
+        value_type& norm22 = this->m_norm22;
+        const size_t n = last - first;
+
+        for (size_t i = 0;i < n;++i) {
+            this->m_loss += losses[i];
+        }
+
+        // W *= (1 - eta * lambda).
+        decay *= (1. - eta * lambda);
+        scale = decay * proj;
+
+        // W -= (eta / n) * sum(err * x).
+        value_type gain = 1;
+        if (0 < decay) {
+            gain = eta / scale;
+        } else {
+            // decay = 0 implies that W should be initialized to 0.
+            this->initialize_weights();
+            gain = 1;
+        }
+        gain /= (value_type)n;
+
+        // Update the feature weights.
+        std::vector<value_type> deltas;
+        for (size_t i = 0;i < n;++i) {
+            deltas.resize(errs[i].size());
+            for (size_t j = 0;j < deltas.size();++j) {
+                deltas[j] = -errs[i][j] * gain;
+            }
+            update_weights(fgen, *insts[first+i], deltas, norm22);
+        }
+
+        // Project the weight vector within an L2 ball.
+        if (1 < lambda * norm22 * scale * scale) {
+            proj = 1.0 / (sqrt(lambda * norm22) * scale);
+            scale = decay * proj;
+        }
+
+        // Increment the update count.
+        ++this->m_t;
+    }
+
 protected:
     /**
      * Adds a value to weights associated with a feature vector.
@@ -576,6 +949,7 @@ protected:
      *  @param  last        The iterator pointing just beyond the last
      *                      element of the feature vector.
      *  @param  delta       The value to be added to the weights.
+     *  @param  norm22      The square of the L2-norm to be updated.
      */
     template <class feature_generator_type, class iterator_type>
     inline void update_weights(
@@ -583,11 +957,11 @@ protected:
         feature_generator_type& fgen,
         iterator_type first,
         iterator_type last,
-        value_type delta
+        value_type delta,
+        value_type& norm22
         )
     {
         model_type& model = this->m_model;
-        value_type& norm22 = this->m_norm22;
 
         for (iterator_type it = first;it != last;++it) {
             typename feature_generator_type::feature_type f;
@@ -599,6 +973,77 @@ protected:
             }
         }
     }
+
+    /**
+     * Adds values to weights associated with the candidates of an instance.
+     *  @param  fgen        The feature generator.
+     *  @param  inst        The instance.
+     *  @param  deltas      The values to be added to the weights of the
+     *                      candidates.
+     *  @param  norm22      The square of the L2-norm to be updated.
+     */
+    template <class feature_generator_type, class instance_type>
+    inline void update_weights(
+        const feature_generator_type& fgen,
+        const instance_type& inst,
+        const std::vector<value_type>& deltas,
+        value_type& norm22
+        )
+    {
+        for (int i = 0;i < (int)deltas.size();++i) {
+            update_weights(
+                i,
+                fgen,
+                inst.attributes(i).begin(),
+                inst.attributes(i).end(),
+                deltas[i],
+                norm22
+                );
+        }
+    }
+
+    /**
+     * Adds values to weights associated with the labels of an instance.
+     *  This function walks the compiled rows of the sparse feature
+     *  generator instead of looking up the features of every label.
+     *  @param  fgen        The feature generator.
+     *  @param  inst        The instance.
+     *  @param  deltas      The values to be added to the weights of the
+     *                      labels.
+     *  @param  norm22      The square of the L2-norm to be updated.
+     */
+    template <class attribute_tmpl, class label_tmpl, class feature_tmpl, class instance_type>
+    inline void update_weights(
+        const sparse_feature_generator_base<attribute_tmpl, label_tmpl, feature_tmpl>& fgen,
+        const instance_type& inst,
+        const std::vector<value_type>& deltas,
+        value_type& norm22
+        )
+    {
+        typedef typename sparse_feature_generator_base<
+            attribute_tmpl, label_tmpl, feature_tmpl>::label_feature_type
+            label_feature_type;
+        typedef typename instance_type::const_iterator iterator_type;
+
+        if (!fgen.compiled()) {
+            for (int i = 0;i < (int)deltas.size();++i) {
+                update_weights(i, fgen, inst.begin(), inst.end(), deltas[i], norm22);
+            }
+            return;
+        }
+
+        model_type& model = this->m_model;
+
+        for (iterator_type it = inst.begin();it != inst.end();++it) {
+            const label_feature_type* last = fgen.row_end(it->first);
+            for (const label_feature_type* p = fgen.row_begin(it->first);p != last;++p) {
+                value_type w = model[p->second];
+                value_type d = deltas[p->first] * it->second;
+                model[p->second] += d;
+                norm22 += d * (d + w + w);
+            }
+        }
+    }
 };
 
 };
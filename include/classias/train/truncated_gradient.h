@@ -34,9 +34,12 @@
 #define __CLASSIAS_TRAIN_TRUNCATED_GRADIENT_H__
 
 #include <iostream>
+#include <vector>
 
 #include <classias/types.h>
 #include <classias/parameters.h>
+#include <classias/simd.h>
+#include <classias/feature_generator.h>
 
 namespace classias
 {
@@ -112,6 +115,8 @@ protected:
     value_type m_loss;
     /// The total amount of L1 penalty.
     value_type m_sum_penalty;
+    /// The total amounts of L1 penalty for the parallel updates.
+    std::vector<value_type> m_parallel_penalties;
 
     /// Parameter interface.
     parameter_exchange m_params;
@@ -175,6 +180,20 @@ public:
         this->initialize_weights();
     }
 
+    /**
+     * Expands the weight vector for new features.
+     *  This function appends zero weights for the features that are unseen
+     *  so far, without resetting the training process.
+     *  @param  size        The number of features.
+     */
+    void expand_num_features(size_t size)
+    {
+        if (m_w.size() < size) {
+            m_w.resize(size, 0.);
+            m_penalty.resize(size, 0.);
+        }
+    }
+
 public:
     /**
      * Starts a training process.
@@ -209,14 +228,9 @@ public:
         // Fill the progress information.
         m_report.init();
         m_report.loss = m_loss;
-        for (size_t i = 0;i < m_w.size();++i) {
-            value_type v = m_w[i];
-            m_report.norm1 += std::fabs(v);
-            m_report.norm2 += v * v;
-            if (v != 0.) {
-                ++m_report.num_actives;
-            }
-        }
+        m_report.norm1 = simd::norm1(m_w);
+        m_report.norm2 = simd::dot(m_w, m_w);
+        m_report.num_actives = (int)simd::count_nonzero(m_w);
         m_report.loss += m_c * m_report.norm1;
 
         // Reset the run-time information.
@@ -288,10 +302,9 @@ protected:
      */
     void initialize_weights()
     {
-        for (size_t i = 0;i < m_w.size();++i) {
-            m_w[i] = 0.;
-            m_penalty[i] = 0.;
-        }
+        m_penalty.resize(m_w.size());
+        simd::fill(m_w, 0.);
+        simd::fill(m_penalty, 0.);
         m_sum_penalty = 0.;
         m_truncated = true;
     }
@@ -302,9 +315,8 @@ protected:
     inline void apply_penalty()
     {
         if (!m_truncated) {
-            for (int i = 0;i < (int)m_w.size();++i) {
-                apply_penalty(i);
-            }
+            m_penalty.resize(m_w.size());
+            simd::truncate(m_w, m_penalty, m_sum_penalty);
             m_truncated = true;
         }
     }
@@ -312,10 +324,11 @@ protected:
     /**
      * Applies the L1 penalty to the weight of a feature.
      *  @param  i           The feature index.
+     *  @param  sum         The total amount of L1 penalty.
      */
-    inline void apply_penalty(int i)
+    inline void apply_penalty(int i, value_type sum)
     {
-        value_type alpha = m_sum_penalty - m_penalty[i];
+        value_type alpha = sum - m_penalty[i];
         if (0 < alpha) {
             if (0 < m_w[i]) {
                 m_w[i] -= alpha;
@@ -332,7 +345,7 @@ protected:
                     return;
                 }
             }
-            m_penalty[i] = m_sum_penalty;
+            m_penalty[i] = sum;
         }
     }
 
@@ -372,6 +385,46 @@ public:
     {
         return m_report.loss;
     }
+
+public:
+    /**
+     * Starts lock-free parallel updates.
+     *  Worker threads update the shared weights without locks during
+     *  parallel updates. The total amount of L1 penalty depends only on
+     *  the update count; this function computes the amounts for the n
+     *  updates in advance so that the i-th update applies the penalty of
+     *  the update count (t + i + 1).
+     *  @param  n           The number of updates.
+     */
+    void begin_parallel(size_t n)
+    {
+        value_type sum = m_sum_penalty;
+        m_parallel_penalties.resize(n+1);
+        for (size_t i = 0;i < n;++i) {
+            const int t = m_t + (int)i + 1;
+            m_parallel_penalties[i] = sum;
+            if (t % m_truncate_period == 0) {
+                sum += m_lambda * m_truncate_period * learning_rate(t);
+            }
+        }
+        m_parallel_penalties[n] = sum;
+    }
+
+    /**
+     * Finishes lock-free parallel updates.
+     *  @param  n           The number of updates performed.
+     *  @param  loss        The sum of the losses of the updates.
+     */
+    void end_parallel(size_t n, value_type loss)
+    {
+        m_t += (int)n;
+        m_eta = learning_rate(m_t);
+        m_loss += loss;
+        if (m_sum_penalty != m_parallel_penalties[n]) {
+            m_sum_penalty = m_parallel_penalties[n];
+            m_truncated = false;
+        }
+    }
 };
 
 
@@ -419,7 +472,7 @@ public:
 
         // Delay application of L1 penalties to the feature weights that
         // are relevant to the current instance.
-        this->apply_penalty(it->begin(), it->end());
+        this->apply_penalty(it->begin(), it->end(), this->m_sum_penalty);
 
         // Compute the error and loss for the instance.
         error_type cls(w);
@@ -430,7 +483,8 @@ public:
 
         // Stochastic gradient descent without L1 regularization term.
         this->update_weights(
-            it->begin(), it->end(), -err * eta * it->get_weight());
+            it->begin(), it->end(), -err * eta * it->get_weight(),
+            this->m_sum_penalty);
 
         // Accumulate the L1 penalty that should be applied in this update.
         this->accumulate_penalty(t, eta);
@@ -451,6 +505,119 @@ public:
         }
     }
 
+    /**
+     * Receives a training instance in lock-free parallel updates.
+     *  This function can be called by multiple threads between
+     *  begin_parallel() and end_parallel().
+     *  @param  it          An interator for the training instance.
+     *  @param  i           The index of the update in the parallel updates.
+     *  @param  loss        The loss to which this function adds the loss
+     *                      of the instance.
+     */
+    template <class iterator_type>
+    void update_parallel(iterator_type it, size_t i, value_type& loss)
+    {
+        const value_type eta = this->learning_rate(this->m_t + (int)i + 1);
+        const value_type sum = this->m_parallel_penalties[i];
+
+        // Delay application of L1 penalties to the feature weights that
+        // are relevant to the current instance.
+        this->apply_penalty(it->begin(), it->end(), sum);
+
+        // Compute the error and loss for the instance.
+        error_type cls(this->m_w);
+        cls.inner_product(it->begin(), it->end());
+        value_type nlogp = 0.;
+        value_type err = cls.error(it->get_label(), nlogp);
+        loss += (it->get_weight() * nlogp);
+
+        // Stochastic gradient descent without L1 regularization term.
+        this->update_weights(
+            it->begin(), it->end(), -err * eta * it->get_weight(), sum);
+    }
+
+
+    /**
+     * Prepares for a mini-batch of training instances.
+     *  This function applies the delayed L1 penalties to the feature
+     *  weights that are relevant to the instances of the mini-batch.
+     *  @param  insts       The iterators of the training instances.
+     *  @param  first       The position of the first instance of the
+     *                      mini-batch.
+     *  @param  last        The position just beyond the last instance of
+     *                      the mini-batch.
+     */
+    template <class iterator_type>
+    void begin_batch(
+        const std::vector<iterator_type>& insts,
+        size_t first,
+        size_t last
+        )
+    {
+        // Compute the learning rate for the current update.
+        this->m_eta = this->learning_rate(++this->m_t);
+
+        for (size_t i = first;i < last;++i) {
+            this->apply_penalty(
+                insts[i]->begin(), insts[i]->end(), this->m_sum_penalty);
+        }
+    }
+
+    /**
+     * Computes the error of a training instance in a mini-batch.
+     *  This function does not change the model, and can be called by
+     *  multiple threads between begin_batch() and update_batch().
+     *  @param  it          An interator for the training instance.
+     *  @param  err         The variable that receives the error of the
+     *                      instance.
+     *  @return value_type  The loss of the instance.
+     */
+    template <class iterator_type>
+    value_type batch_error(iterator_type it, value_type& err)
+    {
+        error_type cls(this->m_w);
+        cls.inner_product(it->begin(), it->end());
+        value_type nlogp = 0.;
+        err = cls.error(it->get_label(), nlogp) * it->get_weight();
+        return it->get_weight() * nlogp;
+    }
+
+    /**
+     * Updates feature weights with the errors of a mini-batch.
+     *  This function applies the average of the gradients of the
+     *  instances as a single update.
+     *  @param  insts       The iterators of the training instances.
+     *  @param  first       The position of the first instance of the
+     *                      mini-batch.
+     *  @param  last        The position just beyond the last instance of
+     *                      the mini-batch.
+     *  @param  errs        The errors of the instances [last-first].
+     *  @param  losses      The losses of the instances [last-first].
+     */
+    template <class iterator_type>
+    void update_batch(
+        const std::vector<iterator_type>& insts,
+        size_t first,
+        size_t last,
+        const value_type *errs,
+        const value_type *losses
+        )
+    {
+        const size_t n = last - first;
+        const value_type gain = this->m_eta / (value_type)n;
+
+        // Stochastic gradient descent without L1 regularization term.
+        for (size_t i = 0;i < n;++i) {
+            iterator_type it = insts[first+i];
+            this->m_loss += losses[i];
+            this->update_weights(
+                it->begin(), it->end(), -errs[i] * gain, this->m_sum_penalty);
+        }
+
+        // Accumulate the L1 penalty that should be applied in this update.
+        this->accumulate_penalty(this->m_t, this->m_eta);
+    }
+
 protected:
     /**
      * Adds a value to weights associated with a feature vector.
@@ -459,13 +626,19 @@ protected:
      *  @param  last        The iterator pointing just beyond the last
      *                      element of the feature vector.
      *  @param  delta       The value to be added to the weights.
+     *  @param  sum         The total amount of L1 penalty.
      */
     template <class iterator_type>
-    inline void update_weights(iterator_type first, iterator_type last, value_type delta)
+    inline void update_weights(
+        iterator_type first,
+        iterator_type last,
+        value_type delta,
+        value_type sum
+        )
     {
         for (iterator_type it = first;it != last;++it) {
             this->m_w[it->first] += delta * it->second;
-            this->m_penalty[it->first] = this->m_sum_penalty;
+            this->m_penalty[it->first] = sum;
         }
     }
 
@@ -476,12 +649,13 @@ protected:
      *                      the feature vector.
      *  @param  last        The iterator pointing just beyond the last
      *                      element of the feature vector.
+     *  @param  sum         The total amount of L1 penalty.
      */
     template <class iterator_type>
-    inline void apply_penalty(iterator_type first, iterator_type last)
+    inline void apply_penalty(iterator_type first, iterator_type last, value_type sum)
     {
         for (iterator_type it = first;it != last;++it) {
-            base_class::apply_penalty(it->first);
+            base_class::apply_penalty(it->first, sum);
         }
     }
 };
@@ -534,48 +708,27 @@ public:
 
         // Delay application of L1 penalties to the feature weights that
         // are relevant to the current instance.
-        for (int i = 0;i < it->num_candidates(L);++i) {
-            this->apply_penalty(
-                i,
-                fgen,
-                it->attributes(i).begin(),
-                it->attributes(i).end()
-                );
-        }
+        this->apply_penalty(fgen, *it, it->num_candidates(L), this->m_sum_penalty);
 
         // Compute the scores for the labels (candidates) in the instance.
         error_type cls(w);
         cls.resize(it->num_candidates(L));
-        for (int i = 0;i < it->num_candidates(L);++i) {
-            cls.inner_product(
-                i,
-                fgen,
-                it->attributes(i).begin(),
-                it->attributes(i).end(),
-                i
-                );
-        }
+        cls.inner_products(fgen, *it);
         cls.finalize();
 
         // Compute the loss for the instance.
         loss += -it->get_weight() * cls.logprob(it->get_label());
 
-        // Updates the feature weights.
+        // Computes the errors for the labels (candidates).
         value_type gain = eta * it->get_weight();
+        std::vector<value_type> deltas(it->num_candidates(L));
         for (int i = 0;i < it->num_candidates(L);++i) {
-            // Computes the error for the label (candidate).
-            value_type err = cls.error(i, it->get_label());
-
-            // Update the feature weights.
-            update_weights(
-                i,
-                fgen,
-                it->attributes(i).begin(),
-                it->attributes(i).end(),
-                -err * gain 
-                );
+            deltas[i] = -cls.error(i, it->get_label()) * gain;
         }
 
+        // Updates the feature weights.
+        update_weights(fgen, *it, deltas, this->m_sum_penalty);
+
         // Accumulate the L1 penalty that should be applied in this update.
         this->accumulate_penalty(t, eta);
     }
@@ -595,6 +748,157 @@ public:
         }
     }
 
+    /**
+     * Receives a training instance in lock-free parallel updates.
+     *  This function can be called by multiple threads between
+     *  begin_parallel() and end_parallel().
+     *  @param  it          An interator for the training instance.
+     *  @param  fgen        The feature generator.
+     *  @param  i           The index of the update in the parallel updates.
+     *  @param  loss        The loss to which this function adds the loss
+     *                      of the instance.
+     */
+    template <class iterator_type, class feature_generator_type>
+    void update_parallel(
+        iterator_type it,
+        feature_generator_type& fgen,
+        size_t i,
+        value_type& loss
+        )
+    {
+        const int L = (int)fgen.num_labels();
+        const value_type eta = this->learning_rate(this->m_t + (int)i + 1);
+        const value_type sum = this->m_parallel_penalties[i];
+
+        // Delay application of L1 penalties to the feature weights that
+        // are relevant to the current instance.
+        this->apply_penalty(fgen, *it, it->num_candidates(L), sum);
+
+        // Compute the scores for the labels (candidates) in the instance.
+        error_type cls(this->m_w);
+        cls.resize(it->num_candidates(L));
+        cls.inner_products(fgen, *it);
+        cls.finalize();
+
+        // Compute the loss for the instance.
+        loss += -it->get_weight() * cls.logprob(it->get_label());
+
+        // Computes the errors for the labels (candidates).
+        value_type gain = eta * it->get_weight();
+        std::vector<value_type> deltas(it->num_candidates(L));
+        for (int j = 0;j < it->num_candidates(L);++j) {
+            deltas[j] = -cls.error(j, it->get_label()) * gain;
+        }
+
+        // Updates the feature weights.
+        update_weights(fgen, *it, deltas, sum);
+    }
+
+
+    /**
+     * Prepares for a mini-batch of training instances.
+     *  This function applies the delayed L1 penalties to the feature
+     *  weights that are relevant to the instances of the mini-batch.
+     *  @param  insts       The iterators of the training instances.
+     *  @param  first       The position of the first instance of the
+     *                      mini-batch.
+     *  @param  last        The position just beyond the last instance of
+     *                      the mini-batch.
+     *  @param  fgen        The feature generator.
+     */
+    template <class iterator_type, class feature_generator_type>
+    void begin_batch(
+        const std::vector<iterator_type>& insts,
+        size_t first,
+        size_t last,
+        feature_generator_type& fgen
+        )
+    {
+        const int L = (int)fgen.num_labels();
+
+        // Compute the learning rate for the current update.
+        this->m_eta = this->learning_rate(++this->m_t);
+
+        for (size_t i = first;i < last;++i) {
+            this->apply_penalty(
+                fgen, *insts[i], insts[i]->num_candidates(L), this->m_sum_penalty);
+        }
+    }
+
+    /**
+     * Computes the errors of a training instance in a mini-batch.
+     *  This function does not change the model, and can be called by
+     *  multiple threads between begin_batch() and update_batch().
+     *  @param  it          An interator for the training instance.
+     *  @param  fgen        The feature generator.
+     *  @param  errs        The vector that receives the errors of the
+     *                      labels (candidates).
+     *  @return value_type  The loss of the instance.
+     */
+    template <class iterator_type, class feature_generator_type>
+    value_type batch_error(
+        iterator_type it,
+        feature_generator_type& fgen,
+        std::vector<value_type>& errs
+        )
+    {
+        const int L = (int)fgen.num_labels();
+
+        // Compute the scores for the labels (candidates) in the instance.
+        error_type cls(this->m_w);
+        cls.resize(it->num_candidates(L));
+        cls.inner_products(fgen, *it);
+        cls.finalize();
+
+        // Computes the errors for the labels (candidates).
+        errs.resize(it->num_candidates(L));
+        for (int i = 0;i < it->num_candidates(L);++i) {
+            errs[i] = cls.error(i, it->get_label()) * it->get_weight();
+        }
+        return -it->get_weight() * cls.logprob(it->get_label());
+    }
+
+    /**
+     * Updates feature weights with the errors of a mini-batch.
+     *  This function applies the average of the gradients of the
+     *  instances as a single update.
+     *  @param  insts       The iterators of the training instances.
+     *  @param  first       The position of the first instance of the
+     *                      mini-batch.
+     *  @param  last        The position just beyond the last instance of
+     *                      the mini-batch.
+     *  @param  fgen        The feature generator.
+     *  @param  errs        The errors of the instances [last-first].
+     *  @param  losses      The losses of the instances [last-first].
+     */
+    template <class iterator_type, class feature_generator_type>
+    void update_batch(
+        const std::vector<iterator_type>& insts,
+        size_t first,
+        size_t last,
+        feature_generator_type& fgen,
+        const std::vector<value_type> *errs,
+        const value_type *losses
+        )
+    {
+        const size_t n = last - first;
+        const value_type gain = this->m_eta / (value_type)n;
+
+        // Stochastic gradient descent without L1 regularization term.
+        std::vector<value_type> deltas;
+        for (size_t i = 0;i < n;++i) {
+            this->m_loss += losses[i];
+            deltas.resize(errs[i].size());
+            for (size_t j = 0;j < deltas.size();++j) {
+                deltas[j] = -errs[i][j] * gain;
+            }
+            update_weights(fgen, *insts[first+i], deltas, this->m_sum_penalty);
+        }
+
+        // Accumulate the L1 penalty that should be applied in this update.
+        this->accumulate_penalty(this->m_t, this->m_eta);
+    }
+
 protected:
     /**
      * Adds a value to weights associated with a feature vector.
@@ -605,6 +909,7 @@ protected:
      *  @param  last        The iterator pointing just beyond the last
      *                      element of the feature vector.
      *  @param  delta       The value to be added to the weights.
+     *  @param  sum         The total amount of L1 penalty.
      */
     template <class feature_generator_type, class iterator_type>
     inline void update_weights(
@@ -612,14 +917,15 @@ protected:
         feature_generator_type& fgen,
         iterator_type first,
         iterator_type last,
-        value_type delta
+        value_type delta,
+        value_type sum
         )
     {
         for (iterator_type it = first;it != last;++it) {
             typename feature_generator_type::feature_type f;
             if (fgen.forward(it->first, l, f)) {
                 this->m_w[f] += delta * it->second;
-                this->m_penalty[f] = this->m_sum_penalty;
+                this->m_penalty[f] = sum;
             }
         }
     }
@@ -633,19 +939,151 @@ protected:
      *                      the feature vector.
      *  @param  last        The iterator pointing just beyond the last
      *                      element of the feature vector.
+     *  @param  sum         The total amount of L1 penalty.
      */
     template <class feature_generator_type, class iterator_type>
     inline void apply_penalty(
         int l,
         feature_generator_type& fgen,
         iterator_type first,
-        iterator_type last
+        iterator_type last,
+        value_type sum
         )
     {
         for (iterator_type it = first;it != last;++it) {
             typename feature_generator_type::feature_type f;
             if (fgen.forward(it->first, l, f)) {
-                base_class::apply_penalty(f);
+                base_class::apply_penalty(f, sum);
+            }
+        }
+    }
+
+    /**
+     * Adds values to weights associated with the candidates of an instance.
+     *  @param  fgen        The feature generator.
+     *  @param  inst        The instance.
+     *  @param  deltas      The values to be added to the weights of the
+     *                      candidates.
+     *  @param  sum         The total amount of L1 penalty.
+     */
+    template <class feature_generator_type, class instance_type>
+    inline void update_weights(
+        const feature_generator_type& fgen,
+        const instance_type& inst,
+        const std::vector<value_type>& deltas,
+        value_type sum
+        )
+    {
+        for (int i = 0;i < (int)deltas.size();++i) {
+            update_weights(
+                i,
+                fgen,
+                inst.attributes(i).begin(),
+                inst.attributes(i).end(),
+                deltas[i],
+                sum
+                );
+        }
+    }
+
+    /**
+     * Adds values to weights associated with the labels of an instance.
+     *  This function walks the compiled rows of the sparse feature
+     *  generator instead of looking up the features of every label.
+     *  @param  fgen        The feature generator.
+     *  @param  inst        The instance.
+     *  @param  deltas      The values to be added to the weights of the
+     *                      labels.
+     *  @param  sum         The total amount of L1 penalty.
+     */
+    template <class attribute_tmpl, class label_tmpl, class feature_tmpl, class instance_type>
+    inline void update_weights(
+        const sparse_feature_generator_base<attribute_tmpl, label_tmpl, feature_tmpl>& fgen,
+        const instance_type& inst,
+        const std::vector<value_type>& deltas,
+        value_type sum
+        )
+    {
+        typedef typename sparse_feature_generator_base<
+            attribute_tmpl, label_tmpl, feature_tmpl>::label_feature_type
+            label_feature_type;
+        typedef typename instance_type::const_iterator iterator_type;
+
+        if (!fgen.compiled()) {
+            for (int i = 0;i < (int)deltas.size();++i) {
+                update_weights(i, fgen, inst.begin(), inst.end(), deltas[i], sum);
+            }
+            return;
+        }
+
+        for (iterator_type it = inst.begin();it != inst.end();++it) {
+            const label_feature_type* last = fgen.row_end(it->first);
+            for (const label_feature_type* p = fgen.row_begin(it->first);p != last;++p) {
+                this->m_w[p->second] += deltas[p->first] * it->second;
+                this->m_penalty[p->second] = sum;
+            }
+        }
+    }
+
+    /**
+     * Applies L1 penalties to the feature weights of an instance.
+     *  @param  fgen        The feature generator.
+     *  @param  inst        The instance.
+     *  @param  n           The number of candidates.
+     *  @param  sum         The total amount of L1 penalty.
+     */
+    template <class feature_generator_type, class instance_type>
+    inline void apply_penalty(
+        const feature_generator_type& fgen,
+        const instance_type& inst,
+        int n,
+        value_type sum
+        )
+    {
+        for (int i = 0;i < n;++i) {
+            apply_penalty(
+                i,
+                fgen,
+                inst.attributes(i).begin(),
+                inst.attributes(i).end(),
+                sum
+                );
+        }
+    }
+
+    /**
+     * Applies L1 penalties to the feature weights of a multi-class instance.
+     *  This function walks the compiled rows of the sparse feature
+     *  generator instead of looking up the features of every label.
+     *  @param  fgen        The feature generator.
+     *  @param  inst        The instance.
+     *  @param  n           The number of labels.
+     *  @param  sum         The total amount of L1 penalty.
+     */
+    template <class attribute_tmpl, class label_tmpl, class feature_tmpl, class instance_type>
+    inline void apply_penalty(
+        const sparse_feature_generator_base<attribute_tmpl, label_tmpl, feature_tmpl>& fgen,
+        const instance_type& inst,
+        int n,
+        value_type sum
+        )
+    {
+        typedef typename sparse_feature_generator_base<
+            attribute_tmpl, label_tmpl, feature_tmpl>::label_feature_type
+            label_feature_type;
+        typedef typename instance_type::const_iterator iterator_type;
+
+        if (!fgen.compiled()) {
+            for (int i = 0;i < n;++i) {
+                apply_penalty(i, fgen, inst.begin(), inst.end(), sum);
+            }
+            return;
+        }
+
+        for (iterator_type it = inst.begin();it != inst.end();++it) {
+            const label_feature_type* last = fgen.row_end(it->first);
+            for (const label_feature_type* p = fgen.row_begin(it->first);p != last;++p) {
+                base_class::apply_penalty(p->second, sum);
             }
         }
     }
@@ -33,6 +33,11 @@
 #ifndef __CLASSIAS_TYPES_H__
 #define __CLASSIAS_TYPES_H__
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <utility>
 #include <vector>
 
 
@@ -373,6 +378,15 @@ public:
         return cont.end();
     }
 
+    /**
+     * Reserves the storage for elements.
+     *  @param  n           The number of elements to reserve.
+     */
+    inline void reserve(size_type n)
+    {
+        cont.reserve(n);
+    }
+
     /**
      * Appends an element (name, value) to the end of the vector.
      *  @param  id          The element identifier.
@@ -385,6 +399,335 @@ public:
 };
 
 
+/**
+ * Returns the capacity of a compact array for a number of elements.
+ *  A compact array does not store its capacity; the capacity is implied by
+ *  the number of elements as the smallest power of two (at least four) that
+ *  is no smaller than the number. Appending an element to a full array
+ *  doubles the capacity.
+ *  @param  n           The number of elements.
+ *  @return size_t      The capacity.
+ */
+inline size_t compact_capacity(size_t n)
+{
+    if (n == 0) {
+        return 0;
+    }
+    size_t c = 4;
+    while (c < n) {
+        c *= 2;
+    }
+    return c;
+}
+
+/**
+ * A pair of (identifier, value) for compact arrays.
+ *  This structure provides the members first and second as std::pair
+ *  does, but it is trivially copyable so that an array of pairs can be
+ *  resized by std::realloc() and copied by std::memcpy().
+ *  @param  first_tmpl      The type of the first member.
+ *  @param  second_tmpl     The type of the second member.
+ */
+template <class first_tmpl, class second_tmpl>
+struct compact_pair
+{
+    /// The type of the first member.
+    typedef first_tmpl first_type;
+    /// The type of the second member.
+    typedef second_tmpl second_type;
+
+    /// The first member.
+    first_type first;
+    /// The second member.
+    second_type second;
+
+    /**
+     * Constructs a pair with the default values.
+     */
+    compact_pair() : first(), second()
+    {
+    }
+
+    /**
+     * Constructs a pair.
+     *  @param  x           The first member.
+     *  @param  y           The second member.
+     */
+    compact_pair(const first_type& x, const second_type& y)
+        : first(x), second(y)
+    {
+    }
+};
+
+/**
+ * Resizes a block of trivially copyable objects.
+ *  The block is allocated by std::realloc() so that objects are moved with
+ *  their bytes; use this function only for trivially copyable types such
+ *  as compact_pair.
+ *  @param  p           The pointer to the block (or \c NULL).
+ *  @param  n           The new number of objects.
+ *  @return value_type* The pointer to the resized block.
+ */
+template <class value_type>
+inline value_type* compact_realloc(value_type* p, size_t n)
+{
+    if (n == 0) {
+        std::free(p);
+        return NULL;
+    }
+    void *q = std::realloc(p, sizeof(value_type) * n);
+    if (q == NULL) {
+        throw std::bad_alloc();
+    }
+    return reinterpret_cast<value_type*>(q);
+}
+
+/**
+ * Resizes a block of objects that can exchange their contents.
+ *  The block is allocated by std::malloc(), and an object is moved to the
+ *  new block by swapping it with a default-constructed object, which is
+ *  cheap for objects owning their storage through a pointer (e.g.,
+ *  compact_sparse_vector).
+ *  @param  p           The pointer to the block (or \c NULL).
+ *  @param  size        The number of constructed objects in the block.
+ *  @param  n           The new number of objects (no smaller than size).
+ *  @return value_type* The pointer to the resized block.
+ */
+template <class value_type>
+inline value_type* compact_relocate(value_type* p, size_t size, size_t n)
+{
+    value_type* q = NULL;
+    if (0 < n) {
+        q = reinterpret_cast<value_type*>(std::malloc(sizeof(value_type) * n));
+        if (q == NULL) {
+            throw std::bad_alloc();
+        }
+    }
+    for (size_t i = 0;i < size;++i) {
+        new(&q[i]) value_type();
+        q[i].swap(p[i]);
+        p[i].~value_type();
+    }
+    std::free(p);
+    return q;
+}
+
+
+
+/**
+ * A template class for compact sparse vectors.
+ *
+ *  This class implements a sparse vector with the interface of
+ *  sparse_vector_base, but without a virtual table: an object consists of
+ *  a pointer to the elements and two 32-bit counters (16 bytes on 64-bit
+ *  systems). The elements are trivially copyable (see compact_pair), and an
+ *  object owns them through a single pointer, so that it can be moved to
+ *  another address cheaply by swap().
+ *
+ *  @param  identifier_base The type of element identifier.
+ *  @param  value_base      The type of element values.
+ */
+template <class identifier_base, class value_base>
+class compact_sparse_vector
+{
+public:
+    /// A type representing an element identifier.
+    typedef identifier_base identifier_type;
+    /// A type representing an element value.
+    typedef value_base value_type;
+    /// A type representing an element, a pair of (identifier, value).
+    typedef compact_pair<identifier_type, value_type> element_type;
+    /// A type counting the number of pairs in a container.
+    typedef size_t size_type;
+    /// A type providing a random-access iterator.
+    typedef element_type* iterator;
+    /// A type providing a read-only random-access iterator.
+    typedef const element_type* const_iterator;
+
+protected:
+    /// The array of (identifier, value) pairs.
+    element_type* m_elems;
+    /// The number of elements.
+    unsigned int m_size;
+    /// The capacity of the array.
+    unsigned int m_capacity;
+
+public:
+    /**
+     * Constructs a sparse vector.
+     */
+    compact_sparse_vector() : m_elems(NULL), m_size(0), m_capacity(0)
+    {
+    }
+
+    /**
+     * Constructs a sparse vector by copying another.
+     *  @param  x           The sparse vector to be copied.
+     */
+    compact_sparse_vector(const compact_sparse_vector& x)
+        : m_elems(NULL), m_size(0), m_capacity(0)
+    {
+        assign(x);
+    }
+
+#if     __cplusplus >= 201103L
+    /**
+     * Constructs a sparse vector by moving another.
+     *  @param  x           The sparse vector to be moved.
+     */
+    compact_sparse_vector(compact_sparse_vector&& x) noexcept
+        : m_elems(x.m_elems), m_size(x.m_size), m_capacity(x.m_capacity)
+    {
+        x.m_elems = NULL;
+        x.m_size = x.m_capacity = 0;
+    }
+#endif/*__cplusplus >= 201103L*/
+
+    /**
+     * Destructs the sparse vector.
+     */
+    ~compact_sparse_vector()
+    {
+        std::free(m_elems);
+    }
+
+    /**
+     * Copies the elements from another sparse vector.
+     *  @param  x           The sparse vector to be copied.
+     *  @return compact_sparse_vector&  The reference to this object.
+     */
+    compact_sparse_vector& operator=(const compact_sparse_vector& x)
+    {
+        if (this != &x) {
+            assign(x);
+        }
+        return *this;
+    }
+
+    /**
+     * Exchanges the elements with another sparse vector.
+     *  @param  x           The sparse vector.
+     */
+    inline void swap(compact_sparse_vector& x)
+    {
+        std::swap(m_elems, x.m_elems);
+        std::swap(m_size, x.m_size);
+        std::swap(m_capacity, x.m_capacity);
+    }
+
+    /**
+     * Erases all the elements of the vector.
+     */
+    inline void clear()
+    {
+        m_size = 0;
+    }
+
+    /**
+     * Tests if the sparse vector is empty.
+     *  @retval bool        \c true if the sparse vector is empty,
+     *                      \c false otherwise.
+     */
+    inline bool empty() const
+    {
+        return (m_size == 0);
+    }
+
+    /**
+     * Returns the number of elements in the vector.
+     *  @retval size_type   The current size of the sparse vector.
+     */
+    inline size_type size() const
+    {
+        return m_size;
+    }
+
+    /**
+     * Returns a random-access iterator to the first element.
+     *  @retval iterator    A random-access iterator (for read/write).
+     */
+    inline iterator begin()
+    {
+        return m_elems;
+    }
+
+    /**
+     * Returns a random-access iterator to the first element.
+     *  @retval const_iterator  A random-access iterator (for read-only).
+     */
+    inline const_iterator begin() const
+    {
+        return m_elems;
+    }
+
+    /**
+     * Returns a random-access iterator pointing just beyond the last element.
+     *  @retval iterator    A random-access iterator (for read/write).
+     */
+    inline iterator end()
+    {
+        return m_elems + m_size;
+    }
+
+    /**
+     * Returns a random-access iterator pointing just beyond the last element.
+     *  @retval const_iterator  A random-access iterator (for read-only).
+     */
+    inline const_iterator end() const
+    {
+        return m_elems + m_size;
+    }
+
+    /**
+     * Reserves the storage for elements.
+     *  @param  n           The number of elements to reserve.
+     */
+    inline void reserve(size_type n)
+    {
+        if (m_capacity < n) {
+            m_elems = compact_realloc(m_elems, n);
+            m_capacity = (unsigned int)n;
+        }
+    }
+
+    /**
+     * Appends an element (name, value) to the end of the vector.
+     *  @param  id          The element identifier.
+     *  @param  value       The element value.
+     */
+    inline void append(const identifier_type& id, const value_type& value)
+    {
+        if (m_size == m_capacity) {
+            reserve(compact_capacity(m_size+1));
+        }
+        m_elems[m_size++] = element_type(id, value);
+    }
+
+protected:
+    void assign(const compact_sparse_vector& x)
+    {
+        m_size = 0;
+        reserve(x.m_size);
+        if (0 < x.m_size) {
+            std::memcpy(m_elems, x.m_elems, sizeof(element_type) * x.m_size);
+        }
+        m_size = x.m_size;
+    }
+};
+
+/**
+ * Exchanges the elements of two compact sparse vectors.
+ */
+template <class identifier_base, class value_base>
+inline void swap(
+    compact_sparse_vector<identifier_base, value_base>& x,
+    compact_sparse_vector<identifier_base, value_base>& y
+    )
+{
+    x.swap(y);
+}
+
+
 
 template <
     class type
@@ -417,6 +760,254 @@ public:
     }
 };
 
+
+
+/**
+ * A weight vector storing elements in lazily allocated pages.
+ *
+ *  This class splits the index space into pages of 2^page_bits elements,
+ *  and allocates the storage of a page (filled with zeros) when an element
+ *  in the page is accessed by the non-const operator[] for the first time.
+ *  The memory usage is thus proportional to the number of pages touched by
+ *  the features in the training data, not to the largest feature
+ *  identifier; an access costs one table lookup. The const operator[]
+ *  never allocates a page: it returns zero for an element in an untouched
+ *  page or out of the range. Vector operations (e.g., simd::fill() and
+ *  simd::dot() for containers) visit the touched pages only.
+ *
+ *  The allocation of a page is not thread-safe. Use this class with a
+ *  single-threaded training process.
+ *
+ *  @param  value_tmpl      The type of an element.
+ *  @param  page_bits       The number of bits for the offset in a page.
+ */
+template <
+    class value_tmpl,
+    int page_bits = 12
+    >
+class paged_vector
+{
+public:
+    /// The type of an element.
+    typedef value_tmpl value_type;
+    /// The type of the size.
+    typedef size_t size_type;
+    /// The reference to an element.
+    typedef value_type& reference;
+    /// The read-only reference to an element.
+    typedef const value_type& const_reference;
+
+protected:
+    /// The table of pages (NULL for an untouched page).
+    std::vector<value_type*> m_pages;
+    /// The number of elements.
+    size_type m_size;
+    /// The zero value returned for an element in an untouched page.
+    value_type m_zero;
+
+public:
+    /**
+     * Constructs an empty vector.
+     */
+    paged_vector() : m_size(0), m_zero(0)
+    {
+    }
+
+    /**
+     * Constructs a copy of another vector.
+     *  @param  x           The vector to be copied.
+     */
+    paged_vector(const paged_vector& x) : m_size(0), m_zero(0)
+    {
+        assign(x);
+    }
+
+    /**
+     * Destructs the vector.
+     */
+    virtual ~paged_vector()
+    {
+        clear();
+    }
+
+    /**
+     * Copies the elements from another vector.
+     *  @param  x           The vector to be copied.
+     *  @return paged_vector&   The reference to this object.
+     */
+    paged_vector& operator=(const paged_vector& x)
+    {
+        if (this != &x) {
+            assign(x);
+        }
+        return *this;
+    }
+
+    /**
+     * Exchanges the elements with another vector.
+     *  @param  x           The vector.
+     */
+    inline void swap(paged_vector& x)
+    {
+        m_pages.swap(x.m_pages);
+        std::swap(m_size, x.m_size);
+    }
+
+    /**
+     * Erases all the elements and releases the pages.
+     */
+    void clear()
+    {
+        for (size_t p = 0;p < m_pages.size();++p) {
+            delete[] m_pages[p];
+        }
+        m_pages.clear();
+        m_size = 0;
+    }
+
+    /**
+     * Tests if the vector is empty.
+     *  @retval bool        \c true if the vector is empty,
+     *                      \c false otherwise.
+     */
+    inline bool empty() const
+    {
+        return (m_size == 0);
+    }
+
+    /**
+     * Returns the number of elements.
+     *  @return size_type   The number of elements.
+     */
+    inline size_type size() const
+    {
+        return m_size;
+    }
+
+    /**
+     * Changes the number of elements.
+     *  This function does not allocate a page; new elements are zero.
+     *  @param  size        The number of elements.
+     *  @param  value       Unused (new elements are always zero).
+     */
+    void resize(size_type size, const value_type& value = value_type())
+    {
+        const size_t n = (size + page_size() - 1) >> page_bits;
+        for (size_t p = n;p < m_pages.size();++p) {
+            delete[] m_pages[p];
+        }
+        m_pages.resize(n, NULL);
+
+        // Erase the elements beyond the new size in the last page.
+        if (size < m_size && 0 < n && m_pages[n-1] != NULL) {
+            const size_t offset = size - ((n-1) << page_bits);
+            std::fill(m_pages[n-1] + offset, m_pages[n-1] + page_size(), value_type(0));
+        }
+        m_size = size;
+    }
+
+    /**
+     * Accesses an element, allocating its page if necessary.
+     *  The vector grows if the index is out of the range.
+     *  @param  i           The index of the element.
+     *  @return reference   The reference to the element.
+     */
+    inline reference operator[](size_type i)
+    {
+        if (m_size <= i) {
+            resize(i+1);
+        }
+        return touch_page(i >> page_bits)[i & (page_size() - 1)];
+    }
+
+    /**
+     * Reads an element without allocating a page.
+     *  @param  i           The index of the element.
+     *  @return const_reference The element (zero if the page is untouched
+     *                      or the index is out of the range).
+     */
+    inline const_reference operator[](size_type i) const
+    {
+        if (i < m_size) {
+            const value_type* page = m_pages[i >> page_bits];
+            if (page != NULL) {
+                return page[i & (page_size() - 1)];
+            }
+        }
+        return m_zero;
+    }
+
+    /**
+     * Returns the number of elements in a page.
+     *  @return size_t      The number of elements in a page.
+     */
+    static inline size_t page_size()
+    {
+        return ((size_t)1 << page_bits);
+    }
+
+    /**
+     * Returns the number of pages covering the elements.
+     *  @return size_t      The number of pages.
+     */
+    inline size_t num_pages() const
+    {
+        return m_pages.size();
+    }
+
+    /**
+     * Returns the number of elements in a page within the size.
+     *  @param  p           The page number.
+     *  @return size_t      The number of elements (smaller than
+     *                      page_size() for the last page).
+     */
+    inline size_t page_length(size_t p) const
+    {
+        const size_t first = p << page_bits;
+        return (m_size - first < page_size()) ? (m_size - first) : page_size();
+    }
+
+    /**
+     * Returns a page for reading.
+     *  @param  p           The page number.
+     *  @return const value_type*   The elements in the page, or \c NULL if
+     *                      the page is untouched.
+     */
+    inline const value_type* page(size_t p) const
+    {
+        return m_pages[p];
+    }
+
+    /**
+     * Returns a page for writing, allocating it if necessary.
+     *  @param  p           The page number.
+     *  @return value_type* The elements in the page.
+     */
+    inline value_type* touch_page(size_t p)
+    {
+        value_type*& page = m_pages[p];
+        if (page == NULL) {
+            page = new value_type[page_size()];
+            std::fill(page, page + page_size(), value_type(0));
+        }
+        return page;
+    }
+
+protected:
+    void assign(const paged_vector& x)
+    {
+        clear();
+        m_pages.resize(x.m_pages.size(), NULL);
+        for (size_t p = 0;p < x.m_pages.size();++p) {
+            if (x.m_pages[p] != NULL) {
+                m_pages[p] = new value_type[page_size()];
+                std::copy(x.m_pages[p], x.m_pages[p] + page_size(), m_pages[p]);
+            }
+        }
+        m_size = x.m_size;
+    }
+};
+
 };
 
 #endif/*__CLASSIAS_TYPES_H__*/
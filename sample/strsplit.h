@@ -36,6 +36,63 @@
 #include <cstdlib>
 #include <string>
 
+/*
+ * A slice of a string, i.e., a pair of pointers to the first character and
+ * the position just beyond the last character. A slice refers to the source
+ * string without copying it.
+ */
+template <class char_type>
+struct basic_strslice
+{
+	const char_type* first;
+	const char_type* last;
+
+	basic_strslice() : first(NULL), last(NULL)
+	{
+	}
+
+	basic_strslice(const char_type* f, const char_type* l) : first(f), last(l)
+	{
+	}
+
+	size_t size() const
+	{
+		return (size_t)(last - first);
+	}
+
+	bool empty() const
+	{
+		return first == last;
+	}
+
+	std::basic_string<char_type> str() const
+	{
+		return std::basic_string<char_type>(first, last);
+	}
+
+	bool operator==(const char_type* s) const
+	{
+		const char_type* p = first;
+		for (;p != last;++p, ++s) {
+			if (*s == 0 || *p != *s) {
+				return false;
+			}
+		}
+		return (*s == 0);
+	}
+
+	bool operator!=(const char_type* s) const
+	{
+		return !operator==(s);
+	}
+};
+
+typedef basic_strslice<char> strslice;
+
+/*
+ * Splits a string into slices; no memory is allocated per field once the
+ * container has grown enough. The slices are valid while the string lives.
+ */
 template <class container_type, class char_type>
 static void strsplit(
 	container_type& values,
@@ -46,31 +103,39 @@ static void strsplit(
 	// Initialize the container.
 	values.clear();
 
-	typename std::basic_string<char_type>::const_iterator it = line.begin();
-	while (it != line.end()) {
-		std::basic_string<char_type> value;
-		for (;it != line.end();++it) {
-			if (*it == sep) {
-				++it;
-				break;
-			}
-			value += *it;
+	const char_type* it = line.data();
+	const char_type* end = line.data() + line.size();
+	while (it != end) {
+		const char_type* first = it;
+		while (it != end && *it != sep) {
+			++it;
+		}
+		values.push_back(basic_strslice<char_type>(first, it));
+		if (it != end) {
+			++it;
 		}
-		values.push_back(value);
 	}
 }
 
+/*
+ * Parses a field "<id>[<separator><value>]". The field must be a slice of a
+ * null-terminated string whose fields are separated by non-numeric
+ * characters, so that std::atoi() and std::atof() stop at the end of the
+ * field.
+ */
 static void
 get_id_value(
-    const std::string& str, int& id, double& value, char separator)
+    const strslice& str, int& id, double& value, char separator)
 {
-    size_t col = str.rfind(separator);
-    if (col == str.npos) {
-        id = std::atoi(str.c_str());
+    const char* col = str.last;
+    while (col != str.first && *(col-1) != separator) {
+        --col;
+    }
+    id = str.empty() ? 0 : std::atoi(str.first);
+    if (col == str.first) {
         value = 1.;
     } else {
-        id = std::atoi(str.substr(0, col).c_str());
-        value = std::atof(str.c_str() + col + 1);
+        value = std::atof(col);
     }
 }
 
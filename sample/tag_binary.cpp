@@ -102,16 +102,16 @@ int main(int argc, char *argv[])
     classias::accuracy acc;     // An accuracy counter.
     classifier_type cla(model); // The classifier.
 
+    std::string line;
+    std::vector<strslice> fields;
     for (;;) {
         // Read a line.
-        std::string line;
         std::getline(is, line);
         if (is.eof()) {
             break;
         }
 
         // Split the line into fields with space characters.
-        std::vector<std::string> fields;
         strsplit(fields, line);
 
         // The line must have at least a label and a feature.
@@ -40,7 +40,7 @@
 
 #include "strsplit.h"   // necessary for strsplit() and get_id_value().
 
-typedef classias::expandable_weight_vector model_type;
+typedef classias::paged_weight_vector model_type;
 
 // Define the type of a training algorithm. Change this type to use a
 // different online training algorithm.
@@ -65,16 +65,16 @@ int main(int argc, char *argv[])
     tr.start();
 
     // Read a data set from STDIN.
+    std::string line;
+    std::vector<strslice> fields;
     for (;;) {
         // Read a line.
-        std::string line;
         std::getline(is, line);
         if (is.eof()) {
             break;
         }
 
         // Split the line into fields with space characters.
-        std::vector<std::string> fields;
         strsplit(fields, line);
 
         // The line must have at least a label and a feature.
@@ -107,11 +107,16 @@ int main(int argc, char *argv[])
     // Finalize the trainer.
     tr.finish();
 
-    // Output the model.
+    // Output the model (the pages touched by the training data only).
     const model_type& w = tr.model();
-    for (size_t i = 0;i < w.size();++i) {
-        // Feature ID and its weight.
-        os << i << '\t' << w[i] << std::endl;
+    for (size_t p = 0;p < w.num_pages();++p) {
+        const double* page = w.page(p);
+        if (page != NULL) {
+            for (size_t j = 0;j < w.page_length(p);++j) {
+                // Feature ID and its weight.
+                os << p * w.page_size() + j << '\t' << page[j] << std::endl;
+            }
+        }
     }
 
     return 0;